@@ -0,0 +1,140 @@
+#include "asset_pack.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_ttf.h>
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// benchmark settings
+const int DEFAULT_ITERATIONS = 50;
+const char DEFAULT_PACK_PATH[] = "bin/assets.pack";
+const int FONT_SIZES[] = {50, 100, 25};
+
+/**
+ * The assets the game loads at startup and on its first frames,
+ * in the order it loads them. The font is opened once per size.
+ */
+const char *const STARTUP_ASSETS[] = {
+    "assets/default_tank_sound.wav", "assets/death.wav",
+    "assets/font.ttf",               "assets/tank.png",
+    "assets/gravity_tank.png",       "assets/sniper_tank.png",
+    "assets/gatling_tank.png",       "assets/destroyed_tank.png",
+};
+
+typedef struct {
+  double total_ms;
+  double min_ms;
+  size_t loaded;
+} timing_t;
+
+/**
+ * Decodes one asset the way the game does: images into surfaces,
+ * sounds into samples and fonts at each size.
+ * Returns how many objects were created.
+ */
+size_t load_asset(const char *path) {
+  size_t length = strlen(path);
+  const char *extension = length > 4 ? path + length - 4 : path;
+  size_t loaded = 0;
+  if (strcmp(extension, ".png") == 0) {
+    SDL_Surface *surface = IMG_Load_RW(asset_open(path), 1);
+    if (surface != NULL) {
+      SDL_FreeSurface(surface);
+      loaded++;
+    }
+  } else if (strcmp(extension, ".wav") == 0) {
+    SDL_AudioSpec spec;
+    Uint8 *buffer;
+    Uint32 buffer_length;
+    if (SDL_LoadWAV_RW(asset_open(path), 1, &spec, &buffer, &buffer_length) !=
+        NULL) {
+      SDL_FreeWAV(buffer);
+      loaded++;
+    }
+  } else if (strcmp(extension, ".ttf") == 0) {
+    for (size_t i = 0; i < sizeof(FONT_SIZES) / sizeof(FONT_SIZES[0]); i++) {
+      TTF_Font *font = TTF_OpenFontRW(asset_open(path), 1, FONT_SIZES[i]);
+      if (font != NULL) {
+        TTF_CloseFont(font);
+        loaded++;
+      }
+    }
+  }
+  return loaded;
+}
+
+double elapsed_ms(uint64_t start, uint64_t end) {
+  return (double)(end - start) * 1e3 / SDL_GetPerformanceFrequency();
+}
+
+/**
+ * Times loading every startup asset, either from loose files or
+ * from the archive (including mapping and unmapping it).
+ */
+timing_t time_startup(int iterations, const char *pack_path) {
+  timing_t timing = {.total_ms = 0.0, .min_ms = INFINITY, .loaded = 0};
+  size_t asset_count = sizeof(STARTUP_ASSETS) / sizeof(STARTUP_ASSETS[0]);
+  // One untimed run first, so both sides start with a warm page cache
+  for (int i = -1; i < iterations; i++) {
+    uint64_t start = SDL_GetPerformanceCounter();
+    if (pack_path != NULL) {
+      bool mounted = asset_pack_mount(pack_path);
+      assert(mounted);
+    }
+    size_t loaded = 0;
+    for (size_t j = 0; j < asset_count; j++) {
+      loaded += load_asset(STARTUP_ASSETS[j]);
+    }
+    asset_pack_unmount();
+    double ms = elapsed_ms(start, SDL_GetPerformanceCounter());
+    if (i >= 0) {
+      timing.total_ms += ms;
+      timing.min_ms = ms < timing.min_ms ? ms : timing.min_ms;
+      timing.loaded = loaded;
+    }
+  }
+  return timing;
+}
+
+/**
+ * Compares loading the game's startup assets from loose files in assets/
+ * against loading them from a packed archive.
+ *
+ * Usage: bin/asset_bench [iterations] [archive]
+ * Build the archive first with 'make bin/assets.pack'.
+ */
+int main(int argc, char *argv[]) {
+  int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+  assert(iterations > 0);
+  const char *pack_path = argc > 2 ? argv[2] : DEFAULT_PACK_PATH;
+
+  SDL_Init(0);
+  TTF_Init();
+  asset_pack_t *pack = asset_pack_open(pack_path);
+  if (pack == NULL) {
+    fprintf(stderr, "asset_bench: could not open %s\n", pack_path);
+    return 1;
+  }
+  asset_pack_close(pack);
+
+  timing_t loose = time_startup(iterations, NULL);
+  timing_t packed = time_startup(iterations, pack_path);
+  if (loose.loaded != packed.loaded) {
+    fprintf(stderr, "asset_bench: loaded %zu assets loose but %zu packed\n",
+            loose.loaded, packed.loaded);
+    return 1;
+  }
+
+  printf("asset_bench: %d startups, %zu assets each\n", iterations,
+         loose.loaded);
+  printf("  loose  mean %.3f ms, min %.3f ms\n", loose.total_ms / iterations,
+         loose.min_ms);
+  printf("  packed mean %.3f ms, min %.3f ms\n", packed.total_ms / iterations,
+         packed.min_ms);
+  TTF_Quit();
+  SDL_Quit();
+  return 0;
+}
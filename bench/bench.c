@@ -0,0 +1,971 @@
+#include "alloc_track.h"
+#include "arena.h"
+#include "bench_stats.h"
+#include "body.h"
+#include "collision.h"
+#include "forces.h"
+#include "gjk.h"
+#include "list.h"
+#include "map.h"
+#include "polygon.h"
+#include "profiler.h"
+#include "scene.h"
+#include "star.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+// types of different bodies (the library expects these from the program)
+const size_t WALL_TYPE = 0;
+const size_t BULLET_TYPE = 1;
+const size_t SNIPER_BULLET_TYPE = 10;
+const size_t GRAVITY_BULLET_TYPE = 13;
+const size_t GATLING_BULLET_TYPE = 11;
+const size_t DEFAULT_TANK_TYPE = 2;
+const size_t GRAVITY_TANK_TYPE = 3;
+const size_t SNIPER_TANK_TYPE = 4;
+const size_t HEALTH_BAR_TYPE = 6;
+const size_t GATLING_TANK_TYPE = 7;
+
+const double BULLET_DAMAGE = 10.0;
+const double GRAVITY_BULLET_DAMAGE = 15.0;
+const double SNIPER_BULLET_DAMAGE = 25.0;
+const double GATLING_BULLET_DAMAGE = 5.0;
+
+const double MAX_WIDTH_GAME = 1600.0;
+const double MAX_HEIGHT_GAME = 1300.0;
+
+// benchmark settings
+/** Every scenario is set up from this seed, so runs are comparable */
+const unsigned BENCH_SEED = 39;
+const size_t DEFAULT_SAMPLES = 10;
+const double TICK_DT = 1.0 / 60.0;
+const char DEFAULT_JSON_PATH[] = "bin/bench.json";
+/** Saved results go in BASELINE_DIR/<fingerprint>/<commit>.json */
+const char BASELINE_DIR[] = "bench/baselines";
+const char LATEST_BASELINE[] = "latest";
+/** The default slowdown, in percent, that fails a comparison */
+const double DEFAULT_THRESHOLD = 5.0;
+#define PATH_LENGTH 256
+#define MACHINE_LENGTH 256
+
+// nbodies: stars pulling on each other, as in demo/nbodies.c
+/** Each star pulls on the next this many stars, so the force count grows
+ * linearly and 10,000 stars still fit in memory */
+const size_t NBODIES_NEIGHBORS = 32;
+const double NBODIES_WIDTH = 1000.0;
+const double NBODIES_HEIGHT = 500.0;
+const double NBODIES_GRAVITY = 500.0;
+const size_t NBODIES_TYPE = 100;
+
+// bullet storm: two gatling tanks firing nonstop over the game's map
+const double TANK_SIDE_LENGTH = 60.0;
+const double TANK_MASS = 1000.0;
+const double TANK_MAX_HEALTH = 80.0;
+const double TANK_ROTATION_SPEED = 0.5;
+const double TANK_ELASTICITY = 20.0;
+const double BULLET_MASS = 5.0;
+const double BULLET_LENGTH = 25.0;
+const double BULLET_WIDTH = 10.0;
+const double BULLET_VELOCITY = 400.0;
+const double BULLET_LIFETIME = 3.0;
+const double FIRE_INTERVAL = 0.05;
+/** Seconds the storm runs before it is measured, to reach steady state */
+const double STORM_WARMUP = 3.0;
+/** How far apart the rays cast across the storm are, in radians */
+const double RAY_ANGLE_STEP = 0.1;
+
+// pegs: balls dropped onto a grid of pegs, as in demo/pegs.c
+const size_t PEG_ROWS = 11;
+const double PEG_ROW_SPACING = 3.6;
+const double PEG_COL_SPACING = 3.5;
+const double PEG_RADIUS = 0.5;
+const double BALL_RADIUS = 1.0;
+const double BALL_MASS = 2.0;
+const double PEG_ELASTICITY = 0.3;
+const double BALL_ELASTICITY = 0.7;
+const double PEGS_WIDTH = 80.0;
+const double PEGS_HEIGHT = 80.0;
+const size_t PEGS_BALLS = 60;
+const size_t CIRCLE_POINTS = 20;
+// As many vertices as the game's hearts have
+const size_t HEART_POINTS = 39;
+/** A body this heavy, this far below, pulls like the earth does */
+const double EARTH_MASS = 6e24;
+const double EARTH_DISTANCE = 6.38e6;
+const double GRAVITATIONAL_CONSTANT = 6.67e-11;
+
+// kernels
+const size_t KERNEL_POINTS = 40;
+
+/** Results that would otherwise be unused go here, so they are computed */
+volatile double bench_sink;
+
+/**
+ * A benchmark: a scenario that is set up once, then run one op at a time.
+ */
+typedef struct {
+  const char *name;
+  /** What one op is, e.g. "tick" */
+  const char *unit;
+  /** Ops per timed sample */
+  size_t ops;
+  /** Passed to setup, e.g. the number of bodies */
+  size_t size;
+  void *(*setup)(size_t size);
+  void (*run)(void *context);
+  void (*teardown)(void *context);
+} bench_t;
+
+/**
+ * What a benchmark measured.
+ */
+typedef struct {
+  double ns_per_op[BENCH_MAX_SAMPLES];
+  bench_summary_t summary;
+  /** Heap allocations per op, or NAN unless built with ALLOC_TRACK */
+  double allocs_per_op;
+} bench_result_t;
+
+size_t *make_type(size_t type) {
+  size_t *info = malloc(sizeof(size_t));
+  assert(info != NULL);
+  *info = type;
+  return info;
+}
+
+/** Makes a regular polygon, counterclockwise */
+list_t *make_circle(vector_t center, double radius, size_t points) {
+  list_t *shape = list_init(points, free);
+  for (size_t i = 0; i < points; i++) {
+    double angle = 2 * M_PI * i / points;
+    vector_t *point = malloc(sizeof(vector_t));
+    assert(point != NULL);
+    *point = vec_add(center, (vector_t){radius * cos(angle),
+                                        radius * sin(angle)});
+    list_add(shape, point);
+  }
+  return shape;
+}
+
+void scene_teardown(void *scene) { scene_free(scene); }
+
+void scene_run(void *scene) { scene_tick(scene, TICK_DT); }
+
+void *nbodies_setup(size_t stars) {
+  scene_t *scene = scene_init();
+  for (size_t i = 0; i < stars; i++) {
+    vector_t center = {rand_num(0.0, NBODIES_WIDTH),
+                       rand_num(0.0, NBODIES_HEIGHT)};
+    list_t *star = make_star(center, rand_num(10.0, 30.0), 4);
+    rgb_color_t color = {rand_num(0.0, 1.0), rand_num(0.0, 1.0),
+                         rand_num(0.0, 1.0)};
+    scene_add_body(scene,
+                   body_init_with_info(star, rand_num(5.0, 20.0), color,
+                                       make_type(NBODIES_TYPE), free));
+  }
+  for (size_t i = 0; i < stars; i++) {
+    for (size_t j = 1; j <= NBODIES_NEIGHBORS && j < stars; j++) {
+      create_newtonian_gravity(scene, NBODIES_GRAVITY,
+                               scene_get_body(scene, i),
+                               scene_get_body(scene, (i + j) % stars));
+    }
+  }
+  return scene;
+}
+
+/**
+ * The bullet storm's state: the scene, whose first two bodies are the tanks,
+ * and the time until they next fire.
+ */
+typedef struct {
+  scene_t *scene;
+  double until_fire;
+  /** The direction of the next ray cast by storm_raycast_run() */
+  double ray_angle;
+} storm_t;
+
+void fire_bullet(scene_t *scene, body_t *tank, rgb_color_t color) {
+  double rotation = body_get_rotation(tank);
+  vector_t direction = {cos(rotation), sin(rotation)};
+  vector_t back = vec_add(body_get_centroid(tank),
+                          vec_multiply(TANK_SIDE_LENGTH / 2 + 10, direction));
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {{0, -BULLET_WIDTH / 2},
+                        {BULLET_LENGTH, -BULLET_WIDTH / 2},
+                        {BULLET_LENGTH, BULLET_WIDTH / 2},
+                        {0, BULLET_WIDTH / 2}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *corner = malloc(sizeof(vector_t));
+    assert(corner != NULL);
+    *corner = vec_add(back, corners[i]);
+    list_add(shape, corner);
+  }
+  polygon_rotate(shape, rotation, back);
+  body_t *bullet = body_init_with_info(shape, BULLET_MASS, color,
+                                       make_type(GATLING_BULLET_TYPE), free);
+  body_set_rotation_empty(bullet, rotation);
+  body_set_velocity(bullet, vec_multiply(BULLET_VELOCITY, direction));
+  body_set_time(bullet, 0.0);
+  scene_add_body(scene, bullet);
+
+  for (size_t i = 2; i < scene_bodies(scene) - 1; i++) {
+    body_t *body = scene_get_body(scene, i);
+    size_t type = *(size_t *)body_get_info(body);
+    if (type == RECTANGLE_OBSTACLE_TYPE || type == TRIANGLE_OBSTACLE_TYPE) {
+      create_physics_collision(scene, 1.0, bullet, body);
+    }
+  }
+}
+
+void storm_run(void *context) {
+  storm_t *storm = context;
+  scene_t *scene = storm->scene;
+  storm->until_fire -= TICK_DT;
+  if (storm->until_fire <= 0) {
+    fire_bullet(scene, scene_get_body(scene, 0), (rgb_color_t){1, 0, 0});
+    fire_bullet(scene, scene_get_body(scene, 1), (rgb_color_t){0, 1, 0});
+    storm->until_fire += FIRE_INTERVAL;
+  }
+  for (size_t i = 2; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    if (*(size_t *)body_get_info(body) == GATLING_BULLET_TYPE) {
+      body_set_time(body, body_get_time(body) + TICK_DT);
+      if (body_get_time(body) > BULLET_LIFETIME) {
+        body_remove(body);
+      }
+    }
+  }
+  scene_tick(scene, TICK_DT);
+}
+
+/** Sets up a bullet storm whose scene uses a broad phase of the given kind */
+void *storm_setup(size_t broad_phase) {
+  storm_t *storm = malloc(sizeof(storm_t));
+  assert(storm != NULL);
+  scene_t *scene = scene_init();
+  scene_set_broad_phase(scene, broad_phase);
+  vector_t starts[] = {{MAX_WIDTH_GAME / 6, MAX_HEIGHT_GAME - 400.0},
+                       {MAX_WIDTH_GAME * 5 / 6, MAX_HEIGHT_GAME / 2 - 50.0}};
+  for (size_t i = 0; i < 2; i++) {
+    body_t *tank = init_gatling_tank(
+        starts[i], TANK_SIDE_LENGTH, VEC_ZERO, TANK_MASS,
+        (rgb_color_t){i == 0, i == 1, 0}, TANK_MAX_HEALTH, GATLING_TANK_TYPE);
+    // the tanks sweep their fire around the map
+    body_set_rotation_speed(tank, i == 0 ? TANK_ROTATION_SPEED
+                                         : -TANK_ROTATION_SPEED);
+    scene_add_body(scene, tank);
+  }
+  map_init(scene);
+  for (size_t i = 2; i < scene_bodies(scene); i++) {
+    for (size_t j = 0; j < 2; j++) {
+      create_physics_collision(scene, TANK_ELASTICITY, scene_get_body(scene, j),
+                               scene_get_body(scene, i));
+    }
+  }
+  storm->scene = scene;
+  storm->until_fire = 0.0;
+  storm->ray_angle = 0.0;
+  for (double time = 0.0; time < STORM_WARMUP; time += TICK_DT) {
+    storm_run(storm);
+  }
+  return storm;
+}
+
+/** Casts a ray across the map from the first tank, as the game's AI does */
+void storm_raycast_run(void *context) {
+  storm_t *storm = context;
+  vector_t origin = body_get_centroid(scene_get_body(storm->scene, 0));
+  vector_t direction = {cos(storm->ray_angle), sin(storm->ray_angle)};
+  vector_t end = vec_add(origin, vec_multiply(MAX_WIDTH_GAME, direction));
+  storm->ray_angle += RAY_ANGLE_STEP;
+  raycast_hit_t hit;
+  bench_sink = scene_raycast(storm->scene, origin, end, QUERY_FIRST_HIT, NULL,
+                             NULL, &hit, 1);
+}
+
+void storm_teardown(void *context) {
+  storm_t *storm = context;
+  scene_free(storm->scene);
+  free(storm);
+}
+
+/**
+ * Builds the pegs demo's board with a pile of balls, with the balls and
+ * pegs colliding as circles if round, otherwise as their polygons.
+ */
+scene_t *pegs_scene(size_t balls, bool round) {
+  scene_t *scene = scene_init();
+  rgb_color_t peg_color = {0, 1, 0}, ball_color = {1, 0, 0};
+  size_t pegs = 0;
+  for (size_t row = 0; row < PEG_ROWS; row++) {
+    double y = PEGS_HEIGHT - (row + 2) * PEG_ROW_SPACING;
+    for (size_t col = 0; col <= row; col++) {
+      vector_t center = {PEGS_WIDTH / 2 + (col - row / 2.0) * PEG_COL_SPACING,
+                         y};
+      body_t *peg =
+          body_init_with_info(make_circle(center, PEG_RADIUS, CIRCLE_POINTS),
+                              INFINITY, peg_color, make_type(WALL_TYPE), free);
+      if (round) {
+        body_set_circle(peg, PEG_RADIUS);
+      }
+      scene_add_body(scene, peg);
+      pegs++;
+    }
+  }
+  list_t *earth_shape =
+      make_circle((vector_t){PEGS_WIDTH / 2, -EARTH_DISTANCE}, 1.0, 4);
+  body_t *earth = body_init_with_info(earth_shape, EARTH_MASS, peg_color,
+                                      make_type(WALL_TYPE), free);
+  scene_add_body(scene, earth);
+  list_t *floor_shape = list_init(4, free);
+  vector_t corners[] = {
+      {0, 0}, {PEGS_WIDTH, 0}, {PEGS_WIDTH, 1.0}, {0, 1.0}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *corner = malloc(sizeof(vector_t));
+    assert(corner != NULL);
+    *corner = corners[i];
+    list_add(floor_shape, corner);
+  }
+  body_t *floor = body_init_with_info(floor_shape, INFINITY, peg_color,
+                                      make_type(WALL_TYPE), free);
+  scene_add_body(scene, floor);
+
+  // the balls start in a loose column above the top peg, and pile up on
+  // the floor
+  for (size_t i = 0; i < balls; i++) {
+    vector_t center = {PEGS_WIDTH / 2 + rand_num(-8.0, 8.0),
+                       PEGS_HEIGHT + 3 * BALL_RADIUS * i / 4.0};
+    body_t *ball = body_init_with_info(
+        make_circle(center, BALL_RADIUS, CIRCLE_POINTS), BALL_MASS, ball_color,
+        make_type(WALL_TYPE), free);
+    if (round) {
+      body_set_circle(ball, BALL_RADIUS);
+    }
+    scene_add_body(scene, ball);
+    create_newtonian_gravity(scene, GRAVITATIONAL_CONSTANT, ball, earth);
+    create_physics_collision(scene, PEG_ELASTICITY, ball, floor);
+    for (size_t j = 0; j < pegs; j++) {
+      create_physics_collision(scene, PEG_ELASTICITY, ball,
+                               scene_get_body(scene, j));
+    }
+    // the earth and floor come between the pegs and the balls
+    for (size_t j = pegs + 2; j < scene_bodies(scene) - 1; j++) {
+      create_physics_collision(scene, BALL_ELASTICITY, ball,
+                               scene_get_body(scene, j));
+    }
+  }
+  return scene;
+}
+
+void *pegs_setup(size_t balls) { return pegs_scene(balls, false); }
+
+void *pegs_round_setup(size_t balls) { return pegs_scene(balls, true); }
+
+void *pegs_sat_setup(size_t balls) {
+  scene_t *scene = pegs_scene(balls, false);
+  scene_set_narrow_phase(scene, NARROW_PHASE_SAT);
+  return scene;
+}
+
+void *pegs_gjk_setup(size_t balls) {
+  scene_t *scene = pegs_scene(balls, false);
+  scene_set_narrow_phase(scene, NARROW_PHASE_GJK);
+  return scene;
+}
+
+/** Two shapes for the SAT micro-cases, and the arena it works in */
+typedef struct {
+  arena_t *arena;
+  list_t *shape1;
+  list_t *shape2;
+  /** The shapes' edge normals, and the axis that last separated them */
+  vector_t *normals1;
+  vector_t *normals2;
+  size_t separating_axis;
+} sat_case_t;
+
+sat_case_t *sat_case_init(list_t *shape1, list_t *shape2) {
+  sat_case_t *sat = malloc(sizeof(sat_case_t));
+  assert(sat != NULL);
+  sat->arena = arena_init(4096);
+  sat->shape1 = shape1;
+  sat->shape2 = shape2;
+  sat->normals1 = malloc(list_size(shape1) * sizeof(vector_t));
+  sat->normals2 = malloc(list_size(shape2) * sizeof(vector_t));
+  assert(sat->normals1 != NULL && sat->normals2 != NULL);
+  find_perp_axis(shape1, sat->normals1);
+  find_perp_axis(shape2, sat->normals2);
+  sat->separating_axis = 0;
+  return sat;
+}
+
+void *sat_overlap_setup(size_t points) {
+  return sat_case_init(make_circle(VEC_ZERO, 1.0, points),
+                       make_circle((vector_t){1.5, 0.2}, 1.0, points));
+}
+
+void *sat_separated_setup(size_t points) {
+  return sat_case_init(make_circle(VEC_ZERO, 1.0, points),
+                       make_circle((vector_t){3.0, 0.2}, 1.0, points));
+}
+
+void sat_run(void *context) {
+  sat_case_t *sat = context;
+  collision_info_t info =
+      find_collision_arena(sat->arena, sat->shape1, sat->shape2);
+  bench_sink = info.collided;
+}
+
+/** The test a collision force creator runs, with cached normals and axis */
+void sat_cached_run(void *context) {
+  sat_case_t *sat = context;
+  collision_info_t info =
+      find_collision_cached(sat->shape1, sat->normals1, sat->shape2,
+                            sat->normals2, &sat->separating_axis);
+  bench_sink = info.collided;
+}
+
+/** GJK and EPA on the same shapes, which also finds the depth and points */
+void gjk_run(void *context) {
+  sat_case_t *sat = context;
+  bench_sink = find_penetration(sat->shape1, sat->shape2).depth;
+}
+
+void sat_teardown(void *context) {
+  sat_case_t *sat = context;
+  free(sat->normals1);
+  free(sat->normals2);
+  list_free(sat->shape1);
+  list_free(sat->shape2);
+  arena_free(sat->arena);
+  free(sat);
+}
+
+/** Shapes for the circle and capsule micro-cases */
+typedef struct {
+  capsule_t capsule1;
+  capsule_t capsule2;
+  list_t *polygon;
+} round_case_t;
+
+void *round_setup(size_t points) {
+  round_case_t *round = malloc(sizeof(round_case_t));
+  assert(round != NULL);
+  round->capsule1 = (capsule_t){VEC_ZERO, VEC_ZERO, 1.0};
+  round->capsule2 = (capsule_t){{1.5, 0.2}, {1.5, 0.2}, 1.0};
+  round->polygon = make_circle((vector_t){1.5, 0.2}, 1.0, points);
+  return round;
+}
+
+void circles_run(void *context) {
+  round_case_t *round = context;
+  bench_sink = find_collision_capsules(round->capsule1, round->capsule2)
+                   .collided;
+}
+
+/** A capsule like a game bullet's, against the polygon */
+void capsule_polygon_run(void *context) {
+  round_case_t *round = context;
+  capsule_t bullet = {{-1.2, 0}, {0.3, 0}, 0.5};
+  bench_sink =
+      find_collision_capsule_polygon(bullet, round->polygon).collided;
+}
+
+void round_teardown(void *context) {
+  round_case_t *round = context;
+  list_free(round->polygon);
+  free(round);
+}
+
+/** Two boxes overlapping like sat_overlap_quads' squares, turned by degrees */
+void *boxes_setup(size_t degrees) {
+  obb_t *boxes = malloc(2 * sizeof(obb_t));
+  assert(boxes != NULL);
+  double angle = degrees * M_PI / 180;
+  boxes[0] = (obb_t){VEC_ZERO, {cos(angle), sin(angle)}, {1.0, 1.0}};
+  boxes[1] = (obb_t){{1.5, 0.2}, {1, 0}, {1.0, 1.0}};
+  return boxes;
+}
+
+void boxes_run(void *context) {
+  obb_t *boxes = context;
+  bench_sink = find_collision_boxes(boxes[0], boxes[1]).collided;
+}
+
+void *kernel_setup(size_t points) {
+  return make_circle((vector_t){10.0, 20.0}, 5.0, points);
+}
+
+void kernel_teardown(void *shape) { list_free(shape); }
+
+void rotate_run(void *shape) {
+  polygon_rotate(shape, 0.01, (vector_t){10.0, 20.0});
+}
+
+void translate_run(void *shape) {
+  // back and forth, so the shape stays put over many ops
+  static double direction = 1.0;
+  polygon_translate(shape, (vector_t){direction, -direction});
+  direction = -direction;
+}
+
+void centroid_run(void *shape) {
+  bench_sink = polygon_centroid(shape).x;
+}
+
+const bench_t BENCHES[] = {
+    {"nbodies_100", "tick", 50, 100, nbodies_setup, scene_run, scene_teardown},
+    {"nbodies_1000", "tick", 10, 1000, nbodies_setup, scene_run,
+     scene_teardown},
+    {"nbodies_10000", "tick", 2, 10000, nbodies_setup, scene_run,
+     scene_teardown},
+    {"bullet_storm", "tick", 30, BROAD_PHASE_NONE, storm_setup, storm_run,
+     storm_teardown},
+    {"bullet_storm_sap", "tick", 30, BROAD_PHASE_SWEEP_AND_PRUNE, storm_setup,
+     storm_run, storm_teardown},
+    {"bullet_storm_tree", "tick", 30, BROAD_PHASE_AABB_TREE, storm_setup,
+     storm_run, storm_teardown},
+    {"storm_raycast", "ray", 1000, BROAD_PHASE_AABB_TREE, storm_setup,
+     storm_raycast_run, storm_teardown},
+    {"pegs_pile", "tick", 10, PEGS_BALLS, pegs_setup, scene_run,
+     scene_teardown},
+    {"pegs_pile_round", "tick", 10, PEGS_BALLS, pegs_round_setup, scene_run,
+     scene_teardown},
+    {"pegs_pile_sat", "tick", 10, PEGS_BALLS, pegs_sat_setup, scene_run,
+     scene_teardown},
+    {"pegs_pile_gjk", "tick", 10, PEGS_BALLS, pegs_gjk_setup, scene_run,
+     scene_teardown},
+    {"sat_overlap_quads", "test", 100000, 4, sat_overlap_setup, sat_run,
+     sat_teardown},
+    {"sat_separated_quads", "test", 100000, 4, sat_separated_setup, sat_run,
+     sat_teardown},
+    {"sat_overlap_circles", "test", 10000, CIRCLE_POINTS, sat_overlap_setup,
+     sat_run, sat_teardown},
+    {"sat_cached_overlap", "test", 10000, CIRCLE_POINTS, sat_overlap_setup,
+     sat_cached_run, sat_teardown},
+    {"sat_cached_separated", "test", 100000, CIRCLE_POINTS, sat_separated_setup,
+     sat_cached_run, sat_teardown},
+    {"sat_overlap_octagons", "test", 100000, 8, sat_overlap_setup, sat_run,
+     sat_teardown},
+    {"sat_overlap_hearts", "test", 10000, HEART_POINTS, sat_overlap_setup,
+     sat_run, sat_teardown},
+    {"gjk_overlap_quads", "test", 100000, 4, sat_overlap_setup, gjk_run,
+     sat_teardown},
+    {"gjk_separated_quads", "test", 100000, 4, sat_separated_setup, gjk_run,
+     sat_teardown},
+    {"gjk_overlap_octagons", "test", 100000, 8, sat_overlap_setup, gjk_run,
+     sat_teardown},
+    {"gjk_overlap_circles", "test", 10000, CIRCLE_POINTS, sat_overlap_setup,
+     gjk_run, sat_teardown},
+    {"gjk_separated_circles", "test", 100000, CIRCLE_POINTS,
+     sat_separated_setup, gjk_run, sat_teardown},
+    {"gjk_overlap_hearts", "test", 10000, HEART_POINTS, sat_overlap_setup,
+     gjk_run, sat_teardown},
+    {"aabb_overlap_aabb", "test", 100000, 0, boxes_setup, boxes_run, free},
+    {"obb_overlap_aabb", "test", 100000, 30, boxes_setup, boxes_run, free},
+    {"circle_overlap_circle", "test", 100000, CIRCLE_POINTS, round_setup,
+     circles_run, round_teardown},
+    {"capsule_overlap_circles", "test", 10000, CIRCLE_POINTS, round_setup,
+     capsule_polygon_run, round_teardown},
+    {"polygon_rotate", "call", 100000, KERNEL_POINTS, kernel_setup, rotate_run,
+     kernel_teardown},
+    {"polygon_translate", "call", 100000, KERNEL_POINTS, kernel_setup,
+     translate_run, kernel_teardown},
+    {"polygon_centroid", "call", 100000, KERNEL_POINTS, kernel_setup,
+     centroid_run, kernel_teardown},
+};
+
+/** Counts every heap allocation so far, or returns 0 without ALLOC_TRACK */
+size_t allocations(void) {
+  size_t total = 0;
+#ifdef ALLOC_TRACK
+  for (alloc_tag_t tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+    total += alloc_track_stats(tag).total_count;
+  }
+#endif
+  return total;
+}
+
+/**
+ * Sets up a benchmark and times samples of its ops, after one untimed
+ * sample to warm the caches up.
+ */
+bench_result_t run_bench(const bench_t *bench, size_t samples) {
+  srand(BENCH_SEED);
+  void *context = bench->setup(bench->size);
+  for (size_t i = 0; i < bench->ops; i++) {
+    bench->run(context);
+  }
+
+  bench_result_t result;
+  size_t allocations_before = allocations();
+  for (size_t sample = 0; sample < samples; sample++) {
+    uint64_t start = profile_now_ns();
+    for (size_t i = 0; i < bench->ops; i++) {
+      bench->run(context);
+    }
+    uint64_t end = profile_now_ns();
+    result.ns_per_op[sample] = (double)(end - start) / bench->ops;
+  }
+  size_t ops = samples * bench->ops;
+#ifdef ALLOC_TRACK
+  result.allocs_per_op = (double)(allocations() - allocations_before) / ops;
+#else
+  (void)allocations_before;
+  (void)ops;
+  result.allocs_per_op = NAN;
+#endif
+  bench->teardown(context);
+  result.summary = bench_summarize(result.ns_per_op, samples);
+  return result;
+}
+
+/** Returns whether a benchmark was asked for by name (or by a prefix) */
+bool selected(const bench_t *bench, char **filters, size_t filter_count) {
+  if (filter_count == 0) {
+    return true;
+  }
+  for (size_t i = 0; i < filter_count; i++) {
+    if (strncmp(bench->name, filters[i], strlen(filters[i])) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Runs a shell command and copies the first line it prints,
+ * or "unknown" if it prints nothing.
+ */
+void read_command(const char *command, char *line, size_t size) {
+  strncpy(line, "unknown", size);
+  FILE *output = popen(command, "r");
+  if (output == NULL) {
+    return;
+  }
+  if (fgets(line, size, output) != NULL) {
+    line[strcspn(line, "\n")] = '\0';
+  }
+  pclose(output);
+  if (line[0] == '\0') {
+    strncpy(line, "unknown", size);
+  }
+}
+
+/**
+ * Describes the machine and build the benchmarks ran on: the OS, CPU,
+ * compiler and instrumentation, all of which change the timings.
+ */
+void describe_machine(char *machine, size_t size) {
+  struct utsname system;
+  uname(&system);
+  char cpu[MACHINE_LENGTH] = "unknown cpu";
+  FILE *cpuinfo = fopen("/proc/cpuinfo", "r");
+  if (cpuinfo != NULL) {
+    char line[MACHINE_LENGTH];
+    while (fgets(line, sizeof(line), cpuinfo) != NULL) {
+      char *value = strchr(line, ':');
+      if (strncmp(line, "model name", strlen("model name")) == 0 &&
+          value != NULL) {
+        strncpy(cpu, value + 2, sizeof(cpu) - 1);
+        cpu[strcspn(cpu, "\n")] = '\0';
+        break;
+      }
+    }
+    fclose(cpuinfo);
+  }
+  const char *build = "";
+#if defined(__SANITIZE_ADDRESS__)
+  build = " asan";
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+  build = " asan";
+#endif
+#endif
+#ifdef __OPTIMIZE__
+  const char *optimized = " optimized";
+#else
+  const char *optimized = "";
+#endif
+#ifdef ALLOC_TRACK
+  const char *tracked = " alloc_track";
+#else
+  const char *tracked = "";
+#endif
+  snprintf(machine, size, "%s %s, %s, %ld cpus, %s%s%s%s", system.sysname,
+           system.machine, cpu, sysconf(_SC_NPROCESSORS_ONLN), __VERSION__,
+           build, optimized, tracked);
+  // keep the description safe to put in a JSON string
+  for (char *c = machine; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') {
+      *c = ' ';
+    }
+  }
+}
+
+/** Hashes a machine description into a short fingerprint (64-bit FNV-1a) */
+void fingerprint_machine(const char *machine, char *fingerprint) {
+  uint64_t hash = 14695981039346656037ull;
+  for (const char *c = machine; *c != '\0'; c++) {
+    hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+  }
+  snprintf(fingerprint, BENCH_NAME_LENGTH, "%016llx",
+           (unsigned long long)hash);
+}
+
+void write_json_number(FILE *out, double value) {
+  if (isnan(value)) {
+    fputs("null", out);
+  } else {
+    fprintf(out, "%.3f", value);
+  }
+}
+
+/**
+ * What one run of bin/bench measured, and where.
+ */
+typedef struct {
+  char commit[BENCH_NAME_LENGTH];
+  char machine[MACHINE_LENGTH];
+  char fingerprint[BENCH_NAME_LENGTH];
+  size_t samples;
+  const bench_t *benches[sizeof(BENCHES) / sizeof(BENCHES[0])];
+  bench_result_t results[sizeof(BENCHES) / sizeof(BENCHES[0])];
+  size_t count;
+} bench_run_t;
+
+/** Writes a run's results as JSON; returns whether that worked */
+bool write_results(const char *path, const bench_run_t *run) {
+  FILE *out = fopen(path, "w");
+  if (out == NULL) {
+    perror(path);
+    return false;
+  }
+#ifdef ALLOC_TRACK
+  bool counted = true;
+#else
+  bool counted = false;
+#endif
+  fprintf(out, "{\n  \"commit\": \"%s\",\n", run->commit);
+  fprintf(out, "  \"machine\": \"%s\",\n", run->machine);
+  fprintf(out, "  \"fingerprint\": \"%s\",\n", run->fingerprint);
+  fprintf(out, "  \"seed\": %u,\n  \"samples\": %zu,\n", BENCH_SEED,
+          run->samples);
+  fprintf(out, "  \"allocs_counted\": %s,\n  \"benchmarks\": [\n",
+          counted ? "true" : "false");
+  for (size_t i = 0; i < run->count; i++) {
+    const bench_t *bench = run->benches[i];
+    const bench_result_t *result = &run->results[i];
+    fprintf(out,
+            "    {\"name\": \"%s\", \"unit\": \"%s\", \"size\": %zu, "
+            "\"ops_per_sample\": %zu,\n",
+            bench->name, bench->unit, bench->size, bench->ops);
+    fputs("     \"ns_per_op\": ", out);
+    write_json_number(out, result->summary.mean);
+    fputs(", \"stddev\": ", out);
+    write_json_number(out, result->summary.stddev);
+    fputs(", \"ops_per_sec\": ", out);
+    write_json_number(out, 1e9 / result->summary.mean);
+    fputs(", \"allocs_per_op\": ", out);
+    write_json_number(out, result->allocs_per_op);
+    fputs(",\n     \"samples\": [", out);
+    for (size_t j = 0; j < result->summary.count; j++) {
+      fputs(j > 0 ? ", " : "", out);
+      write_json_number(out, result->ns_per_op[j]);
+    }
+    fprintf(out, "]}%s\n", i + 1 < run->count ? "," : "");
+  }
+  fputs("  ]\n}\n", out);
+  return fclose(out) == 0;
+}
+
+/**
+ * Saves a run as the baseline for its commit, and as the latest baseline,
+ * on its machine.
+ */
+bool save_baseline(const bench_run_t *run) {
+  char path[PATH_LENGTH];
+  mkdir(BASELINE_DIR, 0755);
+  snprintf(path, sizeof(path), "%s/%s", BASELINE_DIR, run->fingerprint);
+  mkdir(path, 0755);
+  const char *names[] = {run->commit, LATEST_BASELINE};
+  for (size_t i = 0; i < 2; i++) {
+    snprintf(path, sizeof(path), "%s/%s/%s.json", BASELINE_DIR,
+             run->fingerprint, names[i]);
+    if (!write_results(path, run)) {
+      return false;
+    }
+    printf("saved %s\n", path);
+  }
+  return true;
+}
+
+/**
+ * Compares a run against a baseline: either a results file, or a commit
+ * (or "latest") saved on this machine. Prints each benchmark's change with
+ * its confidence interval and returns how many regressed, or -1 if the
+ * baseline could not be read.
+ */
+int compare_with_baseline(const bench_run_t *run, const char *reference,
+                          double threshold) {
+  char path[PATH_LENGTH];
+  struct stat file_info;
+  if (stat(reference, &file_info) == 0) {
+    snprintf(path, sizeof(path), "%s", reference);
+  } else {
+    snprintf(path, sizeof(path), "%s/%s/%s.json", BASELINE_DIR,
+             run->fingerprint, reference);
+  }
+  bench_record_t *records =
+      malloc(sizeof(bench_record_t) * (sizeof(BENCHES) / sizeof(BENCHES[0])));
+  assert(records != NULL);
+  char fingerprint[BENCH_NAME_LENGTH];
+  int record_count = bench_read_results(
+      path, records, sizeof(BENCHES) / sizeof(BENCHES[0]), fingerprint);
+  if (record_count < 0) {
+    fprintf(stderr, "bench: could not read baseline %s\n", path);
+    free(records);
+    return -1;
+  }
+  if (strcmp(fingerprint, run->fingerprint) != 0) {
+    fprintf(stderr,
+            "bench: warning: %s was recorded on another machine or build "
+            "(%s, not %s)\n",
+            path, fingerprint, run->fingerprint);
+  }
+
+  printf("\ncompared with %s, failing slowdowns over %.1f%%\n", path,
+         threshold * 100);
+  printf("%-22s %14s %14s %8s %20s\n", "benchmark", "baseline ns/op",
+         "ns/op", "change", "95% interval");
+  int regressions = 0;
+  for (size_t i = 0; i < run->count; i++) {
+    const bench_t *bench = run->benches[i];
+    const bench_record_t *baseline = NULL;
+    for (int j = 0; j < record_count; j++) {
+      if (strcmp(records[j].name, bench->name) == 0) {
+        baseline = &records[j];
+      }
+    }
+    bench_summary_t current = run->results[i].summary;
+    if (baseline == NULL || baseline->count < 2 || current.count < 2) {
+      printf("%-22s %14s %14.1f   (needs 2 samples in both runs)\n",
+             bench->name, baseline == NULL ? "-" : "?", current.mean);
+      continue;
+    }
+    bench_summary_t before =
+        bench_summarize(baseline->samples, baseline->count);
+    bench_comparison_t comparison = bench_compare(before, current);
+    bool regressed = bench_is_regression(comparison, threshold);
+    regressions += regressed;
+    const char *verdict = regressed                ? "  REGRESSED"
+                          : !comparison.significant ? ""
+                          : comparison.change > 0   ? "  slower"
+                                                    : "  faster";
+    printf("%-22s %14.1f %14.1f %+7.1f%% [%+7.1f%%, %+7.1f%%]%s\n",
+           bench->name, before.mean, current.mean, comparison.change * 100,
+           comparison.change_low * 100, comparison.change_high * 100, verdict);
+  }
+  free(records);
+  return regressions;
+}
+
+/**
+ * Runs the benchmark scenarios and prints ns/op, ops/sec and allocations
+ * per op for each, then writes the same (and every sample) as JSON.
+ * Allocations are only counted in ALLOC_TRACK builds.
+ *
+ * Usage: bin/bench [-n samples] [-o results.json] [--save]
+ *                  [--compare baseline] [-t percent] [scenario prefix...]
+ * --save keeps the results as this commit's (and the latest) baseline for
+ * this machine and build. --compare checks them against a baseline, given
+ * as a commit saved with --save, "latest", or a results file, and exits
+ * with status 2 if any benchmark is significantly slower by more than -t
+ * percent (default 5).
+ */
+int main(int argc, char *argv[]) {
+  size_t samples = DEFAULT_SAMPLES;
+  const char *json_path = DEFAULT_JSON_PATH;
+  const char *baseline = NULL;
+  bool save = false;
+  double threshold = DEFAULT_THRESHOLD;
+  char **filters = malloc(sizeof(char *) * argc);
+  assert(filters != NULL);
+  size_t filter_count = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      samples = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      json_path = argv[++i];
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      threshold = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+      baseline = argv[++i];
+    } else if (strcmp(argv[i], "--save") == 0) {
+      save = true;
+    } else {
+      filters[filter_count++] = argv[i];
+    }
+  }
+  if (samples < 1 || samples > BENCH_MAX_SAMPLES) {
+    fprintf(stderr, "bench: samples must be between 1 and %d\n",
+            BENCH_MAX_SAMPLES);
+    return 1;
+  }
+
+  bench_run_t *run = malloc(sizeof(bench_run_t));
+  assert(run != NULL);
+  read_command("git describe --always --dirty --abbrev=12 2>/dev/null",
+               run->commit, sizeof(run->commit));
+  describe_machine(run->machine, sizeof(run->machine));
+  fingerprint_machine(run->machine, run->fingerprint);
+  run->samples = samples;
+  run->count = 0;
+  printf("commit %s on %s\n", run->commit, run->machine);
+
+  printf("%-22s %14s %10s %14s %6s %10s\n", "benchmark", "ns/op", "+/-",
+         "ops/s", "op", "allocs/op");
+  for (size_t i = 0; i < sizeof(BENCHES) / sizeof(BENCHES[0]); i++) {
+    const bench_t *bench = &BENCHES[i];
+    if (!selected(bench, filters, filter_count)) {
+      continue;
+    }
+    bench_result_t *result = &run->results[run->count];
+    *result = run_bench(bench, samples);
+    run->benches[run->count++] = bench;
+    printf("%-22s %14.1f %10.1f %14.1f %6s %10.2f\n", bench->name,
+           result->summary.mean, result->summary.stddev,
+           1e9 / result->summary.mean, bench->unit, result->allocs_per_op);
+    fflush(stdout);
+  }
+#ifndef ALLOC_TRACK
+  printf("(build with ALLOC_TRACK=true to count allocations)\n");
+#endif
+
+  int status = 0;
+  if (!write_results(json_path, run) || (save && !save_baseline(run))) {
+    status = 1;
+  } else {
+    printf("wrote %s\n", json_path);
+  }
+  if (status == 0 && baseline != NULL) {
+    int regressions = compare_with_baseline(run, baseline, threshold / 100);
+    if (regressions < 0) {
+      status = 1;
+    } else if (regressions > 0) {
+      printf("%d benchmark%s regressed\n", regressions,
+             regressions == 1 ? "" : "s");
+      status = 2;
+    }
+  }
+  free(run);
+  free(filters);
+  frame_arena_free();
+  return status;
+}
@@ -0,0 +1,131 @@
+#include "asset_loader.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_ttf.h>
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// benchmark settings
+const int DEFAULT_ITERATIONS = 20;
+const size_t DEFAULT_WORKERS = 4;
+
+// the game's startup assets, requested in the same order the game does
+const char FONT_PATH[] = "assets/font.ttf";
+const int FONT_SIZES[] = {50, 100, 25};
+const char *const IMAGE_PATHS[] = {
+    "assets/tank.png",         "assets/gravity_tank.png",
+    "assets/sniper_tank.png",  "assets/gatling_tank.png",
+    "assets/destroyed_tank.png",
+};
+const char *const SOUND_PATHS[] = {
+    "assets/default_tank_sound.wav",
+    "assets/death.wav",
+};
+#define FONT_COUNT (sizeof(FONT_SIZES) / sizeof(FONT_SIZES[0]))
+#define IMAGE_COUNT (sizeof(IMAGE_PATHS) / sizeof(IMAGE_PATHS[0]))
+#define SOUND_COUNT (sizeof(SOUND_PATHS) / sizeof(SOUND_PATHS[0]))
+
+typedef struct {
+  /** Until the menu's fonts are ready, i.e. the first frame can be drawn */
+  double first_frame_ms;
+  /** Until every asset is ready */
+  double all_ready_ms;
+} startup_t;
+
+double elapsed_ms(uint64_t start, uint64_t end) {
+  return (double)(end - start) * 1e3 / SDL_GetPerformanceFrequency();
+}
+
+/** Loads the startup assets once and times it */
+startup_t time_startup(size_t workers) {
+  uint64_t start = SDL_GetPerformanceCounter();
+  asset_loader_t *loader = asset_loader_init(workers);
+  asset_t *fonts[FONT_COUNT], *sounds[SOUND_COUNT];
+  for (size_t i = 0; i < FONT_COUNT; i++) {
+    fonts[i] = asset_loader_font(loader, FONT_PATH, FONT_SIZES[i]);
+  }
+  for (size_t i = 0; i < IMAGE_COUNT; i++) {
+    asset_loader_image(loader, IMAGE_PATHS[i]);
+  }
+  for (size_t i = 0; i < SOUND_COUNT; i++) {
+    sounds[i] = asset_loader_sound(loader, SOUND_PATHS[i]);
+  }
+  for (size_t i = 0; i < FONT_COUNT; i++) {
+    asset_wait(fonts[i]);
+  }
+  startup_t times;
+  times.first_frame_ms = elapsed_ms(start, SDL_GetPerformanceCounter());
+  asset_loader_wait_all(loader);
+  times.all_ready_ms = elapsed_ms(start, SDL_GetPerformanceCounter());
+
+  for (size_t i = 0; i < FONT_COUNT; i++) {
+    if (asset_font(fonts[i]) != NULL) {
+      TTF_CloseFont(asset_font(fonts[i]));
+    }
+  }
+  for (size_t i = 0; i < SOUND_COUNT; i++) {
+    if (asset_chunk(sounds[i]) != NULL) {
+      Mix_FreeChunk(asset_chunk(sounds[i]));
+    }
+  }
+  asset_loader_free(loader);
+  return times;
+}
+
+/** Times many startups and prints the mean and best times */
+void report(const char *label, int iterations, size_t workers) {
+  double first_total = 0.0, first_min = INFINITY;
+  double all_total = 0.0, all_min = INFINITY;
+  // One untimed run first, so every run starts with a warm page cache
+  time_startup(workers);
+  for (int i = 0; i < iterations; i++) {
+    startup_t times = time_startup(workers);
+    first_total += times.first_frame_ms;
+    all_total += times.all_ready_ms;
+    first_min = fmin(first_min, times.first_frame_ms);
+    all_min = fmin(all_min, times.all_ready_ms);
+  }
+  printf("  %-22s first frame mean %.3f ms (min %.3f), all ready mean %.3f ms "
+         "(min %.3f)\n",
+         label, first_total / iterations, first_min, all_total / iterations,
+         all_min);
+}
+
+/**
+ * Compares decoding the game's startup assets one after another on the main
+ * thread against decoding them on worker threads, measuring how long it takes
+ * until the first frame (the menu) can be drawn.
+ *
+ * Usage: bin/loader_bench [iterations] [workers]
+ */
+int main(int argc, char *argv[]) {
+  int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+  size_t workers = argc > 2 ? (size_t)atoi(argv[2]) : DEFAULT_WORKERS;
+  assert(iterations > 0);
+  assert(workers > 0);
+
+  // Sounds are decoded into the mixer's format, so the mixer must be open
+  setenv("SDL_AUDIODRIVER", "dummy", 0);
+  SDL_Init(SDL_INIT_AUDIO);
+  TTF_Init();
+  if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) != 0) {
+    fprintf(stderr, "loader_bench: could not open audio: %s\n",
+            Mix_GetError());
+    return 1;
+  }
+
+  printf("loader_bench: %d startups, %zu fonts, %zu images, %zu sounds\n",
+         iterations, FONT_COUNT, IMAGE_COUNT, SOUND_COUNT);
+  report("sequential", iterations, 0);
+  // Room for the label with the largest size_t there is
+  char label[sizeof("18446744073709551615 worker threads")];
+  snprintf(label, sizeof(label), "%zu worker threads", workers);
+  report(label, iterations, workers);
+
+  Mix_CloseAudio();
+  TTF_Quit();
+  SDL_Quit();
+  return 0;
+}
@@ -0,0 +1,243 @@
+#include "body.h"
+#include "forces.h"
+#include "list.h"
+#include "map.h"
+#include "polygon.h"
+#include "scene.h"
+#include "sdl_wrapper.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// types of different bodies (the library expects these from the program)
+const size_t WALL_TYPE = 0;
+const size_t BULLET_TYPE = 1;
+const size_t SNIPER_BULLET_TYPE = 10;
+const size_t GRAVITY_BULLET_TYPE = 13;
+const size_t GATLING_BULLET_TYPE = 11;
+const size_t DEFAULT_TANK_TYPE = 2;
+const size_t GRAVITY_TANK_TYPE = 3;
+const size_t SNIPER_TANK_TYPE = 4;
+const size_t HEALTH_BAR_TYPE = 6;
+const size_t GATLING_TANK_TYPE = 7;
+
+const double BULLET_DAMAGE = 10.0;
+const double GRAVITY_BULLET_DAMAGE = 15.0;
+const double SNIPER_BULLET_DAMAGE = 25.0;
+const double GATLING_BULLET_DAMAGE = 5.0;
+
+const double MAX_WIDTH_GAME = 1600.0;
+const double MAX_HEIGHT_GAME = 1300.0;
+
+// benchmark settings
+const int DEFAULT_FRAMES = 600;
+const int FRAME_WIDTH = 1000;
+const int FRAME_HEIGHT = 500;
+const double FRAME_DT = 1.0 / 60.0;
+
+// recorded scene stats, matching the game's gatling tank
+double TANK_SIDE_LENGTH = 60.0;
+double TANK_MASS = 1000.0;
+double TANK_MAX_HEALTH = 80.0;
+double TANK_VELOCITY = 100.0;
+double TANK_ROTATION_SPEED = M_PI * 3 / 5;
+double TANK_ELASTICITY = 20.0;
+double BULLET_MASS = 5.0;
+double BULLET_LENGTH = 25.0;
+double BULLET_WIDTH = 10.0;
+double BULLET_VELOCITY = 400.0;
+double BULLET_LIFETIME = 3.0;
+rgb_color_t PLAYER1_COLOR = {1.0, 0.0, 0.0};
+rgb_color_t PLAYER2_COLOR = {0.0, 1.0, 0.0};
+
+/**
+ * One input from the recording.
+ * At the given time, the tank either starts driving at the given speed,
+ * starts turning at the given rotation speed, or fires a bullet.
+ */
+typedef enum { DRIVE, TURN, FIRE } action_t;
+
+typedef struct {
+  double time;
+  size_t tank;
+  action_t action;
+  double amount;
+} recorded_input_t;
+
+/**
+ * A short two-player exchange: both tanks reposition, turn towards each other
+ * and trade gatling fire, so the frame has moving textures and many bullets.
+ * The recording loops once it runs out.
+ */
+const recorded_input_t RECORDING[] = {
+    {0.00, 0, DRIVE, 1.0},  {0.00, 1, DRIVE, 1.0},  {0.50, 0, TURN, -1.0},
+    {0.80, 0, TURN, 0.0},   {1.00, 1, TURN, 1.0},   {1.20, 1, TURN, 0.0},
+    {1.30, 0, FIRE, 0.0},   {1.40, 1, FIRE, 0.0},   {1.70, 0, FIRE, 0.0},
+    {1.80, 1, FIRE, 0.0},   {2.00, 0, DRIVE, -1.0}, {2.10, 0, FIRE, 0.0},
+    {2.20, 1, FIRE, 0.0},   {2.50, 0, FIRE, 0.0},   {2.60, 1, DRIVE, 0.0},
+    {2.60, 1, FIRE, 0.0},   {2.90, 0, FIRE, 0.0},   {3.00, 1, TURN, -1.0},
+    {3.10, 1, FIRE, 0.0},   {3.30, 0, TURN, 1.0},   {3.40, 1, TURN, 0.0},
+    {3.50, 0, TURN, 0.0},   {3.50, 1, FIRE, 0.0},   {3.60, 0, FIRE, 0.0},
+    {3.90, 1, FIRE, 0.0},   {4.00, 0, DRIVE, 0.0},  {4.00, 0, FIRE, 0.0},
+};
+const double RECORDING_LENGTH = 4.2;
+
+list_t *make_bullet_shape(vector_t back) {
+  list_t *shape = list_init(4, (free_func_t)free);
+  vector_t corners[] = {
+      {back.x, back.y - BULLET_WIDTH / 2},
+      {back.x + BULLET_LENGTH, back.y - BULLET_WIDTH / 2},
+      {back.x + BULLET_LENGTH, back.y + BULLET_WIDTH / 2},
+      {back.x, back.y + BULLET_WIDTH / 2},
+  };
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *corner = malloc(sizeof(vector_t));
+    assert(corner != NULL);
+    *corner = corners[i];
+    list_add(shape, corner);
+  }
+  return shape;
+}
+
+void fire_bullet(scene_t *scene, body_t *tank, rgb_color_t color) {
+  vector_t direction = {cos(body_get_rotation(tank)),
+                        sin(body_get_rotation(tank))};
+  list_t *shape = make_bullet_shape(body_get_centroid(tank));
+  polygon_rotate(shape, body_get_rotation(tank), body_get_centroid(tank));
+  polygon_translate(shape, vec_multiply(TANK_SIDE_LENGTH / 2 + 10, direction));
+
+  size_t *type = malloc(sizeof(size_t));
+  assert(type != NULL);
+  *type = GATLING_BULLET_TYPE;
+  body_t *bullet =
+      body_init_with_info(shape, BULLET_MASS, color, type, (free_func_t)free);
+  body_set_rotation_empty(bullet, body_get_rotation(tank));
+  body_set_velocity(bullet, vec_multiply(BULLET_VELOCITY, direction));
+  body_set_time(bullet, 0.0);
+  scene_add_body(scene, bullet);
+
+  for (size_t i = 2; i < scene_bodies(scene) - 1; i++) {
+    body_t *body = scene_get_body(scene, i);
+    size_t body_type = *(size_t *)body_get_info(body);
+    if (body_type == RECTANGLE_OBSTACLE_TYPE ||
+        body_type == TRIANGLE_OBSTACLE_TYPE) {
+      create_physics_collision(scene, 1.0, bullet, body);
+    }
+  }
+}
+
+scene_t *make_recorded_scene(void) {
+  scene_t *scene = scene_init();
+  vector_t player1_start = {MAX_WIDTH_GAME / 6, MAX_HEIGHT_GAME - 400.0};
+  vector_t player2_start = {MAX_WIDTH_GAME * 5 / 6, MAX_HEIGHT_GAME / 2 - 50.0};
+  body_t *player1 = init_gatling_tank(player1_start, TANK_SIDE_LENGTH, VEC_ZERO,
+                                      TANK_MASS, PLAYER1_COLOR, TANK_MAX_HEALTH,
+                                      GATLING_TANK_TYPE);
+  body_t *player2 = init_gatling_tank(player2_start, TANK_SIDE_LENGTH, VEC_ZERO,
+                                      TANK_MASS, PLAYER2_COLOR, TANK_MAX_HEALTH,
+                                      GATLING_TANK_TYPE);
+  body_set_rotation(player2, M_PI);
+  scene_add_body(scene, player1);
+  scene_add_body(scene, player2);
+  map_init(scene);
+  for (size_t i = 2; i < scene_bodies(scene); i++) {
+    create_physics_collision(scene, TANK_ELASTICITY, player1,
+                             scene_get_body(scene, i));
+    create_physics_collision(scene, TANK_ELASTICITY, player2,
+                             scene_get_body(scene, i));
+  }
+  return scene;
+}
+
+/** Applies every recorded input that happens in [start, end) */
+void replay_inputs(scene_t *scene, double start, double end) {
+  size_t input_count = sizeof(RECORDING) / sizeof(RECORDING[0]);
+  for (size_t i = 0; i < input_count; i++) {
+    recorded_input_t input = RECORDING[i];
+    if (input.time < start || input.time >= end) {
+      continue;
+    }
+    body_t *tank = scene_get_body(scene, input.tank);
+    switch (input.action) {
+    case DRIVE:
+      body_set_magnitude(tank, input.amount * TANK_VELOCITY);
+      break;
+    case TURN:
+      body_set_rotation_speed(tank, input.amount * TANK_ROTATION_SPEED);
+      break;
+    case FIRE:
+      fire_bullet(scene, tank, input.tank == 0 ? PLAYER1_COLOR : PLAYER2_COLOR);
+      break;
+    }
+  }
+}
+
+/** Ages bullets and removes the ones that have expired */
+void expire_bullets(scene_t *scene, double dt) {
+  for (size_t i = 2; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    if (*(size_t *)body_get_info(body) == GATLING_BULLET_TYPE) {
+      body_set_time(body, body_get_time(body) + dt);
+      if (body_get_time(body) > BULLET_LIFETIME) {
+        body_remove(body);
+      }
+    }
+  }
+}
+
+double elapsed_ms(uint64_t start, uint64_t end) {
+  return (double)(end - start) * 1e3 / SDL_GetPerformanceFrequency();
+}
+
+/**
+ * Renders frames of the recorded scene offscreen and reports the time spent
+ * in sdl_render_scene() per frame. Simulation time is not included.
+ *
+ * Usage: bin/render_bench [frames] [dump path]
+ * If a dump path is given, the last frame is written there (.png or .ppm).
+ */
+int main(int argc, char *argv[]) {
+  int frames = argc > 1 ? atoi(argv[1]) : DEFAULT_FRAMES;
+  assert(frames > 0);
+  char *dump_path = argc > 2 ? argv[2] : NULL;
+
+  vector_t min = VEC_ZERO;
+  vector_t max = {MAX_WIDTH_GAME, MAX_HEIGHT_GAME};
+  sdl_init_offscreen(min, max, FRAME_WIDTH, FRAME_HEIGHT);
+  scene_t *scene = make_recorded_scene();
+
+  double time = 0.0;
+  double total_ms = 0.0, min_ms = INFINITY, max_ms = 0.0;
+  size_t max_bodies = 0;
+  for (int frame = 0; frame < frames; frame++) {
+    double loop_time = fmod(time, RECORDING_LENGTH);
+    replay_inputs(scene, loop_time, loop_time + FRAME_DT);
+    expire_bullets(scene, FRAME_DT);
+    scene_tick(scene, FRAME_DT);
+    time += FRAME_DT;
+    if (scene_bodies(scene) > max_bodies) {
+      max_bodies = scene_bodies(scene);
+    }
+
+    uint64_t start = SDL_GetPerformanceCounter();
+    sdl_render_scene(scene);
+    double frame_ms = elapsed_ms(start, SDL_GetPerformanceCounter());
+    total_ms += frame_ms;
+    min_ms = frame_ms < min_ms ? frame_ms : min_ms;
+    max_ms = frame_ms > max_ms ? frame_ms : max_ms;
+  }
+
+  printf("render_bench: %d frames at %dx%d, up to %zu bodies\n", frames,
+         FRAME_WIDTH, FRAME_HEIGHT, max_bodies);
+  printf("  mean %.3f ms/frame, min %.3f ms, max %.3f ms\n", total_ms / frames,
+         min_ms, max_ms);
+
+  if (dump_path != NULL && !sdl_dump_frame(dump_path)) {
+    fprintf(stderr, "render_bench: could not write %s\n", dump_path);
+    scene_free(scene);
+    return 1;
+  }
+  scene_free(scene);
+  return 0;
+}
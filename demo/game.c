@@ -1,9 +1,16 @@
 #include "body.h"
+#include "body_pool.h"
 #include "collision.h"
+#include "asset_loader.h"
+#include "arena.h"
+#include "asset_pack.h"
+#include "audio.h"
 #include "forces.h"
 #include "list.h"
 #include "map.h"
+#include "perf_overlay.h"
 #include "polygon.h"
+#include "profiler.h"
 #include "scene.h"
 #include "sdl_wrapper.h"
 #include "star.h"
@@ -11,7 +18,6 @@
 #include "text.h"
 #include "vector.h"
 #include <SDL2/SDL.h>
-#include <SDL2/SDL_mixer.h>
 #include <SDL2/SDL_ttf.h>
 #include <assert.h>
 #include <math.h>
@@ -34,11 +40,39 @@ const size_t GATLING_TANK_TYPE = 7;
 int FONT_SIZE = 50;
 int TITLE_SIZE = 100;
 int TANK_SELECT_SIZE = 25;
+int OVERLAY_FONT_SIZE = 14;
 double CIRCLE_POINTS = 300.0;
 
 // DEATH animation time
 double DEATH_PAUSE_TIME = 0.2;
 
+// assets
+// built by 'make bin/assets.pack'; loose files in assets/ are used without it
+const char ASSET_PACK_PATH[] = "bin/assets.pack";
+const char FONT_PATH[] = "assets/font.ttf";
+// images are decoded into surfaces on this many threads while the menu is up
+const size_t ASSET_LOADER_WORKERS = 4;
+const char *const IMAGE_PATHS[] = {
+    "assets/tank.png",         "assets/gravity_tank.png",
+    "assets/sniper_tank.png",  "assets/gatling_tank.png",
+    "assets/destroyed_tank.png",
+};
+// never freed, since the render thread may upload its images until exit
+asset_loader_t *asset_loader;
+
+// sounds
+const char MUSIC_PATH[] = "assets/upbeat_music.wav";
+const char SHOT_SOUND_PATH[] = "assets/default_tank_sound.wav";
+const char DEATH_SOUND_PATH[] = "assets/death.wav";
+// shots heard at once; another shot cuts off the oldest one
+const size_t SHOT_VOICES = 6;
+const size_t DEATH_VOICES = 1;
+// sounds being decoded, then their ids from audio_add()
+asset_t *shot_sound_asset;
+asset_t *death_sound_asset;
+size_t shot_sound_id;
+size_t death_sound_id;
+
 const double MAX_WIDTH_GAME = 1600.0;
 const double MAX_HEIGHT_GAME = 1300.0;
 
@@ -104,23 +138,42 @@ const double GATLING_BULLET_DAMAGE = 5.0;
 // default bullet characteristics
 double BULLET_MASS = 5.0;
 double BULLET_DISAPPEAR_TIME = 10.0;
+// bullets allocated up front; two gatling tanks firing nonstop keep ~50 alive
+const size_t BULLET_POOL_SIZE = 64;
 
 double HEALTH_BAR_WIDTH = 500.0;
 double HEALTH_BAR_HEIGHT = 50.0;
 double HEALTH_BAR_OFFSET_HORIZONTAL = 50.0;
 double HEALTH_BAR_OFFSET_VERTICAL = 25.0;
+// room for both scores in the scoreboard text
+const size_t SCOREBOARD_LENGTH = 32;
+
+// the performance overlay, in the top left corner, is shown and hidden with
+// this key
+const char PERF_OVERLAY_KEY = '`';
+const vector_t PERF_OVERLAY_SIZE = {720.0, 270.0};
 
 double COLLISION_ELASTICITY = 20.0;
 
+// how close the player has to be for the AI to aim and shoot at them
+const double AI_RANGE = 750.0;
+
 // menu stats
-double BUTTON_X_MIN = 404.0;
-double BUTTON_X_MAX = 598.0;
-double START_BUTTON_Y_MIN = 194.0;
-double START_BUTTON_Y_MAX = 262.0;
-double OPTIONS_BUTTON_Y_MIN = 289.0;
-double OPTIONS_BUTTON_Y_MAX = 359.0;
+const aabb_t START_BUTTON = {{404.0, 194.0}, {598.0, 262.0}};
+const aabb_t OPTIONS_BUTTON = {{404.0, 289.0}, {598.0, 359.0}};
 
 // options stats
+const aabb_t SINGLE_PLAYER_BUTTON = {{275.0, 60.0}, {460.0, 140.0}};
+const aabb_t MULTIPLAYER_BUTTON = {{540.0, 60.0}, {730.0, 140.0}};
+const aabb_t PLAYER1_DEFAULT_BUTTON = {{240.0, 265.0}, {320.0, 310.0}};
+const aabb_t PLAYER1_GRAVITY_BUTTON = {{365.0, 265.0}, {445.0, 310.0}};
+const aabb_t PLAYER1_SNIPER_BUTTON = {{240.0, 344.0}, {320.0, 389.0}};
+const aabb_t PLAYER1_GATLING_BUTTON = {{365.0, 344.0}, {445.0, 389.0}};
+const aabb_t PLAYER2_DEFAULT_BUTTON = {{525.0, 265.0}, {605.0, 310.0}};
+const aabb_t PLAYER2_GRAVITY_BUTTON = {{655.0, 265.0}, {735.0, 310.0}};
+const aabb_t PLAYER2_SNIPER_BUTTON = {{525.0, 344.0}, {605.0, 389.0}};
+const aabb_t PLAYER2_GATLING_BUTTON = {{655.0, 344.0}, {735.0, 389.0}};
+const aabb_t GO_BACK_BUTTON = {{404.0, 410.0}, {598.0, 490.0}};
 
 double GAMMA = 1.0;
 
@@ -155,6 +208,7 @@ SDL_Color NUM_PLAYERS_COLOR = {15, 15, 240, 255};
 
 typedef struct state {
   scene_t *scene;
+  body_pool_t *bullet_pool;
   double time;
   size_t player1_tank_type;
   size_t player2_tank_type;
@@ -167,9 +221,20 @@ typedef struct state {
   text_t *text;
   text_t *title;
   text_t *select_tank;
-  text_t *scoreboard;
+  asset_t *text_font;
+  asset_t *title_font;
+  asset_t *select_tank_font;
+  asset_t *overlay_font;
+  perf_overlay_t *perf_overlay;
+  /** When the last frame started, or 0 before the first frame */
+  uint64_t frame_start_ns;
 } state_t;
 
+/** Makes a rectangle that is only drawn this frame */
+list_t *frame_rectangle(vector_t corner, double width, double height) {
+  return make_rectangle_arena(frame_arena(), corner, width, height);
+}
+
 list_t *make_half_circle(vector_t center, double radius) {
   list_t *shape = list_init(18, (free_func_t)free);
   for (size_t i = 0; i < 18; i++) {
@@ -214,93 +279,54 @@ list_t *make_heart(vector_t center, double length) {
   return shape;
 }
 
-list_t *make_health_bar_p1(double health) {
-  list_t *shape = list_init(4, (free_func_t)free);
-  if (health < 0) {
-    health = 0.0;
+/**
+ * Makes player 1's health bar, which shrinks towards the left as the player
+ * loses health.
+ *
+ * @param arena the arena to allocate the shape from, or NULL for the heap
+ * @param health the player's health
+ */
+list_t *make_health_bar_p1(arena_t *arena, double health) {
+  double width = fmax(health, 0.0) / DEFAULT_TANK_MAX_HEALTH * HEALTH_BAR_WIDTH;
+  vector_t corner = {HEALTH_BAR_OFFSET_HORIZONTAL,
+                     MAX_HEIGHT_GAME - HEALTH_BAR_OFFSET_VERTICAL};
+  if (arena != NULL) {
+    return make_rectangle_arena(arena, corner, width, HEALTH_BAR_HEIGHT);
   }
-
-  vector_t *point1 = malloc(sizeof(vector_t));
-  assert(point1 != NULL);
-  point1->x = health / DEFAULT_TANK_MAX_HEALTH * HEALTH_BAR_WIDTH +
-              HEALTH_BAR_OFFSET_HORIZONTAL;
-  point1->y = MAX_HEIGHT_GAME - HEALTH_BAR_HEIGHT - HEALTH_BAR_OFFSET_VERTICAL;
-  list_add(shape, point1);
-
-  vector_t *point2 = malloc(sizeof(vector_t));
-  assert(point2 != NULL);
-  point2->x = health / DEFAULT_TANK_MAX_HEALTH * HEALTH_BAR_WIDTH +
-              HEALTH_BAR_OFFSET_HORIZONTAL;
-  point2->y = MAX_HEIGHT_GAME - HEALTH_BAR_OFFSET_VERTICAL;
-  list_add(shape, point2);
-
-  vector_t *point3 = malloc(sizeof(vector_t));
-  assert(point3 != NULL);
-  point3->x = +HEALTH_BAR_OFFSET_HORIZONTAL;
-  point3->y = MAX_HEIGHT_GAME - HEALTH_BAR_OFFSET_VERTICAL;
-  list_add(shape, point3);
-  vector_t *point4 = malloc(sizeof(vector_t));
-  assert(point4 != NULL);
-  point4->x = +HEALTH_BAR_OFFSET_HORIZONTAL;
-  point4->y = MAX_HEIGHT_GAME - HEALTH_BAR_HEIGHT - HEALTH_BAR_OFFSET_VERTICAL;
-  list_add(shape, point4);
-  return shape;
+  return make_rectangle(corner, width, HEALTH_BAR_HEIGHT);
 }
 
-list_t *make_health_bar_p2(double health) {
-  list_t *shape = list_init(4, (free_func_t)free);
-  if (health < 0) {
-    health = 0.0;
+/**
+ * Makes player 2's health bar, which shrinks towards the right as the player
+ * loses health.
+ *
+ * @param arena the arena to allocate the shape from, or NULL for the heap
+ * @param health the player's health
+ */
+list_t *make_health_bar_p2(arena_t *arena, double health) {
+  double width = fmax(health, 0.0) / DEFAULT_TANK_MAX_HEALTH * HEALTH_BAR_WIDTH;
+  vector_t corner = {MAX_WIDTH_GAME - HEALTH_BAR_OFFSET_HORIZONTAL - width,
+                     MAX_HEIGHT_GAME - HEALTH_BAR_OFFSET_VERTICAL};
+  if (arena != NULL) {
+    return make_rectangle_arena(arena, corner, width, HEALTH_BAR_HEIGHT);
   }
-
-  vector_t *point1 = malloc(sizeof(vector_t));
-  assert(point1 != NULL);
-  point1->x = MAX_WIDTH_GAME -
-              health / DEFAULT_TANK_MAX_HEALTH * HEALTH_BAR_WIDTH -
-              HEALTH_BAR_OFFSET_HORIZONTAL;
-  point1->y = MAX_HEIGHT_GAME - HEALTH_BAR_OFFSET_VERTICAL;
-  list_add(shape, point1);
-
-  vector_t *point2 = malloc(sizeof(vector_t));
-  assert(point2 != NULL);
-  point2->x = MAX_WIDTH_GAME -
-              health / DEFAULT_TANK_MAX_HEALTH * HEALTH_BAR_WIDTH -
-              HEALTH_BAR_OFFSET_HORIZONTAL;
-  point2->y = MAX_HEIGHT_GAME - HEALTH_BAR_HEIGHT - HEALTH_BAR_OFFSET_VERTICAL;
-  list_add(shape, point2);
-
-  vector_t *point3 = malloc(sizeof(vector_t));
-  assert(point3 != NULL);
-  point3->x = MAX_WIDTH_GAME - HEALTH_BAR_OFFSET_HORIZONTAL;
-  point3->y = MAX_HEIGHT_GAME - HEALTH_BAR_HEIGHT - HEALTH_BAR_OFFSET_VERTICAL;
-  list_add(shape, point3);
-
-  vector_t *point4 = malloc(sizeof(vector_t));
-  assert(point4 != NULL);
-  point4->x = MAX_WIDTH_GAME - HEALTH_BAR_OFFSET_HORIZONTAL;
-  point4->y = MAX_HEIGHT_GAME - HEALTH_BAR_OFFSET_VERTICAL;
-  list_add(shape, point4);
-  return shape;
+  return make_rectangle(corner, width, HEALTH_BAR_HEIGHT);
 }
 void init_sounds() {
-  SDL_Init(SDL_INIT_AUDIO);
-  Mix_Init(0);
-  Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048);
-  Mix_Music *music = Mix_LoadMUS("assets/upbeat_music.wav");
-  Mix_PlayMusic(music, -1);
+  audio_init(MUSIC_PATH);
+  shot_sound_asset = asset_loader_sound(asset_loader, SHOT_SOUND_PATH);
+  death_sound_asset = asset_loader_sound(asset_loader, DEATH_SOUND_PATH);
 }
 
-void bullet_shot_sound() {
-  Mix_Chunk *bullet_sound = Mix_LoadWAV("assets/default_tank_sound.wav");
-  Mix_PlayChannel(1, bullet_sound, 0);
+// hands the decoded sounds to the audio module, waiting for them if needed
+void finish_sounds() {
+  shot_sound_id = audio_add(asset_chunk(shot_sound_asset), SHOT_VOICES);
+  death_sound_id = audio_add(asset_chunk(death_sound_asset), DEATH_VOICES);
 }
 
-void death_sound() {
-  Mix_Chunk *death = Mix_LoadWAV("assets/death.wav");
-  Mix_PlayChannel(1, death, 0);
-}
+void bullet_shot_sound() { audio_play(shot_sound_id); }
 
-void free_channel(int channel) { Mix_FreeChunk(Mix_GetChunk(channel)); }
+void death_sound() { audio_play(death_sound_id); }
 
 list_t *make_bullet(vector_t edge) {
   list_t *shape = list_init(4, (free_func_t)free);
@@ -332,37 +358,37 @@ list_t *make_bullet(vector_t edge) {
 
 void handle_bullet(state_t *state, body_t *player, rgb_color_t color) {
   body_set_time(player, 0.0);
-  vector_t spawn_point = body_get_centroid(player);
-  list_t *bullet_points =
-      make_bullet(spawn_point); // can change make bullet later for sniper
-                                // bullet and machine gun bullet
-  polygon_rotate(bullet_points, body_get_rotation(player),
-                 body_get_centroid(player));
   vector_t player_dir = {cos(body_get_rotation(player)),
                          sin(body_get_rotation(player))};
-  vector_t move_up =
-      vec_multiply(DEFAULT_TANK_SIDE_LENGTH / 2 + 10, player_dir);
-  polygon_translate(bullet_points, move_up);
-  size_t *type = malloc(sizeof(size_t));
+  // the bullet starts just in front of the tank, pointing the same way
+  vector_t spawn_point = vec_add(
+      body_get_centroid(player),
+      vec_multiply(DEFAULT_TANK_SIDE_LENGTH / 2 + 10 + BULLET_HEIGHT / 2,
+                   player_dir));
+  size_t type;
   double vel;
   if (*(size_t *)body_get_info(player) == DEFAULT_TANK_TYPE) {
-    *type = BULLET_TYPE;
+    type = BULLET_TYPE;
     vel = BULLET_VELOCITY;
   } else if (*(size_t *)body_get_info(player) == SNIPER_TANK_TYPE) {
-    *type = SNIPER_BULLET_TYPE;
+    type = SNIPER_BULLET_TYPE;
     vel = SNIPER_BULLET_VELOCITY;
   } else if (*(size_t *)body_get_info(player) == GATLING_TANK_TYPE) {
-    *type = GATLING_BULLET_TYPE;
+    type = GATLING_BULLET_TYPE;
     vel = GATLING_BULLET_VELOCITY;
   } else if (*(size_t *)body_get_info(player) == GRAVITY_TANK_TYPE) {
-    *type = GRAVITY_BULLET_TYPE;
+    type = GRAVITY_BULLET_TYPE;
     vel = GRAVITY_BULLET_VELOCITY;
   } else { // default
-    *type = BULLET_TYPE;
+    type = BULLET_TYPE;
     vel = BULLET_VELOCITY;
   }
-  body_t *bullet = body_init_with_info(bullet_points, BULLET_MASS, color, type,
-                                       (free_func_t)free);
+  body_t *bullet = body_pool_get(state->bullet_pool, BULLET_MASS, color, type);
+  body_set_centroid(bullet, spawn_point);
+  body_set_bullet(bullet, true);
+  // the bullet's rectangle with its corners rounded off
+  body_set_capsule(bullet, BULLET_HEIGHT - BULLET_WIDTH, BULLET_WIDTH / 2);
+  body_set_rotation(bullet, body_get_rotation(player));
 
   if (*(size_t *)body_get_info(player) == GRAVITY_TANK_TYPE) {
     if (scene_get_body(state->scene, 0) == player) {
@@ -377,7 +403,6 @@ void handle_bullet(state_t *state, body_t *player, rgb_color_t color) {
                                scene_get_body(state->scene, 1), bullet);
     }
   }
-  body_set_rotation_empty(bullet, body_get_rotation(player));
   body_set_velocity(bullet, vec_multiply(vel, player_dir));
   body_set_time(bullet, 0.0);
   scene_add_body(state->scene, bullet);
@@ -696,10 +721,30 @@ void reset_mode(body_t *ai) {
   body_set_ai_time(ai, 0.0);
 }
 
+/** Whether a body stops the AI's bullets: a wall, an obstacle or the player */
+bool blocks_fire(body_t *body, void *player) {
+  size_t type = *(size_t *)body_get_info(body);
+  return body == player || type == WALL_TYPE ||
+         type == RECTANGLE_OBSTACLE_TYPE || type == TRIANGLE_OBSTACLE_TYPE;
+}
+
+/** Whether the AI is in range of the player and can see past the obstacles */
+bool ai_has_line_of_fire(state_t *state, body_t *player, body_t *ai) {
+  vector_t from = body_get_centroid(ai);
+  vector_t to = body_get_centroid(player);
+  if (body_get_distance(from, to) >= AI_RANGE) {
+    return false;
+  }
+  raycast_hit_t hit;
+  return scene_raycast(state->scene, from, to, QUERY_FIRST_HIT, blocks_fire,
+                       player, &hit, 1) == 1 &&
+         hit.body == player;
+}
+
 void ai_aim(body_t *player, body_t *ai) {
   // program ai to aim towards enemy, works for default tank
   if (body_get_distance(body_get_centroid(ai), body_get_centroid(player)) <
-      750.0) {
+      AI_RANGE) {
     vector_t distance =
         vec_subtract(body_get_centroid(player), body_get_centroid(ai));
     double angle = atan(distance.y / distance.x);
@@ -724,8 +769,9 @@ void ai_aim(body_t *player, body_t *ai) {
 }
 
 void ai_shoot(state_t *state, body_t *player, body_t *ai) {
-  if (body_get_distance(body_get_centroid(ai), body_get_centroid(player)) <
-      750.0) {
+  // only fires with a clear shot, though ai_aim() keeps turning towards a
+  // player behind cover
+  if (ai_has_line_of_fire(state, player, ai)) {
     vector_t distance =
         vec_subtract(body_get_centroid(player), body_get_centroid(ai));
     double angle = atan(distance.y / distance.x);
@@ -859,7 +905,8 @@ void move_ai(state_t *state, double dt) {
 void gameover_pop_up(state_t *state) {
   // background
   vector_t corner1 = {0.0, MAX_HEIGHT_GAME};
-  list_t *background = make_rectangle(corner1, MAX_WIDTH_GAME, MAX_HEIGHT_GAME);
+  list_t *background =
+      frame_rectangle(corner1, MAX_WIDTH_GAME, MAX_HEIGHT_GAME);
   sdl_draw_polygon(background, BLACK);
   char *player1_wins = "Player 1 wins";
   char *player2_wins = "Player 2 wins";
@@ -887,9 +934,15 @@ void check_end_game(state_t *state) {
   }
 }
 
+/** Shows the frame, with the performance overlay on top if it is shown */
+void show_frame(state_t *state) {
+  perf_overlay_draw(state->perf_overlay);
+  sdl_show();
+}
+
 void show_scoreboard(state_t *state, int player1_score, int player2_score) {
   vector_t corner = {600.0, MAX_HEIGHT_GAME - 25.0};
-  list_t *points = make_rectangle(corner, 400.0, 150.0);
+  list_t *points = frame_rectangle(corner, 400.0, 150.0);
   rgb_color_t black = {0.0, 0.0, 0.0};
   sdl_draw_polygon(points, black);
 
@@ -897,23 +950,14 @@ void show_scoreboard(state_t *state, int player1_score, int player2_score) {
   // loc
   vector_t score_loc = {675.0, MAX_HEIGHT_GAME - 13.0};
 
-  char player1_str[20];
-  sprintf(player1_str, "%d", player1_score);
-  char player2_str[20];
-  sprintf(player2_str, "%d", player2_score);
-  char *final_str = (char *)malloc(
-      sizeof(char) * (strlen(player1_str) + strlen(player2_str) + 20));
-  strcpy(final_str, player1_str);
-  strcat(final_str, "   -   ");
-  strcat(final_str, player2_str);
-
-  TTF_Font *font1 = TTF_OpenFont("assets/font.ttf", FONT_SIZE);
-  text_t *text = text_init(font1, (free_func_t)free);
-  state->scoreboard = text;
+  char *final_str = arena_alloc(frame_arena(), SCOREBOARD_LENGTH);
+  snprintf(final_str, SCOREBOARD_LENGTH, "%d   -   %d", player1_score,
+           player2_score);
+
   SDL_Texture *scoreboard =
       sdl_load_text(state, final_str, state->text, white, score_loc);
 
-  sdl_show();
+  show_frame(state);
   SDL_DestroyTexture(scoreboard);
 }
 
@@ -965,14 +1009,16 @@ void make_players(state_t *state) {
 
 void make_health_bars(state_t *state) {
   // initialize health bars
-  list_t *p1_health_bar_shape = make_health_bar_p1(DEFAULT_TANK_MAX_HEALTH);
+  list_t *p1_health_bar_shape =
+      make_health_bar_p1(NULL, DEFAULT_TANK_MAX_HEALTH);
   size_t *type = malloc(sizeof(size_t));
   *type = HEALTH_BAR_TYPE;
   body_t *p1_health_bar = body_init_with_info(
       p1_health_bar_shape, 10.0, PLAYER1_COLOR, type, (free_func_t)free);
   scene_add_body(state->scene, p1_health_bar);
 
-  list_t *p2_health_bar_shape = make_health_bar_p2(DEFAULT_TANK_MAX_HEALTH);
+  list_t *p2_health_bar_shape =
+      make_health_bar_p2(NULL, DEFAULT_TANK_MAX_HEALTH);
   size_t *type2 = malloc(sizeof(size_t));
   *type2 = HEALTH_BAR_TYPE;
   body_t *p2_health_bar = body_init_with_info(
@@ -1003,7 +1049,6 @@ void reset_game(state_t *state) {
     body_remove(body);
   }
   scene_tick(state->scene, 0.0);
-  Mix_ChannelFinished(free_channel);
 
   make_players(state);
   make_health_bars(state);
@@ -1038,123 +1083,88 @@ bool check_round_end(state_t *state) {
 }
 
 bool start_button_pressed(vector_t mouse) {
-  if (mouse.x >= BUTTON_X_MIN && mouse.x <= BUTTON_X_MAX &&
-      mouse.y >= START_BUTTON_Y_MIN && mouse.y <= START_BUTTON_Y_MAX) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(START_BUTTON, mouse);
 }
 
 bool options_button_pressed(vector_t mouse) {
-  if (mouse.x >= BUTTON_X_MIN && mouse.x <= BUTTON_X_MAX &&
-      mouse.y >= OPTIONS_BUTTON_Y_MIN && mouse.y <= OPTIONS_BUTTON_Y_MAX) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(OPTIONS_BUTTON, mouse);
 }
 
 bool single_player_pressed(vector_t mouse) {
-  if (mouse.x >= 275.0 && mouse.x <= 460.0 && mouse.y >= 60.0 &&
-      mouse.y <= 140.0) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(SINGLE_PLAYER_BUTTON, mouse);
 }
+
 bool multiplayer_pressed(vector_t mouse) {
-  if (mouse.x >= 540.0 && mouse.x <= 730.0 && mouse.y >= 60.0 &&
-      mouse.y <= 140.0) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(MULTIPLAYER_BUTTON, mouse);
 }
+
 bool player1_default_pressed(vector_t mouse) {
-  if (mouse.x >= 240.0 && mouse.x <= 320.0 && mouse.y >= 265.0 &&
-      mouse.y <= 310.0) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(PLAYER1_DEFAULT_BUTTON, mouse);
 }
+
 bool player1_gravity_pressed(vector_t mouse) {
-  if (mouse.x >= 365.0 && mouse.x <= 445.0 && mouse.y >= 265.0 &&
-      mouse.y <= 310.0) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(PLAYER1_GRAVITY_BUTTON, mouse);
 }
+
 bool player1_sniper_pressed(vector_t mouse) {
-  if (mouse.x >= 240.0 && mouse.x <= 320.0 && mouse.y >= 344.0 &&
-      mouse.y <= 389.0) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(PLAYER1_SNIPER_BUTTON, mouse);
 }
+
 bool player1_gatling_pressed(vector_t mouse) {
-  if (mouse.x >= 365.0 && mouse.x <= 445.0 && mouse.y >= 344.0 &&
-      mouse.y <= 389.0) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(PLAYER1_GATLING_BUTTON, mouse);
 }
+
 bool player2_default_pressed(vector_t mouse) {
-  if (mouse.x >= 525.0 && mouse.x <= 605.0 && mouse.y >= 265.0 &&
-      mouse.y <= 310.0) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(PLAYER2_DEFAULT_BUTTON, mouse);
 }
+
 bool player2_gravity_pressed(vector_t mouse) {
-  if (mouse.x >= 655.0 && mouse.x <= 735.0 && mouse.y >= 265.0 &&
-      mouse.y <= 310.0) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(PLAYER2_GRAVITY_BUTTON, mouse);
 }
+
 bool player2_sniper_pressed(vector_t mouse) {
-  if (mouse.x >= 525.0 && mouse.x <= 605.0 && mouse.y >= 344.0 &&
-      mouse.y <= 389.0) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(PLAYER2_SNIPER_BUTTON, mouse);
 }
+
 bool player2_gatling_pressed(vector_t mouse) {
-  if (mouse.x >= 655.0 && mouse.x <= 735.0 && mouse.y >= 344.0 &&
-      mouse.y <= 389.0) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(PLAYER2_GATLING_BUTTON, mouse);
 }
+
 bool go_back_pressed(vector_t mouse) {
-  if (mouse.x >= BUTTON_X_MIN && mouse.x <= BUTTON_X_MAX && mouse.y >= 410 &&
-      mouse.y <= 490) {
-    return true;
-  }
-  return false;
+  return aabb_contains_point(GO_BACK_BUTTON, mouse);
 }
 
 void menu_init(state_t *state) {
   state->is_menu = true;
 
-  TTF_Font *font1 = TTF_OpenFont("assets/font.ttf", FONT_SIZE);
+  // The menu is the first frame, so only wait for the fonts it needs
+  TTF_Font *font1 = asset_font(state->text_font);
   text_t *text = text_init(font1, (free_func_t)free);
   state->text = text;
 
-  TTF_Font *font2 = TTF_OpenFont("assets/font.ttf", TITLE_SIZE);
+  TTF_Font *font2 = asset_font(state->title_font);
   text_t *title = text_init(font2, (free_func_t)free);
   state->title = title;
 
-  TTF_Font *font3 = TTF_OpenFont("assets/font.ttf", TANK_SELECT_SIZE);
+  TTF_Font *font3 = asset_font(state->select_tank_font);
   text_t *select_tank = text_init(font3, (free_func_t)free);
   state->select_tank = select_tank;
+
+  text_t *overlay_text = text_init(asset_font(state->overlay_font), NULL);
+  vector_t overlay_corner = {0.0, MAX_HEIGHT_GAME};
+  state->perf_overlay =
+      perf_overlay_init(overlay_text, overlay_corner, PERF_OVERLAY_SIZE);
 }
 
 void menu_pop_up(state_t *state) {
   vector_t corner1 = {0.0, MAX_HEIGHT_GAME};
-  list_t *background = make_rectangle(corner1, MAX_WIDTH_GAME, MAX_HEIGHT_GAME);
+  list_t *background =
+      frame_rectangle(corner1, MAX_WIDTH_GAME, MAX_HEIGHT_GAME);
   sdl_draw_polygon(background, LIGHT_GREY);
 
   // start button
   vector_t corner2 = {550.0, 750.0};
-  list_t *start_button = make_rectangle(corner2, 500.0, 180.0);
+  list_t *start_button = frame_rectangle(corner2, 500.0, 180.0);
   sdl_draw_polygon(start_button, GREEN);
 
   vector_t start_loc = {680.0, 750.0};
@@ -1163,7 +1173,7 @@ void menu_pop_up(state_t *state) {
 
   // options button
   vector_t corner3 = {550.0, 500.0};
-  list_t *options_button = make_rectangle(corner3, 500.0, 180.0);
+  list_t *options_button = frame_rectangle(corner3, 500.0, 180.0);
   sdl_draw_polygon(options_button, SLATE_GREY);
 
   // options text
@@ -1176,7 +1186,7 @@ void menu_pop_up(state_t *state) {
   SDL_Texture *title =
       sdl_load_text(state, "Tanks", state->title, SDL_FOREST_GREEN, title_loc);
 
-  sdl_show();
+  show_frame(state);
   SDL_DestroyTexture(start);
   SDL_DestroyTexture(options);
   SDL_DestroyTexture(title);
@@ -1185,7 +1195,8 @@ void menu_pop_up(state_t *state) {
 void options_pop_up(state_t *state) {
   // background
   vector_t corner1 = {0.0, MAX_HEIGHT_GAME};
-  list_t *background = make_rectangle(corner1, MAX_WIDTH_GAME, MAX_HEIGHT_GAME);
+  list_t *background =
+      frame_rectangle(corner1, MAX_WIDTH_GAME, MAX_HEIGHT_GAME);
   sdl_draw_polygon(background, LIGHT_GREY);
 
   rgb_color_t singleplayer_color = FOREST_GREEN_POLY;
@@ -1199,7 +1210,7 @@ void options_pop_up(state_t *state) {
 
   // 1 PLAYER button
   vector_t corner2 = {200.0, 1140.0};
-  list_t *oneplayer_button = make_rectangle(corner2, 500.0, 200.0);
+  list_t *oneplayer_button = frame_rectangle(corner2, 500.0, 200.0);
   sdl_draw_polygon(oneplayer_button, singleplayer_color);
   vector_t one_player_loc = {250.0, 1130.0};
   SDL_Texture *oneplayer =
@@ -1207,7 +1218,7 @@ void options_pop_up(state_t *state) {
 
   // 2 PLAYER button
   vector_t corner3 = {900.0, 1140.0};
-  list_t *twoplayer_button = make_rectangle(corner3, 500.0, 200.0);
+  list_t *twoplayer_button = frame_rectangle(corner3, 500.0, 200.0);
   sdl_draw_polygon(twoplayer_button, twoplayer_color);
   vector_t two_players_loc = {920.0, 1130.0};
   SDL_Texture *twoplayer = sdl_load_text(state, "2 PLAYERS", state->text,
@@ -1263,28 +1274,28 @@ void options_pop_up(state_t *state) {
 
   // player 1 tanks
   vector_t tank1_corner = {120.0, 600.0};
-  list_t *tank1_box = make_rectangle(tank1_corner, 200.0, 100.0);
+  list_t *tank1_box = frame_rectangle(tank1_corner, 200.0, 100.0);
   sdl_draw_polygon(tank1_box, tank1_color);
   vector_t tank1_loc = {135.0, 600.0};
   SDL_Texture *tank1 =
       sdl_load_text(state, "default", state->select_tank, SDL_WHITE, tank1_loc);
 
   vector_t tank2_corner = {460.0, 600.0};
-  list_t *tank2_box = make_rectangle(tank2_corner, 200.0, 100.0);
+  list_t *tank2_box = frame_rectangle(tank2_corner, 200.0, 100.0);
   sdl_draw_polygon(tank2_box, tank2_color);
   vector_t tank2_loc = {475.0, 600.0};
   SDL_Texture *tank2 =
       sdl_load_text(state, "gravity", state->select_tank, SDL_WHITE, tank2_loc);
 
   vector_t tank3_corner = {120.0, 400.0};
-  list_t *tank3_box = make_rectangle(tank3_corner, 200.0, 100.0);
+  list_t *tank3_box = frame_rectangle(tank3_corner, 200.0, 100.0);
   sdl_draw_polygon(tank3_box, tank3_color);
   vector_t tank3_loc = {145.0, 400.0};
   SDL_Texture *tank3 =
       sdl_load_text(state, "sniper", state->select_tank, SDL_WHITE, tank3_loc);
 
   vector_t tank4_corner = {460.0, 400.0};
-  list_t *tank4_box = make_rectangle(tank4_corner, 200.0, 100.0);
+  list_t *tank4_box = frame_rectangle(tank4_corner, 200.0, 100.0);
   sdl_draw_polygon(tank4_box, tank4_color);
   vector_t tank4_loc = {475.0, 400.0};
   SDL_Texture *tank4 =
@@ -1293,28 +1304,28 @@ void options_pop_up(state_t *state) {
   // player 2 tanks
   double shiftx = 750.0;
   vector_t tank5_corner = {120.0 + shiftx, 600.0};
-  list_t *tank5_box = make_rectangle(tank5_corner, 200.0, 100.0);
+  list_t *tank5_box = frame_rectangle(tank5_corner, 200.0, 100.0);
   sdl_draw_polygon(tank5_box, tank5_color);
   vector_t tank5_loc = {135.0 + shiftx, 600.0};
   SDL_Texture *tank5 =
       sdl_load_text(state, "default", state->select_tank, SDL_WHITE, tank5_loc);
 
   vector_t tank6_corner = {460.0 + shiftx, 600.0};
-  list_t *tank6_box = make_rectangle(tank6_corner, 200.0, 100.0);
+  list_t *tank6_box = frame_rectangle(tank6_corner, 200.0, 100.0);
   sdl_draw_polygon(tank6_box, tank6_color);
   vector_t tank6_loc = {475.0 + shiftx, 600.0};
   SDL_Texture *tank6 =
       sdl_load_text(state, "gravity", state->select_tank, SDL_WHITE, tank6_loc);
 
   vector_t tank7_corner = {120.0 + shiftx, 400.0};
-  list_t *tank7_box = make_rectangle(tank7_corner, 200.0, 100.0);
+  list_t *tank7_box = frame_rectangle(tank7_corner, 200.0, 100.0);
   sdl_draw_polygon(tank7_box, tank7_color);
   vector_t tank7_loc = {145.0 + shiftx, 400.0};
   SDL_Texture *tank7 =
       sdl_load_text(state, "sniper", state->select_tank, SDL_WHITE, tank7_loc);
 
   vector_t tank8_corner = {460.0 + shiftx, 400.0};
-  list_t *tank8_box = make_rectangle(tank8_corner, 200.0, 100.0);
+  list_t *tank8_box = frame_rectangle(tank8_corner, 200.0, 100.0);
   sdl_draw_polygon(tank8_box, tank8_color);
   vector_t tank8_loc = {475.0 + shiftx, 400.0};
   SDL_Texture *tank8 =
@@ -1322,13 +1333,13 @@ void options_pop_up(state_t *state) {
 
   // go back button
   vector_t go_back_corner = {550.0, 220.0};
-  list_t *go_back_button = make_rectangle(go_back_corner, 500.0, 180.0);
+  list_t *go_back_button = frame_rectangle(go_back_corner, 500.0, 180.0);
   sdl_draw_polygon(go_back_button, BLACK);
   vector_t go_back_loc = {680.0, 220.0};
   SDL_Texture *go_back =
       sdl_load_text(state, "Back", state->text, SDL_WHITE, go_back_loc);
 
-  sdl_show();
+  show_frame(state);
   SDL_DestroyTexture(oneplayer);
   SDL_DestroyTexture(twoplayer);
   SDL_DestroyTexture(gamemode);
@@ -1347,6 +1358,7 @@ void options_pop_up(state_t *state) {
 }
 
 void game_starter(state_t *state) {
+  finish_sounds();
   make_players(state);
   make_health_bars(state);
   map_init(state->scene);
@@ -1368,6 +1380,11 @@ void game_starter(state_t *state) {
 
 void handler(char key, key_event_type_t type, double held_time, state_t *state,
              vector_t loc) {
+  // a held key repeats, so only the first press toggles
+  if (key == PERF_OVERLAY_KEY && type == KEY_PRESSED && held_time == 0) {
+    perf_overlay_toggle(state->perf_overlay);
+    return;
+  }
   if (state->is_menu) {
     switch (key) {
     case MOUSE_CLICK: {
@@ -1437,14 +1454,34 @@ void handler(char key, key_event_type_t type, double held_time, state_t *state,
 }
 
 state_t *emscripten_init() {
-  init_sounds();
+  // Left mounted until exit, since the render thread may still load from it
+  asset_pack_mount(ASSET_PACK_PATH);
   vector_t min = VEC_ZERO;
   vector_t max = {MAX_WIDTH_GAME, MAX_HEIGHT_GAME};
   sdl_init(min, max);
   state_t *state = malloc(sizeof(state_t));
   assert(state != NULL);
+
+  // Start decoding every asset; the fonts go first, since the menu needs them
+  asset_loader = asset_loader_init(ASSET_LOADER_WORKERS);
+  state->text_font = asset_loader_font(asset_loader, FONT_PATH, FONT_SIZE);
+  state->title_font = asset_loader_font(asset_loader, FONT_PATH, TITLE_SIZE);
+  state->select_tank_font =
+      asset_loader_font(asset_loader, FONT_PATH, TANK_SELECT_SIZE);
+  state->overlay_font =
+      asset_loader_font(asset_loader, FONT_PATH, OVERLAY_FONT_SIZE);
+  for (size_t i = 0; i < sizeof(IMAGE_PATHS) / sizeof(IMAGE_PATHS[0]); i++) {
+    sdl_register_image(IMAGE_PATHS[i],
+                       asset_loader_image(asset_loader, IMAGE_PATHS[i]));
+  }
+  init_sounds();
+
   state->time = 0.0;
   state->scene = scene_init();
+  // bullets only ever touch a few of the obstacles they are paired with, and
+  // the obstacles never move, so they are kept in a tree of their own
+  scene_set_broad_phase(state->scene, BROAD_PHASE_AABB_TREE);
+  state->bullet_pool = body_pool_init(make_bullet(VEC_ZERO), BULLET_POOL_SIZE);
   state->player1_score = 0;
   state->player2_score = 0;
   state->player1_tank_type = DEFAULT_TANK_TYPE; //
@@ -1452,12 +1489,34 @@ state_t *emscripten_init() {
   state->singleplayer = false; // could comment this out for it to work
   state->is_options = false;
   state->is_round_end = false;
+  state->frame_start_ns = 0;
 
   menu_init(state);
   return state;
 }
 
+/**
+ * Records what the frame cost for the performance overlay
+ *
+ * @param start when the frame started
+ * @param simulated when the frame finished ticking the scene and started
+ *   drawing, or start if it only drew a menu
+ */
+void record_frame(state_t *state, uint64_t start, uint64_t simulated) {
+  uint64_t end = profile_now_ns();
+  if (state->frame_start_ns != 0) {
+    perf_sample_t sample = {.frame_ns = start - state->frame_start_ns,
+                            .simulate_ns = simulated - start,
+                            .render_ns = end - simulated};
+    perf_sample_scene(&sample, state->scene);
+    perf_overlay_add_sample(state->perf_overlay, sample);
+  }
+  state->frame_start_ns = start;
+}
+
 void emscripten_main(state_t *state) {
+  uint64_t start = profile_now_ns();
+  uint64_t simulated = start;
   sdl_clear();
   if (state->is_menu) {
     menu_pop_up(state);
@@ -1504,20 +1563,35 @@ void emscripten_main(state_t *state) {
     }
 
     // //update health bar
-    body_t *health_bar_p1 = scene_get_body(state->scene, 2);
-    body_set_shape(health_bar_p1, make_health_bar_p1(body_get_health(player1)));
-
-    body_t *health_bar_p2 = scene_get_body(state->scene, 3);
-    body_set_shape(health_bar_p2, make_health_bar_p2(body_get_health(player2)));
+    // the new shapes are copied into the bars' own, so they can be transient
+    list_t *bar1 = make_health_bar_p1(frame_arena(), body_get_health(player1));
+    body_set_vertices(scene_get_body(state->scene, 2), bar1);
+    list_t *bar2 = make_health_bar_p2(frame_arena(), body_get_health(player2));
+    body_set_vertices(scene_get_body(state->scene, 3), bar2);
 
     scene_tick(state->scene, dt);
-    sdl_render_scene(state->scene);
+    simulated = profile_now_ns();
+    // show_scoreboard() shows the frame, once the scoreboard is drawn on top
+    sdl_draw_scene(state->scene);
     show_scoreboard(state, state->player1_score, state->player2_score);
     check_end_game(state);
   }
+  record_frame(state, start, simulated);
 }
 
 void emscripten_free(state_t *state) {
+  if (getenv("SCENE_STATS") != NULL) {
+    scene_print_stats(state->scene, stderr);
+  }
+  // the scene hands its bullets back to the pool, so it goes first
   scene_free(state->scene);
+  if (getenv("POOL_STATS") != NULL) {
+    body_pool_stats_t stats = body_pool_stats(state->bullet_pool);
+    fprintf(stderr, "bullets reused %zu, allocated %zu, most alive %zu\n",
+            stats.hits, stats.misses, stats.high_water);
+  }
+  body_pool_free(state->bullet_pool);
+  perf_overlay_free(state->perf_overlay);
+  audio_free();
   free(state);
 }
@@ -120,6 +120,7 @@ body_t *get_ball(vector_t center, vector_t velocity) {
 
   body_set_centroid(ball, center);
   body_set_velocity(ball, velocity);
+  body_set_circle(ball, BALL_RADIUS);
 
   return ball;
 }
@@ -188,6 +189,7 @@ void add_pegs(scene_t *scene) {
       body_t *body = body_init_with_info(polygon, INFINITY, PEG_COLOR,
                                          make_type_info(WALL), free);
       body_set_centroid(body, get_peg_center(i, j));
+      body_set_circle(body, PEG_RADIUS);
       scene_add_body(scene, body);
     }
   }
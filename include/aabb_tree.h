@@ -0,0 +1,178 @@
+#ifndef __AABB_TREE_H__
+#define __AABB_TREE_H__
+
+#include "body.h"
+#include "list.h"
+#include "polygon.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A bounding volume hierarchy over bodies: a binary tree whose leaves hold
+ * bodies' bounding boxes and whose inner nodes hold boxes around their
+ * children, so anything that misses a node's box can skip everything below.
+ *
+ * A tree is either built once over bodies that never move, such as a map's
+ * obstacles (see aabb_tree_build()), or grown one body at a time
+ * (see aabb_tree_insert()). The leaves of a grown tree are fattened a little
+ * past their bodies and stretched along their last movement, so a body that
+ * moves a little stays inside its leaf and aabb_tree_move() leaves the tree
+ * alone. Leaves that do escape are reinserted, and the tree is rebalanced
+ * with rotations as it changes so it stays shallow.
+ */
+typedef struct aabb_tree aabb_tree_t;
+
+/**
+ * A function called with each body a query finds.
+ * Returns whether to keep searching.
+ */
+typedef bool (*body_visitor_t)(body_t *body, void *aux);
+
+/**
+ * A function called with each body whose box a ray passes through,
+ * along with how far along the ray the search still reaches.
+ * Returns how far to keep searching: the same fraction to carry on,
+ * a smaller one (e.g. where the ray hit the body) to only look nearer,
+ * or 0 to stop.
+ */
+typedef double (*ray_visitor_t)(body_t *body, double max_fraction, void *aux);
+
+/**
+ * A function called with each pair of bodies a query finds.
+ */
+typedef void (*pair_visitor_t)(body_t *body1, body_t *body2, void *aux);
+
+/**
+ * Allocates an empty tree, for bodies that move.
+ *
+ * @param fatten how far to grow each leaf past its body's box on each side,
+ *   as a fraction of the box's size, e.g. 0.1
+ * @return the new tree
+ */
+aabb_tree_t *aabb_tree_init(double fatten);
+
+/**
+ * Builds a tree over bodies that will not move, splitting them in half
+ * along the longer side of their bounds at each level. Its leaves fit
+ * the bodies exactly. It is rebuilt rather than updated if they change.
+ *
+ * @param bodies the bodies to build the tree over
+ * @return the new tree
+ */
+aabb_tree_t *aabb_tree_build(list_t *bodies);
+
+/**
+ * Releases a tree. The bodies in it are not freed.
+ *
+ * @param tree a tree returned from aabb_tree_init() or aabb_tree_build()
+ */
+void aabb_tree_free(aabb_tree_t *tree);
+
+/**
+ * Gets the number of bodies in a tree.
+ */
+size_t aabb_tree_size(aabb_tree_t *tree);
+
+/**
+ * Gets the number of levels in a tree: 0 if it is empty,
+ * 1 if it is a single leaf.
+ */
+size_t aabb_tree_height(aabb_tree_t *tree);
+
+/**
+ * Adds a body to a tree.
+ *
+ * @param tree a tree returned from aabb_tree_init()
+ * @param body the body
+ * @param bounds the body's bounding box, e.g. from body_get_bounds()
+ * @return the body's leaf, to pass to aabb_tree_move() and aabb_tree_remove()
+ */
+size_t aabb_tree_insert(aabb_tree_t *tree, body_t *body, aabb_t bounds);
+
+/**
+ * Removes a body's leaf from a tree.
+ *
+ * @param tree a tree returned from aabb_tree_init()
+ * @param leaf a leaf returned from aabb_tree_insert()
+ */
+void aabb_tree_remove(aabb_tree_t *tree, size_t leaf);
+
+/**
+ * Updates a body's box after it moves. If the box is still inside its leaf,
+ * nothing changes; otherwise the leaf is fattened around the new box,
+ * stretched along the displacement, and reinserted.
+ *
+ * @param tree a tree returned from aabb_tree_init()
+ * @param leaf a leaf returned from aabb_tree_insert()
+ * @param bounds the body's new bounding box
+ * @param displacement how far the body moved since its last update
+ * @return whether the leaf was reinserted
+ */
+bool aabb_tree_move(aabb_tree_t *tree, size_t leaf, aabb_t bounds,
+                    vector_t displacement);
+
+/**
+ * Gets the body in a leaf.
+ */
+body_t *aabb_tree_body(aabb_tree_t *tree, size_t leaf);
+
+/**
+ * Gets the box stored in a leaf, which contains its body's box.
+ */
+aabb_t aabb_tree_leaf_bounds(aabb_tree_t *tree, size_t leaf);
+
+/**
+ * Calls a function with each body whose leaf overlaps a box,
+ * until it asks to stop.
+ *
+ * @param tree the tree to search
+ * @param box the box to search
+ * @param visitor the function to call with each body found
+ * @param aux an auxiliary value to pass to the visitor
+ * @return false if the visitor stopped the search, otherwise true
+ */
+bool aabb_tree_query(aabb_tree_t *tree, aabb_t box, body_visitor_t visitor,
+                     void *aux);
+
+/**
+ * Calls a function with each body whose leaf a ray passes through, skipping
+ * the parts of the tree beyond how far the visitor says to keep searching.
+ * Bodies are not visited in order along the ray.
+ *
+ * @param tree the tree to search
+ * @param origin where the ray starts
+ * @param end where the ray ends
+ * @param max_fraction how far towards end to search, from 0 to 1
+ * @param visitor the function to call with each body found
+ * @param aux an auxiliary value to pass to the visitor
+ * @return how far the visitor last said to keep searching,
+ *   or max_fraction if it was never called
+ */
+double aabb_tree_raycast(aabb_tree_t *tree, vector_t origin, vector_t end,
+                         double max_fraction, ray_visitor_t visitor,
+                         void *aux);
+
+/**
+ * Calls a function with each pair of bodies in a tree whose leaves overlap.
+ * Each pair is visited once.
+ *
+ * @param tree the tree to search
+ * @param visitor the function to call with each pair found
+ * @param aux an auxiliary value to pass to the visitor
+ */
+void aabb_tree_self_pairs(aabb_tree_t *tree, pair_visitor_t visitor,
+                          void *aux);
+
+/**
+ * Calls a function with each pair of a body from one tree and a body from
+ * another whose leaves overlap.
+ *
+ * @param tree1 the tree whose bodies are passed first
+ * @param tree2 the tree whose bodies are passed second
+ * @param visitor the function to call with each pair found
+ * @param aux an auxiliary value to pass to the visitor
+ */
+void aabb_tree_pairs(aabb_tree_t *tree1, aabb_tree_t *tree2,
+                     pair_visitor_t visitor, void *aux);
+
+#endif // #ifndef __AABB_TREE_H__
@@ -0,0 +1,146 @@
+#ifndef __ALLOC_TRACK_H__
+#define __ALLOC_TRACK_H__
+
+/**
+ * Opt-in accounting of heap allocations by subsystem.
+ *
+ * Build with 'make ALLOC_TRACK=true' (after 'make clean') to route every
+ * malloc(), calloc(), realloc(), aligned_alloc() and free() in the library
+ * and demos through this module. Each allocation is charged to the line
+ * that made it, and to the subsystem of that line's file (see alloc_tag_t).
+ * The native game then prints a report at exit, and whenever it is sent
+ * SIGUSR1. Without ALLOC_TRACK nothing is tracked and nothing is printed.
+ *
+ * Freeing memory the tracker never saw (e.g. from SDL) just frees it, and
+ * memory freed behind its back (e.g. by SDL) stays counted as live until
+ * its address is reused.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(__has_include)
+#if __has_include(<malloc.h>)
+// SDL includes this too, and it must be parsed before the macros below
+#include <malloc.h>
+#endif
+#endif
+
+/**
+ * The subsystems allocations are charged to.
+ */
+typedef enum {
+  /** list.c */
+  ALLOC_LIST,
+  /** body.c and body_pool.c */
+  ALLOC_BODY,
+  /** scene.c, forces.c and slab.c */
+  ALLOC_FORCE,
+  /** collision.c */
+  ALLOC_COLLISION,
+  /** sdl_wrapper.c, render_snapshot.c and text.c */
+  ALLOC_RENDER,
+  /** The demos, and the shapes they build with map.c, star.c and polygon.c */
+  ALLOC_GAME,
+  /** Everything else, e.g. arenas, assets and audio */
+  ALLOC_OTHER,
+  ALLOC_TAG_COUNT
+} alloc_tag_t;
+
+/**
+ * The allocations charged to one subsystem.
+ */
+typedef struct {
+  /** Bytes allocated and not yet freed */
+  size_t live_bytes;
+  /** The most bytes that were ever live at once */
+  size_t peak_bytes;
+  /** Allocations not yet freed */
+  size_t live_count;
+  /** Every allocation ever made, including reallocations */
+  size_t total_count;
+  /** Allocations made during the last complete frame */
+  size_t last_frame_count;
+  /** The most allocations made during any one frame */
+  size_t max_frame_count;
+} alloc_stats_t;
+
+/**
+ * Allocates memory like malloc(), charging it to the given line.
+ */
+void *alloc_track_malloc(size_t size, const char *file, int line);
+
+/**
+ * Allocates zeroed memory like calloc(), charging it to the given line.
+ */
+void *alloc_track_calloc(size_t count, size_t size, const char *file,
+                         int line);
+
+/**
+ * Resizes memory like realloc(), charging it to the given line.
+ */
+void *alloc_track_realloc(void *memory, size_t size, const char *file,
+                          int line);
+
+/**
+ * Allocates aligned memory like aligned_alloc(), charging it to the line.
+ */
+void *alloc_track_aligned_alloc(size_t alignment, size_t size,
+                                const char *file, int line);
+
+/**
+ * Frees memory like free(), whether or not it was tracked.
+ */
+void alloc_track_free(void *memory);
+
+/**
+ * Gets the subsystem a source file's allocations are charged to.
+ *
+ * @param file a path, as in __FILE__
+ */
+alloc_tag_t alloc_tag_of_file(const char *file);
+
+/**
+ * Gets the name of a subsystem, e.g. "list".
+ */
+const char *alloc_tag_name(alloc_tag_t tag);
+
+/**
+ * Gets the allocations charged to a subsystem.
+ */
+alloc_stats_t alloc_track_stats(alloc_tag_t tag);
+
+/**
+ * Marks the end of a frame, for the per-frame allocation counts.
+ * Called by the main loop before each frame; prints a report if one
+ * was requested with alloc_track_request_dump() since the last frame.
+ */
+void alloc_track_frame(void);
+
+/**
+ * Asks for a report at the end of the current frame.
+ * Only sets a flag, so it is safe to call from a signal handler.
+ */
+void alloc_track_request_dump(void);
+
+/**
+ * Prints the allocations charged to each subsystem,
+ * followed by the lines with the most live bytes.
+ *
+ * @param out where to print the report, e.g. stderr
+ */
+void alloc_track_dump(FILE *out);
+
+#if defined(ALLOC_TRACK) && !defined(ALLOC_TRACK_IMPLEMENTATION)
+#define malloc(size) alloc_track_malloc(size, __FILE__, __LINE__)
+#define calloc(count, size) alloc_track_calloc(count, size, __FILE__, __LINE__)
+#define realloc(memory, size)                                                  \
+  alloc_track_realloc(memory, size, __FILE__, __LINE__)
+#define aligned_alloc(alignment, size)                                         \
+  alloc_track_aligned_alloc(alignment, size, __FILE__, __LINE__)
+// not function-like, so that freers like (free_func_t)free are tracked too
+#define free alloc_track_free
+#endif
+
+#endif // #ifndef __ALLOC_TRACK_H__
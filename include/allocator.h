@@ -0,0 +1,111 @@
+#ifndef __ALLOCATOR_H__
+#define __ALLOCATOR_H__
+
+#include "arena.h"
+#include <stddef.h>
+
+/**
+ * Allocates size bytes of memory.
+ *
+ * @param context the allocator's context
+ * @param size the number of bytes to allocate
+ * @return the memory, or NULL if it could not be allocated
+ */
+typedef void *(*alloc_func_t)(void *context, size_t size);
+
+/**
+ * Releases memory returned by the matching alloc_func_t.
+ *
+ * @param context the allocator's context
+ * @param memory the memory to release
+ */
+typedef void (*release_func_t)(void *context, void *memory);
+
+/**
+ * Where a list, body or scene gets its memory from.
+ * A scene passes its allocator on to everything it creates,
+ * so all of a match's memory can come from one place
+ * (see scene_init_with_allocator()).
+ *
+ * An allocator without a free function owns everything allocated from it,
+ * like an arena: nothing is freed individually, and the allocator's owner
+ * releases it all at once.
+ */
+typedef struct {
+  alloc_func_t alloc;
+  /** Releases a single allocation, or NULL if that is a no-op */
+  release_func_t free;
+  /** Passed to alloc and free, e.g. the arena to allocate from */
+  void *context;
+} allocator_t;
+
+/**
+ * Gets the allocator that uses malloc() and free().
+ */
+allocator_t heap_allocator(void);
+
+/**
+ * Gets an allocator that allocates from an arena.
+ * It has no free function, so memory is released with arena_reset().
+ *
+ * @param arena the arena to allocate from
+ */
+allocator_t arena_allocator(arena_t *arena);
+
+/**
+ * Allocates memory from an allocator.
+ * Asserts that the memory was allocated.
+ *
+ * @param allocator the allocator, or NULL for the heap
+ * @param size the number of bytes to allocate
+ * @return the allocated memory
+ */
+void *allocator_alloc(const allocator_t *allocator, size_t size);
+
+/**
+ * Releases memory from allocator_alloc().
+ * Does nothing for an allocator without a free function.
+ *
+ * @param allocator the allocator the memory came from, or NULL for the heap
+ * @param memory the memory to release
+ */
+void allocator_free(const allocator_t *allocator, void *memory);
+
+/**
+ * Resizes memory from allocator_alloc(), keeping its contents.
+ * Uses realloc() for the heap, and otherwise allocates, copies and frees.
+ *
+ * @param allocator the allocator the memory came from, or NULL for the heap
+ * @param memory the memory to resize
+ * @param old_size the size the memory was allocated with
+ * @param new_size the size to resize the memory to
+ * @return the resized memory, which may have moved
+ */
+void *allocator_realloc(const allocator_t *allocator, void *memory,
+                        size_t old_size, size_t new_size);
+
+/**
+ * Like allocator_alloc(), but charges heap memory to the given line
+ * when allocations are tracked (see alloc_track.h).
+ */
+void *allocator_alloc_at(const allocator_t *allocator, size_t size,
+                         const char *file, int line);
+
+/**
+ * Like allocator_realloc(), but charges heap memory to the given line
+ * when allocations are tracked (see alloc_track.h).
+ */
+void *allocator_realloc_at(const allocator_t *allocator, void *memory,
+                           size_t old_size, size_t new_size, const char *file,
+                           int line);
+
+#ifdef ALLOC_TRACK
+// charge heap memory to the caller's line, not to this module
+#define allocator_alloc(allocator, size)                                       \
+  allocator_alloc_at(allocator, size, __FILE__, __LINE__)
+#define allocator_realloc(allocator, memory, old_size, new_size)               \
+  allocator_realloc_at(allocator, memory, old_size, new_size, __FILE__,       \
+                       __LINE__)
+#endif
+
+#endif // #ifndef __ALLOCATOR_H__
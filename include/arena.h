@@ -0,0 +1,118 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/**
+ * A bump-pointer allocator for short-lived data.
+ * Allocating just advances a pointer, and nothing is freed individually:
+ * arena_reset() (or arena_rewind()) releases everything allocated since,
+ * keeping the memory for reuse. The arena grows by adding blocks when it
+ * runs out, so after the first few frames it stops calling malloc.
+ *
+ * In debug builds (ARENA_DEBUG, or any AddressSanitizer build such as the
+ * default 'make'), released memory is overwritten with ARENA_POISON and,
+ * under AddressSanitizer, marked unaddressable, so a pointer that escapes
+ * its frame is caught where it is used.
+ */
+typedef struct arena arena_t;
+
+/**
+ * The byte released arena memory is filled with in debug builds.
+ */
+#define ARENA_POISON 0xdb
+
+/**
+ * A position in an arena to rewind back to.
+ */
+typedef struct {
+  struct arena_block *block;
+  size_t offset;
+  size_t used;
+} arena_mark_t;
+
+/**
+ * How much of an arena is in use, and the most that ever was.
+ */
+typedef struct {
+  /** Bytes allocated since the last reset */
+  size_t used;
+  /** The most bytes that were ever allocated between two resets */
+  size_t high_water;
+  /** Bytes the arena has reserved from malloc */
+  size_t capacity;
+} arena_stats_t;
+
+/**
+ * Allocates an arena.
+ *
+ * @param block_size the size of the arena's first block,
+ *   and the smallest block it grows by
+ * @return the new arena
+ */
+arena_t *arena_init(size_t block_size);
+
+/**
+ * Releases an arena and everything allocated from it.
+ *
+ * @param arena an arena returned from arena_init()
+ */
+void arena_free(arena_t *arena);
+
+/**
+ * Allocates memory from an arena. The memory is suitably aligned for any
+ * type and stays valid until the arena is reset or rewound past it.
+ *
+ * @param arena an arena returned from arena_init()
+ * @param size the number of bytes to allocate
+ * @return the allocated memory
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * Releases everything allocated from an arena.
+ *
+ * @param arena an arena returned from arena_init()
+ */
+void arena_reset(arena_t *arena);
+
+/**
+ * Gets the arena's current position, for arena_rewind().
+ */
+arena_mark_t arena_mark(arena_t *arena);
+
+/**
+ * Releases everything allocated from an arena since a mark was taken.
+ * Lets a function use an arena for scratch space without growing it.
+ *
+ * @param arena an arena returned from arena_init()
+ * @param mark a mark returned from arena_mark() since the last reset
+ */
+void arena_rewind(arena_t *arena, arena_mark_t mark);
+
+/**
+ * Gets an arena's usage and high-water mark.
+ */
+arena_stats_t arena_stats(arena_t *arena);
+
+/**
+ * Gets the frame arena, which is reset at the start of every frame
+ * (see frame_arena_reset()). Allocations from it must not be kept past the
+ * end of the frame. Only for use on the main (simulation) thread.
+ *
+ * @return the frame arena, created the first time this is called
+ */
+arena_t *frame_arena(void);
+
+/**
+ * Resets the frame arena. Called by the main loop before each frame.
+ */
+void frame_arena_reset(void);
+
+/**
+ * Frees the frame arena. Called by the main loop on exit.
+ * Set the ARENA_STATS environment variable to print its high-water mark.
+ */
+void frame_arena_free(void);
+
+#endif // #ifndef __ARENA_H__
@@ -0,0 +1,120 @@
+#ifndef __ASSET_LOADER_H__
+#define __ASSET_LOADER_H__
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_ttf.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Decodes assets on a pool of worker threads.
+ * Each requested asset is returned as a future (asset_t) that becomes ready
+ * once it is decoded. Only decoding happens on the workers; anything that
+ * needs the renderer, like uploading an image as a texture, is left to the
+ * thread that owns the renderer.
+ *
+ * Under emscripten there are no worker threads, so each asset is decoded
+ * as soon as it is requested.
+ */
+typedef struct asset_loader asset_loader_t;
+
+/**
+ * A requested asset, which is ready once it has been decoded
+ * (or has failed to decode).
+ */
+typedef struct asset asset_t;
+
+/**
+ * Starts an asset loader.
+ *
+ * @param workers the number of worker threads; 0 decodes every asset
+ *   on the requesting thread
+ * @return the new asset loader
+ */
+asset_loader_t *asset_loader_init(size_t workers);
+
+/**
+ * Stops the workers and frees the loader, its futures and the image surfaces
+ * it decoded. Assets that were not decoded yet are abandoned.
+ * Sound chunks and fonts belong to the caller and are not freed.
+ *
+ * @param loader a loader returned from asset_loader_init()
+ */
+void asset_loader_free(asset_loader_t *loader);
+
+/**
+ * Requests an image, decoded into an SDL_Surface.
+ *
+ * @param loader a loader returned from asset_loader_init()
+ * @param path the image's path (read through asset_open()); must outlive
+ *   the loader
+ * @return the image's future
+ */
+asset_t *asset_loader_image(asset_loader_t *loader, const char *path);
+
+/**
+ * Requests a sound effect, decoded into a Mix_Chunk.
+ * The audio device must already be open.
+ *
+ * @param loader a loader returned from asset_loader_init()
+ * @param path the WAV file's path; must outlive the loader
+ * @return the sound's future
+ */
+asset_t *asset_loader_sound(asset_loader_t *loader, const char *path);
+
+/**
+ * Requests a font at a point size. TTF_Init() must already have been called.
+ *
+ * @param loader a loader returned from asset_loader_init()
+ * @param path the font file's path; must outlive the loader
+ * @param size the point size to open the font at
+ * @return the font's future
+ */
+asset_t *asset_loader_font(asset_loader_t *loader, const char *path,
+                           int size);
+
+/**
+ * Gets the fraction of requested assets that are ready, from 0 to 1.
+ * 1 if nothing has been requested.
+ */
+double asset_loader_progress(asset_loader_t *loader);
+
+/**
+ * Waits until every requested asset is ready.
+ */
+void asset_loader_wait_all(asset_loader_t *loader);
+
+/**
+ * Returns whether an asset is ready, without waiting. Safe to call from
+ * any thread.
+ */
+bool asset_ready(asset_t *asset);
+
+/**
+ * Waits until an asset is ready.
+ */
+void asset_wait(asset_t *asset);
+
+/**
+ * Waits for an image and gets its surface, which the loader owns.
+ *
+ * @return the decoded image, or NULL if it could not be loaded
+ */
+SDL_Surface *asset_surface(asset_t *asset);
+
+/**
+ * Waits for a sound and gets its chunk, which the caller owns.
+ *
+ * @return the decoded sound, or NULL if it could not be loaded
+ */
+Mix_Chunk *asset_chunk(asset_t *asset);
+
+/**
+ * Waits for a font and gets it. The caller owns the font.
+ *
+ * @return the opened font, or NULL if it could not be loaded
+ */
+TTF_Font *asset_font(asset_t *asset);
+
+#endif // #ifndef __ASSET_LOADER_H__
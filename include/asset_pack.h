@@ -0,0 +1,89 @@
+#ifndef __ASSET_PACK_H__
+#define __ASSET_PACK_H__
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * The longest asset path an archive can store, including the terminating '\0'.
+ */
+#define ASSET_PATH_MAX 64
+
+/**
+ * An archive of asset files, packed by bin/pack_assets.
+ * The whole archive is mapped into memory once when it is opened,
+ * and every asset is served straight out of that mapping.
+ */
+typedef struct asset_pack asset_pack_t;
+
+/**
+ * Packs files into an archive. Each file is stored under the path it was
+ * read from, e.g. "assets/tank.png".
+ *
+ * @param pack_path the archive to write
+ * @param paths the files to pack
+ * @param count the number of files
+ * @return whether every file was read and the archive was written
+ */
+bool asset_pack_write(const char *pack_path, const char *const *paths,
+                      size_t count);
+
+/**
+ * Opens an archive written by asset_pack_write().
+ *
+ * @param pack_path the archive to open
+ * @return the archive, or NULL if it is missing or malformed
+ */
+asset_pack_t *asset_pack_open(const char *pack_path);
+
+/**
+ * Closes an archive. Any data or RWops obtained from it become invalid.
+ *
+ * @param pack an archive returned from asset_pack_open()
+ */
+void asset_pack_close(asset_pack_t *pack);
+
+/**
+ * Gets the number of assets in an archive.
+ */
+size_t asset_pack_size(asset_pack_t *pack);
+
+/**
+ * Finds an asset's bytes in an archive.
+ *
+ * @param pack an archive returned from asset_pack_open()
+ * @param path the path the asset was packed under
+ * @param size set to the asset's size in bytes, if it is found
+ * @return a pointer to the asset's bytes, or NULL if it is not in the archive
+ */
+const void *asset_pack_find(asset_pack_t *pack, const char *path,
+                            size_t *size);
+
+/**
+ * Makes an archive the one asset_open() reads from.
+ * Replaces (and closes) any archive mounted before.
+ *
+ * @param pack_path the archive to open
+ * @return whether the archive could be opened; if not,
+ *   asset_open() keeps reading loose files
+ */
+bool asset_pack_mount(const char *pack_path);
+
+/**
+ * Closes the mounted archive, if there is one.
+ */
+void asset_pack_unmount(void);
+
+/**
+ * Opens an asset for SDL's *_RW loaders, e.g. IMG_LoadTexture_RW().
+ * The asset comes from the mounted archive if it holds the path,
+ * and is read from disk otherwise.
+ *
+ * @param path the asset's path, e.g. "assets/tank.png"
+ * @return a read-only SDL_RWops, or NULL if the asset cannot be found;
+ *   pass freesrc = 1 to the loader so it is closed afterwards
+ */
+SDL_RWops *asset_open(const char *path);
+
+#endif // #ifndef __ASSET_PACK_H__
@@ -0,0 +1,76 @@
+#ifndef __AUDIO_H__
+#define __AUDIO_H__
+
+#include <SDL2/SDL_mixer.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * The most sound effects that can be loaded at once.
+ */
+#define MAX_SOUNDS 16
+
+/**
+ * Counters for how the channel pool is being used.
+ */
+typedef struct {
+  /** Sounds started on a free channel */
+  size_t played;
+  /** Sounds that cut off the oldest voice of the same sound instead */
+  size_t stolen;
+  /** Sounds that could not be played at all */
+  size_t failed;
+} audio_stats_t;
+
+/**
+ * Opens the audio device and starts the background music, if there is any.
+ * Must be called once before any of the other audio functions.
+ *
+ * @param music_path the music file to loop, or NULL for no music
+ * @return whether the audio device could be opened; if not, the other
+ *   audio functions do nothing, so the game can run without sound
+ */
+bool audio_init(const char *music_path);
+
+/**
+ * Decodes a sound effect once and gives it its own pool of channels.
+ * Meant to be called at startup, since it reads the file and allocates.
+ *
+ * @param path the WAV file to load
+ * @param max_voices how many copies of the sound may play at once;
+ *   playing one more cuts off the oldest
+ * @return the id to pass to audio_play()
+ */
+size_t audio_load(const char *path, size_t max_voices);
+
+/**
+ * Like audio_load(), but for a sound that is already decoded,
+ * e.g. by an asset loader.
+ *
+ * @param chunk the decoded sound, which the audio module now owns;
+ *   NULL for a sound that failed to load
+ * @param max_voices how many copies of the sound may play at once
+ * @return the id to pass to audio_play()
+ */
+size_t audio_add(Mix_Chunk *chunk, size_t max_voices);
+
+/**
+ * Plays a loaded sound effect on one of its channels.
+ * Does no file I/O or allocation.
+ *
+ * @param sound an id returned from audio_load()
+ */
+void audio_play(size_t sound);
+
+/**
+ * Gets how many sounds were played, stolen and failed so far.
+ */
+audio_stats_t audio_stats(void);
+
+/**
+ * Stops all sound, frees every loaded sound and the music,
+ * and closes the audio device.
+ */
+void audio_free(void);
+
+#endif // #ifndef __AUDIO_H__
@@ -0,0 +1,110 @@
+#ifndef __BENCH_STATS_H__
+#define __BENCH_STATS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Statistics for deciding whether a benchmark got slower, and the reading
+ * side of the results files bin/bench writes (see bench/bench.c).
+ *
+ * Two runs are compared with Welch's t-test on their samples, which allows
+ * them to have different variances and sample counts. A benchmark has
+ * regressed if the 95% confidence interval of its change in ns/op lies
+ * entirely above zero and its mean slowed down by more than a threshold,
+ * so noise alone does not fail a comparison, and neither does a real but
+ * negligible slowdown.
+ */
+
+/**
+ * The most samples a benchmark records.
+ */
+#define BENCH_MAX_SAMPLES 100
+
+/**
+ * The longest benchmark name, and the longest machine fingerprint.
+ */
+#define BENCH_NAME_LENGTH 64
+
+/**
+ * The mean and sample standard deviation of a benchmark's samples.
+ */
+typedef struct {
+  double mean;
+  double stddev;
+  size_t count;
+} bench_summary_t;
+
+/**
+ * How a benchmark's current run differs from its baseline.
+ * Changes are relative to the baseline mean, e.g. 0.1 is 10% slower.
+ */
+typedef struct {
+  double change;
+  /** The 95% confidence interval of the change */
+  double change_low;
+  double change_high;
+  /** Welch's t statistic and its degrees of freedom */
+  double t;
+  double df;
+  /** Whether the confidence interval excludes no change */
+  bool significant;
+} bench_comparison_t;
+
+/**
+ * One benchmark read from a results file.
+ */
+typedef struct {
+  char name[BENCH_NAME_LENGTH];
+  double samples[BENCH_MAX_SAMPLES];
+  size_t count;
+} bench_record_t;
+
+/**
+ * Computes the mean and sample standard deviation of some samples.
+ *
+ * @param samples the samples
+ * @param count how many samples there are, at least 1
+ */
+bench_summary_t bench_summarize(const double *samples, size_t count);
+
+/**
+ * Gets the two-sided 95% critical value of Student's t distribution.
+ *
+ * @param df the degrees of freedom, at least 1
+ */
+double bench_t_critical(double df);
+
+/**
+ * Compares a benchmark's current samples against its baseline's.
+ *
+ * @param baseline the baseline's summary, with at least 2 samples
+ * @param current the current run's summary, with at least 2 samples
+ */
+bench_comparison_t bench_compare(bench_summary_t baseline,
+                                 bench_summary_t current);
+
+/**
+ * Returns whether a comparison shows a slowdown that is both significant
+ * and larger than a threshold.
+ *
+ * @param comparison a comparison from bench_compare()
+ * @param threshold the smallest slowdown that counts, e.g. 0.05 for 5%
+ */
+bool bench_is_regression(bench_comparison_t comparison, double threshold);
+
+/**
+ * Reads the benchmarks from a results file written by bin/bench.
+ *
+ * @param path the file to read
+ * @param records where to put the benchmarks
+ * @param max_records how many records there is room for
+ * @param fingerprint if not NULL, receives the machine fingerprint the
+ *   results were recorded on (BENCH_NAME_LENGTH bytes)
+ * @return the number of benchmarks read, or -1 if the file could not be
+ *   read or is not a results file
+ */
+int bench_read_results(const char *path, bench_record_t *records,
+                       size_t max_records, char *fingerprint);
+
+#endif // #ifndef __BENCH_STATS_H__
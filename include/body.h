@@ -1,8 +1,10 @@
 #ifndef __BODY_H__
 #define __BODY_H__
 
+#include "collision.h"
 #include "color.h"
 #include "list.h"
+#include "polygon.h"
 #include "vector.h"
 #include <stdbool.h>
 
@@ -34,12 +36,35 @@ extern const size_t AI_90_RIGHT;
  */
 typedef struct body body_t;
 
+/**
+ * The shapes a body can collide as. A circle or capsule body still draws
+ * as its polygon, but collision force creators test the round shape, which
+ * takes a few dot products where the polygon would need one axis per edge.
+ * Bodies whose polygons are rectangles are found to be boxes whenever their
+ * shapes are set, and tested as boxes.
+ */
+typedef enum {
+  /** The body's polygon */
+  COLLIDER_POLYGON,
+  /** The body's polygon, which is a rectangle (see body_get_box()) */
+  COLLIDER_BOX,
+  /** A circle around the body's centroid */
+  COLLIDER_CIRCLE,
+  /** A capsule through the body's centroid, along its rotation */
+  COLLIDER_CAPSULE
+} collider_kind_t;
+
 /**
  * Graphic struct that represents a visual element
  * on the screen, including text.
  */
 typedef struct graphic graphic_t;
 
+/**
+ * A pool that bodies can be recycled into (see body_pool.h).
+ */
+typedef struct body_pool body_pool_t;
+
 /**
  * Initializes a body without any info.
  * Acts like body_init_with_info() where info and info_freer are NULL.
@@ -62,13 +87,47 @@ body_t *body_init(list_t *shape, double mass, rgb_color_t color);
 body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
                             void *info, free_func_t info_freer);
 
+/**
+ * Like body_init_with_info(), but allocates the body from an allocator,
+ * e.g. the one returned by scene_get_allocator().
+ * The shape and info should come from the same allocator.
+ *
+ * @param allocator the allocator to use, or NULL for the heap.
+ *   The body keeps a copy of it.
+ */
+body_t *body_init_with_allocator(list_t *shape, double mass,
+                                 rgb_color_t color, void *info,
+                                 free_func_t info_freer,
+                                 const allocator_t *allocator);
+
 /**
  * Releases the memory allocated for a body.
+ * A body from a pool is handed back to its pool instead.
  *
  * @param body a pointer to a body returned from body_init()
  */
 void body_free(body_t *body);
 
+/**
+ * Puts a body back in the state body_init() leaves it in, reusing its memory.
+ * The body keeps its info, info freer and pool.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param shape the shape to copy into the body's shape,
+ *   which must have the same number of vertices
+ * @param mass the body's new mass
+ * @param color the body's new color
+ */
+void body_reset(body_t *body, list_t *shape, double mass, rgb_color_t color);
+
+/**
+ * Makes body_free() hand a body back to a pool rather than free it.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param pool the pool to hand the body back to, or NULL to free it
+ */
+void body_set_pool(body_t *body, body_pool_t *pool);
+
 /**
  * Gets the current shape of a body.
  * Returns a newly allocated vector list, which must be list_free()d.
@@ -78,6 +137,16 @@ void body_free(body_t *body);
  */
 list_t *body_get_shape(body_t *body);
 
+/**
+ * Like body_get_shape(), but allocates the copy from an arena,
+ * so it does not need to be freed.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param arena the arena to allocate the copy from, e.g. frame_arena()
+ * @return the polygon describing the body's current position
+ */
+list_t *body_get_shape_arena(body_t *body, arena_t *arena);
+
 /**
  * Gets the current center of mass of a body.
  * While this could be calculated with polygon_centroid(), that becomes too slow
@@ -89,6 +158,51 @@ list_t *body_get_shape(body_t *body);
  */
 vector_t body_get_centroid(body_t *body);
 
+/**
+ * Gets the smallest axis-aligned box containing a body's current shape,
+ * without copying the shape.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's bounding box
+ */
+aabb_t body_get_bounds(body_t *body);
+
+/**
+ * Gets the shape a body collides as (see body_set_circle()).
+ */
+collider_kind_t body_get_collider(body_t *body);
+
+/**
+ * Gets the unit normals of a body's edges as it is turned now: normal i is
+ * perpendicular to the edge from vertex i to vertex i + 1
+ * (see find_perp_axis()). They are found once whenever the body's shape is
+ * set, and only turned again when its rotation changes.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return one normal per vertex, owned by the body, valid until its shape
+ *   or rotation next changes
+ */
+const vector_t *body_get_normals(body_t *body);
+
+/**
+ * Gets a box body's rectangle, where it is now, from its first two vertices.
+ * Only meaningful if the body is a box.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's box
+ */
+obb_t body_get_box(body_t *body);
+
+/**
+ * Gets a circle or capsule body's round shape, where it is now: a capsule
+ * lies along the body's rotation, centered on its centroid, and a circle's
+ * segment is just the centroid. Only meaningful if the body is not a polygon.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's capsule
+ */
+capsule_t body_get_capsule(body_t *body);
+
 /**
  * Gets the current velocity of a body.
  *
@@ -105,6 +219,16 @@ vector_t body_get_velocity(body_t *body);
  */
 double body_get_rotation(body_t *body);
 
+/**
+ * Gets a number that tells a body apart from every other body made in the
+ * program, e.g. to key things by pairs of bodies. A pooled body gets a new
+ * id each time it is reset, unlike its address, which is reused.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's id, which is never 0
+ */
+size_t body_get_id(body_t *body);
+
 /**
  * Gets the mass of a body.
  *
@@ -159,6 +283,15 @@ void body_set_velocity(body_t *body, vector_t v);
 
 void body_set_shape(body_t *body, list_t *shape);
 
+/**
+ * Moves a body's vertices to those of another shape, without allocating.
+ * The body's centroid is updated to match.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param shape the vertices to copy, which must be as many as the body has
+ */
+void body_set_vertices(body_t *body, list_t *shape);
+
 void body_set_rotation_speed(body_t *body, double w);
 
 void body_set_magnitude(body_t *body, double magnitude);
@@ -200,6 +333,27 @@ void body_add_impulse(body_t *body, vector_t impulse);
 void body_set_time(body_t *body, double time);
 
 void body_set_rotation_empty(body_t *body, double rotation);
+
+/**
+ * Computes how far a body will move in its next body_tick(),
+ * given the forces and impulses applied to it so far this tick.
+ *
+ * @param body the body that will be ticked
+ * @param dt the number of seconds the tick will cover
+ * @return the translation body_tick() would apply
+ */
+vector_t body_get_translation(body_t *body, double dt);
+
+/**
+ * Computes the velocity a body will have after its next body_tick(),
+ * given the forces and impulses applied to it so far this tick.
+ *
+ * @param body the body that will be ticked
+ * @param dt the number of seconds the tick will cover
+ * @return the velocity body_tick() would leave the body with
+ */
+vector_t body_next_velocity(body_t *body, double dt);
+
 /**
  * Updates the body after a given time interval has elapsed.
  * Sets acceleration and velocity according to the forces and impulses
@@ -246,6 +400,47 @@ void body_set_ai_time(body_t *body, double time);
 
 void body_set_just_collided(body_t *body, bool just_collided);
 
+/**
+ * Marks a body as a fast-moving projectile. Each scene_tick() sweeps a
+ * bullet along its movement and stops it where it would first touch a body
+ * it has a collision with, so it cannot pass through thin bodies between
+ * ticks however large the tick is. Bullets are not swept against each other.
+ * Bodies are not bullets until this is called.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param is_bullet whether the body is a bullet
+ */
+void body_set_bullet(body_t *body, bool is_bullet);
+
+/**
+ * Returns whether a body is marked as a bullet (see body_set_bullet()).
+ */
+bool body_is_bullet(body_t *body);
+
+/**
+ * Makes a body collide as a circle around its centroid, e.g. for a ball drawn
+ * as a many-sided polygon. Its bounding box becomes the circle's.
+ * Bodies collide as their polygons (or boxes) until this or
+ * body_set_capsule() is called, and again after body_reset().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param radius the circle's radius
+ */
+void body_set_circle(body_t *body, double radius);
+
+/**
+ * Makes a body collide as a capsule through its centroid that turns with the
+ * body, e.g. for a bullet drawn as a long, thin rectangle.
+ * At no rotation, the capsule's segment lies along the x-axis.
+ * Its bounding box becomes the capsule's.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param length the length of the capsule's segment, between the centers of
+ *   its round ends
+ * @param radius the capsule's radius
+ */
+void body_set_capsule(body_t *body, double length, double radius);
+
 void body_set_image_path(body_t *body, char *image_path);
 
 char *body_get_image_path(body_t *body);
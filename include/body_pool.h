@@ -0,0 +1,77 @@
+#ifndef __BODY_POOL_H__
+#define __BODY_POOL_H__
+
+#include "body.h"
+#include "color.h"
+#include "list.h"
+#include <stddef.h>
+
+/**
+ * A pool of bodies that all start with the same shape, e.g. bullets.
+ * Freeing a pooled body (usually by removing it from its scene) hands it back
+ * to the pool with its shape and info still allocated, so the next
+ * body_pool_get() reuses it instead of allocating.
+ */
+typedef struct body_pool body_pool_t;
+
+/**
+ * Counters for how well a pool is recycling its bodies.
+ */
+typedef struct {
+  /** Bodies handed out from the pool's spares */
+  size_t hits;
+  /** Bodies that had to be allocated because there were no spares */
+  size_t misses;
+  /** Bodies handed out and not yet freed */
+  size_t in_use;
+  /** The most bodies that were ever in use at once */
+  size_t high_water;
+} body_pool_stats_t;
+
+/**
+ * Allocates a pool and fills it with spare bodies.
+ *
+ * @param shape the shape every body starts with; the pool takes ownership
+ * @param initial how many bodies to allocate up front
+ * @return the new pool
+ */
+body_pool_t *body_pool_init(list_t *shape, size_t initial);
+
+/**
+ * Frees a pool and its spare bodies.
+ * Every body the pool handed out must have been freed first,
+ * e.g. by freeing the scene they were added to.
+ *
+ * @param pool a pool returned from body_pool_init()
+ */
+void body_pool_free(body_pool_t *pool);
+
+/**
+ * Gets a body from a pool, in the state body_init() would leave it in:
+ * at rest, with the pool's shape and no rotation.
+ * The body's info is a size_t type, like the game's other bodies.
+ * Only allocates if the pool has no spare bodies.
+ *
+ * @param pool a pool returned from body_pool_init()
+ * @param mass the mass of the body
+ * @param color the color of the body
+ * @param type the value to store in the body's info
+ * @return the body, which goes back to the pool when body_free()d
+ */
+body_t *body_pool_get(body_pool_t *pool, double mass, rgb_color_t color,
+                      size_t type);
+
+/**
+ * Takes back a body from the pool. Called by body_free() on pooled bodies.
+ *
+ * @param pool the pool the body came from
+ * @param body a body returned from body_pool_get()
+ */
+void body_pool_release(body_pool_t *pool, body_t *body);
+
+/**
+ * Gets how many bodies were reused and allocated so far.
+ */
+body_pool_stats_t body_pool_stats(body_pool_t *pool);
+
+#endif // #ifndef __BODY_POOL_H__
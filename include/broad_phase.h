@@ -0,0 +1,148 @@
+#ifndef __BROAD_PHASE_H__
+#define __BROAD_PHASE_H__
+
+#include "aabb_tree.h"
+#include "body.h"
+#include "list.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Finds the pairs of bodies whose bounding boxes overlap, so that collision
+ * force creators can skip the separating-axis test for pairs that cannot be
+ * touching (see scene_set_broad_phase()).
+ *
+ * The sweep-and-prune broad phase keeps each body's bounding box as an
+ * interval on each axis, in arrays of interval endpoints sorted by position,
+ * and keeps the set of overlapping pairs between updates. Bodies only move a
+ * little between ticks, so an update re-sorts the endpoints with an
+ * insertion sort, which is close to linear when they are nearly sorted
+ * already. Each swap of one body's start past another's end is exactly where
+ * a pair begins or stops overlapping, so the pair set is updated at those
+ * swaps rather than rebuilt.
+ *
+ * The AABB tree broad phase keeps bodies with infinite mass, such as the
+ * map's obstacles, in a static tree (see aabb_tree_build()) that is only
+ * rebuilt when they change, and every other body in a dynamic tree whose
+ * fattened leaves are only reinserted when their bodies move out of them.
+ * Each update finds the pairs within the dynamic tree and between it and
+ * the static tree, and never tests static bodies against each other.
+ */
+typedef struct broad_phase broad_phase_t;
+
+/**
+ * The ways a scene can find candidate collision pairs.
+ */
+typedef enum {
+  /** No broad phase: every collision force creator runs its test */
+  BROAD_PHASE_NONE,
+  BROAD_PHASE_SWEEP_AND_PRUNE,
+  BROAD_PHASE_AABB_TREE,
+  BROAD_PHASE_KIND_COUNT
+} broad_phase_kind_t;
+
+/**
+ * Allocates a broad phase with no bodies in it.
+ *
+ * @param kind how to find overlapping pairs; not BROAD_PHASE_NONE
+ * @return the new broad phase
+ */
+broad_phase_t *broad_phase_init(broad_phase_kind_t kind);
+
+/**
+ * Releases a broad phase. The bodies in it are not freed.
+ *
+ * @param broad_phase a broad phase returned from broad_phase_init()
+ */
+void broad_phase_free(broad_phase_t *broad_phase);
+
+/**
+ * Gets the kind of a broad phase.
+ */
+broad_phase_kind_t broad_phase_kind(broad_phase_t *broad_phase);
+
+/**
+ * Gets the name of a kind of broad phase, e.g. "sweep and prune".
+ */
+const char *broad_phase_name(broad_phase_kind_t kind);
+
+/**
+ * Brings a broad phase up to date with a list of bodies: adds the bodies it
+ * has not seen, drops the ones that are no longer in the list (or are marked
+ * for removal), and updates the overlapping pairs from the bodies' current
+ * bounding boxes.
+ *
+ * @param broad_phase a broad phase returned from broad_phase_init()
+ * @param bodies every body that can collide, e.g. a scene's bodies
+ */
+void broad_phase_update(broad_phase_t *broad_phase, list_t *bodies);
+
+/**
+ * Brings a broad phase's bodies and their bounding boxes up to date, like
+ * broad_phase_update(), for queries, without finding the overlapping pairs
+ * again: they are left as of the last update. Sweep and prune keeps its
+ * pairs as it sorts the boxes, so for it this is the same as an update.
+ *
+ * @param broad_phase a broad phase returned from broad_phase_init()
+ * @param bodies every body that can collide, e.g. a scene's bodies
+ */
+void broad_phase_refresh(broad_phase_t *broad_phase, list_t *bodies);
+
+/**
+ * Returns whether two bodies' bounding boxes overlapped at the last update.
+ * Bodies the broad phase has not seen yet may always collide.
+ *
+ * @param broad_phase a broad phase returned from broad_phase_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ */
+bool broad_phase_may_collide(broad_phase_t *broad_phase, body_t *body1,
+                             body_t *body2);
+
+/**
+ * Gets the number of overlapping pairs found by the last update.
+ *
+ * @param broad_phase a broad phase returned from broad_phase_init()
+ */
+size_t broad_phase_pair_count(broad_phase_t *broad_phase);
+
+/**
+ * Calls a function with each pair of bodies whose bounding boxes overlapped
+ * at the last update, in no particular order.
+ *
+ * @param broad_phase a broad phase returned from broad_phase_init()
+ * @param visitor the function to call with each pair
+ * @param aux an auxiliary value to pass to the visitor
+ */
+void broad_phase_visit_pairs(broad_phase_t *broad_phase, pair_visitor_t visitor,
+                             void *aux);
+
+/**
+ * Calls a function with each body whose bounding box, as of the last update
+ * or refresh, may overlap a box, until it asks to stop. The AABB tree broad
+ * phase searches its trees; sweep and prune checks every body's box.
+ *
+ * @param broad_phase a broad phase returned from broad_phase_init()
+ * @param box the box to search
+ * @param visitor the function to call with each body found
+ * @param aux an auxiliary value to pass to the visitor
+ * @return false if the visitor stopped the search, otherwise true
+ */
+bool broad_phase_query(broad_phase_t *broad_phase, aabb_t box,
+                       body_visitor_t visitor, void *aux);
+
+/**
+ * Calls a function with each body whose bounding box, as of the last update
+ * or refresh, a ray may pass through (see aabb_tree_raycast()).
+ *
+ * @param broad_phase a broad phase returned from broad_phase_init()
+ * @param origin where the ray starts
+ * @param end where the ray ends
+ * @param visitor the function to call with each body found
+ * @param aux an auxiliary value to pass to the visitor
+ * @return how far along the ray the visitor last said to keep searching
+ */
+double broad_phase_raycast(broad_phase_t *broad_phase, vector_t origin,
+                           vector_t end, ray_visitor_t visitor, void *aux);
+
+#endif // #ifndef __BROAD_PHASE_H__
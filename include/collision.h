@@ -1,7 +1,9 @@
 #ifndef __COLLISION_H__
 #define __COLLISION_H__
 
+#include "arena.h"
 #include "list.h"
+#include "polygon.h"
 #include "vector.h"
 #include <stdbool.h>
 
@@ -21,6 +23,66 @@ typedef struct {
   vector_t axis;
 } collision_info_t;
 
+/**
+ * When two moving shapes first touch, if they do.
+ */
+typedef struct {
+  /** Whether the shapes touch during their movement */
+  bool collided;
+  /**
+   * How far through their movement the shapes first touch,
+   * from 0 at the start to 1 at the end.
+   * If collided is false, this value is undefined.
+   */
+  double time;
+  /**
+   * The unit normal of the faces that first touch, pointing from the first
+   * shape towards the second. If collided is false, this value is undefined.
+   */
+  vector_t axis;
+} impact_info_t;
+
+/**
+ * A capsule: every point within a radius of a segment.
+ * A circle is a capsule whose segment has the same start and end.
+ */
+typedef struct {
+  vector_t start;
+  vector_t end;
+  double radius;
+} capsule_t;
+
+/**
+ * The ways two polygons can be tested for a collision
+ * (see find_body_collision()).
+ */
+typedef enum {
+  /**
+   * The separating-axis test for polygons with few vertices between them,
+   * and GJK for the rest
+   */
+  NARROW_PHASE_AUTO,
+  /** The separating-axis test, e.g. find_collision_cached() */
+  NARROW_PHASE_SAT,
+  /** GJK, with EPA for the depth (see find_penetration()) */
+  NARROW_PHASE_GJK,
+  NARROW_PHASE_KIND_COUNT
+} narrow_phase_kind_t;
+
+/**
+ * Gets the name of a kind of narrow phase, e.g. "separating axis".
+ */
+const char *narrow_phase_name(narrow_phase_kind_t kind);
+
+/**
+ * Computes the unit normal of each of a polygon's edges: axes[i] is
+ * perpendicular to the edge from vertex i to vertex i + 1.
+ *
+ * @param shape the polygon
+ * @param axes room for one normal per vertex
+ */
+void find_perp_axis(list_t *shape, vector_t *axes);
+
 /**
  * Computes the status of the collision between two convex polygons.
  * The shapes are given as lists of vertices in counterclockwise order.
@@ -34,4 +96,133 @@ typedef struct {
  */
 collision_info_t find_collision(list_t *shape1, list_t *shape2);
 
+/**
+ * Like find_collision(), but does its scratch work in an arena and
+ * leaves the shapes alone, so they can be arena lists too
+ * (see body_get_shape_arena()).
+ *
+ * @param arena the arena to allocate from; it is rewound before returning
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @return whether the shapes are colliding, and if so, the collision axis
+ */
+collision_info_t find_collision_arena(arena_t *arena, list_t *shape1,
+                                      list_t *shape2);
+
+/**
+ * Computes the status of the collision between two convex polygons whose
+ * edge normals are already known (see find_perp_axis() and
+ * body_get_normals()), so none are computed.
+ * The axes are numbered with shape1's normals first, then shape2's.
+ * If first_axis is given, the test starts from that axis, and when the
+ * shapes are apart it is set to the axis that separated them. Keeping it
+ * between tests of the same pair means a pair that stays apart is usually
+ * ruled out by the first axis it tries.
+ * Unlike find_collision(), this does not free the shapes.
+ *
+ * @param shape1 the first shape
+ * @param normals1 the unit normals of the first shape's edges
+ * @param shape2 the second shape
+ * @param normals2 the unit normals of the second shape's edges
+ * @param first_axis the axis to test first, which is updated; may be NULL
+ * @return whether the shapes are colliding, and if so, the collision axis
+ */
+collision_info_t find_collision_cached(list_t *shape1, const vector_t *normals1,
+                                       list_t *shape2, const vector_t *normals2,
+                                       size_t *first_axis);
+
+/**
+ * Tests whether one of two convex polygons' edge normals separates them,
+ * e.g. the axis that last separated them (see find_collision_cached()).
+ * Unlike find_collision(), this does not free the shapes.
+ *
+ * @param shape1 the first shape
+ * @param normals1 the unit normals of the first shape's edges
+ * @param shape2 the second shape
+ * @param normals2 the unit normals of the second shape's edges
+ * @param axis the normal to test, numbered as in find_collision_cached()
+ * @return whether the shapes' projections on the normal are apart
+ */
+bool is_separating_axis(list_t *shape1, const vector_t *normals1,
+                        list_t *shape2, const vector_t *normals2,
+                        size_t axis);
+
+/**
+ * Finds when two convex polygons moving in straight lines first touch,
+ * by sweeping the separating-axis test: on each of the shapes' edge
+ * normals, the shapes' projections overlap for an interval of the movement,
+ * and the shapes touch where all of these intervals overlap.
+ * Rotation during the movement is ignored.
+ *
+ * Shapes that already overlap at the start do not count as colliding,
+ * since find_collision() finds them without sweeping.
+ * Unlike find_collision(), this does not free the shapes.
+ *
+ * @param shape1 the first shape, at the start of its movement
+ * @param displacement1 how far the first shape moves
+ * @param shape2 the second shape, at the start of its movement
+ * @param displacement2 how far the second shape moves
+ * @return whether the shapes touch, and if so, when and along what axis
+ */
+impact_info_t find_time_of_impact(list_t *shape1, vector_t displacement1,
+                                  list_t *shape2, vector_t displacement2);
+
+/**
+ * Computes the status of the collision between two capsules (or circles)
+ * from the closest points on their segments, without any projections.
+ *
+ * @param capsule1 the first capsule
+ * @param capsule2 the second capsule
+ * @return whether the capsules are colliding, and if so, the collision axis,
+ *   a unit vector pointing from capsule1 towards capsule2
+ */
+collision_info_t find_collision_capsules(capsule_t capsule1,
+                                         capsule_t capsule2);
+
+/**
+ * Computes the status of the collision between a capsule (or circle) and a
+ * convex polygon. This is the separating-axis test on the polygon's edge
+ * normals, the capsule's side and the directions from its ends to the
+ * nearest vertices, where the capsule's projection on each axis takes
+ * two dot products rather than one per vertex.
+ * Unlike find_collision(), this does not free the polygon.
+ *
+ * @param capsule the capsule
+ * @param polygon the polygon, as a list of vertices in counterclockwise order
+ * @return whether the shapes are colliding, and if so, the collision axis,
+ *   a unit vector pointing from the capsule towards the polygon
+ */
+collision_info_t find_collision_capsule_polygon(capsule_t capsule,
+                                                list_t *polygon);
+
+/**
+ * Computes the status of the collision between two boxes. Each box's
+ * projection on an axis is its center's plus or minus two dot products,
+ * so no vertices are projected. Boxes that are both axis-aligned only
+ * compare their extents in x and y, and boxes turned by a multiple of a
+ * right angle from each other share their axes, so only two are tested.
+ *
+ * @param box1 the first box
+ * @param box2 the second box
+ * @return whether the boxes are colliding, and if so, the collision axis,
+ *   a unit vector pointing from box1 towards box2
+ */
+collision_info_t find_collision_boxes(obb_t box1, obb_t box2);
+
+/**
+ * Computes the status of the collision between a box and a convex polygon,
+ * by the separating-axis test on the box's two axes and the polygon's edge
+ * normals, skipping the normals that lie along the box's axes.
+ * Unlike find_collision(), this does not free the polygon.
+ *
+ * @param box the box
+ * @param polygon the polygon, as a list of vertices in counterclockwise order
+ * @param normals the unit normals of the polygon's edges, if they are known
+ *   (see find_perp_axis()); if NULL, they are computed
+ * @return whether the shapes are colliding, and if so, the collision axis,
+ *   a unit vector pointing from the box towards the polygon
+ */
+collision_info_t find_collision_box_polygon(obb_t box, list_t *polygon,
+                                            const vector_t *normals);
+
 #endif // #ifndef __COLLISION_H__
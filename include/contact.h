@@ -0,0 +1,137 @@
+#ifndef __CONTACT_H__
+#define __CONTACT_H__
+
+#include "allocator.h"
+#include "body.h"
+#include "gjk.h"
+#include "list.h"
+#include "vector.h"
+#include <stddef.h>
+
+/** The most points two convex shapes touch at */
+#define CONTACT_MAX_POINTS 2
+
+/**
+ * A point where two shapes touch.
+ */
+typedef struct {
+  /** Halfway between the shapes' surfaces */
+  vector_t point;
+  /** How far the shapes overlap at the point */
+  double depth;
+  /**
+   * The edges and vertex the point came from, which stay the same while
+   * the shapes keep touching the same way, so the point can be found again
+   * next tick
+   */
+  size_t feature;
+  /**
+   * The impulse the solver applied at the point, along the normal, which
+   * it starts from next tick (see contact_manifold_warm_start())
+   */
+  double normal_impulse;
+} contact_point_t;
+
+/**
+ * Where two shapes touch: up to two points along one normal.
+ */
+typedef struct {
+  /** A unit vector pointing from the first shape towards the second */
+  vector_t normal;
+  size_t count;
+  contact_point_t points[CONTACT_MAX_POINTS];
+} contact_manifold_t;
+
+/**
+ * Solves the contacts found in a tick together, by sequential impulses:
+ * each contact point's impulse is adjusted in turn so that the shapes stop
+ * moving into each other there, for a few passes over every point, so the
+ * impulses settle on what a pile of bodies pressing on each other needs.
+ * Each point's total impulse is kept from going negative (pulling), and
+ * starts from what it was last tick, so a resting contact needs little
+ * more work. Overlap beyond a small slop is pushed out a fraction at a
+ * time by a bias on the velocity the points aim for (Baumgarte's method).
+ *
+ * Bodies have no moment of inertia, so the solver only changes their
+ * velocities, through their impulses (see body_add_impulse()).
+ */
+typedef struct contact_solver contact_solver_t;
+
+/**
+ * Finds where two convex polygons touch, given how deep they overlap
+ * (see find_penetration()). The edge of one shape facing the other most
+ * squarely is the reference edge, the other shape's edge facing it is
+ * clipped to the reference edge's sides, and the clipped points inside the
+ * reference edge are the contact points.
+ * The shapes' vertices may be in either order.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @param penetration the shapes' penetration
+ * @return the contact points, with no impulses; none if the shapes are apart
+ */
+contact_manifold_t find_contact_manifold(list_t *shape1, list_t *shape2,
+                                         penetration_info_t penetration);
+
+/**
+ * Makes a manifold with the one point a penetration found, e.g. for
+ * circles and capsules.
+ *
+ * @param penetration the shapes' penetration
+ * @return the contact point, with no impulse; none if the shapes are apart
+ */
+contact_manifold_t contact_manifold_point(penetration_info_t penetration);
+
+/**
+ * Gives a manifold's points the impulses of the points of last tick's
+ * manifold that came from the same features.
+ *
+ * @param manifold this tick's manifold
+ * @param old last tick's manifold for the same shapes
+ */
+void contact_manifold_warm_start(contact_manifold_t *manifold,
+                                 const contact_manifold_t *old);
+
+/**
+ * Allocates a contact solver with no contacts.
+ *
+ * @param allocator where to allocate the solver's memory, e.g. a scene's
+ * @return the new solver
+ */
+contact_solver_t *contact_solver_init(const allocator_t *allocator);
+
+/**
+ * Releases a contact solver. Its manifolds and bodies are not freed.
+ */
+void contact_solver_free(contact_solver_t *solver);
+
+/**
+ * Adds two bodies' contact to be solved with the rest of the tick's.
+ * The manifold must stay where it is until contact_solver_solve(), which
+ * writes the impulses it used back into it.
+ *
+ * @param solver a solver returned from contact_solver_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param manifold where the bodies touch, with the normal from body1
+ * @param elasticity the "coefficient of restitution" of the contact
+ */
+void contact_solver_add(contact_solver_t *solver, body_t *body1,
+                        body_t *body2, contact_manifold_t *manifold,
+                        double elasticity);
+
+/**
+ * Gets the number of contacts added since the last solve.
+ */
+size_t contact_solver_count(contact_solver_t *solver);
+
+/**
+ * Solves the contacts added since the last solve, by adding impulses to
+ * their bodies, and forgets them.
+ *
+ * @param solver a solver returned from contact_solver_init()
+ * @param dt the time the tick being solved takes
+ */
+void contact_solver_solve(contact_solver_t *solver, double dt);
+
+#endif // #ifndef __CONTACT_H__
@@ -0,0 +1,127 @@
+#ifndef __CONTACT_CACHE_H__
+#define __CONTACT_CACHE_H__
+
+#include "allocator.h"
+#include "body.h"
+#include "contact.h"
+#include <stddef.h>
+
+/**
+ * The pairs of bodies that are touching, kept from tick to tick in a hash
+ * table keyed by the bodies' ids (see body_get_id()), so a pair is found
+ * in constant time whichever collision found it, and whichever order the
+ * bodies are given in. Collisions touch their pair's contact each tick the
+ * bodies touch, which tells them whether the contact began this tick, and
+ * keeps its manifold for the solver to warm-start from.
+ * At the end of a tick, every contact that was not touched is ended
+ * together (see contact_cache_expire()).
+ */
+typedef struct contact_cache contact_cache_t;
+
+/**
+ * What happened to a pair of bodies' contact in a tick.
+ */
+typedef enum {
+  /** The bodies started touching */
+  CONTACT_BEGIN,
+  /** The bodies were touching last tick too */
+  CONTACT_PERSIST,
+  /** The bodies stopped touching, or one of them was removed */
+  CONTACT_END
+} contact_event_t;
+
+/**
+ * A pair of bodies that are touching.
+ */
+typedef struct {
+  /** The bodies, in the order they were first touched in */
+  body_t *body1;
+  body_t *body2;
+  /**
+   * Where the bodies touch, with the normal from body1, for a physics
+   * collision. Until it is replaced with this tick's manifold, it is last
+   * tick's, with the impulses the solver applied.
+   */
+  contact_manifold_t manifold;
+  /** The tick the contact began */
+  size_t began;
+  /** The last tick the contact was touched */
+  size_t touched;
+} contact_t;
+
+/**
+ * A function called with each contact event, once per contact per tick.
+ *
+ * @param body1 the contact's first body
+ * @param body2 the contact's second body
+ * @param event what happened to the contact
+ * @param aux the value passed to contact_cache_set_listener()
+ */
+typedef void (*contact_listener_t)(body_t *body1, body_t *body2,
+                                   contact_event_t event, void *aux);
+
+/**
+ * Allocates a contact cache with no contacts.
+ *
+ * @param allocator where to allocate the contacts, e.g. a scene's
+ * @return the new cache
+ */
+contact_cache_t *contact_cache_init(const allocator_t *allocator);
+
+/**
+ * Releases a contact cache and its contacts, without ending them.
+ */
+void contact_cache_free(contact_cache_t *cache);
+
+/**
+ * Sets the function called with each contact event, or NULL for none.
+ *
+ * @param cache a cache returned from contact_cache_init()
+ * @param listener the function to call
+ * @param aux an auxiliary value to pass to the listener
+ */
+void contact_cache_set_listener(contact_cache_t *cache,
+                                contact_listener_t listener, void *aux);
+
+/**
+ * Records that two bodies are touching this tick, adding their contact if
+ * they were not. Every touch of a pair in the same tick gets the same
+ * event, so each collision between the bodies sees the contact begin.
+ * The contact stays where it is until it ends.
+ *
+ * @param cache a cache returned from contact_cache_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param event where to store whether the contact began or persisted
+ * @return the bodies' contact
+ */
+contact_t *contact_cache_touch(contact_cache_t *cache, body_t *body1,
+                               body_t *body2, contact_event_t *event);
+
+/**
+ * Finds two bodies' contact, in either order.
+ *
+ * @param cache a cache returned from contact_cache_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return the contact, or NULL if the bodies are not touching
+ */
+contact_t *contact_cache_find(contact_cache_t *cache, body_t *body1,
+                              body_t *body2);
+
+/**
+ * Gets the number of contacts, i.e. pairs of bodies touching.
+ */
+size_t contact_cache_size(contact_cache_t *cache);
+
+/**
+ * Ends every contact that was not touched this tick, or that has a body
+ * marked for removal, and starts the next tick. This must be called before
+ * the removed bodies are freed.
+ *
+ * @param cache a cache returned from contact_cache_init()
+ * @return the number of contacts that ended
+ */
+size_t contact_cache_expire(contact_cache_t *cache);
+
+#endif // #ifndef __CONTACT_CACHE_H__
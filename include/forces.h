@@ -85,7 +85,9 @@ void create_drag(scene_t *scene, double gamma, body_t *body);
  * This generalizes create_destructive_collision() from last week,
  * allowing different things to happen on a collision.
  * The handler is passed the bodies, the collision axis, and an auxiliary value.
- * It should only be called once while the bodies are still colliding.
+ * It is only called when the bodies start touching, i.e. when the scene's
+ * contact for them begins (see scene_touch_contact()), so it runs once
+ * however long they stay touching.
  *
  * @param scene the scene containing the bodies
  * @param body1 the first body
@@ -98,6 +100,68 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2,
                       collision_handler_t handler, void *aux,
                       free_func_t freer);
 
+/**
+ * Tests two bodies for a collision the cheapest way their shapes allow
+ * (see collider_kind_t): circles and capsules are tested against each
+ * other in closed form, and against anything else with
+ * find_collision_capsule_polygon(); boxes are tested against each other
+ * with find_collision_boxes(), and against polygons with
+ * find_collision_box_polygon(). Only two polygons that are not boxes run the
+ * full separating-axis test. The shapes are copied into the frame arena,
+ * which is rewound before returning.
+ *
+ * Polygons are tested along their cached edge normals
+ * (see body_get_normals()), starting from first_axis if it is given
+ * (see find_collision_cached()).
+ *
+ * Every pair but two round bodies or two boxes can be tested with GJK
+ * instead (see find_penetration()), which is what NARROW_PHASE_GJK does,
+ * and what NARROW_PHASE_AUTO does for pairs with many vertices between
+ * them, such as the hearts. Two polygons apart are still first tested
+ * along the one axis that last separated them, which rules out a pair
+ * that stays apart faster than GJK does.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param kind how to test polygons, e.g. scene_get_narrow_phase()
+ * @param first_axis the axis that last separated the bodies' polygons,
+ *   which is updated; may be NULL
+ * @return whether the bodies are colliding, and if so, the collision axis,
+ *   a unit vector pointing from body1 towards body2
+ */
+collision_info_t find_body_collision(body_t *body1, body_t *body2,
+                                     narrow_phase_kind_t kind,
+                                     size_t *first_axis);
+
+/**
+ * Finds where two colliding bodies touch: the points along two polygons'
+ * facing edges (see find_contact_manifold()), or the one point of a circle
+ * or capsule. The normal comes from find_penetration(), so it always
+ * points from body1 towards body2.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return the contact points, with no impulses; none if the bodies are apart
+ */
+contact_manifold_t find_body_manifold(body_t *body1, body_t *body2);
+
+/**
+ * Finds when two moving bodies first touch, sweeping the shapes their
+ * collisions test (see find_body_collision()): a circle or capsule is swept
+ * by find_time_of_impact_capsule(), so a round bullet stops where its
+ * rounded ends meet a body rather than where its polygon's corners would,
+ * and two polygons by find_time_of_impact().
+ *
+ * @param body1 the first body
+ * @param displacement1 how far the first body moves
+ * @param body2 the second body
+ * @param displacement2 how far the second body moves
+ * @return whether the bodies touch, and if so, when and along what axis,
+ *   a unit vector pointing from body1 towards body2
+ */
+impact_info_t find_body_time_of_impact(body_t *body1, vector_t displacement1,
+                                       body_t *body2, vector_t displacement2);
+
 /**
  * Adds a force creator to a scene that destroys two bodies when they collide.
  * The bodies should be destroyed by calling body_remove().
@@ -116,13 +180,16 @@ void create_partial_destructive_collision(scene_t *scene, body_t *body1,
 /**
  * Adds a force creator to a scene that applies impulses
  * to resolve collisions between two bodies in the scene.
- * This should be represented as an on-collision callback
- * registered with create_collision().
  *
- * You may remember from project01 that you should avoid applying impulses
- * multiple times while the bodies are still colliding.
- * You should also have a special case that allows either body1 or body2
- * to have mass INFINITY, as this is useful for simulating walls.
+ * Each tick the bodies touch, the force creator finds where
+ * (see find_body_manifold()) and adds the contact to the scene, which solves
+ * every contact of the tick together (see scene_add_contact()), starting
+ * from the impulses the scene's contact for the bodies kept from last tick
+ * (see scene_touch_contact()). The impulses keep the bodies from moving
+ * into each other, push out any overlap a little at a time, and bounce them
+ * apart if they hit hard enough, so bodies resting on each other settle
+ * rather than colliding again every tick. Either body may have mass
+ * INFINITY, as this is useful for simulating walls.
  *
  * @param scene the scene containing the bodies
  * @param elasticity the "coefficient of restitution" of the collision;
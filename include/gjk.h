@@ -0,0 +1,112 @@
+#ifndef __GJK_H__
+#define __GJK_H__
+
+#include "collision.h"
+#include "list.h"
+#include "vector.h"
+#include <stdbool.h>
+
+/**
+ * How deep two shapes overlap, or how far apart they are, and where.
+ *
+ * The separating-axis test (see find_collision()) projects every vertex of
+ * both shapes onto every edge normal, so its cost grows with the square of
+ * their vertex counts, and it only finds an axis. GJK instead walks the
+ * shapes' Minkowski difference towards the origin one support point at a
+ * time, where each support point takes one pass over the vertices, and
+ * needs only a few of them. When the shapes overlap, EPA grows the
+ * polygon GJK ended with out to the nearest edge of the difference, which
+ * gives the depth, and the vertices it came from give the contact points.
+ */
+typedef struct {
+  /** Whether the shapes overlap (or just touch) */
+  bool collided;
+  /**
+   * A unit vector pointing from the first shape towards the second.
+   * Moving the second shape along it by depth separates the shapes.
+   */
+  vector_t axis;
+  /**
+   * How far the shapes overlap along axis;
+   * if they are apart, minus the distance between them
+   */
+  double depth;
+  /**
+   * The points on each shape nearest the other, if they are apart.
+   * If they overlap, the point of each shape deepest inside the other,
+   * so that point1 - point2 is axis * depth.
+   */
+  vector_t point1;
+  vector_t point2;
+} penetration_info_t;
+
+/**
+ * Finds how deep two convex polygons overlap, or how far apart they are,
+ * by GJK and EPA. The shapes are lists of vertices, which may be in
+ * either order and may repeat. Unlike find_collision(), this does not
+ * free the shapes.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @return whether the shapes overlap, the axis and depth, and the points
+ */
+penetration_info_t find_penetration(list_t *shape1, list_t *shape2);
+
+/**
+ * Like find_penetration(), for a capsule (or circle) and a convex polygon.
+ * GJK works on the capsule's segment, and its radius is taken off the
+ * distance afterwards, so the rounded ends are exact.
+ *
+ * @param capsule the capsule
+ * @param polygon the polygon
+ * @return whether the shapes overlap, the axis from the capsule towards the
+ *   polygon and the depth, and the points
+ */
+penetration_info_t find_penetration_capsule(capsule_t capsule,
+                                            list_t *polygon);
+
+/**
+ * Like find_penetration(), for two capsules (or circles).
+ *
+ * @param capsule1 the first capsule
+ * @param capsule2 the second capsule
+ * @return whether the capsules overlap, the axis and depth, and the points
+ */
+penetration_info_t find_penetration_capsules(capsule_t capsule1,
+                                             capsule_t capsule2);
+
+/**
+ * Like find_time_of_impact(), for a capsule (or circle) and a convex
+ * polygon, so the capsule's rounded ends are swept rather than the corners
+ * of a polygon around it. The capsule is moved up to the gap GJK finds
+ * between the shapes at a time, since it cannot touch the polygon sooner,
+ * until the gap closes. Shapes that already overlap at the start do not
+ * count as colliding.
+ *
+ * @param capsule the capsule, at the start of its movement
+ * @param displacement1 how far the capsule moves
+ * @param polygon the polygon, at the start of its movement
+ * @param displacement2 how far the polygon moves
+ * @return whether the shapes touch, and if so, when and along what axis,
+ *   a unit vector pointing from the capsule towards the polygon
+ */
+impact_info_t find_time_of_impact_capsule(capsule_t capsule,
+                                          vector_t displacement1,
+                                          list_t *polygon,
+                                          vector_t displacement2);
+
+/**
+ * Like find_time_of_impact_capsule(), for two capsules (or circles).
+ *
+ * @param capsule1 the first capsule, at the start of its movement
+ * @param displacement1 how far the first capsule moves
+ * @param capsule2 the second capsule, at the start of its movement
+ * @param displacement2 how far the second capsule moves
+ * @return whether the capsules touch, and if so, when and along what axis
+ */
+impact_info_t find_time_of_impact_capsules(capsule_t capsule1,
+                                           vector_t displacement1,
+                                           capsule_t capsule2,
+                                           vector_t displacement2);
+
+#endif // #ifndef __GJK_H__
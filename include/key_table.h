@@ -0,0 +1,66 @@
+#ifndef __KEY_TABLE_H__
+#define __KEY_TABLE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** An empty slot in a key table; no key may be this */
+extern const uint64_t EMPTY_KEY;
+
+/**
+ * An open-addressed hash table from nonzero keys to indices,
+ * with linear probing. It is kept at most half full.
+ * Its slots can be walked directly: a slot whose key is EMPTY_KEY is free.
+ */
+typedef struct {
+  uint64_t *keys;
+  size_t *values;
+  /** A power of two */
+  size_t capacity;
+  size_t size;
+} key_table_t;
+
+/**
+ * Allocates an empty key table's slots.
+ *
+ * @param table the table to initialize
+ * @param capacity how many slots to start with; a power of two
+ */
+void key_table_init(key_table_t *table, size_t capacity);
+
+/**
+ * Releases a key table's slots.
+ */
+void key_table_free(key_table_t *table);
+
+/**
+ * Sets the index a key maps to, adding the key if it is not there.
+ *
+ * @param table the table
+ * @param key the key; not EMPTY_KEY
+ * @param value the index
+ */
+void key_table_put(key_table_t *table, uint64_t key, size_t value);
+
+/**
+ * Looks up a key.
+ *
+ * @param table the table
+ * @param key the key
+ * @param value where to store the index the key maps to, or NULL
+ * @return whether the key is in the table
+ */
+bool key_table_get(key_table_t *table, uint64_t key, size_t *value);
+
+/**
+ * Removes a key, if it is in the table. A later key may move into its slot.
+ */
+void key_table_remove(key_table_t *table, uint64_t key);
+
+/**
+ * Removes every key, keeping the slots.
+ */
+void key_table_clear(key_table_t *table);
+
+#endif // #ifndef __KEY_TABLE_H__
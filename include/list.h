@@ -1,6 +1,8 @@
 #ifndef __LIST_H__
 #define __LIST_H__
 
+#include "allocator.h"
+#include "arena.h"
 #include <stddef.h>
 
 /**
@@ -28,8 +30,35 @@ typedef void (*free_func_t)(void *);
  */
 list_t *list_init(size_t initial_size, free_func_t freer);
 
+/**
+ * Like list_init(), but allocates the list, and its array as it grows,
+ * from the given allocator.
+ *
+ * @param initial_size the number of elements to allocate space for
+ * @param freer if non-NULL, a function to call on elements in the list
+ *   in list_free() when they are no longer in use
+ * @param allocator the allocator to use, or NULL for the heap.
+ *   The list keeps a copy of it.
+ * @return a pointer to the newly allocated list
+ */
+list_t *list_init_with_allocator(size_t initial_size, free_func_t freer,
+                                 const allocator_t *allocator);
+
+/**
+ * Allocates a list, and its array as it grows, from an arena.
+ * The list has no freer, and it is released along with the arena's memory
+ * rather than by list_free(), so its elements should live in the arena too.
+ *
+ * @param arena the arena to allocate from
+ * @param initial_size the number of elements to allocate space for
+ * @return a pointer to the new list
+ */
+list_t *list_init_arena(arena_t *arena, size_t initial_size);
+
 /**
  * Releases the memory allocated for a list.
+ * Does nothing for a list from list_init_arena(), or any other list whose
+ * allocator has no free function, beyond calling the freer on its elements.
  *
  * @param list a pointer to a list returned from list_init()
  */
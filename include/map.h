@@ -12,6 +12,13 @@ extern const double TRIANGLE_DAMAGE;
 
 list_t *make_rectangle(vector_t corner, double width, double height);
 
+/**
+ * Like make_rectangle(), but allocated from an arena,
+ * for a rectangle that is only drawn this frame.
+ */
+list_t *make_rectangle_arena(arena_t *arena, vector_t corner, double width,
+                             double height);
+
 /**
  * This function initializes the game map and is called once
  *
@@ -0,0 +1,106 @@
+#ifndef __PERF_OVERLAY_H__
+#define __PERF_OVERLAY_H__
+
+#include "scene.h"
+#include "text.h"
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * An on-screen readout of how a demo is performing: its frame rate, frame
+ * time percentiles, how each frame splits between simulating and drawing,
+ * and how much work the scene did. It can be shown and hidden while the
+ * demo runs. The figures are only summarized a few times per second and are
+ * drawn with sdl_draw_glyphs(), so leaving it on costs very little.
+ */
+typedef struct perf_overlay perf_overlay_t;
+
+/**
+ * The number of lines of text the overlay shows.
+ */
+#define PERF_OVERLAY_LINES 6
+
+/**
+ * What one frame cost.
+ */
+typedef struct {
+  /** Nanoseconds from the start of the previous frame to this one's */
+  uint64_t frame_ns;
+  /** Nanoseconds spent updating the game and ticking the scene */
+  uint64_t simulate_ns;
+  /** Nanoseconds spent drawing (or, with a render thread, recording) */
+  uint64_t render_ns;
+  size_t bodies;
+  /** Force creators run by the last scene tick */
+  size_t forces;
+  /** Collision tests run by the last scene tick */
+  size_t collision_tests;
+  /** Heap allocations made last frame, only counted with ALLOC_TRACK */
+  size_t allocations;
+} perf_sample_t;
+
+/**
+ * Allocates a hidden overlay.
+ *
+ * @param text the font to draw with; must outlive the overlay
+ * @param corner the top left corner of the overlay, in scene coordinates
+ * @param size the width and height of the overlay, in scene units
+ * @return the new overlay
+ */
+perf_overlay_t *perf_overlay_init(text_t *text, vector_t corner,
+                                  vector_t size);
+
+/**
+ * Releases an overlay. Its font is not freed.
+ *
+ * @param overlay an overlay returned from perf_overlay_init()
+ */
+void perf_overlay_free(perf_overlay_t *overlay);
+
+/**
+ * Shows a hidden overlay, or hides a shown one.
+ */
+void perf_overlay_toggle(perf_overlay_t *overlay);
+
+/**
+ * Returns whether an overlay is being shown.
+ */
+bool perf_overlay_visible(perf_overlay_t *overlay);
+
+/**
+ * Fills in the scene's share of a frame's sample: its body count, what its
+ * last tick ran (see scene_stats()), and the allocations made last frame.
+ *
+ * @param sample the sample to fill in
+ * @param scene the scene the frame ticked
+ */
+void perf_sample_scene(perf_sample_t *sample, scene_t *scene);
+
+/**
+ * Records what a frame cost. Samples are taken whether or not the overlay
+ * is shown; the text is updated after every quarter second of frames.
+ *
+ * @param overlay an overlay returned from perf_overlay_init()
+ * @param sample what the frame cost
+ */
+void perf_overlay_add_sample(perf_overlay_t *overlay, perf_sample_t sample);
+
+/**
+ * Gets a line of the overlay's text, as of its last update.
+ *
+ * @param overlay an overlay returned from perf_overlay_init()
+ * @param index which line, less than PERF_OVERLAY_LINES
+ */
+const char *perf_overlay_line(perf_overlay_t *overlay, size_t index);
+
+/**
+ * Draws an overlay on top of the current frame, if it is shown.
+ * Call it after everything else is drawn and before sdl_show().
+ *
+ * @param overlay an overlay returned from perf_overlay_init()
+ */
+void perf_overlay_draw(perf_overlay_t *overlay);
+
+#endif // #ifndef __PERF_OVERLAY_H__
@@ -3,6 +3,30 @@
 
 #include "list.h"
 #include "vector.h"
+#include <stdbool.h>
+
+/**
+ * An axis-aligned bounding box: every point with min.x <= x <= max.x
+ * and min.y <= y <= max.y.
+ */
+typedef struct {
+  vector_t min;
+  vector_t max;
+} aabb_t;
+
+/**
+ * An oriented box: a rectangle that may be turned to any angle.
+ */
+typedef struct {
+  vector_t center;
+  /** The unit direction of the box's first side */
+  vector_t axis;
+  /**
+   * Half the box's size along its first side (x) and along the side
+   * perpendicular to it (y)
+   */
+  vector_t half_size;
+} obb_t;
 
 /**
  * Computes the area of a polygon.
@@ -46,4 +70,97 @@ void polygon_translate(list_t *polygon, vector_t translation);
  */
 void polygon_rotate(list_t *polygon, double angle, vector_t point);
 
+/**
+ * Computes the smallest axis-aligned box containing a polygon.
+ *
+ * @param polygon the list of vertices that make up the polygon
+ * @return the polygon's bounding box
+ */
+aabb_t polygon_bounds(list_t *polygon);
+
+/**
+ * Returns whether a polygon is a rectangle: four vertices, with a right angle
+ * at each of them to within rounding error.
+ *
+ * @param polygon the list of vertices that make up the polygon
+ */
+bool polygon_is_rectangle(list_t *polygon);
+
+/**
+ * Returns whether a point lies inside a polygon.
+ * Points on the polygon's edges may count as either inside or outside.
+ *
+ * @param polygon the list of vertices that make up the polygon
+ * @param point the point to test
+ */
+bool polygon_contains(list_t *polygon, vector_t point);
+
+/**
+ * Returns whether a convex polygon overlaps an axis-aligned box.
+ *
+ * @param polygon the list of vertices that make up the convex polygon
+ * @param box the box to test
+ */
+bool polygon_overlaps_aabb(list_t *polygon, aabb_t box);
+
+/**
+ * Finds where a line segment first crosses a polygon's edges.
+ *
+ * @param polygon the list of vertices that make up the polygon
+ * @param origin where the segment starts
+ * @param end where the segment ends
+ * @param fraction set to how far along the segment the crossing is,
+ *   from 0 at origin to 1 at end, if there is one
+ * @param normal set to the unit normal of the crossed edge, on the side
+ *   facing the segment's origin, if there is a crossing
+ * @return whether the segment crosses any edge
+ */
+bool polygon_raycast(list_t *polygon, vector_t origin, vector_t end,
+                     double *fraction, vector_t *normal);
+
+/**
+ * Returns whether two axis-aligned boxes overlap.
+ * Boxes that only touch along an edge count as overlapping.
+ */
+bool aabb_overlap(aabb_t box1, aabb_t box2);
+
+/**
+ * Computes the smallest axis-aligned box containing two boxes.
+ */
+aabb_t aabb_union(aabb_t box1, aabb_t box2);
+
+/**
+ * Computes the smallest axis-aligned box containing a box at both the start
+ * and the end of a movement, and so everywhere in between.
+ *
+ * @param box the box at the start of the movement
+ * @param displacement how far the box moves
+ */
+aabb_t aabb_sweep(aabb_t box, vector_t displacement);
+
+/**
+ * Returns whether one axis-aligned box lies entirely inside another.
+ *
+ * @param outer the box that may contain the other
+ * @param inner the box that may be contained
+ */
+bool aabb_contains(aabb_t outer, aabb_t inner);
+
+/**
+ * Returns whether a point lies inside (or on the edge of) an axis-aligned box.
+ */
+bool aabb_contains_point(aabb_t box, vector_t point);
+
+/**
+ * Returns whether part of a line segment touches an axis-aligned box.
+ *
+ * @param box the box to test
+ * @param origin where the segment starts
+ * @param end where the segment would end at a fraction of 1
+ * @param max_fraction how far towards end the segment actually goes,
+ *   e.g. 0.5 to stop halfway
+ */
+bool aabb_segment_overlap(aabb_t box, vector_t origin, vector_t end,
+                          double max_fraction);
+
 #endif // #ifndef __POLYGON_H__
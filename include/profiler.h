@@ -0,0 +1,129 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * A frame profiler that records how long named scopes take, on every thread.
+ *
+ * Build with 'make PROFILE=true' to compile in the PROFILE_* macros below;
+ * without PROFILE they expand to nothing. Even then nothing is recorded
+ * until profile_enable() is called. The native game enables the profiler
+ * when the PROFILE_TRACE environment variable is set, and writes a trace to
+ * the file it names at exit. Open it in chrome://tracing or Perfetto.
+ *
+ * Each thread records into its own ring buffer of PROFILE_EVENTS events,
+ * so threads never wait on each other; once a ring is full, a thread's
+ * oldest events are overwritten.
+ */
+
+/**
+ * How many events each thread keeps.
+ */
+extern const size_t PROFILE_EVENTS;
+
+/**
+ * A completed scope.
+ */
+typedef struct {
+  const char *name;
+  /** When the scope began, in nanoseconds since the profiler was enabled */
+  uint64_t start_ns;
+  uint64_t duration_ns;
+  /** How many scopes enclosed this one on its thread */
+  uint32_t depth;
+} profile_event_t;
+
+/**
+ * Starts or stops recording.
+ * Scopes already open when recording starts are not recorded.
+ */
+void profile_enable(bool enabled);
+
+/**
+ * Returns whether scopes are being recorded.
+ */
+bool profile_enabled(void);
+
+/**
+ * Gets a monotonic timestamp in nanoseconds.
+ */
+uint64_t profile_now_ns(void);
+
+/**
+ * Opens a scope on the calling thread. Scopes nest, and must be closed
+ * with profile_end() in the reverse order they were opened.
+ *
+ * @param name the scope's name, which must outlive the profiler
+ *   (e.g. a string literal)
+ * @return whether the scope is being recorded
+ */
+bool profile_begin(const char *name);
+
+/**
+ * Closes the calling thread's innermost open scope and records it.
+ * Does nothing if no scope is open.
+ */
+void profile_end(void);
+
+/**
+ * Names the calling thread in traces, e.g. "render".
+ * Does nothing unless the profiler is enabled.
+ *
+ * @param name the thread's name, which must outlive the profiler
+ */
+void profile_thread_name(const char *name);
+
+/**
+ * Copies the calling thread's recorded events, oldest first.
+ *
+ * @param events where to copy the events to
+ * @param max the most events to copy
+ * @return how many events were copied
+ */
+size_t profile_thread_events(profile_event_t *events, size_t max);
+
+/**
+ * Writes every thread's recorded events as Chrome trace-event JSON.
+ * Threads should not be recording while this runs.
+ *
+ * @param out where to write the trace
+ * @return how many events were written
+ */
+size_t profile_write_trace(FILE *out);
+
+/**
+ * Discards every recorded event. Threads should not be recording.
+ */
+void profile_reset(void);
+
+/** Closes a PROFILE_SCOPE at the end of its block */
+void profile_scope_end(bool *recording);
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef PROFILE
+/**
+ * Times from here to the end of the enclosing block.
+ */
+#define PROFILE_SCOPE(name)                                                    \
+  bool PROFILE_CONCAT(profile_scope_, __LINE__)                               \
+      __attribute__((cleanup(profile_scope_end))) = profile_begin(name)
+/**
+ * Times from here to the matching PROFILE_END().
+ */
+#define PROFILE_BEGIN(name) profile_begin(name)
+#define PROFILE_END() profile_end()
+#define PROFILE_THREAD(name) profile_thread_name(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END() ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
+
+#endif // #ifndef __PROFILER_H__
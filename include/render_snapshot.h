@@ -0,0 +1,232 @@
+#ifndef __RENDER_SNAPSHOT_H__
+#define __RENDER_SNAPSHOT_H__
+
+#include "color.h"
+#include "list.h"
+#include "text.h"
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * The kinds of things a snapshot can ask the renderer to draw.
+ */
+typedef enum {
+  RENDER_POLYGON,
+  RENDER_TEXTURE,
+  RENDER_TEXT,
+  /** A label drawn from cached glyphs, see sdl_draw_glyphs() */
+  RENDER_GLYPHS
+} render_item_kind_t;
+
+/**
+ * One thing to draw, in scene coordinates.
+ * Only the fields for the item's kind are meaningful.
+ */
+typedef struct {
+  render_item_kind_t kind;
+  /** RENDER_POLYGON: the fill color and the item's range of vertices */
+  rgb_color_t color;
+  size_t first_vertex;
+  size_t vertex_count;
+  /** RENDER_TEXTURE: which image to draw and where it is */
+  size_t texture_id;
+  const char *image_path;
+  vector_t centroid;
+  double rotation;
+  /**
+   * RENDER_TEXT and RENDER_GLYPHS: the label's font, color, position and
+   * offset of its text
+   */
+  text_t *font;
+  SDL_Color text_color;
+  vector_t loc;
+  size_t text_offset;
+} render_item_t;
+
+/**
+ * An immutable (once published) description of one frame.
+ * Holds copies of everything the renderer needs, so it can be drawn on
+ * another thread while the simulation keeps changing the scene.
+ */
+typedef struct render_snapshot render_snapshot_t;
+
+/**
+ * Two snapshots shared by one writer (the simulation) and one reader
+ * (the render thread), without locks.
+ * The writer fills the back snapshot and publishes it as the front one;
+ * the reader draws the newest front snapshot. If the reader is still
+ * holding the snapshot the writer would overwrite next, the writer drops
+ * that frame instead of waiting, so neither side ever blocks the other.
+ */
+typedef struct render_buffer render_buffer_t;
+
+/**
+ * Counters for comparing simulation and render throughput.
+ */
+typedef struct {
+  /** Snapshots the writer published */
+  size_t published;
+  /** Frames the writer skipped because the reader held the back snapshot */
+  size_t dropped;
+  /** Snapshots the reader acquired and drew */
+  size_t rendered;
+} render_stats_t;
+
+/**
+ * Removes every item from a snapshot, keeping its memory for reuse.
+ *
+ * @param snapshot the snapshot to clear
+ */
+void render_snapshot_clear(render_snapshot_t *snapshot);
+
+/**
+ * Appends a filled polygon to a snapshot.
+ * The vertices are copied, so the list may change or be freed afterwards.
+ *
+ * @param snapshot the snapshot to add to
+ * @param points the list of vertices of the polygon
+ * @param color the color used to fill in the polygon
+ */
+void render_snapshot_add_polygon(render_snapshot_t *snapshot, list_t *points,
+                                 rgb_color_t color);
+
+/**
+ * Appends a textured body to a snapshot.
+ *
+ * @param snapshot the snapshot to add to
+ * @param texture_id a small integer identifying the image,
+ *   so the renderer can cache the loaded texture
+ * @param image_path the image file; must outlive the snapshot
+ * @param centroid the body's center of mass
+ * @param rotation the body's rotation angle in radians
+ */
+void render_snapshot_add_texture(render_snapshot_t *snapshot, size_t texture_id,
+                                 const char *image_path, vector_t centroid,
+                                 double rotation);
+
+/**
+ * Appends a text label to a snapshot. The words are copied.
+ *
+ * @param snapshot the snapshot to add to
+ * @param font the font to render the label with; must outlive the snapshot
+ * @param words the label's text
+ * @param color the label's color
+ * @param loc the top left corner of the label, in scene coordinates
+ */
+void render_snapshot_add_text(render_snapshot_t *snapshot, text_t *font,
+                              const char *words, SDL_Color color, vector_t loc);
+
+/**
+ * Appends a text label to a snapshot, to be drawn from cached glyphs.
+ * The words are copied.
+ *
+ * @param snapshot the snapshot to add to
+ * @param font the font to render the label with; must outlive the snapshot
+ * @param words the label's text
+ * @param color the label's color
+ * @param loc the top left corner of the label, in scene coordinates
+ */
+void render_snapshot_add_glyphs(render_snapshot_t *snapshot, text_t *font,
+                                const char *words, SDL_Color color,
+                                vector_t loc);
+
+/**
+ * Records the size of the window a snapshot is drawn for, so the renderer
+ * can lay the frame out without asking the window, which the thread that
+ * publishes the snapshot owns. It is kept until it is set again.
+ *
+ * @param snapshot the snapshot being written
+ * @param window_size the window's width and height in pixels
+ */
+void render_snapshot_set_window_size(render_snapshot_t *snapshot,
+                                     vector_t window_size);
+
+/**
+ * Gets the window size recorded with render_snapshot_set_window_size(),
+ * or zero if none was.
+ */
+vector_t render_snapshot_window_size(render_snapshot_t *snapshot);
+
+/**
+ * Gets the number of items in a snapshot.
+ */
+size_t render_snapshot_size(render_snapshot_t *snapshot);
+
+/**
+ * Gets the item at a given index in a snapshot.
+ * Asserts that the index is valid.
+ */
+const render_item_t *render_snapshot_get(render_snapshot_t *snapshot,
+                                         size_t index);
+
+/**
+ * Gets the vertices of a RENDER_POLYGON item.
+ */
+const vector_t *render_snapshot_vertices(render_snapshot_t *snapshot,
+                                         const render_item_t *item);
+
+/**
+ * Gets the text of a RENDER_TEXT or RENDER_GLYPHS item.
+ */
+const char *render_snapshot_text(render_snapshot_t *snapshot,
+                                 const render_item_t *item);
+
+/**
+ * Allocates a render buffer with two empty snapshots.
+ *
+ * @return the new render buffer
+ */
+render_buffer_t *render_buffer_init(void);
+
+/**
+ * Releases a render buffer and both of its snapshots.
+ * Neither side may be using the buffer.
+ *
+ * @param buffer a render buffer returned from render_buffer_init()
+ */
+void render_buffer_free(render_buffer_t *buffer);
+
+/**
+ * Starts writing the next frame. Only the writer may call this.
+ * Returns the cleared back snapshot, or NULL if the reader is still drawing
+ * it, in which case the frame should be skipped.
+ *
+ * @param buffer a render buffer returned from render_buffer_init()
+ * @return the snapshot to fill, or NULL
+ */
+render_snapshot_t *render_buffer_begin_write(render_buffer_t *buffer);
+
+/**
+ * Publishes the snapshot returned by the last render_buffer_begin_write(),
+ * making it the one the reader draws next.
+ *
+ * @param buffer a render buffer returned from render_buffer_init()
+ */
+void render_buffer_publish(render_buffer_t *buffer);
+
+/**
+ * Takes the newest published snapshot for drawing. Only the reader may call
+ * this. The writer will not touch the snapshot until render_buffer_release().
+ * Returns NULL if nothing new was published since the last acquire.
+ *
+ * @param buffer a render buffer returned from render_buffer_init()
+ * @return the snapshot to draw, or NULL
+ */
+render_snapshot_t *render_buffer_acquire(render_buffer_t *buffer);
+
+/**
+ * Hands the snapshot from render_buffer_acquire() back to the writer.
+ *
+ * @param buffer a render buffer returned from render_buffer_init()
+ */
+void render_buffer_release(render_buffer_t *buffer);
+
+/**
+ * Gets the buffer's throughput counters.
+ *
+ * @param buffer a render buffer returned from render_buffer_init()
+ */
+render_stats_t render_buffer_stats(render_buffer_t *buffer);
+
+#endif // #ifndef __RENDER_SNAPSHOT_H__
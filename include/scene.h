@@ -2,7 +2,14 @@
 #define __SCENE_H__
 
 #include "body.h"
+#include "broad_phase.h"
+#include "collision.h"
+#include "contact.h"
+#include "contact_cache.h"
 #include "list.h"
+#include "slab.h"
+#include <stdint.h>
+#include <stdio.h>
 
 extern const double MAX_WIDTH_GAME;
 extern const double MAX_HEIGHT_GAME;
@@ -29,6 +36,85 @@ typedef void (*force_creator_t)(void *aux);
 
 typedef struct force_info force_info_t;
 
+/**
+ * The kinds of force creators, which scene_stats() reports separately.
+ */
+typedef enum {
+  FORCE_GRAVITY,
+  FORCE_SPRING,
+  FORCE_DRAG,
+  FORCE_COLLISION,
+  /** Force creators added with scene_add_bodies_force_creator() */
+  FORCE_OTHER,
+  FORCE_KIND_COUNT
+} force_kind_t;
+
+/**
+ * What running one kind of force creator cost.
+ */
+typedef struct {
+  /** Force creators run */
+  size_t count;
+  /** Nanoseconds spent running them */
+  uint64_t ns;
+} force_cost_t;
+
+/**
+ * The collision tests run by collision force creators.
+ */
+typedef struct {
+  /** Separating-axis tests run */
+  size_t tests;
+  /** Tests that found the bodies overlapping */
+  size_t hits;
+  /** Pairs the broad phase ruled out without a test */
+  size_t culled;
+  /** Bullets stopped where they would have passed into a body */
+  size_t impacts;
+} collision_counts_t;
+
+/**
+ * What a scene's force creators cost, by kind.
+ */
+typedef struct {
+  /** Ticks since the scene was created or its stats were reset */
+  size_t ticks;
+  force_cost_t last_tick[FORCE_KIND_COUNT];
+  /** Summed over every tick */
+  force_cost_t total[FORCE_KIND_COUNT];
+  collision_counts_t last_tick_collisions;
+  collision_counts_t total_collisions;
+} scene_stats_t;
+
+/**
+ * A function that says whether a query should consider a body,
+ * e.g. to skip bullets or the body doing the looking.
+ * Takes in the auxiliary value passed to the query.
+ */
+typedef bool (*query_filter_t)(body_t *body, void *aux);
+
+/**
+ * How many bodies a query looks for.
+ */
+typedef enum {
+  /** Stop at the first body found; for a raycast, the nearest one */
+  QUERY_FIRST_HIT,
+  QUERY_ALL_HITS
+} query_mode_t;
+
+/**
+ * Where a ray hit a body.
+ */
+typedef struct {
+  body_t *body;
+  /** Where the ray entered the body */
+  vector_t point;
+  /** The unit normal of the edge the ray entered through, facing the ray */
+  vector_t normal;
+  /** How far along the ray the hit is, from 0 at its origin to 1 at its end */
+  double fraction;
+} raycast_hit_t;
+
 void force_free(force_info_t *force_storage);
 
 /**
@@ -40,6 +126,51 @@ void force_free(force_info_t *force_storage);
  */
 scene_t *scene_init(void);
 
+/**
+ * Allocates an empty scene from an allocator.
+ * Everything the scene creates comes from the same allocator (see
+ * scene_get_allocator()), except its force infos and force storage,
+ * which come from a slab the scene owns (see scene_get_record_allocator()).
+ *
+ * If the allocator has no free function (e.g. an arena_allocator()),
+ * scene_free() does not walk the scene: its memory is released all at once
+ * when the allocator's owner resets it. Every body added to such a scene,
+ * along with its shape and info, must then come from the allocator too,
+ * and not from a body pool.
+ *
+ * @param allocator the allocator to use, or NULL for the heap.
+ *   The scene keeps a copy of it.
+ * @return the new scene
+ */
+scene_t *scene_init_with_allocator(const allocator_t *allocator);
+
+/**
+ * Gets the allocator a scene was created with,
+ * for allocating bodies and force storage that belong to it.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's allocator
+ */
+const allocator_t *scene_get_allocator(scene_t *scene);
+
+/**
+ * Gets the allocator for a scene's small fixed-size records, such as
+ * force storage. It allocates from a slab the scene owns (see slab.h),
+ * which scene_free() releases whole, so records need not be freed first.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's record allocator, which allocates at most
+ *   SLAB_MAX_RECORD bytes at a time
+ */
+const allocator_t *scene_get_record_allocator(scene_t *scene);
+
+/**
+ * Gets how many records a scene's slab holds.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+slab_stats_t scene_record_stats(scene_t *scene);
+
 /**
  * Releases memory allocated for a given scene
  * and all the bodies and force creators it contains.
@@ -111,12 +242,234 @@ void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies,
                                     free_func_t freer);
 
+/**
+ * Like scene_add_bodies_force_creator(), but says what kind of force the
+ * force creator applies, so scene_stats() can charge its cost to that kind.
+ * The aux must be a store_force_t, as force_free() assumes.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param kind the kind of force
+ * @param forcer a force creator function
+ * @param aux an auxiliary value to pass to forcer when it is called
+ * @param bodies the list of bodies affected by the force creator
+ */
+void scene_add_force(scene_t *scene, force_kind_t kind, force_creator_t forcer,
+                     void *aux, list_t *bodies);
+
+/**
+ * Sets how a scene finds the pairs of bodies that may be colliding.
+ * With BROAD_PHASE_NONE (the default) every collision force creator runs
+ * its separating-axis test every tick; otherwise, a broad phase is updated
+ * at the start of each tick and collision force creators skip the test for
+ * bodies whose bounding boxes do not overlap (see scene_may_collide()).
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param kind the kind of broad phase to use
+ */
+void scene_set_broad_phase(scene_t *scene, broad_phase_kind_t kind);
+
+/**
+ * Sets how a scene's collision force creators test two polygons for a
+ * collision (see find_body_collision()). With NARROW_PHASE_AUTO (the
+ * default) each pair is tested whichever way is faster for its shapes.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param kind the kind of narrow phase to use
+ */
+void scene_set_narrow_phase(scene_t *scene, narrow_phase_kind_t kind);
+
+/**
+ * Gets how a scene's collision force creators test polygons.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+narrow_phase_kind_t scene_get_narrow_phase(scene_t *scene);
+
+/**
+ * Returns whether two bodies may be colliding this tick, according to the
+ * scene's broad phase. Without a broad phase, any two bodies may collide.
+ * Pairs ruled out are counted in scene_stats() as culled.
+ *
+ * @param scene the scene whose tick is running a collision force creator
+ * @param body1 the first body
+ * @param body2 the second body
+ */
+bool scene_may_collide(scene_t *scene, body_t *body1, body_t *body2);
+
+/**
+ * Adds a contact found by a physics collision force creator, to be solved
+ * with the rest of the tick's contacts once every force creator has run
+ * (see contact_solver_t).
+ *
+ * @param scene the scene whose tick is running the force creator
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param manifold where the bodies touch, which must stay where it is until
+ *   the end of the tick, and is given the impulses applied
+ * @param elasticity the "coefficient of restitution" of the contact
+ */
+void scene_add_contact(scene_t *scene, body_t *body1, body_t *body2,
+                       contact_manifold_t *manifold, double elasticity);
+
+/**
+ * Records that a collision force creator found two bodies touching this
+ * tick (see contact_cache_touch()). Contacts that no force creator touches
+ * in a tick, e.g. because the broad phase ruled their bodies out, end when
+ * the tick's contacts have been solved.
+ *
+ * @param scene the scene whose tick is running the force creator
+ * @param body1 the first body
+ * @param body2 the second body
+ * @param event where to store whether the contact began this tick
+ * @return the bodies' contact, which stays where it is until it ends
+ */
+contact_t *scene_touch_contact(scene_t *scene, body_t *body1, body_t *body2,
+                               contact_event_t *event);
+
+/**
+ * Finds two bodies' contact, if they touched in the last tick.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return the contact, or NULL if the bodies are not touching
+ */
+contact_t *scene_find_contact(scene_t *scene, body_t *body1, body_t *body2);
+
+/**
+ * Gets the number of pairs of bodies that touched in the last tick.
+ */
+size_t scene_contacts(scene_t *scene);
+
+/**
+ * Sets a function to call when two bodies start touching, each tick they
+ * keep touching, and when they stop, e.g. to play a sound.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param listener the function to call, or NULL for none
+ * @param aux an auxiliary value to pass to the listener
+ */
+void scene_set_contact_listener(scene_t *scene, contact_listener_t listener,
+                                void *aux);
+
+/**
+ * Counts a collision test run by a collision force creator during a tick.
+ *
+ * @param scene the scene whose tick is running the force creator
+ * @param hit whether the bodies were found to overlap
+ */
+void scene_count_collision_test(scene_t *scene, bool hit);
+
+/**
+ * Gets how many force creators of each kind a scene ran,
+ * and how long they took, in the last tick and since the stats were reset.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the scene's force creator stats
+ */
+scene_stats_t scene_stats(scene_t *scene);
+
+/**
+ * Starts a scene's stats over from zero.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+void scene_stats_reset(scene_t *scene);
+
+/**
+ * Prints the average cost per tick of each kind of force creator in a
+ * scene, and how many of its collision tests were hits.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param out where to print the stats, e.g. stderr
+ */
+void scene_print_stats(scene_t *scene, FILE *out);
+
+/**
+ * Gets the name of a kind of force, e.g. "gravity".
+ */
+const char *force_kind_name(force_kind_t kind);
+
+/**
+ * Gets the aux of a force creator that scene_tick() removed, so that adding
+ * a force does not have to allocate a new one.
+ * Like force_free(), this assumes every aux is a store_force_t.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return a removed force creator's aux, which the caller now owns,
+ *   or NULL if there is none. It lives in the scene's slab,
+ *   so it is released with the scene if the caller does not free it.
+ */
+void *scene_reuse_aux(scene_t *scene);
+
+/**
+ * Finds the bodies in a scene whose shapes overlap a box.
+ *
+ * Queries search the scene's broad phase, or a tree the scene keeps for
+ * them if it has none, so they only look at bodies near the box. The first
+ * query after bodies move brings it up to date; bodies moved by hand since
+ * then (e.g. with body_set_centroid()) are found where they were.
+ * Bodies marked for removal are never found.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param box the box to search
+ * @param mode whether to stop at the first body found
+ * @param filter if non-NULL, which bodies to consider
+ * @param aux an auxiliary value to pass to filter
+ * @param hits if non-NULL, a list to add the bodies found to.
+ *   It should not own the bodies, so its freer should be NULL.
+ * @return the number of bodies found
+ */
+size_t scene_query_aabb(scene_t *scene, aabb_t box, query_mode_t mode,
+                        query_filter_t filter, void *aux, list_t *hits);
+
+/**
+ * Finds the bodies in a scene whose shapes contain a point,
+ * like scene_query_aabb().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param point the point to test
+ * @param mode whether to stop at the first body found
+ * @param filter if non-NULL, which bodies to consider
+ * @param aux an auxiliary value to pass to filter
+ * @param hits if non-NULL, a list to add the bodies found to
+ * @return the number of bodies found
+ */
+size_t scene_query_point(scene_t *scene, vector_t point, query_mode_t mode,
+                         query_filter_t filter, void *aux, list_t *hits);
+
+/**
+ * Finds where a ray from one point to another enters bodies in a scene,
+ * nearest first. Bodies that contain the ray's origin are not hit,
+ * so a ray cast from inside a body passes out of it.
+ * Bodies are found like in scene_query_aabb().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param origin where the ray starts
+ * @param end where the ray ends
+ * @param mode QUERY_FIRST_HIT for only the nearest hit,
+ *   or QUERY_ALL_HITS for as many as there is room for
+ * @param filter if non-NULL, which bodies the ray can hit
+ * @param aux an auxiliary value to pass to filter
+ * @param hits an array to store the hits in, nearest first
+ * @param max_hits the length of hits, at least 1. If there are more hits,
+ *   only the nearest ones are kept.
+ * @return the number of hits stored
+ */
+size_t scene_raycast(scene_t *scene, vector_t origin, vector_t end,
+                     query_mode_t mode, query_filter_t filter, void *aux,
+                     raycast_hit_t *hits, size_t max_hits);
+
 /**
  * Executes a tick of a given scene over a small time interval.
  * This requires executing all the force creators
  * and then ticking each body (see body_tick()).
+ * Bullets (see body_set_bullet()) that would move into a body they have
+ * a collision with are stopped just inside it instead, so their collision
+ * is found at the start of the next tick.
  * If any bodies are marked for removal, they should be removed from the scene
  * and freed, along with any force creators acting on them.
+ * Removed force creators are kept for reuse until the scene is freed.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param dt the time elapsed since the last tick, in seconds
@@ -1,8 +1,10 @@
 #ifndef __SDL_WRAPPER_H__
 #define __SDL_WRAPPER_H__
 
+#include "asset_loader.h"
 #include "color.h"
 #include "list.h"
+#include "render_snapshot.h"
 #include "scene.h"
 #include "state.h"
 #include "text.h"
@@ -48,11 +50,58 @@ typedef void (*key_handler_t)(char key, key_event_type_t type, double held_time,
  * Initializes the SDL window and renderer.
  * Must be called once before any of the other SDL functions.
  *
+ * In native builds (unless compiled with -DNO_RENDER_THREAD), this also starts
+ * a render thread that owns the renderer. The drawing functions then record
+ * each frame into a snapshot, which sdl_show() publishes to the render thread,
+ * so a slow present no longer stalls the simulation and vice versa.
+ *
  * @param min the x and y coordinates of the bottom left of the scene
  * @param max the x and y coordinates of the top right of the scene
  */
 void sdl_init(vector_t min, vector_t max);
 
+/**
+ * Initializes SDL to render into an in-memory surface instead of a window.
+ * Frames are drawn by the software renderer, so no display is needed;
+ * this is meant for benchmarks and golden-image tests.
+ * Must be called once instead of sdl_init().
+ *
+ * @param min the x and y coordinates of the bottom left of the scene
+ * @param max the x and y coordinates of the top right of the scene
+ * @param width the width of the frame in pixels
+ * @param height the height of the frame in pixels
+ */
+void sdl_init_offscreen(vector_t min, vector_t max, int width, int height);
+
+/**
+ * Returns whether frames are being rendered offscreen,
+ * i.e. whether sdl_init_offscreen() was used.
+ */
+bool sdl_is_offscreen(void);
+
+/**
+ * Writes the current offscreen frame to an image file.
+ * Paths ending in ".png" are saved as PNG; anything else is saved as
+ * a binary PPM, which needs no image library to read back.
+ * Asserts that the renderer is offscreen.
+ *
+ * @param path the file to write
+ * @return whether the file was written successfully
+ */
+bool sdl_dump_frame(const char *path);
+
+/**
+ * Compares the current offscreen frame against a stored PPM image.
+ * A pixel differs if any of its color channels differs by more than
+ * the tolerance. Asserts that the renderer is offscreen.
+ *
+ * @param golden_path the PPM file written by an earlier sdl_dump_frame()
+ * @param tolerance the largest per-channel difference to ignore (0-255)
+ * @return the number of differing pixels, or SIZE_MAX if the golden image
+ *   could not be read or has different dimensions
+ */
+size_t sdl_frame_diff(const char *golden_path, int tolerance);
+
 /**
  * Processes all SDL events and returns whether the window has been closed.
  * This function must be called in order to handle keypresses.
@@ -63,6 +112,7 @@ bool sdl_is_done(state_t *state);
 
 /**
  * Clears the screen. Should be called before drawing polygons in each frame.
+ * With a render thread, this starts recording a new frame instead.
  */
 void sdl_clear(void);
 
@@ -74,9 +124,26 @@ void sdl_clear(void);
  */
 void sdl_draw_polygon(list_t *points, rgb_color_t color);
 
+/**
+ * Draws a line of text with its top left corner at loc.
+ * With a render thread, the text is recorded and NULL is returned;
+ * the font must then stay open as long as the render thread runs.
+ *
+ * @return the texture holding the text, which the caller must destroy
+ */
 SDL_Texture *sdl_load_text(state_t *state, char *words, text_t *text,
                            SDL_Color color, vector_t loc);
 
+/**
+ * Draws a line of text with its top left corner at loc, like
+ * sdl_load_text(), but from glyphs rendered once per font and then reused.
+ * Meant for text that changes often, such as counters, which would
+ * otherwise need a new texture whenever it changed. Only printable ASCII
+ * is drawn, and without kerning. At most a few fonts can be used.
+ */
+void sdl_draw_glyphs(text_t *text, const char *words, SDL_Color color,
+                     vector_t loc);
+
 /**
  * Function returns vector_t of mouse position
  */
@@ -85,9 +152,19 @@ vector_t sdl_mouse_position();
 /**
  * Displays the rendered frame on the SDL window.
  * Must be called after drawing the polygons in order to show them.
+ * With a render thread, this publishes the recorded frame and returns
+ * without waiting for it to be drawn.
  */
 void sdl_show(void);
 
+/**
+ * Draws all bodies in a scene, without clearing or showing the frame,
+ * so more can be drawn on top before calling sdl_show().
+ *
+ * @param scene the scene to draw
+ */
+void sdl_draw_scene(scene_t *scene);
+
 /**
  * Draws all bodies in a scene.
  * This internally calls sdl_clear(), sdl_draw_polygon(), and sdl_show(),
@@ -97,6 +174,24 @@ void sdl_show(void);
  */
 void sdl_render_scene(scene_t *scene);
 
+/**
+ * Tells the renderer to take an image from an asset loader instead of
+ * loading it itself. The renderer only uploads the decoded surface,
+ * and the render thread skips the image until it is decoded.
+ * Must be called before the first frame that draws the image.
+ *
+ * @param image_path the path bodies use for the image
+ * @param image the image's future from asset_loader_image();
+ *   its loader must outlive the renderer
+ */
+void sdl_register_image(const char *image_path, asset_t *image);
+
+/**
+ * Gets how many frames were published to, drawn by and dropped by
+ * the render thread. All zero when there is no render thread.
+ */
+render_stats_t sdl_render_stats(void);
+
 vector_t get_window_position(vector_t scene_pos, vector_t window_center);
 
 vector_t get_window_center(void);
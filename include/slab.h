@@ -0,0 +1,82 @@
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+#include "allocator.h"
+#include <stddef.h>
+
+/**
+ * An allocator for many small records of a few fixed sizes,
+ * such as the force infos and force storage a scene creates.
+ *
+ * Each size is rounded up to a size class, and each class carves its
+ * records out of pages it shares with no other class, so records of one
+ * kind sit next to each other in memory. Allocating and freeing a record
+ * just pops or pushes it on its class's free list. slab_free() releases
+ * whole pages at once, without visiting the records in them.
+ */
+typedef struct slab slab_t;
+
+/**
+ * The largest record a slab can allocate.
+ */
+extern const size_t SLAB_MAX_RECORD;
+
+/**
+ * How many records a slab has handed out, and the pages holding them.
+ */
+typedef struct {
+  /** Records allocated and not yet released */
+  size_t live;
+  /** The most records that were ever live at once */
+  size_t high_water;
+  /** Pages reserved from the heap */
+  size_t pages;
+} slab_stats_t;
+
+/**
+ * Allocates an empty slab. It reserves no pages until the first allocation.
+ *
+ * @return the new slab
+ */
+slab_t *slab_init(void);
+
+/**
+ * Releases a slab, along with every record allocated from it.
+ *
+ * @param slab a slab returned from slab_init()
+ */
+void slab_free(slab_t *slab);
+
+/**
+ * Allocates a record from a slab.
+ * Asserts that the size is at most SLAB_MAX_RECORD.
+ *
+ * @param slab a slab returned from slab_init()
+ * @param size the size of the record
+ * @return the record, aligned for any type
+ */
+void *slab_alloc(slab_t *slab, size_t size);
+
+/**
+ * Hands a record back to its slab, to be reused by the next record of the
+ * same size class.
+ *
+ * @param slab the slab the record came from
+ * @param record a record returned from slab_alloc()
+ */
+void slab_release(slab_t *slab, void *record);
+
+/**
+ * Gets an allocator whose memory comes from a slab.
+ * Its allocations must be at most SLAB_MAX_RECORD bytes.
+ *
+ * @param slab a slab returned from slab_init()
+ */
+allocator_t slab_allocator(slab_t *slab);
+
+/**
+ * Gets a slab's record and page counts.
+ */
+slab_stats_t slab_stats(slab_t *slab);
+
+#endif // #ifndef __SLAB_H__
@@ -0,0 +1,475 @@
+#include "aabb_tree.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define NULL_NODE SIZE_MAX
+const size_t INITIAL_NODES = 32;
+/** How far along its displacement a moved leaf is stretched, as a multiple */
+const double DISPLACEMENT_STRETCH = 2.0;
+
+typedef struct {
+  aabb_t box;
+  /** The body in a leaf, or NULL in an inner node */
+  body_t *body;
+  /** The parent node, or the next free node if this one is free */
+  size_t parent;
+  size_t child1;
+  size_t child2;
+  /** 0 for a leaf, one more than the taller child's for an inner node */
+  size_t height;
+} node_t;
+
+typedef struct aabb_tree {
+  node_t *nodes;
+  size_t capacity;
+  /** Nodes past this have never been used */
+  size_t used;
+  size_t free_list;
+  size_t root;
+  size_t leaves;
+  double fatten;
+} aabb_tree_t;
+
+/** The perimeter of a box, which is what inserting tries to keep small */
+double aabb_perimeter(aabb_t box) {
+  return 2 * ((box.max.x - box.min.x) + (box.max.y - box.min.y));
+}
+
+aabb_tree_t *aabb_tree_init(double fatten) {
+  assert(fatten >= 0);
+  aabb_tree_t *tree = malloc(sizeof(aabb_tree_t));
+  assert(tree != NULL);
+  tree->nodes = malloc(INITIAL_NODES * sizeof(node_t));
+  assert(tree->nodes != NULL);
+  tree->capacity = INITIAL_NODES;
+  tree->used = 0;
+  tree->free_list = NULL_NODE;
+  tree->root = NULL_NODE;
+  tree->leaves = 0;
+  tree->fatten = fatten;
+  return tree;
+}
+
+void aabb_tree_free(aabb_tree_t *tree) {
+  free(tree->nodes);
+  free(tree);
+}
+
+size_t aabb_tree_size(aabb_tree_t *tree) { return tree->leaves; }
+
+size_t aabb_tree_height(aabb_tree_t *tree) {
+  return tree->root == NULL_NODE ? 0 : tree->nodes[tree->root].height + 1;
+}
+
+/** Takes a node off the free list, or a new one. This may move the nodes. */
+size_t alloc_node(aabb_tree_t *tree) {
+  size_t node;
+  if (tree->free_list != NULL_NODE) {
+    node = tree->free_list;
+    tree->free_list = tree->nodes[node].parent;
+  } else {
+    if (tree->used == tree->capacity) {
+      tree->capacity *= 2;
+      tree->nodes = realloc(tree->nodes, tree->capacity * sizeof(node_t));
+      assert(tree->nodes != NULL);
+    }
+    node = tree->used++;
+  }
+  tree->nodes[node] = (node_t){.body = NULL,
+                               .parent = NULL_NODE,
+                               .child1 = NULL_NODE,
+                               .child2 = NULL_NODE,
+                               .height = 0};
+  return node;
+}
+
+void free_node(aabb_tree_t *tree, size_t node) {
+  tree->nodes[node].parent = tree->free_list;
+  tree->free_list = node;
+}
+
+bool is_leaf(node_t *node) { return node->child1 == NULL_NODE; }
+
+/** Points a node's parent (or the root) at a new child in its place */
+void replace_child(aabb_tree_t *tree, size_t parent, size_t old_child,
+                   size_t new_child) {
+  if (parent == NULL_NODE) {
+    tree->root = new_child;
+  } else if (tree->nodes[parent].child1 == old_child) {
+    tree->nodes[parent].child1 = new_child;
+  } else {
+    tree->nodes[parent].child2 = new_child;
+  }
+}
+
+/** Recomputes an inner node's box and height from its children */
+void refit(aabb_tree_t *tree, size_t index) {
+  node_t *node = &tree->nodes[index];
+  node_t *child1 = &tree->nodes[node->child1];
+  node_t *child2 = &tree->nodes[node->child2];
+  node->box = aabb_union(child1->box, child2->box);
+  node->height = 1 + (child1->height > child2->height ? child1->height
+                                                      : child2->height);
+}
+
+/**
+ * If one of a node's children is more than one level taller than the other,
+ * rotates the taller child up into the node's place, with the node taking
+ * the taller child's shorter grandchild. Returns the node now in its place.
+ */
+size_t balance(aabb_tree_t *tree, size_t a) {
+  node_t *nodes = tree->nodes;
+  if (is_leaf(&nodes[a]) || nodes[a].height < 2) {
+    return a;
+  }
+  size_t b = nodes[a].child1, c = nodes[a].child2;
+  size_t taller;
+  if (nodes[c].height > nodes[b].height + 1) {
+    taller = c;
+  } else if (nodes[b].height > nodes[c].height + 1) {
+    taller = b;
+  } else {
+    return a;
+  }
+
+  size_t f = nodes[taller].child1, g = nodes[taller].child2;
+  // the taller child's taller grandchild stays with it, the other goes to a
+  size_t keep = nodes[f].height > nodes[g].height ? f : g;
+  size_t give = keep == f ? g : f;
+
+  nodes[taller].parent = nodes[a].parent;
+  replace_child(tree, nodes[a].parent, a, taller);
+  nodes[taller].child1 = a;
+  nodes[taller].child2 = keep;
+  nodes[a].parent = taller;
+  if (taller == c) {
+    nodes[a].child2 = give;
+  } else {
+    nodes[a].child1 = give;
+  }
+  nodes[give].parent = a;
+  refit(tree, a);
+  refit(tree, taller);
+  return taller;
+}
+
+/** Refits and rebalances the nodes from one up to the root */
+void fix_upwards(aabb_tree_t *tree, size_t index) {
+  while (index != NULL_NODE) {
+    index = balance(tree, index);
+    refit(tree, index);
+    index = tree->nodes[index].parent;
+  }
+}
+
+/**
+ * Puts a leaf into the tree next to the node where it adds the least
+ * perimeter, counting what it adds to every node above.
+ */
+void insert_leaf(aabb_tree_t *tree, size_t leaf) {
+  if (tree->root == NULL_NODE) {
+    tree->root = leaf;
+    tree->nodes[leaf].parent = NULL_NODE;
+    return;
+  }
+
+  aabb_t box = tree->nodes[leaf].box;
+  size_t index = tree->root;
+  while (!is_leaf(&tree->nodes[index])) {
+    node_t *node = &tree->nodes[index];
+    double perimeter = aabb_perimeter(node->box);
+    double combined = aabb_perimeter(aabb_union(node->box, box));
+    // the cost of making a new parent for this node and the leaf
+    double cost = 2 * combined;
+    // what going further down adds to this node's box
+    double inherited = 2 * (combined - perimeter);
+
+    double child_costs[2];
+    size_t children[] = {node->child1, node->child2};
+    for (size_t i = 0; i < 2; i++) {
+      node_t *child = &tree->nodes[children[i]];
+      double grown = aabb_perimeter(aabb_union(child->box, box));
+      child_costs[i] = inherited + (is_leaf(child)
+                                        ? grown
+                                        : grown - aabb_perimeter(child->box));
+    }
+    if (cost < child_costs[0] && cost < child_costs[1]) {
+      break;
+    }
+    index = child_costs[0] < child_costs[1] ? children[0] : children[1];
+  }
+
+  size_t sibling = index;
+  size_t parent = alloc_node(tree);
+  node_t *nodes = tree->nodes;
+  size_t old_parent = nodes[sibling].parent;
+  nodes[parent].parent = old_parent;
+  nodes[parent].child1 = sibling;
+  nodes[parent].child2 = leaf;
+  replace_child(tree, old_parent, sibling, parent);
+  nodes[sibling].parent = parent;
+  nodes[leaf].parent = parent;
+  fix_upwards(tree, parent);
+}
+
+/** Takes a leaf out of the tree, replacing its parent with its sibling */
+void remove_leaf(aabb_tree_t *tree, size_t leaf) {
+  node_t *nodes = tree->nodes;
+  if (leaf == tree->root) {
+    tree->root = NULL_NODE;
+    return;
+  }
+  size_t parent = nodes[leaf].parent;
+  size_t grandparent = nodes[parent].parent;
+  size_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2
+                                                : nodes[parent].child1;
+  replace_child(tree, grandparent, parent, sibling);
+  nodes[sibling].parent = grandparent;
+  free_node(tree, parent);
+  fix_upwards(tree, grandparent);
+}
+
+/** Grows a box by a fraction of its size on every side */
+aabb_t fatten(aabb_t box, double fraction) {
+  double dx = (box.max.x - box.min.x) * fraction;
+  double dy = (box.max.y - box.min.y) * fraction;
+  return (aabb_t){{box.min.x - dx, box.min.y - dy},
+                  {box.max.x + dx, box.max.y + dy}};
+}
+
+size_t aabb_tree_insert(aabb_tree_t *tree, body_t *body, aabb_t bounds) {
+  size_t leaf = alloc_node(tree);
+  tree->nodes[leaf].body = body;
+  tree->nodes[leaf].box = fatten(bounds, tree->fatten);
+  insert_leaf(tree, leaf);
+  tree->leaves++;
+  return leaf;
+}
+
+void aabb_tree_remove(aabb_tree_t *tree, size_t leaf) {
+  assert(leaf < tree->used && tree->nodes[leaf].body != NULL);
+  remove_leaf(tree, leaf);
+  tree->nodes[leaf].body = NULL;
+  free_node(tree, leaf);
+  tree->leaves--;
+}
+
+bool aabb_tree_move(aabb_tree_t *tree, size_t leaf, aabb_t bounds,
+                    vector_t displacement) {
+  assert(leaf < tree->used && tree->nodes[leaf].body != NULL);
+  if (aabb_contains(tree->nodes[leaf].box, bounds)) {
+    return false;
+  }
+  remove_leaf(tree, leaf);
+  // Stretch the leaf the way the body is going, so it stays inside longer
+  aabb_t box = fatten(bounds, tree->fatten);
+  vector_t stretch = vec_multiply(DISPLACEMENT_STRETCH, displacement);
+  if (stretch.x < 0) {
+    box.min.x += stretch.x;
+  } else {
+    box.max.x += stretch.x;
+  }
+  if (stretch.y < 0) {
+    box.min.y += stretch.y;
+  } else {
+    box.max.y += stretch.y;
+  }
+  tree->nodes[leaf].box = box;
+  insert_leaf(tree, leaf);
+  return true;
+}
+
+body_t *aabb_tree_body(aabb_tree_t *tree, size_t leaf) {
+  assert(leaf < tree->used);
+  return tree->nodes[leaf].body;
+}
+
+aabb_t aabb_tree_leaf_bounds(aabb_tree_t *tree, size_t leaf) {
+  assert(leaf < tree->used);
+  return tree->nodes[leaf].box;
+}
+
+/** A leaf and where its center is along the axis being split */
+typedef struct {
+  double center;
+  size_t leaf;
+} split_leaf_t;
+
+int compare_centers(const void *a, const void *b) {
+  double x = ((const split_leaf_t *)a)->center;
+  double y = ((const split_leaf_t *)b)->center;
+  return (x > y) - (x < y);
+}
+
+/** Sorts leaves by their centers along one axis */
+void sort_leaves(aabb_tree_t *tree, size_t *leaves, size_t count,
+                 bool along_x) {
+  split_leaf_t *split = malloc(count * sizeof(split_leaf_t));
+  assert(split != NULL);
+  for (size_t i = 0; i < count; i++) {
+    aabb_t box = tree->nodes[leaves[i]].box;
+    split[i].center = along_x ? box.min.x + box.max.x : box.min.y + box.max.y;
+    split[i].leaf = leaves[i];
+  }
+  qsort(split, count, sizeof(split_leaf_t), compare_centers);
+  for (size_t i = 0; i < count; i++) {
+    leaves[i] = split[i].leaf;
+  }
+  free(split);
+}
+
+/** Builds a subtree over some leaves and returns its root */
+size_t build_nodes(aabb_tree_t *tree, size_t *leaves, size_t count) {
+  if (count == 1) {
+    return leaves[0];
+  }
+  aabb_t bounds = tree->nodes[leaves[0]].box;
+  for (size_t i = 1; i < count; i++) {
+    bounds = aabb_union(bounds, tree->nodes[leaves[i]].box);
+  }
+  bool along_x = bounds.max.x - bounds.min.x >= bounds.max.y - bounds.min.y;
+  sort_leaves(tree, leaves, count, along_x);
+
+  size_t half = count / 2;
+  size_t child1 = build_nodes(tree, leaves, half);
+  size_t child2 = build_nodes(tree, leaves + half, count - half);
+  size_t node = alloc_node(tree);
+  tree->nodes[node].child1 = child1;
+  tree->nodes[node].child2 = child2;
+  tree->nodes[child1].parent = node;
+  tree->nodes[child2].parent = node;
+  refit(tree, node);
+  return node;
+}
+
+aabb_tree_t *aabb_tree_build(list_t *bodies) {
+  aabb_tree_t *tree = aabb_tree_init(0.0);
+  size_t count = list_size(bodies);
+  if (count == 0) {
+    return tree;
+  }
+  // a tree over n leaves has n - 1 inner nodes
+  tree->capacity = 2 * count;
+  tree->nodes = realloc(tree->nodes, tree->capacity * sizeof(node_t));
+  size_t *leaves = malloc(count * sizeof(size_t));
+  assert(tree->nodes != NULL && leaves != NULL);
+  for (size_t i = 0; i < count; i++) {
+    body_t *body = list_get(bodies, i);
+    leaves[i] = alloc_node(tree);
+    tree->nodes[leaves[i]].body = body;
+    tree->nodes[leaves[i]].box = body_get_bounds(body);
+  }
+  tree->root = build_nodes(tree, leaves, count);
+  tree->nodes[tree->root].parent = NULL_NODE;
+  tree->leaves = count;
+  free(leaves);
+  return tree;
+}
+
+bool query_node(aabb_tree_t *tree, size_t index, aabb_t box,
+                body_visitor_t visitor, void *aux) {
+  node_t *node = &tree->nodes[index];
+  if (!aabb_overlap(node->box, box)) {
+    return true;
+  }
+  if (is_leaf(node)) {
+    return visitor(node->body, aux);
+  }
+  size_t child2 = node->child2;
+  return query_node(tree, node->child1, box, visitor, aux) &&
+         query_node(tree, child2, box, visitor, aux);
+}
+
+bool aabb_tree_query(aabb_tree_t *tree, aabb_t box, body_visitor_t visitor,
+                     void *aux) {
+  return tree->root == NULL_NODE ||
+         query_node(tree, tree->root, box, visitor, aux);
+}
+
+/** The state of a raycast, shared by every node it visits */
+typedef struct {
+  vector_t origin;
+  vector_t end;
+  double max_fraction;
+  ray_visitor_t visitor;
+  void *aux;
+} raycast_t;
+
+void raycast_node(aabb_tree_t *tree, size_t index, raycast_t *ray) {
+  node_t *node = &tree->nodes[index];
+  if (ray->max_fraction <= 0 ||
+      !aabb_segment_overlap(node->box, ray->origin, ray->end,
+                            ray->max_fraction)) {
+    return;
+  }
+  if (is_leaf(node)) {
+    ray->max_fraction = ray->visitor(node->body, ray->max_fraction, ray->aux);
+    return;
+  }
+  size_t child2 = node->child2;
+  raycast_node(tree, node->child1, ray);
+  raycast_node(tree, child2, ray);
+}
+
+double aabb_tree_raycast(aabb_tree_t *tree, vector_t origin, vector_t end,
+                         double max_fraction, ray_visitor_t visitor,
+                         void *aux) {
+  raycast_t ray = {origin, end, max_fraction, visitor, aux};
+  if (tree->root != NULL_NODE) {
+    raycast_node(tree, tree->root, &ray);
+  }
+  return ray.max_fraction;
+}
+
+/**
+ * Visits the overlapping pairs of leaves under two nodes, splitting the
+ * taller node until both are leaves.
+ */
+void cross_pairs(aabb_tree_t *tree1, size_t index1, aabb_tree_t *tree2,
+                 size_t index2, pair_visitor_t visitor, void *aux) {
+  node_t *node1 = &tree1->nodes[index1];
+  node_t *node2 = &tree2->nodes[index2];
+  if (!aabb_overlap(node1->box, node2->box)) {
+    return;
+  }
+  bool leaf1 = is_leaf(node1), leaf2 = is_leaf(node2);
+  if (leaf1 && leaf2) {
+    visitor(node1->body, node2->body, aux);
+  } else if (leaf2 || (!leaf1 && node1->height >= node2->height)) {
+    size_t child2 = node1->child2;
+    cross_pairs(tree1, node1->child1, tree2, index2, visitor, aux);
+    cross_pairs(tree1, child2, tree2, index2, visitor, aux);
+  } else {
+    size_t child2 = node2->child2;
+    cross_pairs(tree1, index1, tree2, node2->child1, visitor, aux);
+    cross_pairs(tree1, index1, tree2, child2, visitor, aux);
+  }
+}
+
+void self_pairs(aabb_tree_t *tree, size_t index, pair_visitor_t visitor,
+                void *aux) {
+  node_t *node = &tree->nodes[index];
+  if (is_leaf(node)) {
+    return;
+  }
+  size_t child1 = node->child1, child2 = node->child2;
+  self_pairs(tree, child1, visitor, aux);
+  self_pairs(tree, child2, visitor, aux);
+  cross_pairs(tree, child1, tree, child2, visitor, aux);
+}
+
+void aabb_tree_self_pairs(aabb_tree_t *tree, pair_visitor_t visitor,
+                          void *aux) {
+  if (tree->root != NULL_NODE) {
+    self_pairs(tree, tree->root, visitor, aux);
+  }
+}
+
+void aabb_tree_pairs(aabb_tree_t *tree1, aabb_tree_t *tree2,
+                     pair_visitor_t visitor, void *aux) {
+  if (tree1->root != NULL_NODE && tree2->root != NULL_NODE) {
+    cross_pairs(tree1, tree1->root, tree2, tree2->root, visitor, aux);
+  }
+}
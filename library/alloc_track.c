@@ -0,0 +1,366 @@
+#define ALLOC_TRACK_IMPLEMENTATION
+#include "alloc_track.h"
+#include <assert.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+// The tracker itself uses the real allocator, even when this header was
+// force-included ahead of everything else
+#undef malloc
+#undef calloc
+#undef realloc
+#undef aligned_alloc
+#undef free
+
+const size_t INITIAL_TRACKED = 1024;
+/** How many distinct allocating lines are told apart */
+#define MAX_SITES 1024
+/** How many sites alloc_track_dump() lists */
+const size_t DUMPED_SITES = 10;
+
+/** Marks an entry of the pointer table whose allocation was freed */
+#define TOMBSTONE ((void *)1)
+
+/** Which subsystem each source file's allocations are charged to */
+const struct {
+  const char *file;
+  alloc_tag_t tag;
+} FILE_TAGS[] = {
+    {"list.c", ALLOC_LIST},
+    {"body.c", ALLOC_BODY},
+    {"body_pool.c", ALLOC_BODY},
+    {"scene.c", ALLOC_FORCE},
+    {"forces.c", ALLOC_FORCE},
+    {"slab.c", ALLOC_FORCE},
+    {"collision.c", ALLOC_COLLISION},
+    {"sdl_wrapper.c", ALLOC_RENDER},
+    {"render_snapshot.c", ALLOC_RENDER},
+    {"text.c", ALLOC_RENDER},
+    {"map.c", ALLOC_GAME},
+    {"star.c", ALLOC_GAME},
+    {"polygon.c", ALLOC_GAME},
+};
+
+const char *TAG_NAMES[ALLOC_TAG_COUNT] = {
+    "list", "body", "force", "collision", "render", "game", "other"};
+
+/** A line of code that allocates */
+typedef struct {
+  const char *file;
+  int line;
+  alloc_tag_t tag;
+  size_t live_bytes;
+  size_t live_count;
+  size_t total_count;
+} alloc_site_t;
+
+/** A live allocation */
+typedef struct {
+  void *memory;
+  size_t size;
+  size_t site;
+} tracked_t;
+
+/** Only one thread touches the tables below at a time */
+atomic_flag track_lock = ATOMIC_FLAG_INIT;
+
+/** Open-addressed by address; NULL entries are empty */
+tracked_t *tracked = NULL;
+size_t tracked_capacity = 0;
+/** Live entries and tombstones, which both lengthen probes */
+size_t tracked_used = 0;
+
+/** Open-addressed by file and line; entries with a NULL file are empty */
+alloc_site_t sites[MAX_SITES];
+alloc_stats_t tag_stats[ALLOC_TAG_COUNT];
+size_t frame_counts[ALLOC_TAG_COUNT];
+size_t frames = 0;
+volatile sig_atomic_t dump_requested = 0;
+
+void track_lock_acquire(void) {
+  while (atomic_flag_test_and_set_explicit(&track_lock,
+                                           memory_order_acquire)) {
+  }
+}
+
+void track_lock_release(void) {
+  atomic_flag_clear_explicit(&track_lock, memory_order_release);
+}
+
+size_t hash_pointer(void *memory) {
+  return (size_t)(((uintptr_t)memory >> 4) * 0x9e3779b97f4a7c15ull);
+}
+
+alloc_tag_t alloc_tag_of_file(const char *file) {
+  const char *slash = strrchr(file, '/');
+  const char *name = slash != NULL ? slash + 1 : file;
+  for (size_t i = 0; i < sizeof(FILE_TAGS) / sizeof(FILE_TAGS[0]); i++) {
+    if (strcmp(name, FILE_TAGS[i].file) == 0) {
+      return FILE_TAGS[i].tag;
+    }
+  }
+  return strstr(file, "demo/") != NULL ? ALLOC_GAME : ALLOC_OTHER;
+}
+
+const char *alloc_tag_name(alloc_tag_t tag) {
+  assert(tag < ALLOC_TAG_COUNT);
+  return TAG_NAMES[tag];
+}
+
+/** Finds a site's index, adding it the first time it allocates */
+size_t find_site(const char *file, int line) {
+  size_t index = ((uintptr_t)file * 31 + (size_t)line) % MAX_SITES;
+  for (size_t probes = 0; probes < MAX_SITES; probes++) {
+    alloc_site_t *site = &sites[index];
+    if (site->file == NULL) {
+      *site = (alloc_site_t){file, line, alloc_tag_of_file(file), 0, 0, 0};
+      return index;
+    }
+    if (site->file == file && site->line == line) {
+      return index;
+    }
+    index = (index + 1) % MAX_SITES;
+  }
+  // every site is taken; charge the line to whichever one it hashed to
+  return ((uintptr_t)file * 31 + (size_t)line) % MAX_SITES;
+}
+
+void insert_tracked(tracked_t entry) {
+  size_t index = hash_pointer(entry.memory) % tracked_capacity;
+  while (tracked[index].memory != NULL && tracked[index].memory != TOMBSTONE) {
+    index = (index + 1) % tracked_capacity;
+  }
+  if (tracked[index].memory == NULL) {
+    tracked_used++;
+  }
+  tracked[index] = entry;
+}
+
+/** Rebuilds the pointer table, growing it if it is mostly live entries */
+void rehash_tracked(void) {
+  tracked_t *old = tracked;
+  size_t old_capacity = tracked_capacity;
+  size_t live = 0;
+  for (size_t i = 0; i < old_capacity; i++) {
+    live += old[i].memory != NULL && old[i].memory != TOMBSTONE;
+  }
+  tracked_capacity = INITIAL_TRACKED;
+  while (tracked_capacity < 4 * live) {
+    tracked_capacity *= 2;
+  }
+  tracked = calloc(tracked_capacity, sizeof(tracked_t));
+  assert(tracked != NULL);
+  tracked_used = 0;
+  for (size_t i = 0; i < old_capacity; i++) {
+    if (old[i].memory != NULL && old[i].memory != TOMBSTONE) {
+      insert_tracked(old[i]);
+    }
+  }
+  free(old);
+}
+
+/** Charges an allocation to its site. Called with the lock held. */
+void track(void *memory, size_t size, const char *file, int line) {
+  if (2 * (tracked_used + 1) > tracked_capacity) {
+    rehash_tracked();
+  }
+  size_t index = find_site(file, line);
+  insert_tracked((tracked_t){memory, size, index});
+
+  alloc_site_t *site = &sites[index];
+  site->live_bytes += size;
+  site->live_count++;
+  site->total_count++;
+  alloc_stats_t *stats = &tag_stats[site->tag];
+  stats->live_bytes += size;
+  stats->live_count++;
+  stats->total_count++;
+  if (stats->live_bytes > stats->peak_bytes) {
+    stats->peak_bytes = stats->live_bytes;
+  }
+  frame_counts[site->tag]++;
+}
+
+/**
+ * Stops tracking an allocation, if it was tracked, and returns its entry,
+ * whose memory is NULL if it was not. Called with the lock held.
+ */
+tracked_t untrack(void *memory) {
+  tracked_t entry = {NULL, 0, 0};
+  if (tracked_capacity == 0) {
+    return entry;
+  }
+  size_t index = hash_pointer(memory) % tracked_capacity;
+  while (tracked[index].memory != NULL) {
+    if (tracked[index].memory == memory) {
+      entry = tracked[index];
+      alloc_site_t *site = &sites[entry.site];
+      site->live_bytes -= entry.size;
+      site->live_count--;
+      tag_stats[site->tag].live_bytes -= entry.size;
+      tag_stats[site->tag].live_count--;
+      tracked[index].memory = TOMBSTONE;
+      return entry;
+    }
+    index = (index + 1) % tracked_capacity;
+  }
+  return entry;
+}
+
+/**
+ * Tracks an entry untrack() returned again, as the live allocation it still
+ * is, without counting it as a new one. Called with the lock held.
+ */
+void retrack(tracked_t entry) {
+  if (entry.memory == NULL) {
+    return;
+  }
+  if (2 * (tracked_used + 1) > tracked_capacity) {
+    rehash_tracked();
+  }
+  insert_tracked(entry);
+  alloc_site_t *site = &sites[entry.site];
+  site->live_bytes += entry.size;
+  site->live_count++;
+  tag_stats[site->tag].live_bytes += entry.size;
+  tag_stats[site->tag].live_count++;
+}
+
+void *alloc_track_malloc(size_t size, const char *file, int line) {
+  void *memory = malloc(size);
+  if (memory != NULL) {
+    track_lock_acquire();
+    // the address may have been freed behind our back
+    untrack(memory);
+    track(memory, size, file, line);
+    track_lock_release();
+  }
+  return memory;
+}
+
+void *alloc_track_calloc(size_t count, size_t size, const char *file,
+                         int line) {
+  void *memory = calloc(count, size);
+  if (memory != NULL) {
+    track_lock_acquire();
+    untrack(memory);
+    track(memory, count * size, file, line);
+    track_lock_release();
+  }
+  return memory;
+}
+
+void *alloc_track_realloc(void *memory, size_t size, const char *file,
+                          int line) {
+  // The old block is untracked before it can be freed, and the lock is held
+  // until the new one is tracked, so no other thread can be handed the old
+  // address in between and have its record removed
+  track_lock_acquire();
+  tracked_t old = {NULL, 0, 0};
+  if (memory != NULL) {
+    old = untrack(memory);
+  }
+  void *resized = realloc(memory, size);
+  if (resized != NULL) {
+    untrack(resized);
+    track(resized, size, file, line);
+  } else if (size != 0) {
+    // the resize failed, so the old block is still live
+    retrack(old);
+  }
+  track_lock_release();
+  return resized;
+}
+
+void *alloc_track_aligned_alloc(size_t alignment, size_t size,
+                                const char *file, int line) {
+  void *memory = aligned_alloc(alignment, size);
+  if (memory != NULL) {
+    track_lock_acquire();
+    untrack(memory);
+    track(memory, size, file, line);
+    track_lock_release();
+  }
+  return memory;
+}
+
+void alloc_track_free(void *memory) {
+  if (memory == NULL) {
+    return;
+  }
+  track_lock_acquire();
+  untrack(memory);
+  track_lock_release();
+  free(memory);
+}
+
+alloc_stats_t alloc_track_stats(alloc_tag_t tag) {
+  assert(tag < ALLOC_TAG_COUNT);
+  track_lock_acquire();
+  alloc_stats_t stats = tag_stats[tag];
+  track_lock_release();
+  return stats;
+}
+
+void alloc_track_frame(void) {
+  track_lock_acquire();
+  for (size_t i = 0; i < ALLOC_TAG_COUNT; i++) {
+    // the first "frame" is startup, which is not a frame at all
+    if (frames > 0) {
+      tag_stats[i].last_frame_count = frame_counts[i];
+      if (frame_counts[i] > tag_stats[i].max_frame_count) {
+        tag_stats[i].max_frame_count = frame_counts[i];
+      }
+    }
+    frame_counts[i] = 0;
+  }
+  frames++;
+  track_lock_release();
+
+  if (dump_requested) {
+    dump_requested = 0;
+    alloc_track_dump(stderr);
+  }
+}
+
+void alloc_track_request_dump(void) { dump_requested = 1; }
+
+void alloc_track_dump(FILE *out) {
+  track_lock_acquire();
+  fprintf(out, "allocations after %zu frames:\n", frames > 0 ? frames - 1 : 0);
+  fprintf(out, "  %-10s %12s %12s %10s %12s %10s %10s\n", "subsystem",
+          "live bytes", "peak bytes", "live", "total", "last frame",
+          "max frame");
+  for (size_t i = 0; i < ALLOC_TAG_COUNT; i++) {
+    alloc_stats_t *stats = &tag_stats[i];
+    fprintf(out, "  %-10s %12zu %12zu %10zu %12zu %10zu %10zu\n",
+            TAG_NAMES[i], stats->live_bytes, stats->peak_bytes,
+            stats->live_count, stats->total_count, stats->last_frame_count,
+            stats->max_frame_count);
+  }
+
+  // picks the sites with the most live bytes, largest first
+  fprintf(out, "top allocation sites by live bytes:\n");
+  bool dumped[MAX_SITES] = {false};
+  for (size_t n = 0; n < DUMPED_SITES; n++) {
+    alloc_site_t *top = NULL;
+    size_t top_index = 0;
+    for (size_t i = 0; i < MAX_SITES; i++) {
+      if (sites[i].file != NULL && sites[i].live_count > 0 && !dumped[i] &&
+          (top == NULL || sites[i].live_bytes > top->live_bytes)) {
+        top = &sites[i];
+        top_index = i;
+      }
+    }
+    if (top == NULL) {
+      break;
+    }
+    dumped[top_index] = true;
+    fprintf(out, "  %s:%d (%s): %zu bytes in %zu allocations, %zu in total\n",
+            top->file, top->line, TAG_NAMES[top->tag], top->live_bytes,
+            top->live_count, top->total_count);
+  }
+  track_lock_release();
+}
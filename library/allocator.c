@@ -0,0 +1,82 @@
+#include "allocator.h"
+#include "alloc_track.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the functions themselves, rather than the call-site macros
+#undef allocator_alloc
+#undef allocator_realloc
+
+void *heap_alloc(void *context, size_t size) { return malloc(size); }
+
+void heap_free(void *context, void *memory) { free(memory); }
+
+void *arena_allocator_alloc(void *context, size_t size) {
+  return arena_alloc(context, size);
+}
+
+allocator_t heap_allocator(void) {
+  return (allocator_t){heap_alloc, heap_free, NULL};
+}
+
+allocator_t arena_allocator(arena_t *arena) {
+  return (allocator_t){arena_allocator_alloc, NULL, arena};
+}
+
+bool is_heap(const allocator_t *allocator) {
+  return allocator == NULL || allocator->alloc == heap_alloc;
+}
+
+void *allocator_alloc_at(const allocator_t *allocator, size_t size,
+                         const char *file, int line) {
+  void *memory;
+  if (is_heap(allocator)) {
+#ifdef ALLOC_TRACK
+    memory = alloc_track_malloc(size, file, line);
+#else
+    memory = malloc(size);
+#endif
+  } else {
+    memory = allocator->alloc(allocator->context, size);
+  }
+  assert(memory != NULL);
+  return memory;
+}
+
+void *allocator_alloc(const allocator_t *allocator, size_t size) {
+  return allocator_alloc_at(allocator, size, __FILE__, __LINE__);
+}
+
+void allocator_free(const allocator_t *allocator, void *memory) {
+  if (allocator == NULL) {
+    free(memory);
+  } else if (allocator->free != NULL) {
+    allocator->free(allocator->context, memory);
+  }
+}
+
+void *allocator_realloc_at(const allocator_t *allocator, void *memory,
+                           size_t old_size, size_t new_size, const char *file,
+                           int line) {
+  if (is_heap(allocator)) {
+#ifdef ALLOC_TRACK
+    void *resized = alloc_track_realloc(memory, new_size, file, line);
+#else
+    void *resized = realloc(memory, new_size);
+#endif
+    assert(resized != NULL);
+    return resized;
+  }
+  void *resized = allocator_alloc_at(allocator, new_size, file, line);
+  memcpy(resized, memory, old_size < new_size ? old_size : new_size);
+  allocator_free(allocator, memory);
+  return resized;
+}
+
+void *allocator_realloc(const allocator_t *allocator, void *memory,
+                        size_t old_size, size_t new_size) {
+  return allocator_realloc_at(allocator, memory, old_size, new_size, __FILE__,
+                              __LINE__);
+}
@@ -0,0 +1,180 @@
+#include "arena.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define ARENA_ASAN
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) && !defined(ARENA_ASAN)
+#define ARENA_ASAN
+#endif
+
+#ifdef ARENA_ASAN
+#include <sanitizer/asan_interface.h>
+#ifndef ARENA_DEBUG
+#define ARENA_DEBUG
+#endif
+#else
+#define ASAN_POISON_MEMORY_REGION(addr, size) ((void)(addr), (void)(size))
+#define ASAN_UNPOISON_MEMORY_REGION(addr, size) ((void)(addr), (void)(size))
+#endif
+
+/** Every allocation starts at a multiple of this, which suits any type */
+const size_t ARENA_ALIGNMENT = 16;
+const size_t FRAME_ARENA_SIZE = 64 * 1024;
+
+typedef struct arena_block {
+  struct arena_block *next;
+  size_t capacity;
+  size_t used;
+  /** The block's memory, which follows this header */
+  unsigned char *data;
+} arena_block_t;
+
+typedef struct arena {
+  arena_block_t *first;
+  /** The block allocations currently come from; later blocks are empty */
+  arena_block_t *current;
+  size_t block_size;
+  size_t used;
+  size_t high_water;
+  size_t capacity;
+} arena_t;
+
+/** The frame arena, or NULL until frame_arena() is first called */
+arena_t *shared_frame_arena = NULL;
+
+size_t align_up(size_t size) {
+  return (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+arena_block_t *block_init(size_t capacity, arena_block_t *next) {
+  size_t header = align_up(sizeof(arena_block_t));
+  arena_block_t *block = malloc(header + capacity);
+  assert(block != NULL);
+  block->next = next;
+  block->capacity = capacity;
+  block->used = 0;
+  block->data = (unsigned char *)block + header;
+  // Nothing in a block is addressable until it is allocated
+  ASAN_POISON_MEMORY_REGION(block->data, capacity);
+  return block;
+}
+
+/** Releases the part of a block after offset, poisoning it in debug builds */
+void block_release(arena_block_t *block, size_t offset) {
+#ifdef ARENA_DEBUG
+  ASAN_UNPOISON_MEMORY_REGION(block->data + offset, block->used - offset);
+  memset(block->data + offset, ARENA_POISON, block->used - offset);
+  ASAN_POISON_MEMORY_REGION(block->data + offset, block->used - offset);
+#endif
+  block->used = offset;
+}
+
+arena_t *arena_init(size_t block_size) {
+  assert(block_size > 0);
+  arena_t *arena = malloc(sizeof(arena_t));
+  assert(arena != NULL);
+  arena->block_size = align_up(block_size);
+  arena->first = block_init(arena->block_size, NULL);
+  arena->current = arena->first;
+  arena->used = 0;
+  arena->high_water = 0;
+  arena->capacity = arena->block_size;
+  return arena;
+}
+
+void arena_free(arena_t *arena) {
+  arena_block_t *block = arena->first;
+  while (block != NULL) {
+    arena_block_t *next = block->next;
+    ASAN_UNPOISON_MEMORY_REGION(block->data, block->capacity);
+    free(block);
+    block = next;
+  }
+  free(arena);
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+  size_t padded = align_up(size > 0 ? size : 1);
+  arena_block_t *block = arena->current;
+  if (block->capacity - block->used < padded) {
+    // Move on to the next block, inserting a new one if it is too small
+    if (block->next == NULL || block->next->capacity < padded) {
+      size_t capacity =
+          padded > arena->block_size ? padded : arena->block_size;
+      block->next = block_init(capacity, block->next);
+      arena->capacity += capacity;
+    }
+    block = block->next;
+    arena->current = block;
+  }
+  void *memory = block->data + block->used;
+  block->used += padded;
+  arena->used += padded;
+  if (arena->used > arena->high_water) {
+    arena->high_water = arena->used;
+  }
+  ASAN_UNPOISON_MEMORY_REGION(memory, size);
+  return memory;
+}
+
+arena_mark_t arena_mark(arena_t *arena) {
+  return (arena_mark_t){arena->current, arena->current->used, arena->used};
+}
+
+void arena_rewind(arena_t *arena, arena_mark_t mark) {
+  assert(mark.used <= arena->used);
+  if (mark.block != arena->current) {
+    arena_block_t *block = mark.block->next;
+    while (true) {
+      block_release(block, 0);
+      if (block == arena->current) {
+        break;
+      }
+      block = block->next;
+    }
+  }
+  block_release(mark.block, mark.offset);
+  arena->current = mark.block;
+  arena->used = mark.used;
+}
+
+void arena_reset(arena_t *arena) {
+  arena_rewind(arena, (arena_mark_t){arena->first, 0, 0});
+}
+
+arena_stats_t arena_stats(arena_t *arena) {
+  return (arena_stats_t){arena->used, arena->high_water, arena->capacity};
+}
+
+arena_t *frame_arena(void) {
+  if (shared_frame_arena == NULL) {
+    shared_frame_arena = arena_init(FRAME_ARENA_SIZE);
+  }
+  return shared_frame_arena;
+}
+
+void frame_arena_reset(void) {
+  if (shared_frame_arena != NULL) {
+    arena_reset(shared_frame_arena);
+  }
+}
+
+void frame_arena_free(void) {
+  if (shared_frame_arena == NULL) {
+    return;
+  }
+  if (getenv("ARENA_STATS") != NULL) {
+    arena_stats_t stats = arena_stats(shared_frame_arena);
+    fprintf(stderr, "frame arena high water %zu bytes of %zu reserved\n",
+            stats.high_water, stats.capacity);
+  }
+  arena_free(shared_frame_arena);
+  shared_frame_arena = NULL;
+}
@@ -0,0 +1,232 @@
+#include "asset_loader.h"
+#include "asset_pack.h"
+#include "list.h"
+#include "profiler.h"
+#include <SDL2/SDL_image.h>
+#include <assert.h>
+#include <stdlib.h>
+
+const size_t INITIAL_ASSETS = 16;
+
+typedef enum { ASSET_IMAGE, ASSET_SOUND, ASSET_FONT } asset_kind_t;
+
+typedef struct asset {
+  asset_kind_t kind;
+  const char *path;
+  /** The point size, for fonts */
+  int size;
+  /** The SDL_Surface, Mix_Chunk or TTF_Font, once ready */
+  void *result;
+  /** Set (after result) once the asset is decoded */
+  SDL_atomic_t ready;
+  asset_loader_t *loader;
+} asset_t;
+
+typedef struct asset_loader {
+  /** Guards everything below except the workers themselves */
+  SDL_mutex *lock;
+  /** Signalled when an asset is requested or the loader is stopping */
+  SDL_cond *requested;
+  /** Signalled when an asset becomes ready */
+  SDL_cond *decoded;
+  /** Every requested asset, in request order; the loader owns them */
+  list_t *assets;
+  /** The index in assets of the next one for a worker to decode */
+  size_t next;
+  /** The number of ready assets */
+  size_t ready_count;
+  bool stopping;
+  SDL_Thread **workers;
+  size_t worker_count;
+  /**
+   * SDL_ttf shares one FreeType library between all fonts,
+   * which may only open one font at a time
+   */
+  SDL_mutex *font_lock;
+} asset_loader_t;
+
+void asset_free(asset_t *asset) {
+  if (asset->kind == ASSET_IMAGE && asset->result != NULL) {
+    SDL_FreeSurface(asset->result);
+  }
+  free(asset);
+}
+
+/** Decodes an asset's file into its result */
+void decode_asset(asset_t *asset) {
+  SDL_RWops *file = asset_open(asset->path);
+  switch (asset->kind) {
+  case ASSET_IMAGE:
+    asset->result = IMG_Load_RW(file, 1);
+    break;
+  case ASSET_SOUND:
+    asset->result = Mix_LoadWAV_RW(file, 1);
+    break;
+  case ASSET_FONT:
+    SDL_LockMutex(asset->loader->font_lock);
+    asset->result = TTF_OpenFontRW(file, 1, asset->size);
+    SDL_UnlockMutex(asset->loader->font_lock);
+    break;
+  }
+}
+
+/** Marks an asset ready. The loader's lock must be held. */
+void finish_asset(asset_t *asset) {
+  SDL_AtomicSet(&asset->ready, 1);
+  asset->loader->ready_count++;
+  SDL_CondBroadcast(asset->loader->decoded);
+}
+
+/** A worker thread: decodes requested assets until the loader stops */
+int worker_main(void *data) {
+  asset_loader_t *loader = data;
+  PROFILE_THREAD("asset loader");
+  SDL_LockMutex(loader->lock);
+  while (true) {
+    while (!loader->stopping && loader->next == list_size(loader->assets)) {
+      SDL_CondWait(loader->requested, loader->lock);
+    }
+    if (loader->stopping) {
+      break;
+    }
+    asset_t *asset = list_get(loader->assets, loader->next++);
+    SDL_UnlockMutex(loader->lock);
+    PROFILE_BEGIN("decode");
+    decode_asset(asset);
+    PROFILE_END();
+    SDL_LockMutex(loader->lock);
+    finish_asset(asset);
+  }
+  SDL_UnlockMutex(loader->lock);
+  return 0;
+}
+
+asset_loader_t *asset_loader_init(size_t workers) {
+#ifdef __EMSCRIPTEN__
+  // No threads to decode on
+  workers = 0;
+#endif
+  asset_loader_t *loader = malloc(sizeof(asset_loader_t));
+  assert(loader != NULL);
+  loader->lock = SDL_CreateMutex();
+  loader->requested = SDL_CreateCond();
+  loader->decoded = SDL_CreateCond();
+  loader->font_lock = SDL_CreateMutex();
+  assert(loader->lock != NULL && loader->font_lock != NULL);
+  assert(loader->requested != NULL && loader->decoded != NULL);
+  loader->assets = list_init(INITIAL_ASSETS, (free_func_t)asset_free);
+  loader->next = 0;
+  loader->ready_count = 0;
+  loader->stopping = false;
+  loader->worker_count = workers;
+  loader->workers = malloc((workers > 0 ? workers : 1) * sizeof(SDL_Thread *));
+  assert(loader->workers != NULL);
+  for (size_t i = 0; i < workers; i++) {
+    loader->workers[i] = SDL_CreateThread(worker_main, "asset loader", loader);
+    assert(loader->workers[i] != NULL);
+  }
+  return loader;
+}
+
+void asset_loader_free(asset_loader_t *loader) {
+  SDL_LockMutex(loader->lock);
+  loader->stopping = true;
+  SDL_CondBroadcast(loader->requested);
+  SDL_UnlockMutex(loader->lock);
+  for (size_t i = 0; i < loader->worker_count; i++) {
+    SDL_WaitThread(loader->workers[i], NULL);
+  }
+  free(loader->workers);
+  list_free(loader->assets);
+  SDL_DestroyMutex(loader->font_lock);
+  SDL_DestroyCond(loader->decoded);
+  SDL_DestroyCond(loader->requested);
+  SDL_DestroyMutex(loader->lock);
+  free(loader);
+}
+
+/** Queues an asset for the workers, or decodes it now if there are none */
+asset_t *request_asset(asset_loader_t *loader, asset_kind_t kind,
+                       const char *path, int size) {
+  asset_t *asset = malloc(sizeof(asset_t));
+  assert(asset != NULL);
+  asset->kind = kind;
+  asset->path = path;
+  asset->size = size;
+  asset->result = NULL;
+  SDL_AtomicSet(&asset->ready, 0);
+  asset->loader = loader;
+
+  SDL_LockMutex(loader->lock);
+  list_add(loader->assets, asset);
+  if (loader->worker_count == 0) {
+    loader->next++;
+    decode_asset(asset);
+    finish_asset(asset);
+  } else {
+    SDL_CondSignal(loader->requested);
+  }
+  SDL_UnlockMutex(loader->lock);
+  return asset;
+}
+
+asset_t *asset_loader_image(asset_loader_t *loader, const char *path) {
+  return request_asset(loader, ASSET_IMAGE, path, 0);
+}
+
+asset_t *asset_loader_sound(asset_loader_t *loader, const char *path) {
+  return request_asset(loader, ASSET_SOUND, path, 0);
+}
+
+asset_t *asset_loader_font(asset_loader_t *loader, const char *path,
+                           int size) {
+  return request_asset(loader, ASSET_FONT, path, size);
+}
+
+double asset_loader_progress(asset_loader_t *loader) {
+  SDL_LockMutex(loader->lock);
+  size_t total = list_size(loader->assets);
+  double progress = total == 0 ? 1.0 : (double)loader->ready_count / total;
+  SDL_UnlockMutex(loader->lock);
+  return progress;
+}
+
+void asset_loader_wait_all(asset_loader_t *loader) {
+  SDL_LockMutex(loader->lock);
+  while (loader->ready_count < list_size(loader->assets)) {
+    SDL_CondWait(loader->decoded, loader->lock);
+  }
+  SDL_UnlockMutex(loader->lock);
+}
+
+bool asset_ready(asset_t *asset) { return SDL_AtomicGet(&asset->ready); }
+
+void asset_wait(asset_t *asset) {
+  if (asset_ready(asset)) {
+    return;
+  }
+  asset_loader_t *loader = asset->loader;
+  SDL_LockMutex(loader->lock);
+  while (!asset_ready(asset)) {
+    SDL_CondWait(loader->decoded, loader->lock);
+  }
+  SDL_UnlockMutex(loader->lock);
+}
+
+SDL_Surface *asset_surface(asset_t *asset) {
+  assert(asset->kind == ASSET_IMAGE);
+  asset_wait(asset);
+  return asset->result;
+}
+
+Mix_Chunk *asset_chunk(asset_t *asset) {
+  assert(asset->kind == ASSET_SOUND);
+  asset_wait(asset);
+  return asset->result;
+}
+
+TTF_Font *asset_font(asset_t *asset) {
+  assert(asset->kind == ASSET_FONT);
+  asset_wait(asset);
+  return asset->result;
+}
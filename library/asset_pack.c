@@ -0,0 +1,254 @@
+#include "asset_pack.h"
+#include <SDL2/SDL.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__EMSCRIPTEN__) || defined(_WIN32)
+// No mmap(); the archive is read into memory instead
+#define PACK_READ_WHOLE_FILE
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char PACK_MAGIC[4] = {'T', 'P', 'A', 'K'};
+const uint32_t PACK_VERSION = 1;
+/** Asset data starts on a multiple of this, so it can be read in place */
+const size_t PACK_ALIGNMENT = 16;
+
+/**
+ * An archive is a header, then an index of entries sorted by path,
+ * then the asset data. All integers are little-endian.
+ */
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint32_t count;
+  uint32_t reserved;
+} pack_header_t;
+
+typedef struct {
+  /** The asset's path, padded with '\0's */
+  char path[ASSET_PATH_MAX];
+  /** Where the asset's bytes start, from the start of the archive */
+  uint64_t offset;
+  uint64_t size;
+} pack_entry_t;
+
+typedef struct asset_pack {
+  /** The whole archive */
+  const uint8_t *data;
+  size_t size;
+  const pack_entry_t *entries;
+  size_t count;
+} asset_pack_t;
+
+/**
+ * The archive asset_open() reads from, or NULL to read loose files.
+ */
+asset_pack_t *mounted_pack = NULL;
+
+int compare_entries(const void *a, const void *b) {
+  return strcmp(((const pack_entry_t *)a)->path,
+                ((const pack_entry_t *)b)->path);
+}
+
+/** Reads a whole file into a new buffer, setting size to its length */
+uint8_t *read_file(const char *path, size_t *size) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  uint8_t *data = malloc(length > 0 ? length : 1);
+  assert(data != NULL);
+  if (length < 0 || fread(data, 1, length, file) != (size_t)length) {
+    free(data);
+    fclose(file);
+    return NULL;
+  }
+  fclose(file);
+  *size = length;
+  return data;
+}
+
+bool asset_pack_write(const char *pack_path, const char *const *paths,
+                      size_t count) {
+  pack_entry_t *entries = calloc(count, sizeof(pack_entry_t));
+  uint8_t **contents = malloc(count * sizeof(uint8_t *));
+  assert(entries != NULL);
+  assert(contents != NULL);
+  bool ok = true;
+  size_t offset = sizeof(pack_header_t) + count * sizeof(pack_entry_t);
+  for (size_t i = 0; i < count; i++) {
+    contents[i] = NULL;
+    size_t size = 0;
+    if (!ok || strlen(paths[i]) >= ASSET_PATH_MAX ||
+        (contents[i] = read_file(paths[i], &size)) == NULL) {
+      ok = false;
+      continue;
+    }
+    strcpy(entries[i].path, paths[i]);
+    offset = (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+    entries[i].offset = offset;
+    entries[i].size = size;
+    offset += size;
+  }
+
+  FILE *file = ok ? fopen(pack_path, "wb") : NULL;
+  if (file != NULL) {
+    // The data is laid out in the given order, but the index is sorted
+    // by path so lookups can binary search it
+    pack_entry_t *index = malloc(count * sizeof(pack_entry_t));
+    assert(index != NULL);
+    memcpy(index, entries, count * sizeof(pack_entry_t));
+    qsort(index, count, sizeof(pack_entry_t), compare_entries);
+    pack_header_t header = {.version = PACK_VERSION, .count = count};
+    memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(index, sizeof(pack_entry_t), count, file);
+    free(index);
+    for (size_t i = 0; i < count; i++) {
+      // Pad up to the entry's offset
+      while ((uint64_t)ftell(file) < entries[i].offset) {
+        fputc('\0', file);
+      }
+      fwrite(contents[i], 1, entries[i].size, file);
+    }
+    ok = !ferror(file);
+    ok = fclose(file) == 0 && ok;
+  } else {
+    ok = false;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    free(contents[i]);
+  }
+  free(contents);
+  free(entries);
+  return ok;
+}
+
+/** Checks that the archive's header and index describe its data */
+bool pack_is_valid(const uint8_t *data, size_t size) {
+  if (size < sizeof(pack_header_t)) {
+    return false;
+  }
+  const pack_header_t *header = (const pack_header_t *)data;
+  if (memcmp(header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 ||
+      header->version != PACK_VERSION ||
+      header->count > (size - sizeof(pack_header_t)) / sizeof(pack_entry_t)) {
+    return false;
+  }
+  const pack_entry_t *entries =
+      (const pack_entry_t *)(data + sizeof(pack_header_t));
+  for (size_t i = 0; i < header->count; i++) {
+    if (memchr(entries[i].path, '\0', ASSET_PATH_MAX) == NULL ||
+        entries[i].offset > size ||
+        entries[i].size > size - entries[i].offset) {
+      return false;
+    }
+  }
+  return true;
+}
+
+asset_pack_t *asset_pack_open(const char *pack_path) {
+  uint8_t *data = NULL;
+  size_t size = 0;
+#ifdef PACK_READ_WHOLE_FILE
+  data = read_file(pack_path, &size);
+  if (data == NULL) {
+    return NULL;
+  }
+#else
+  int fd = open(pack_path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+  size = info.st_size;
+  data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the file is closed
+  close(fd);
+  if (data == MAP_FAILED) {
+    return NULL;
+  }
+#endif
+
+  if (!pack_is_valid(data, size)) {
+#ifdef PACK_READ_WHOLE_FILE
+    free(data);
+#else
+    munmap(data, size);
+#endif
+    return NULL;
+  }
+  asset_pack_t *pack = malloc(sizeof(asset_pack_t));
+  assert(pack != NULL);
+  pack->data = data;
+  pack->size = size;
+  pack->entries = (const pack_entry_t *)(data + sizeof(pack_header_t));
+  pack->count = ((const pack_header_t *)data)->count;
+  return pack;
+}
+
+void asset_pack_close(asset_pack_t *pack) {
+#ifdef PACK_READ_WHOLE_FILE
+  free((uint8_t *)pack->data);
+#else
+  munmap((uint8_t *)pack->data, pack->size);
+#endif
+  free(pack);
+}
+
+size_t asset_pack_size(asset_pack_t *pack) { return pack->count; }
+
+const void *asset_pack_find(asset_pack_t *pack, const char *path,
+                            size_t *size) {
+  pack_entry_t key;
+  if (strlen(path) >= ASSET_PATH_MAX) {
+    return NULL;
+  }
+  strcpy(key.path, path);
+  const pack_entry_t *entry = bsearch(&key, pack->entries, pack->count,
+                                      sizeof(pack_entry_t), compare_entries);
+  if (entry == NULL) {
+    return NULL;
+  }
+  *size = entry->size;
+  return pack->data + entry->offset;
+}
+
+bool asset_pack_mount(const char *pack_path) {
+  asset_pack_unmount();
+  mounted_pack = asset_pack_open(pack_path);
+  return mounted_pack != NULL;
+}
+
+void asset_pack_unmount(void) {
+  if (mounted_pack != NULL) {
+    asset_pack_close(mounted_pack);
+    mounted_pack = NULL;
+  }
+}
+
+SDL_RWops *asset_open(const char *path) {
+  if (mounted_pack != NULL) {
+    size_t size;
+    const void *data = asset_pack_find(mounted_pack, path, &size);
+    if (data != NULL) {
+      return SDL_RWFromConstMem(data, size);
+    }
+  }
+  return SDL_RWFromFile(path, "rb");
+}
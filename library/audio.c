@@ -0,0 +1,132 @@
+#include "audio.h"
+#include "asset_pack.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <assert.h>
+#include <stdio.h>
+
+const int AUDIO_FREQUENCY = 44100;
+const int AUDIO_CHANNELS = 2;
+const int AUDIO_CHUNK_SIZE = 2048;
+
+/**
+ * A decoded sound effect and the range of mixer channels it plays on.
+ * The channels form a mixer group tagged with the sound's id.
+ */
+typedef struct {
+  Mix_Chunk *chunk;
+  int first_channel;
+  int voices;
+} sound_t;
+
+/**
+ * Whether the audio device is open.
+ */
+bool audio_open = false;
+/**
+ * The looping background music, or NULL if there is none.
+ */
+Mix_Music *audio_music = NULL;
+/**
+ * The loaded sound effects, indexed by sound id.
+ */
+sound_t audio_sounds[MAX_SOUNDS];
+size_t audio_sound_count = 0;
+/**
+ * The number of mixer channels handed out to sounds so far.
+ */
+int audio_channel_count = 0;
+audio_stats_t audio_counters = {0};
+
+bool audio_init(const char *music_path) {
+  assert(!audio_open);
+  if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0 ||
+      Mix_OpenAudio(AUDIO_FREQUENCY, MIX_DEFAULT_FORMAT, AUDIO_CHANNELS,
+                    AUDIO_CHUNK_SIZE) != 0) {
+    fprintf(stderr, "audio disabled: %s\n", Mix_GetError());
+    return false;
+  }
+  audio_open = true;
+  // Every channel belongs to a sound's pool, so start with none
+  Mix_AllocateChannels(0);
+  if (music_path != NULL) {
+    audio_music = Mix_LoadMUS_RW(asset_open(music_path), 1);
+    if (audio_music != NULL) {
+      Mix_PlayMusic(audio_music, -1);
+    }
+  }
+  return true;
+}
+
+size_t audio_load(const char *path, size_t max_voices) {
+  Mix_Chunk *chunk = NULL;
+  if (audio_open) {
+    chunk = Mix_LoadWAV_RW(asset_open(path), 1);
+    if (chunk == NULL) {
+      fprintf(stderr, "could not load %s: %s\n", path, Mix_GetError());
+    }
+  }
+  return audio_add(chunk, max_voices);
+}
+
+size_t audio_add(Mix_Chunk *chunk, size_t max_voices) {
+  assert(audio_sound_count < MAX_SOUNDS);
+  assert(max_voices > 0);
+  size_t id = audio_sound_count++;
+  sound_t *sound = &audio_sounds[id];
+  sound->chunk = chunk;
+  sound->first_channel = audio_channel_count;
+  sound->voices = max_voices;
+  if (!audio_open || chunk == NULL) {
+    return id;
+  }
+  audio_channel_count += max_voices;
+  Mix_AllocateChannels(audio_channel_count);
+  Mix_GroupChannels(sound->first_channel, audio_channel_count - 1, id);
+  return id;
+}
+
+void audio_play(size_t sound_id) {
+  assert(sound_id < audio_sound_count);
+  sound_t *sound = &audio_sounds[sound_id];
+  if (sound->chunk == NULL) {
+    audio_counters.failed++;
+    return;
+  }
+  int channel = Mix_GroupAvailable(sound_id);
+  if (channel == -1) {
+    // Every voice is busy, so restart the one that has played longest
+    channel = Mix_GroupOldest(sound_id);
+    audio_counters.stolen++;
+  } else {
+    audio_counters.played++;
+  }
+  if (channel == -1 || Mix_PlayChannel(channel, sound->chunk, 0) == -1) {
+    audio_counters.failed++;
+  }
+}
+
+audio_stats_t audio_stats(void) { return audio_counters; }
+
+void audio_free(void) {
+  if (!audio_open) {
+    audio_sound_count = 0;
+    return;
+  }
+  Mix_HaltChannel(-1);
+  Mix_HaltMusic();
+  for (size_t i = 0; i < audio_sound_count; i++) {
+    if (audio_sounds[i].chunk != NULL) {
+      Mix_FreeChunk(audio_sounds[i].chunk);
+    }
+  }
+  if (audio_music != NULL) {
+    Mix_FreeMusic(audio_music);
+    audio_music = NULL;
+  }
+  audio_sound_count = 0;
+  audio_channel_count = 0;
+  Mix_CloseAudio();
+  SDL_QuitSubSystem(SDL_INIT_AUDIO);
+  audio_open = false;
+}
@@ -0,0 +1,166 @@
+#include "bench_stats.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Two-sided 95% critical values of Student's t, for 1 to 30 degrees */
+const double T_CRITICAL[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+const double T_CRITICAL_LIMIT = 1.960;
+
+bench_summary_t bench_summarize(const double *samples, size_t count) {
+  assert(count > 0);
+  double sum = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    sum += samples[i];
+  }
+  double mean = sum / count;
+  double squares = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    squares += (samples[i] - mean) * (samples[i] - mean);
+  }
+  double stddev = count > 1 ? sqrt(squares / (count - 1)) : 0.0;
+  return (bench_summary_t){mean, stddev, count};
+}
+
+double bench_t_critical(double df) {
+  assert(df >= 1);
+  size_t table_size = sizeof(T_CRITICAL) / sizeof(T_CRITICAL[0]);
+  if (df <= table_size) {
+    // Welch's degrees of freedom are fractional; round down to be cautious
+    return T_CRITICAL[(size_t)df - 1];
+  }
+  // Close to the true value (within 0.003) for every df past the table
+  return T_CRITICAL_LIMIT + 2.4 / df;
+}
+
+bench_comparison_t bench_compare(bench_summary_t baseline,
+                                 bench_summary_t current) {
+  assert(baseline.count > 1 && current.count > 1);
+  assert(baseline.mean > 0);
+  double baseline_variance =
+      baseline.stddev * baseline.stddev / baseline.count;
+  double current_variance = current.stddev * current.stddev / current.count;
+  double standard_error = sqrt(baseline_variance + current_variance);
+  double difference = current.mean - baseline.mean;
+
+  bench_comparison_t comparison;
+  comparison.change = difference / baseline.mean;
+  if (standard_error == 0.0) {
+    // Perfectly repeatable samples: any difference at all is real
+    comparison.df = baseline.count + current.count - 2;
+    comparison.t = difference == 0.0 ? 0.0 : copysign(INFINITY, difference);
+    comparison.change_low = comparison.change;
+    comparison.change_high = comparison.change;
+    comparison.significant = difference != 0.0;
+    return comparison;
+  }
+  // The Welch-Satterthwaite approximation
+  comparison.df =
+      pow(baseline_variance + current_variance, 2) /
+      (baseline_variance * baseline_variance / (baseline.count - 1) +
+       current_variance * current_variance / (current.count - 1));
+  comparison.t = difference / standard_error;
+  double margin = bench_t_critical(comparison.df) * standard_error;
+  comparison.change_low = (difference - margin) / baseline.mean;
+  comparison.change_high = (difference + margin) / baseline.mean;
+  comparison.significant =
+      comparison.change_low > 0.0 || comparison.change_high < 0.0;
+  return comparison;
+}
+
+bool bench_is_regression(bench_comparison_t comparison, double threshold) {
+  return comparison.significant && comparison.change_low > 0.0 &&
+         comparison.change > threshold;
+}
+
+/** Reads a whole file into a string, or returns NULL */
+char *read_results_file(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *contents = malloc(size + 1);
+  assert(contents != NULL);
+  size_t read = fread(contents, 1, size, file);
+  fclose(file);
+  contents[read] = '\0';
+  return contents;
+}
+
+/**
+ * Copies the string value that follows a key, e.g. "name": "...".
+ * Returns a pointer past the value, or NULL if the key is not found.
+ */
+const char *read_json_string(const char *json, const char *key, char *value) {
+  const char *start = strstr(json, key);
+  if (start == NULL) {
+    return NULL;
+  }
+  start += strlen(key);
+  const char *end = strchr(start, '"');
+  if (end == NULL) {
+    return NULL;
+  }
+  size_t length = end - start;
+  if (length >= BENCH_NAME_LENGTH) {
+    length = BENCH_NAME_LENGTH - 1;
+  }
+  memcpy(value, start, length);
+  value[length] = '\0';
+  return end + 1;
+}
+
+int bench_read_results(const char *path, bench_record_t *records,
+                       size_t max_records, char *fingerprint) {
+  char *json = read_results_file(path);
+  if (json == NULL) {
+    return -1;
+  }
+  const char *cursor = strstr(json, "\"benchmarks\"");
+  if (cursor == NULL) {
+    free(json);
+    return -1;
+  }
+  if (fingerprint != NULL &&
+      read_json_string(json, "\"fingerprint\": \"", fingerprint) == NULL) {
+    fingerprint[0] = '\0';
+  }
+
+  size_t count = 0;
+  while (count < max_records) {
+    bench_record_t *record = &records[count];
+    cursor = read_json_string(cursor, "\"name\": \"", record->name);
+    if (cursor == NULL) {
+      break;
+    }
+    cursor = strstr(cursor, "\"samples\": [");
+    if (cursor == NULL) {
+      break;
+    }
+    cursor += strlen("\"samples\": [");
+    record->count = 0;
+    while (*cursor != ']' && record->count < BENCH_MAX_SAMPLES) {
+      char *end;
+      double sample = strtod(cursor, &end);
+      if (end == cursor) {
+        break;
+      }
+      record->samples[record->count++] = sample;
+      cursor = end;
+      while (*cursor == ',' || *cursor == ' ') {
+        cursor++;
+      }
+    }
+    count++;
+  }
+  free(json);
+  return count;
+}
@@ -1,4 +1,5 @@
 
+#include "body_pool.h"
 #include "color.h"
 #include "forces.h"
 #include "list.h"
@@ -27,7 +28,11 @@ char *GRAVITY_IMAGE_PATH = "assets/gravity_tank.png";
 char *SNIPER_IMAGE_PATH = "assets/sniper_tank.png";
 char *GATLING_IMAGE_PATH = "assets/gatling_tank.png";
 
+// The id the next body made or reset gets (see body_get_id())
+size_t next_body_id = 1;
+
 typedef struct body {
+  size_t id;
   graphic_t *graphic;
   double mass;
   list_t *shape;
@@ -47,52 +52,153 @@ typedef struct body {
   size_t ai_mode;
   double ai_time;
   bool just_collided;
+  /** Whether scene_tick() sweeps the body so it cannot pass through others */
+  bool is_bullet;
+  /** What the body collides as, and the size of its circle or capsule */
+  collider_kind_t collider;
+  double half_length;
+  double radius;
+  /** Half the size of a box body's rectangle (see body_get_box()) */
+  vector_t half_size;
+  /**
+   * The unit normals of the body's edges at no rotation, and then at
+   * normals_rotation (see body_get_normals()), in one allocation
+   */
+  vector_t *local_normals;
+  vector_t *normals;
+  size_t normal_count;
+  double normals_rotation;
   char *image_path;
+  body_pool_t *pool;
+  /** Where the body was allocated from */
+  allocator_t allocator;
 } body_t;
 
-body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
-  body_t *body = malloc(sizeof(body_t));
-  assert(body != NULL);
-  body->shape = shape;
+/**
+ * Makes a body that collides as its polygon a box if the polygon is a
+ * rectangle, and otherwise a polygon. Round bodies are left alone.
+ */
+void body_find_box(body_t *body) {
+  if (body->collider != COLLIDER_POLYGON && body->collider != COLLIDER_BOX) {
+    return;
+  }
+  if (!polygon_is_rectangle(body->shape)) {
+    body->collider = COLLIDER_POLYGON;
+    return;
+  }
+  body->collider = COLLIDER_BOX;
+  vector_t *corner1 = list_get(body->shape, 0);
+  vector_t *corner2 = list_get(body->shape, 1);
+  vector_t *corner3 = list_get(body->shape, 2);
+  vector_t side1 = vec_subtract(*corner2, *corner1);
+  vector_t side2 = vec_subtract(*corner3, *corner2);
+  body->half_size = (vector_t){sqrt(vec_dot(side1, side1)) / 2,
+                               sqrt(vec_dot(side2, side2)) / 2};
+}
+
+/**
+ * Computes a body's edge normals from its shape, as they are now and as they
+ * would be at no rotation
+ */
+void body_find_normals(body_t *body) {
+  size_t n = list_size(body->shape);
+  if (n != body->normal_count) {
+    if (body->local_normals != NULL) {
+      allocator_free(&body->allocator, body->local_normals);
+    }
+    body->local_normals =
+        allocator_alloc(&body->allocator, 2 * n * sizeof(vector_t));
+    body->normals = body->local_normals + n;
+    body->normal_count = n;
+  }
+  find_perp_axis(body->shape, body->normals);
+  for (size_t i = 0; i < n; i++) {
+    body->local_normals[i] = vec_rotate(body->normals[i], -body->rotation);
+  }
+  body->normals_rotation = body->rotation;
+}
+
+/** Resets everything but a body's shape, info and pool */
+void body_reset_state(body_t *body, double mass, rgb_color_t color) {
+  body->id = next_body_id++;
   body->velocity = VEC_ZERO;
-  body->centroid = polygon_centroid(shape);
+  body->centroid = polygon_centroid(body->shape);
   body->color = color;
   body->rotation = 0.0;
   body->rotation_speed = 0.0;
   body->mass = mass;
   body->force = VEC_ZERO;
   body->impulse = VEC_ZERO;
-  body->info = NULL;
   body->magnitude = 0.0;
-  body->freer = (free_func_t)free;
   body->is_removed = false;
   body->time = INFINITY;
   body->health = 10.0;
   body->ai_mode = 0;
   body->ai_time = 0;
   body->just_collided = false;
+  body->is_bullet = false;
+  body->collider = COLLIDER_POLYGON;
+  body_find_box(body);
+  body_find_normals(body);
   body->image_path = NULL;
-  return body;
+}
+
+body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
+  return body_init_with_allocator(shape, mass, color, NULL, NULL, NULL);
+}
+
+void body_set_vertices(body_t *body, list_t *shape) {
+  assert(list_size(shape) == list_size(body->shape));
+  for (size_t i = 0; i < list_size(shape); i++) {
+    *(vector_t *)list_get(body->shape, i) = *(vector_t *)list_get(shape, i);
+  }
+  body->centroid = polygon_centroid(body->shape);
+  body_find_box(body);
+  body_find_normals(body);
+}
+
+void body_reset(body_t *body, list_t *shape, double mass, rgb_color_t color) {
+  body_set_vertices(body, shape);
+  body_reset_state(body, mass, color);
 }
 
 body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
                             void *info, free_func_t info_freer) {
-  body_t *body = body_init(shape, mass, color);
-  if (mass == INFINITY) {
-    body->velocity = VEC_ZERO;
-  }
+  return body_init_with_allocator(shape, mass, color, info, info_freer, NULL);
+}
+
+body_t *body_init_with_allocator(list_t *shape, double mass,
+                                 rgb_color_t color, void *info,
+                                 free_func_t info_freer,
+                                 const allocator_t *allocator) {
+  allocator_t body_allocator =
+      allocator != NULL ? *allocator : heap_allocator();
+  body_t *body = allocator_alloc(&body_allocator, sizeof(body_t));
+  body->allocator = body_allocator;
+  body->shape = shape;
   body->info = info;
   body->freer = info_freer;
-  if (info_freer == NULL) {
-    body->freer = (free_func_t)free;
-  }
+  body->pool = NULL;
+  body->local_normals = NULL;
+  body->normal_count = 0;
+  body_reset_state(body, mass, color);
   return body;
 }
 
 void body_free(body_t *body) {
+  if (body->pool != NULL) {
+    body_pool_release(body->pool, body);
+    return;
+  }
   list_free(body->shape);
-  body->freer(body->info);
-  free(body);
+  allocator_free(&body->allocator, body->local_normals);
+  if (body->freer != NULL) {
+    body->freer(body->info);
+  } else {
+    allocator_free(&body->allocator, body->info);
+  }
+  allocator_t allocator = body->allocator;
+  allocator_free(&allocator, body);
 }
 
 list_t *body_get_shape(body_t *body) {
@@ -107,8 +213,66 @@ list_t *body_get_shape(body_t *body) {
   return lst;
 }
 
+list_t *body_get_shape_arena(body_t *body, arena_t *arena) {
+  size_t n = list_size(body->shape);
+  list_t *lst = list_init_arena(arena, n);
+  vector_t *points = arena_alloc(arena, n * sizeof(vector_t));
+  for (size_t i = 0; i < n; i++) {
+    points[i] = *(vector_t *)list_get(body->shape, i);
+    list_add(lst, &points[i]);
+  }
+  return lst;
+}
+
 vector_t body_get_centroid(body_t *body) { return body->centroid; }
 
+obb_t body_get_box(body_t *body) {
+  // The box turns and moves with its polygon, so its first side gives its
+  // direction; its length is known, so this needs no square root
+  vector_t *corner1 = list_get(body->shape, 0);
+  vector_t *corner2 = list_get(body->shape, 1);
+  vector_t side = vec_subtract(*corner2, *corner1);
+  return (obb_t){body->centroid,
+                 vec_multiply(0.5 / body->half_size.x, side), body->half_size};
+}
+
+capsule_t body_get_capsule(body_t *body) {
+  vector_t half = {body->half_length * cos(body->rotation),
+                   body->half_length * sin(body->rotation)};
+  return (capsule_t){vec_subtract(body->centroid, half),
+                     vec_add(body->centroid, half), body->radius};
+}
+
+aabb_t body_get_bounds(body_t *body) {
+  if (body->collider == COLLIDER_POLYGON || body->collider == COLLIDER_BOX) {
+    return polygon_bounds(body->shape);
+  }
+  capsule_t capsule = body_get_capsule(body);
+  vector_t radius = {capsule.radius, capsule.radius};
+  aabb_t start = {vec_subtract(capsule.start, radius),
+                  vec_add(capsule.start, radius)};
+  aabb_t end = {vec_subtract(capsule.end, radius),
+                vec_add(capsule.end, radius)};
+  return aabb_union(start, end);
+}
+
+collider_kind_t body_get_collider(body_t *body) { return body->collider; }
+
+const vector_t *body_get_normals(body_t *body) {
+  if (body->rotation != body->normals_rotation) {
+    double c = cos(body->rotation), s = sin(body->rotation);
+    for (size_t i = 0; i < body->normal_count; i++) {
+      vector_t local = body->local_normals[i];
+      body->normals[i] =
+          (vector_t){c * local.x - s * local.y, s * local.x + c * local.y};
+    }
+    body->normals_rotation = body->rotation;
+  }
+  return body->normals;
+}
+
+size_t body_get_id(body_t *body) { return body->id; }
+
 double body_get_rotation(body_t *body) { return body->rotation; }
 
 vector_t body_get_velocity(body_t *body) { return body->velocity; }
@@ -138,6 +302,8 @@ void body_set_centroid(body_t *body, vector_t x) {
   body->centroid = x;
 }
 
+void body_set_pool(body_t *body, body_pool_t *pool) { body->pool = pool; }
+
 void body_set_graphic(body_t *body, graphic_t *graphic) {
   body->graphic = graphic;
 }
@@ -148,7 +314,11 @@ void body_set_magnitude(body_t *body, double magnitude) {
 
 void body_set_force(body_t *body, vector_t v) { body->force = v; }
 
-void body_set_shape(body_t *body, list_t *shape) { body->shape = shape; }
+void body_set_shape(body_t *body, list_t *shape) {
+  body->shape = shape;
+  body_find_box(body);
+  body_find_normals(body);
+}
 
 void body_set_health(body_t *body, double health) { body->health = health; }
 
@@ -164,6 +334,24 @@ void body_set_just_collided(body_t *body, bool just_collided) {
   body->just_collided = just_collided;
 }
 
+void body_set_bullet(body_t *body, bool is_bullet) {
+  body->is_bullet = is_bullet;
+}
+
+bool body_is_bullet(body_t *body) { return body->is_bullet; }
+
+void body_set_circle(body_t *body, double radius) {
+  body->collider = COLLIDER_CIRCLE;
+  body->half_length = 0.0;
+  body->radius = radius;
+}
+
+void body_set_capsule(body_t *body, double length, double radius) {
+  body->collider = COLLIDER_CAPSULE;
+  body->half_length = length / 2;
+  body->radius = radius;
+}
+
 void body_set_rotation_speed(body_t *body, double w) {
   body->rotation_speed = w;
 }
@@ -176,6 +364,8 @@ void body_set_rotation(body_t *body, double angle) {
 
 void body_set_rotation_empty(body_t *body, double rotation) {
   body->rotation = rotation;
+  // the shape is already turned, so its normals are too
+  body_find_normals(body);
 }
 
 void body_set_ai_mode(body_t *body, size_t mode) { body->ai_mode = mode; };
@@ -184,25 +374,30 @@ void body_combine_mass(body_t *body1, body_t *body2) {
   body1->mass = body1->mass + body2->mass;
 }
 
-void body_tick(body_t *body, double dt) {
+vector_t body_next_velocity(body_t *body, double dt) {
   // get acceleration
-  vector_t old_velocity = body_get_velocity(body);
   vector_t acceleration =
       vec_multiply(1.0 / body_get_mass(body), body_get_force(body));
   vector_t changed_velocity =
       vec_add(body->velocity, vec_multiply(dt, acceleration));
-  body->velocity = changed_velocity;
   // get velocity
   vector_t impulse =
       vec_multiply(1.0 / body_get_mass(body), body_get_impulse(body));
-  vector_t changed_velocity2 = vec_add(body->velocity, impulse);
-  body->velocity = changed_velocity2;
+  return vec_add(changed_velocity, impulse);
+}
 
+vector_t body_get_translation(body_t *body, double dt) {
   // average velocity
-  vector_t added = vec_add(old_velocity, body->velocity);
+  vector_t added = vec_add(body->velocity, body_next_velocity(body, dt));
   vector_t average = vec_multiply(0.5, added);
+  return (vector_t){dt * (average.x), dt * (average.y)};
+}
 
-  // vector_t translation = {dt * (body->velocity.x), dt * (body->velocity.y)};
+void body_tick(body_t *body, double dt) {
+  vector_t old_velocity = body->velocity;
+  body->velocity = body_next_velocity(body, dt);
+  // translate at the average velocity, like body_get_translation()
+  vector_t average = vec_multiply(0.5, vec_add(old_velocity, body->velocity));
   vector_t translation = {dt * (average.x), dt * (average.y)};
   polygon_translate(body->shape, translation);
   body->centroid = polygon_centroid(body->shape);
@@ -0,0 +1,85 @@
+#include "body_pool.h"
+#include <assert.h>
+#include <stdlib.h>
+
+typedef struct body_pool {
+  /** The shape every body starts with */
+  list_t *shape;
+  /** Freed bodies, ready to be handed out again */
+  list_t *spares;
+  body_pool_stats_t stats;
+} body_pool_t;
+
+/** Frees a spare body for real, rather than handing it back to its pool */
+void spare_body_free(body_t *body) {
+  body_set_pool(body, NULL);
+  body_free(body);
+}
+
+/** Allocates a body, with its own copy of the pool's shape */
+body_t *pool_body_init(body_pool_t *pool) {
+  list_t *shape = list_init(list_size(pool->shape), (free_func_t)free);
+  for (size_t i = 0; i < list_size(pool->shape); i++) {
+    vector_t *point = malloc(sizeof(vector_t));
+    assert(point != NULL);
+    *point = *(vector_t *)list_get(pool->shape, i);
+    list_add(shape, point);
+  }
+  size_t *type = malloc(sizeof(size_t));
+  assert(type != NULL);
+  body_t *body = body_init_with_info(shape, 1.0, (rgb_color_t){0, 0, 0}, type,
+                                     (free_func_t)free);
+  body_set_pool(body, pool);
+  return body;
+}
+
+body_pool_t *body_pool_init(list_t *shape, size_t initial) {
+  assert(list_size(shape) > 0);
+  body_pool_t *pool = malloc(sizeof(body_pool_t));
+  assert(pool != NULL);
+  pool->shape = shape;
+  pool->spares =
+      list_init(initial > 0 ? initial : 1, (free_func_t)spare_body_free);
+  for (size_t i = 0; i < initial; i++) {
+    list_add(pool->spares, pool_body_init(pool));
+  }
+  pool->stats = (body_pool_stats_t){0, 0, 0, 0};
+  return pool;
+}
+
+void body_pool_free(body_pool_t *pool) {
+  assert(pool->stats.in_use == 0);
+  list_free(pool->spares);
+  list_free(pool->shape);
+  free(pool);
+}
+
+body_t *body_pool_get(body_pool_t *pool, double mass, rgb_color_t color,
+                      size_t type) {
+  body_t *body;
+  size_t spares = list_size(pool->spares);
+  if (spares > 0) {
+    body = list_remove(pool->spares, spares - 1);
+    pool->stats.hits++;
+  } else {
+    body = pool_body_init(pool);
+    pool->stats.misses++;
+  }
+  body_reset(body, pool->shape, mass, color);
+  *(size_t *)body_get_info(body) = type;
+
+  pool->stats.in_use++;
+  if (pool->stats.in_use > pool->stats.high_water) {
+    pool->stats.high_water = pool->stats.in_use;
+  }
+  return body;
+}
+
+void body_pool_release(body_pool_t *pool, body_t *body) {
+  assert(pool->stats.in_use > 0);
+  pool->stats.in_use--;
+  // only grows past the preallocated spares if the high-water mark rises
+  list_add(pool->spares, body);
+}
+
+body_pool_stats_t body_pool_stats(body_pool_t *pool) { return pool->stats; }
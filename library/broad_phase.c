@@ -0,0 +1,494 @@
+#include "broad_phase.h"
+#include "aabb_tree.h"
+#include "body.h"
+#include "key_table.h"
+#include "polygon.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AXES 2
+const size_t INITIAL_PROXIES = 64;
+const size_t INITIAL_TABLE_SIZE = 128;
+/** How far the tree broad phase fattens moving bodies' leaves */
+const double TREE_FATTEN = 0.1;
+
+/** A body in the broad phase */
+typedef struct {
+  /** The body, or NULL if the slot is free */
+  body_t *body;
+  aabb_t bounds;
+  /** The update that last saw the body */
+  size_t seen;
+  /** Whether the body has infinite mass, so it goes in the static tree */
+  bool is_static;
+  /** The body's leaf in the dynamic tree, if it is not static */
+  size_t leaf;
+} proxy_t;
+
+/** One end of a proxy's interval on an axis */
+typedef struct {
+  double value;
+  uint32_t proxy;
+  bool is_max;
+} endpoint_t;
+
+typedef struct broad_phase {
+  broad_phase_kind_t kind;
+  proxy_t *proxies;
+  size_t proxy_capacity;
+  /** Slots past the last live proxy are free, as are the ones listed here */
+  size_t proxy_count;
+  size_t *free_proxies;
+  size_t free_count;
+  /** Sweep and prune: each axis's endpoints, sorted as of the last update */
+  endpoint_t *endpoints[AXES];
+  size_t endpoint_count;
+  /** AABB tree: the static bodies, rebuilt whenever they change */
+  aabb_tree_t *static_tree;
+  bool static_changed;
+  /** AABB tree: the moving bodies */
+  aabb_tree_t *dynamic_tree;
+  /** Maps each body to its proxy */
+  key_table_t body_proxies;
+  /** The overlapping pairs of proxies, see pair_key() */
+  key_table_t pairs;
+  size_t updates;
+} broad_phase_t;
+
+/** The key of a pair of proxies, in either order */
+uint64_t pair_key(size_t proxy1, size_t proxy2) {
+  size_t low = proxy1 < proxy2 ? proxy1 : proxy2;
+  size_t high = proxy1 < proxy2 ? proxy2 : proxy1;
+  // the high proxy is never 0, so neither is the key
+  return ((uint64_t)low << 32) | high;
+}
+
+uint64_t body_key(body_t *body) { return (uint64_t)(uintptr_t)body; }
+
+broad_phase_t *broad_phase_init(broad_phase_kind_t kind) {
+  assert(kind != BROAD_PHASE_NONE && kind < BROAD_PHASE_KIND_COUNT);
+  broad_phase_t *broad_phase = calloc(1, sizeof(broad_phase_t));
+  assert(broad_phase != NULL);
+  broad_phase->kind = kind;
+  broad_phase->proxy_capacity = INITIAL_PROXIES;
+  broad_phase->proxies = malloc(INITIAL_PROXIES * sizeof(proxy_t));
+  broad_phase->free_proxies = malloc(INITIAL_PROXIES * sizeof(size_t));
+  assert(broad_phase->proxies != NULL && broad_phase->free_proxies != NULL);
+  for (size_t axis = 0; axis < AXES; axis++) {
+    broad_phase->endpoints[axis] =
+        malloc(2 * INITIAL_PROXIES * sizeof(endpoint_t));
+    assert(broad_phase->endpoints[axis] != NULL);
+  }
+  key_table_init(&broad_phase->body_proxies, INITIAL_TABLE_SIZE);
+  key_table_init(&broad_phase->pairs, INITIAL_TABLE_SIZE);
+  if (kind == BROAD_PHASE_AABB_TREE) {
+    list_t *no_bodies = list_init(1, NULL);
+    broad_phase->static_tree = aabb_tree_build(no_bodies);
+    list_free(no_bodies);
+    broad_phase->dynamic_tree = aabb_tree_init(TREE_FATTEN);
+  }
+  return broad_phase;
+}
+
+void broad_phase_free(broad_phase_t *broad_phase) {
+  free(broad_phase->proxies);
+  free(broad_phase->free_proxies);
+  for (size_t axis = 0; axis < AXES; axis++) {
+    free(broad_phase->endpoints[axis]);
+  }
+  key_table_free(&broad_phase->body_proxies);
+  key_table_free(&broad_phase->pairs);
+  if (broad_phase->kind == BROAD_PHASE_AABB_TREE) {
+    aabb_tree_free(broad_phase->static_tree);
+    aabb_tree_free(broad_phase->dynamic_tree);
+  }
+  free(broad_phase);
+}
+
+broad_phase_kind_t broad_phase_kind(broad_phase_t *broad_phase) {
+  return broad_phase->kind;
+}
+
+const char *broad_phase_name(broad_phase_kind_t kind) {
+  static const char *names[BROAD_PHASE_KIND_COUNT] = {
+      "none", "sweep and prune", "aabb tree"};
+  assert(kind < BROAD_PHASE_KIND_COUNT);
+  return names[kind];
+}
+
+double axis_min(aabb_t bounds, size_t axis) {
+  return axis == 0 ? bounds.min.x : bounds.min.y;
+}
+
+double axis_max(aabb_t bounds, size_t axis) {
+  return axis == 0 ? bounds.max.x : bounds.max.y;
+}
+
+/** Adds a proxy for a body, to be put in place by the rest of the update */
+size_t add_proxy(broad_phase_t *broad_phase, body_t *body) {
+  size_t proxy;
+  if (broad_phase->free_count > 0) {
+    proxy = broad_phase->free_proxies[--broad_phase->free_count];
+  } else {
+    if (broad_phase->proxy_count == broad_phase->proxy_capacity) {
+      size_t capacity = broad_phase->proxy_capacity * 2;
+      broad_phase->proxies =
+          realloc(broad_phase->proxies, capacity * sizeof(proxy_t));
+      broad_phase->free_proxies =
+          realloc(broad_phase->free_proxies, capacity * sizeof(size_t));
+      assert(broad_phase->proxies != NULL &&
+             broad_phase->free_proxies != NULL);
+      for (size_t axis = 0; axis < AXES; axis++) {
+        broad_phase->endpoints[axis] = realloc(
+            broad_phase->endpoints[axis], 2 * capacity * sizeof(endpoint_t));
+        assert(broad_phase->endpoints[axis] != NULL);
+      }
+      broad_phase->proxy_capacity = capacity;
+    }
+    proxy = broad_phase->proxy_count++;
+  }
+  assert(proxy < UINT32_MAX);
+  broad_phase->proxies[proxy] = (proxy_t){.body = body, .seen = 0};
+  key_table_put(&broad_phase->body_proxies, body_key(body), proxy);
+  return proxy;
+}
+
+/**
+ * Gives a new proxy endpoints past every other endpoint, as if it were
+ * infinitely far away, so sorting them into place finds the pairs it
+ * overlaps.
+ */
+void add_endpoints(broad_phase_t *broad_phase, size_t proxy) {
+  for (size_t axis = 0; axis < AXES; axis++) {
+    endpoint_t *endpoints = broad_phase->endpoints[axis];
+    endpoints[broad_phase->endpoint_count] =
+        (endpoint_t){INFINITY, proxy, false};
+    endpoints[broad_phase->endpoint_count + 1] =
+        (endpoint_t){INFINITY, proxy, true};
+  }
+  broad_phase->endpoint_count += 2;
+}
+
+/** Whether one endpoint belongs after another; starts go before ends */
+bool endpoint_after(endpoint_t endpoint1, endpoint_t endpoint2) {
+  return endpoint1.value > endpoint2.value ||
+         (endpoint1.value == endpoint2.value && endpoint1.is_max &&
+          !endpoint2.is_max);
+}
+
+/**
+ * Insertion-sorts an axis's endpoints, updating the pairs as they pass each
+ * other. When a start moves back past an end, the two intervals begin to
+ * overlap on this axis, so the boxes may now overlap; when an end moves back
+ * past a start, they stop overlapping.
+ */
+void sort_axis(broad_phase_t *broad_phase, size_t axis) {
+  endpoint_t *endpoints = broad_phase->endpoints[axis];
+  proxy_t *proxies = broad_phase->proxies;
+  for (size_t i = 1; i < broad_phase->endpoint_count; i++) {
+    endpoint_t endpoint = endpoints[i];
+    size_t j = i;
+    while (j > 0 && endpoint_after(endpoints[j - 1], endpoint)) {
+      endpoint_t passed = endpoints[j - 1];
+      if (!endpoint.is_max && passed.is_max) {
+        if (aabb_overlap(proxies[endpoint.proxy].bounds,
+                         proxies[passed.proxy].bounds)) {
+          key_table_put(&broad_phase->pairs,
+                        pair_key(endpoint.proxy, passed.proxy), 0);
+        }
+      } else if (endpoint.is_max && !passed.is_max) {
+        key_table_remove(&broad_phase->pairs,
+                         pair_key(endpoint.proxy, passed.proxy));
+      }
+      endpoints[j] = passed;
+      j--;
+    }
+    endpoints[j] = endpoint;
+  }
+}
+
+/**
+ * Re-sorts the endpoints after the proxies' bounds are updated. Bodies that
+ * are gone have been sent infinitely far away, which ends their pairs as
+ * they are sorted to the back, where they are dropped.
+ */
+void sweep_and_prune(broad_phase_t *broad_phase, size_t removed) {
+  proxy_t *proxies = broad_phase->proxies;
+  for (size_t axis = 0; axis < AXES; axis++) {
+    endpoint_t *endpoints = broad_phase->endpoints[axis];
+    for (size_t i = 0; i < broad_phase->endpoint_count; i++) {
+      aabb_t bounds = proxies[endpoints[i].proxy].bounds;
+      endpoints[i].value =
+          endpoints[i].is_max ? axis_max(bounds, axis) : axis_min(bounds, axis);
+    }
+    sort_axis(broad_phase, axis);
+  }
+
+  // Far-away proxies tie with each other, so their pairs with each other
+  // may not have ended while sorting
+  endpoint_t *gone = broad_phase->endpoints[0] +
+                     (broad_phase->endpoint_count - 2 * removed);
+  for (size_t i = 0; i < 2 * removed; i++) {
+    for (size_t j = i + 1; j < 2 * removed; j++) {
+      key_table_remove(&broad_phase->pairs,
+                       pair_key(gone[i].proxy, gone[j].proxy));
+    }
+  }
+  broad_phase->endpoint_count -= 2 * removed;
+}
+
+/** Keeps a pair found in the trees if the bodies' own boxes overlap */
+void add_tree_pair(body_t *body1, body_t *body2, void *aux) {
+  broad_phase_t *broad_phase = aux;
+  size_t proxy1, proxy2;
+  key_table_get(&broad_phase->body_proxies, body_key(body1), &proxy1);
+  key_table_get(&broad_phase->body_proxies, body_key(body2), &proxy2);
+  if (aabb_overlap(broad_phase->proxies[proxy1].bounds,
+                   broad_phase->proxies[proxy2].bounds)) {
+    key_table_put(&broad_phase->pairs, pair_key(proxy1, proxy2), 0);
+  }
+}
+
+/** Rebuilds the static tree if the static bodies changed */
+void rebuild_static_tree(broad_phase_t *broad_phase) {
+  if (broad_phase->static_changed) {
+    list_t *static_bodies = list_init(broad_phase->proxy_count + 1, NULL);
+    for (size_t proxy = 0; proxy < broad_phase->proxy_count; proxy++) {
+      proxy_t *p = &broad_phase->proxies[proxy];
+      if (p->body != NULL && p->is_static &&
+          p->seen == broad_phase->updates) {
+        list_add(static_bodies, p->body);
+      }
+    }
+    aabb_tree_free(broad_phase->static_tree);
+    broad_phase->static_tree = aabb_tree_build(static_bodies);
+    list_free(static_bodies);
+    broad_phase->static_changed = false;
+  }
+}
+
+/**
+ * Finds the pairs among the moving bodies and between them and the static
+ * ones. Static bodies never collide with each other.
+ */
+void find_tree_pairs(broad_phase_t *broad_phase) {
+  rebuild_static_tree(broad_phase);
+  key_table_clear(&broad_phase->pairs);
+  aabb_tree_self_pairs(broad_phase->dynamic_tree, add_tree_pair, broad_phase);
+  aabb_tree_pairs(broad_phase->dynamic_tree, broad_phase->static_tree,
+                  add_tree_pair, broad_phase);
+}
+
+/** Puts a new proxy, or one whose body became (non-)static, in a tree */
+void place_in_tree(broad_phase_t *broad_phase, size_t proxy) {
+  proxy_t *p = &broad_phase->proxies[proxy];
+  p->is_static = body_get_mass(p->body) == INFINITY;
+  if (p->is_static) {
+    broad_phase->static_changed = true;
+  } else {
+    p->leaf = aabb_tree_insert(broad_phase->dynamic_tree, p->body, p->bounds);
+  }
+}
+
+/** Takes a proxy out of whichever tree it is in */
+void remove_from_tree(broad_phase_t *broad_phase, size_t proxy) {
+  proxy_t *p = &broad_phase->proxies[proxy];
+  if (p->is_static) {
+    broad_phase->static_changed = true;
+  } else {
+    aabb_tree_remove(broad_phase->dynamic_tree, p->leaf);
+  }
+}
+
+/**
+ * Updates the proxies' bounds from their bodies, adding proxies for bodies
+ * not seen before. The proxies of bodies that are gone are taken out of the
+ * trees and sent infinitely far away, to be dropped by drop_proxies().
+ *
+ * @return how many proxies' bodies are gone
+ */
+size_t sync_proxies(broad_phase_t *broad_phase, list_t *bodies) {
+  size_t update = ++broad_phase->updates;
+  bool tree = broad_phase->kind == BROAD_PHASE_AABB_TREE;
+  for (size_t i = 0; i < list_size(bodies); i++) {
+    body_t *body = list_get(bodies, i);
+    if (body_is_removed(body)) {
+      continue;
+    }
+    aabb_t bounds = body_get_bounds(body);
+    size_t proxy;
+    if (!key_table_get(&broad_phase->body_proxies, body_key(body), &proxy)) {
+      proxy = add_proxy(broad_phase, body);
+      broad_phase->proxies[proxy].bounds = bounds;
+      if (tree) {
+        place_in_tree(broad_phase, proxy);
+      } else {
+        add_endpoints(broad_phase, proxy);
+      }
+    } else if (tree) {
+      proxy_t *p = &broad_phase->proxies[proxy];
+      aabb_t old_bounds = p->bounds;
+      p->bounds = bounds;
+      if (p->is_static != (body_get_mass(body) == INFINITY)) {
+        // a freed body's memory may be reused by a different kind of body
+        remove_from_tree(broad_phase, proxy);
+        place_in_tree(broad_phase, proxy);
+      } else if (p->is_static) {
+        broad_phase->static_changed |=
+            memcmp(&old_bounds, &bounds, sizeof(aabb_t)) != 0;
+      } else {
+        aabb_tree_move(broad_phase->dynamic_tree, p->leaf, bounds,
+                       vec_subtract(bounds.min, old_bounds.min));
+      }
+    } else {
+      broad_phase->proxies[proxy].bounds = bounds;
+    }
+    broad_phase->proxies[proxy].seen = update;
+  }
+
+  proxy_t *proxies = broad_phase->proxies;
+  size_t removed = 0;
+  aabb_t far_away = {{INFINITY, INFINITY}, {INFINITY, INFINITY}};
+  for (size_t proxy = 0; proxy < broad_phase->proxy_count; proxy++) {
+    if (proxies[proxy].seen != update && proxies[proxy].body != NULL) {
+      if (tree) {
+        remove_from_tree(broad_phase, proxy);
+      }
+      proxies[proxy].bounds = far_away;
+      removed++;
+    }
+  }
+  return removed;
+}
+
+/** Whether a proxy's body was not seen by the last update */
+bool is_gone(broad_phase_t *broad_phase, size_t proxy) {
+  proxy_t *p = &broad_phase->proxies[proxy];
+  return p->body != NULL && p->seen != broad_phase->updates;
+}
+
+/**
+ * Forgets the pairs of the proxies whose bodies are gone, for when the tree
+ * broad phase drops them without finding the pairs again.
+ */
+void drop_gone_pairs(broad_phase_t *broad_phase) {
+  key_table_t *pairs = &broad_phase->pairs;
+  size_t i = 0;
+  while (i < pairs->capacity) {
+    uint64_t key = pairs->keys[i];
+    if (key != EMPTY_KEY &&
+        (is_gone(broad_phase, key >> 32) ||
+         is_gone(broad_phase, key & UINT32_MAX))) {
+      // removing shifts a later key back into this slot, so look again
+      key_table_remove(pairs, key);
+    } else {
+      i++;
+    }
+  }
+}
+
+/** Frees the proxies whose bodies are gone, for new bodies to reuse */
+void drop_proxies(broad_phase_t *broad_phase) {
+  proxy_t *proxies = broad_phase->proxies;
+  for (size_t proxy = 0; proxy < broad_phase->proxy_count; proxy++) {
+    if (is_gone(broad_phase, proxy)) {
+      key_table_remove(&broad_phase->body_proxies,
+                       body_key(proxies[proxy].body));
+      proxies[proxy].body = NULL;
+      broad_phase->free_proxies[broad_phase->free_count++] = proxy;
+    }
+  }
+}
+
+void broad_phase_update(broad_phase_t *broad_phase, list_t *bodies) {
+  size_t removed = sync_proxies(broad_phase, bodies);
+  if (broad_phase->kind == BROAD_PHASE_AABB_TREE) {
+    find_tree_pairs(broad_phase);
+  } else {
+    sweep_and_prune(broad_phase, removed);
+  }
+  if (removed > 0) {
+    drop_proxies(broad_phase);
+  }
+}
+
+void broad_phase_refresh(broad_phase_t *broad_phase, list_t *bodies) {
+  if (broad_phase->kind != BROAD_PHASE_AABB_TREE) {
+    // sorting the endpoints is what keeps the pairs, so it cannot be skipped
+    broad_phase_update(broad_phase, bodies);
+    return;
+  }
+  size_t removed = sync_proxies(broad_phase, bodies);
+  rebuild_static_tree(broad_phase);
+  if (removed > 0) {
+    drop_gone_pairs(broad_phase);
+    drop_proxies(broad_phase);
+  }
+}
+
+bool broad_phase_may_collide(broad_phase_t *broad_phase, body_t *body1,
+                             body_t *body2) {
+  size_t proxy1, proxy2;
+  if (!key_table_get(&broad_phase->body_proxies, body_key(body1), &proxy1) ||
+      !key_table_get(&broad_phase->body_proxies, body_key(body2), &proxy2)) {
+    return true;
+  }
+  return key_table_get(&broad_phase->pairs, pair_key(proxy1, proxy2), NULL);
+}
+
+size_t broad_phase_pair_count(broad_phase_t *broad_phase) {
+  return broad_phase->pairs.size;
+}
+
+void broad_phase_visit_pairs(broad_phase_t *broad_phase, pair_visitor_t visitor,
+                             void *aux) {
+  key_table_t *pairs = &broad_phase->pairs;
+  for (size_t i = 0; i < pairs->capacity; i++) {
+    uint64_t key = pairs->keys[i];
+    if (key != EMPTY_KEY) {
+      visitor(broad_phase->proxies[key >> 32].body,
+              broad_phase->proxies[key & UINT32_MAX].body, aux);
+    }
+  }
+}
+
+bool broad_phase_query(broad_phase_t *broad_phase, aabb_t box,
+                       body_visitor_t visitor, void *aux) {
+  if (broad_phase->kind == BROAD_PHASE_AABB_TREE) {
+    return aabb_tree_query(broad_phase->static_tree, box, visitor, aux) &&
+           aabb_tree_query(broad_phase->dynamic_tree, box, visitor, aux);
+  }
+  for (size_t proxy = 0; proxy < broad_phase->proxy_count; proxy++) {
+    proxy_t *p = &broad_phase->proxies[proxy];
+    if (p->body != NULL && aabb_overlap(p->bounds, box) &&
+        !visitor(p->body, aux)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+double broad_phase_raycast(broad_phase_t *broad_phase, vector_t origin,
+                           vector_t end, ray_visitor_t visitor, void *aux) {
+  if (broad_phase->kind == BROAD_PHASE_AABB_TREE) {
+    double max_fraction = aabb_tree_raycast(broad_phase->static_tree, origin,
+                                            end, 1, visitor, aux);
+    return aabb_tree_raycast(broad_phase->dynamic_tree, origin, end,
+                             max_fraction, visitor, aux);
+  }
+  double max_fraction = 1;
+  for (size_t proxy = 0; proxy < broad_phase->proxy_count; proxy++) {
+    proxy_t *p = &broad_phase->proxies[proxy];
+    if (max_fraction <= 0) {
+      break;
+    }
+    if (p->body != NULL &&
+        aabb_segment_overlap(p->bounds, origin, end, max_fraction)) {
+      max_fraction = visitor(p->body, max_fraction, aux);
+    }
+  }
+  return max_fraction;
+}
@@ -11,18 +11,25 @@
 
 double const LARGE_NUM = INFINITY;
 double const SMALL_NUM = -INFINITY;
+// How far from a box's sides another direction may be and still count as
+// along them, as the sine (or cosine) of the angle between them
+double const AXIS_TOLERANCE = 1e-9;
 
-void find_perp_axis(list_t *shape, list_t *axes) {
+const char *narrow_phase_name(narrow_phase_kind_t kind) {
+  static const char *names[NARROW_PHASE_KIND_COUNT] = {
+      "auto", "separating axis", "gjk"};
+  assert(kind < NARROW_PHASE_KIND_COUNT);
+  return names[kind];
+}
+
+void find_perp_axis(list_t *shape, vector_t *axes) {
   for (size_t i = 0; i < list_size(shape); i++) {
     vector_t *p1 = list_get(shape, i);
     vector_t *p2 = list_get(shape, (i + 1) % list_size(shape));
     vector_t edge = vec_subtract(*p1, *p2);
-    vector_t *axis = malloc(sizeof(vector_t));
     double magnitude = sqrt(edge.x * edge.x + edge.y * edge.y);
-    assert(axis != NULL);
-    axis->x = -edge.y / magnitude;
-    axis->y = edge.x / magnitude;
-    list_add(axes, axis);
+    axes[i].x = -edge.y / magnitude;
+    axes[i].y = edge.x / magnitude;
   }
 }
 
@@ -58,35 +65,429 @@ double calculate_overlap(vector_t p1, vector_t p2) {
   }
 }
 
-collision_info_t find_collision(list_t *shape1, list_t *shape2) {
+collision_info_t find_collision_cached(list_t *shape1, const vector_t *normals1,
+                                       list_t *shape2, const vector_t *normals2,
+                                       size_t *first_axis) {
   collision_info_t collision;
-  size_t num_points = list_size(shape1) + list_size(shape2);
-  list_t *axes = list_init(num_points, (free_func_t)free);
-  find_perp_axis(shape1, axes);
-  find_perp_axis(shape2, axes);
+  size_t count1 = list_size(shape1);
+  size_t num_points = count1 + list_size(shape2);
+  size_t first = first_axis != NULL && *first_axis < num_points ? *first_axis
+                                                                : 0;
 
   double least_overlap = INFINITY;
-  for (size_t i = 0; i < num_points; i++) {
-    vector_t *curr_axis = list_get(axes, i);
-    if (!test_intersecting_projections(get_projection(shape1, curr_axis),
-                                       get_projection(shape2, curr_axis))) {
-      list_free(shape1);
-      list_free(shape2);
-      list_free(axes);
+  for (size_t j = 0; j < num_points; j++) {
+    size_t i = (first + j) % num_points;
+    vector_t curr_axis = i < count1 ? normals1[i] : normals2[i - count1];
+    vector_t projection1 = get_projection(shape1, &curr_axis);
+    vector_t projection2 = get_projection(shape2, &curr_axis);
+    if (!test_intersecting_projections(projection1, projection2)) {
+      if (first_axis != NULL) {
+        *first_axis = i;
+      }
       collision.collided = false;
       return collision;
-    } else {
-      double overlap = calculate_overlap(get_projection(shape1, curr_axis),
-                                         get_projection(shape2, curr_axis));
-      if (overlap < least_overlap) {
-        least_overlap = overlap;
-        collision.axis = *curr_axis;
-      }
+    }
+    double overlap = calculate_overlap(projection1, projection2);
+    if (overlap < least_overlap) {
+      least_overlap = overlap;
+      collision.axis = curr_axis;
     }
   }
   collision.collided = true;
+  return collision;
+}
+
+bool is_separating_axis(list_t *shape1, const vector_t *normals1,
+                        list_t *shape2, const vector_t *normals2,
+                        size_t axis) {
+  size_t count1 = list_size(shape1);
+  if (axis >= count1 + list_size(shape2)) {
+    return false;
+  }
+  vector_t normal = axis < count1 ? normals1[axis] : normals2[axis - count1];
+  return !test_intersecting_projections(get_projection(shape1, &normal),
+                                        get_projection(shape2, &normal));
+}
+
+/**
+ * Tests the shapes for a collision along each of their edge normals,
+ * using axes as room for one axis per vertex
+ */
+collision_info_t find_collision_axes(list_t *shape1, list_t *shape2,
+                                     vector_t *axes) {
+  find_perp_axis(shape1, axes);
+  find_perp_axis(shape2, axes + list_size(shape1));
+  return find_collision_cached(shape1, axes, shape2, axes + list_size(shape1),
+                               NULL);
+}
+
+collision_info_t find_collision(list_t *shape1, list_t *shape2) {
+  size_t num_points = list_size(shape1) + list_size(shape2);
+  vector_t *axes = malloc(num_points * sizeof(vector_t));
+  assert(axes != NULL);
+  collision_info_t collision = find_collision_axes(shape1, shape2, axes);
   list_free(shape1);
   list_free(shape2);
-  list_free(axes);
+  free(axes);
+  return collision;
+}
+
+collision_info_t find_collision_arena(arena_t *arena, list_t *shape1,
+                                      list_t *shape2) {
+  arena_mark_t mark = arena_mark(arena);
+  size_t num_points = list_size(shape1) + list_size(shape2);
+  vector_t *axes = arena_alloc(arena, num_points * sizeof(vector_t));
+  collision_info_t collision = find_collision_axes(shape1, shape2, axes);
+  arena_rewind(arena, mark);
+  return collision;
+}
+
+/**
+ * Narrows the interval of a movement during which two shapes overlap to
+ * the part where their projections on one axis overlap.
+ * The axis is one of the shapes' edge normals, not necessarily a unit vector.
+ *
+ * @param speed how fast shape1 moves along the axis relative to shape2,
+ *   per unit of time
+ * @param impact the interval's start, and the axis it was last narrowed by
+ * @param end the interval's end
+ * @return whether any of the interval is left
+ */
+bool sweep_axis(list_t *shape1, list_t *shape2, vector_t axis, double speed,
+                impact_info_t *impact, double *end) {
+  vector_t projection1 = get_projection(shape1, &axis);
+  vector_t projection2 = get_projection(shape2, &axis);
+  if (speed == 0) {
+    return test_intersecting_projections(projection1, projection2);
+  }
+  // the times at which shape1's projection reaches either side of shape2's
+  double time1 = (projection2.x - projection1.y) / speed;
+  double time2 = (projection2.y - projection1.x) / speed;
+  double enter = fmin(time1, time2), exit = fmax(time1, time2);
+  if (enter > impact->time) {
+    impact->time = enter;
+    impact->axis = axis;
+  }
+  *end = fmin(*end, exit);
+  return impact->time <= *end;
+}
+
+impact_info_t find_time_of_impact(list_t *shape1, vector_t displacement1,
+                                  list_t *shape2, vector_t displacement2) {
+  vector_t relative = vec_subtract(displacement1, displacement2);
+  impact_info_t impact = {.collided = false, .time = -INFINITY};
+  double end = INFINITY;
+  list_t *shapes[] = {shape1, shape2};
+  for (size_t i = 0; i < 2; i++) {
+    list_t *shape = shapes[i];
+    size_t size = list_size(shape);
+    for (size_t j = 0; j < size; j++) {
+      vector_t *p1 = list_get(shape, j);
+      vector_t *p2 = list_get(shape, (j + 1) % size);
+      vector_t axis = {p1->y - p2->y, p2->x - p1->x};
+      if (!sweep_axis(shape1, shape2, axis, vec_dot(relative, axis), &impact,
+                      &end)) {
+        return impact;
+      }
+    }
+  }
+  // overlapping from the start (time below 0) is left to find_collision()
+  if (impact.time < 0 || impact.time > 1) {
+    return impact;
+  }
+  impact.collided = true;
+  double magnitude = sqrt(vec_dot(impact.axis, impact.axis));
+  impact.axis = vec_multiply(1 / magnitude, impact.axis);
+  // shape1 is moving towards shape2 along the axis where they meet
+  if (vec_dot(impact.axis, relative) < 0) {
+    impact.axis = vec_negate(impact.axis);
+  }
+  return impact;
+}
+
+/**
+ * Finds the closest points between two segments, from p1 to q1 and from p2
+ * to q2, as how far along each segment they are (see Ericson, Real-Time
+ * Collision Detection, section 5.1.9). Either segment may be a single point.
+ */
+void closest_segment_points(vector_t p1, vector_t q1, vector_t p2, vector_t q2,
+                            double *s, double *t) {
+  vector_t d1 = vec_subtract(q1, p1);
+  vector_t d2 = vec_subtract(q2, p2);
+  vector_t r = vec_subtract(p1, p2);
+  double a = vec_dot(d1, d1);
+  double e = vec_dot(d2, d2);
+  double f = vec_dot(d2, r);
+  if (a == 0 && e == 0) {
+    *s = 0;
+    *t = 0;
+    return;
+  }
+  if (a == 0) {
+    *s = 0;
+    *t = fmin(fmax(f / e, 0), 1);
+    return;
+  }
+  double c = vec_dot(d1, r);
+  if (e == 0) {
+    *t = 0;
+    *s = fmin(fmax(-c / a, 0), 1);
+    return;
+  }
+  double b = vec_dot(d1, d2);
+  double denominator = a * e - b * b;
+  // parallel segments have no single closest pair, so any one will do
+  *s = denominator != 0 ? fmin(fmax((b * f - c * e) / denominator, 0), 1) : 0;
+  *t = (b * *s + f) / e;
+  if (*t < 0) {
+    *t = 0;
+    *s = fmin(fmax(-c / a, 0), 1);
+  } else if (*t > 1) {
+    *t = 1;
+    *s = fmin(fmax((b - c) / a, 0), 1);
+  }
+}
+
+vector_t capsule_middle(capsule_t capsule) {
+  return vec_multiply(0.5, vec_add(capsule.start, capsule.end));
+}
+
+collision_info_t find_collision_capsules(capsule_t capsule1,
+                                         capsule_t capsule2) {
+  collision_info_t collision = {.collided = false};
+  double s, t;
+  closest_segment_points(capsule1.start, capsule1.end, capsule2.start,
+                         capsule2.end, &s, &t);
+  vector_t along1 = vec_subtract(capsule1.end, capsule1.start);
+  vector_t along2 = vec_subtract(capsule2.end, capsule2.start);
+  vector_t point1 = vec_add(capsule1.start, vec_multiply(s, along1));
+  vector_t point2 = vec_add(capsule2.start, vec_multiply(t, along2));
+  vector_t delta = vec_subtract(point2, point1);
+  double distance = sqrt(vec_dot(delta, delta));
+  if (distance > capsule1.radius + capsule2.radius) {
+    return collision;
+  }
+  collision.collided = true;
+  if (distance == 0) {
+    // the segments cross, so fall back on the direction between their middles
+    delta = vec_subtract(capsule_middle(capsule2), capsule_middle(capsule1));
+    distance = sqrt(vec_dot(delta, delta));
+    if (distance == 0) {
+      delta = (vector_t){1, 0};
+      distance = 1;
+    }
+  }
+  collision.axis = vec_multiply(1 / distance, delta);
   return collision;
-}
\ No newline at end of file
+}
+
+/**
+ * Tests a shape and a polygon for overlap along one unit axis, keeping the
+ * axis with the least overlap so far in collision, turned to point from the
+ * shape towards the polygon.
+ *
+ * @param projection the shape's projection on the axis
+ * @return whether the projections on the axis overlap
+ */
+bool test_polygon_axis(vector_t projection, list_t *polygon, vector_t axis,
+                       double *least_overlap, collision_info_t *collision) {
+  vector_t polygon_projection = get_projection(polygon, &axis);
+  if (!test_intersecting_projections(projection, polygon_projection)) {
+    return false;
+  }
+  double overlap = fmin(projection.y, polygon_projection.y) -
+                   fmax(projection.x, polygon_projection.x);
+  if (overlap < *least_overlap) {
+    *least_overlap = overlap;
+    bool forwards = projection.x + projection.y <=
+                    polygon_projection.x + polygon_projection.y;
+    collision->axis = forwards ? axis : vec_negate(axis);
+  }
+  return true;
+}
+
+/**
+ * Tests a capsule and a polygon for overlap along one axis
+ * (see test_polygon_axis()). Axes of length 0 separate nothing.
+ */
+bool capsule_polygon_axis(capsule_t capsule, list_t *polygon, vector_t axis,
+                          double *least_overlap, collision_info_t *collision) {
+  double magnitude = sqrt(vec_dot(axis, axis));
+  if (magnitude == 0) {
+    return true;
+  }
+  axis = vec_multiply(1 / magnitude, axis);
+  double start = vec_dot(axis, capsule.start);
+  double end = vec_dot(axis, capsule.end);
+  vector_t projection = {fmin(start, end) - capsule.radius,
+                         fmax(start, end) + capsule.radius};
+  return test_polygon_axis(projection, polygon, axis, least_overlap,
+                           collision);
+}
+
+/** Finds the vertex of a polygon nearest to a point */
+vector_t nearest_vertex(list_t *polygon, vector_t point) {
+  vector_t nearest = *(vector_t *)list_get(polygon, 0);
+  vector_t delta = vec_subtract(nearest, point);
+  double least_distance = vec_dot(delta, delta);
+  for (size_t i = 1; i < list_size(polygon); i++) {
+    vector_t *vertex = list_get(polygon, i);
+    delta = vec_subtract(*vertex, point);
+    double distance = vec_dot(delta, delta);
+    if (distance < least_distance) {
+      least_distance = distance;
+      nearest = *vertex;
+    }
+  }
+  return nearest;
+}
+
+collision_info_t find_collision_capsule_polygon(capsule_t capsule,
+                                                list_t *polygon) {
+  collision_info_t collision = {.collided = false};
+  double least_overlap = INFINITY;
+  size_t size = list_size(polygon);
+  for (size_t i = 0; i < size; i++) {
+    vector_t *p1 = list_get(polygon, i);
+    vector_t *p2 = list_get(polygon, (i + 1) % size);
+    vector_t axis = {p1->y - p2->y, p2->x - p1->x};
+    if (!capsule_polygon_axis(capsule, polygon, axis, &least_overlap,
+                              &collision)) {
+      return collision;
+    }
+  }
+  // The polygon and the capsule's segment grown by its radius can only be
+  // apart along the segment's normal, or where a vertex nearest one of the
+  // segment's ends meets that end's round cap
+  vector_t along = vec_subtract(capsule.end, capsule.start);
+  vector_t axes[] = {
+      {-along.y, along.x},
+      vec_subtract(nearest_vertex(polygon, capsule.start), capsule.start),
+      vec_subtract(nearest_vertex(polygon, capsule.end), capsule.end)};
+  // a circle's side is a zero axis, which is skipped, and its ends are the same
+  size_t count = vec_dot(along, along) == 0 ? 2 : 3;
+  for (size_t i = 0; i < count; i++) {
+    if (!capsule_polygon_axis(capsule, polygon, axes[i], &least_overlap,
+                              &collision)) {
+      return collision;
+    }
+  }
+  collision.collided = true;
+  return collision;
+}
+
+/** Gets the unit direction of a box's second side */
+vector_t box_side(obb_t box) { return (vector_t){-box.axis.y, box.axis.x}; }
+
+/** Gets how far a box reaches from its center along a unit axis */
+double box_reach(obb_t box, vector_t axis) {
+  return box.half_size.x * fabs(vec_dot(axis, box.axis)) +
+         box.half_size.y * fabs(vec_dot(axis, box_side(box)));
+}
+
+/**
+ * Returns whether a direction lies along one of a box's sides, so testing
+ * it would repeat a test along the box's own axes. The direction need not
+ * be a unit vector.
+ */
+bool along_box(obb_t box, vector_t direction) {
+  // |cross * dot| is |direction|^2 * |sin * cos| of the angle between them
+  double turn = vec_cross(box.axis, direction) * vec_dot(box.axis, direction);
+  return fabs(turn) <= AXIS_TOLERANCE * vec_dot(direction, direction);
+}
+
+/** Returns whether a box's sides run along the x- and y-axes */
+bool is_axis_aligned(obb_t box) {
+  return fabs(box.axis.x) <= AXIS_TOLERANCE ||
+         fabs(box.axis.y) <= AXIS_TOLERANCE;
+}
+
+/** Gets how far an axis-aligned box reaches from its center in x and y */
+vector_t aligned_reach(obb_t box) {
+  return fabs(box.axis.y) < fabs(box.axis.x)
+             ? box.half_size
+             : (vector_t){box.half_size.y, box.half_size.x};
+}
+
+collision_info_t find_collision_boxes(obb_t box1, obb_t box2) {
+  collision_info_t collision = {.collided = false};
+  vector_t between = vec_subtract(box2.center, box1.center);
+  if (is_axis_aligned(box1) && is_axis_aligned(box2)) {
+    // Two axis-aligned boxes only need their extents compared in x and y
+    vector_t reach1 = aligned_reach(box1), reach2 = aligned_reach(box2);
+    double overlap_x = reach1.x + reach2.x - fabs(between.x);
+    double overlap_y = reach1.y + reach2.y - fabs(between.y);
+    if (overlap_x < 0 || overlap_y < 0) {
+      return collision;
+    }
+    collision.collided = true;
+    collision.axis = overlap_x < overlap_y
+                         ? (vector_t){between.x < 0 ? -1 : 1, 0}
+                         : (vector_t){0, between.y < 0 ? -1 : 1};
+    return collision;
+  }
+
+  vector_t axes[] = {box1.axis, box_side(box1), box2.axis, box_side(box2)};
+  // boxes turned by a multiple of a right angle from each other share axes
+  size_t count = along_box(box1, box2.axis) ? 2 : 4;
+  double least_overlap = INFINITY;
+  for (size_t i = 0; i < count; i++) {
+    double distance = vec_dot(between, axes[i]);
+    double overlap =
+        box_reach(box1, axes[i]) + box_reach(box2, axes[i]) - fabs(distance);
+    if (overlap < 0) {
+      return collision;
+    }
+    if (overlap < least_overlap) {
+      least_overlap = overlap;
+      collision.axis = distance < 0 ? vec_negate(axes[i]) : axes[i];
+    }
+  }
+  collision.collided = true;
+  return collision;
+}
+
+/**
+ * Tests a box and a polygon for overlap along one unit axis
+ * (see test_polygon_axis()).
+ */
+bool box_polygon_axis(obb_t box, list_t *polygon, vector_t axis,
+                      double *least_overlap, collision_info_t *collision) {
+  double center = vec_dot(axis, box.center);
+  double reach = box_reach(box, axis);
+  return test_polygon_axis((vector_t){center - reach, center + reach},
+                           polygon, axis, least_overlap, collision);
+}
+
+collision_info_t find_collision_box_polygon(obb_t box, list_t *polygon,
+                                            const vector_t *normals) {
+  collision_info_t collision = {.collided = false};
+  double least_overlap = INFINITY;
+  if (!box_polygon_axis(box, polygon, box.axis, &least_overlap, &collision) ||
+      !box_polygon_axis(box, polygon, box_side(box), &least_overlap,
+                        &collision)) {
+    return collision;
+  }
+  size_t size = list_size(polygon);
+  for (size_t i = 0; i < size; i++) {
+    vector_t axis;
+    if (normals != NULL) {
+      axis = normals[i];
+    } else {
+      vector_t *p1 = list_get(polygon, i);
+      vector_t *p2 = list_get(polygon, (i + 1) % size);
+      axis = (vector_t){p1->y - p2->y, p2->x - p1->x};
+    }
+    if (along_box(box, axis)) {
+      continue;
+    }
+    if (normals == NULL) {
+      axis = vec_multiply(1 / sqrt(vec_dot(axis, axis)), axis);
+    }
+    if (!box_polygon_axis(box, polygon, axis, &least_overlap, &collision)) {
+      return collision;
+    }
+  }
+  collision.collided = true;
+  return collision;
+}
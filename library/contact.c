@@ -0,0 +1,307 @@
+#include "contact.h"
+#include <assert.h>
+#include <math.h>
+
+// How many passes the solver makes over every contact point
+const size_t CONTACT_ITERATIONS = 8;
+// The fraction of the overlap past the slop pushed out each tick
+const double BAUMGARTE = 0.2;
+// How far shapes may overlap without being pushed apart, so that resting
+// contacts stay touching rather than jittering in and out
+const double CONTACT_SLOP = 0.01;
+// Below this closing speed contacts do not bounce, so resting ones settle
+const double RESTITUTION_THRESHOLD = 1.0;
+// How much more squarely the second shape's edge must face the first for
+// it to be the reference edge, so the choice does not flicker between ties
+const double REFERENCE_TOLERANCE = 1e-3;
+// Clipped points this far outside the reference edge still count, since
+// shapes that just touch are found to overlap by nothing at all
+const double CONTACT_TOLERANCE = 1e-9;
+const size_t CONTACTS_SIZE = 16;
+
+/** One pair's contact, as the solver keeps it for a tick */
+typedef struct {
+  body_t *body1;
+  body_t *body2;
+  contact_manifold_t *manifold;
+  double elasticity;
+  /** The relative normal velocity each point aims for */
+  double targets[CONTACT_MAX_POINTS];
+} contact_constraint_t;
+
+struct contact_solver {
+  const allocator_t *allocator;
+  contact_constraint_t *constraints;
+  size_t count;
+  size_t capacity;
+};
+
+/** Whether a polygon's vertices go counterclockwise */
+bool is_counterclockwise(list_t *shape) {
+  double area = 0.0;
+  size_t n = list_size(shape);
+  for (size_t i = 0; i < n; i++) {
+    vector_t *v1 = list_get(shape, i);
+    vector_t *v2 = list_get(shape, (i + 1) % n);
+    area += vec_cross(*v1, *v2);
+  }
+  return area >= 0;
+}
+
+/**
+ * Finds the edge of a polygon whose outward normal is nearest a direction,
+ * and that normal. Edges with no length are skipped.
+ */
+size_t facing_edge(list_t *shape, vector_t direction, vector_t *normal) {
+  size_t n = list_size(shape);
+  double sign = is_counterclockwise(shape) ? 1.0 : -1.0;
+  size_t best = 0;
+  double best_dot = -INFINITY;
+  *normal = direction;
+  for (size_t i = 0; i < n; i++) {
+    vector_t *start = list_get(shape, i);
+    vector_t *end = list_get(shape, (i + 1) % n);
+    vector_t edge = vec_subtract(*end, *start);
+    double length = sqrt(vec_dot(edge, edge));
+    if (length == 0) {
+      continue;
+    }
+    vector_t outward = {sign * edge.y / length, -sign * edge.x / length};
+    double dot = vec_dot(outward, direction);
+    if (dot > best_dot) {
+      best_dot = dot;
+      best = i;
+      *normal = outward;
+    }
+  }
+  return best;
+}
+
+/** A point of the incident edge, and the vertex it came from */
+typedef struct {
+  vector_t point;
+  size_t vertex;
+} clip_point_t;
+
+/**
+ * Clips a segment to the side of a line where dot(normal, p) <= offset.
+ * Returns how many points are left.
+ */
+size_t clip_segment(clip_point_t *points, vector_t normal, double offset) {
+  double distance0 = vec_dot(normal, points[0].point) - offset;
+  double distance1 = vec_dot(normal, points[1].point) - offset;
+  if (distance0 > 0 && distance1 > 0) {
+    return 0;
+  }
+  if (distance0 > 0 || distance1 > 0) {
+    // The point outside moves to where the segment crosses the line
+    size_t outside = distance0 > 0 ? 0 : 1;
+    double t = distance0 / (distance0 - distance1);
+    points[outside].point =
+        vec_add(points[0].point,
+                vec_multiply(t, vec_subtract(points[1].point,
+                                             points[0].point)));
+  }
+  return 2;
+}
+
+contact_manifold_t contact_manifold_point(penetration_info_t penetration) {
+  contact_manifold_t manifold;
+  manifold.normal = penetration.axis;
+  manifold.count = 0;
+  if (penetration.collided) {
+    manifold.points[0].point =
+        vec_multiply(0.5, vec_add(penetration.point1, penetration.point2));
+    manifold.points[0].depth = penetration.depth;
+    manifold.points[0].feature = 0;
+    manifold.points[0].normal_impulse = 0.0;
+    manifold.count = 1;
+  }
+  return manifold;
+}
+
+contact_manifold_t find_contact_manifold(list_t *shape1, list_t *shape2,
+                                         penetration_info_t penetration) {
+  if (!penetration.collided) {
+    return contact_manifold_point(penetration);
+  }
+  vector_t normal1, normal2;
+  size_t edge1 = facing_edge(shape1, penetration.axis, &normal1);
+  size_t edge2 = facing_edge(shape2, vec_negate(penetration.axis), &normal2);
+  // The reference edge is the one facing the other shape most squarely
+  bool flip = vec_dot(normal2, vec_negate(penetration.axis)) >
+              vec_dot(normal1, penetration.axis) + REFERENCE_TOLERANCE;
+  list_t *reference = flip ? shape2 : shape1;
+  list_t *incident = flip ? shape1 : shape2;
+  size_t reference_edge = flip ? edge2 : edge1;
+  vector_t normal = flip ? normal2 : normal1;
+  vector_t incident_normal;
+  size_t incident_edge =
+      facing_edge(incident, vec_negate(normal), &incident_normal);
+
+  size_t reference_count = list_size(reference);
+  size_t incident_count = list_size(incident);
+  vector_t start = *(vector_t *)list_get(reference, reference_edge);
+  vector_t end =
+      *(vector_t *)list_get(reference, (reference_edge + 1) % reference_count);
+  vector_t tangent = vec_subtract(end, start);
+  tangent = vec_multiply(1 / sqrt(vec_dot(tangent, tangent)), tangent);
+  clip_point_t points[2];
+  for (size_t i = 0; i < 2; i++) {
+    points[i].vertex = (incident_edge + i) % incident_count;
+    points[i].point = *(vector_t *)list_get(incident, points[i].vertex);
+  }
+
+  contact_manifold_t manifold;
+  manifold.normal = flip ? vec_negate(normal) : normal;
+  manifold.count = 0;
+  // Keep the part of the incident edge beside the reference edge
+  if (clip_segment(points, vec_negate(tangent), -vec_dot(tangent, start)) ==
+          0 ||
+      clip_segment(points, tangent, vec_dot(tangent, end)) == 0) {
+    return contact_manifold_point(penetration);
+  }
+  for (size_t i = 0; i < 2; i++) {
+    double separation = vec_dot(normal, vec_subtract(points[i].point, start));
+    if (separation > CONTACT_TOLERANCE) {
+      continue;
+    }
+    contact_point_t *contact = &manifold.points[manifold.count++];
+    contact->point = vec_subtract(points[i].point,
+                                  vec_multiply(separation / 2, normal));
+    contact->depth = fmax(-separation, 0.0);
+    contact->feature =
+        (reference_edge * 2 + flip) * incident_count + points[i].vertex;
+    contact->normal_impulse = 0.0;
+  }
+  if (manifold.count == 0) {
+    return contact_manifold_point(penetration);
+  }
+  return manifold;
+}
+
+void contact_manifold_warm_start(contact_manifold_t *manifold,
+                                 const contact_manifold_t *old) {
+  for (size_t i = 0; i < manifold->count; i++) {
+    contact_point_t *point = &manifold->points[i];
+    point->normal_impulse = 0.0;
+    for (size_t j = 0; j < old->count; j++) {
+      if (old->points[j].feature == point->feature) {
+        point->normal_impulse = old->points[j].normal_impulse;
+        break;
+      }
+    }
+  }
+}
+
+contact_solver_t *contact_solver_init(const allocator_t *allocator) {
+  contact_solver_t *solver =
+      allocator_alloc(allocator, sizeof(contact_solver_t));
+  solver->allocator = allocator;
+  solver->capacity = CONTACTS_SIZE;
+  solver->constraints = allocator_alloc(
+      allocator, solver->capacity * sizeof(contact_constraint_t));
+  solver->count = 0;
+  return solver;
+}
+
+void contact_solver_free(contact_solver_t *solver) {
+  allocator_free(solver->allocator, solver->constraints);
+  allocator_free(solver->allocator, solver);
+}
+
+void contact_solver_add(contact_solver_t *solver, body_t *body1,
+                        body_t *body2, contact_manifold_t *manifold,
+                        double elasticity) {
+  if (solver->count == solver->capacity) {
+    size_t size = solver->capacity * sizeof(contact_constraint_t);
+    solver->constraints =
+        allocator_realloc(solver->allocator, solver->constraints, size,
+                          2 * size);
+    solver->capacity *= 2;
+  }
+  contact_constraint_t *constraint = &solver->constraints[solver->count++];
+  constraint->body1 = body1;
+  constraint->body2 = body2;
+  constraint->manifold = manifold;
+  constraint->elasticity = elasticity;
+}
+
+size_t contact_solver_count(contact_solver_t *solver) {
+  return solver->count;
+}
+
+double inverse_mass(body_t *body) { return 1.0 / body_get_mass(body); }
+
+/** How fast body2 moves away from body1 along a normal, after this tick */
+double normal_speed(contact_constraint_t *constraint, double dt) {
+  vector_t relative =
+      vec_subtract(body_next_velocity(constraint->body2, dt),
+                   body_next_velocity(constraint->body1, dt));
+  return vec_dot(relative, constraint->manifold->normal);
+}
+
+void apply_normal_impulse(contact_constraint_t *constraint, double impulse) {
+  vector_t push = vec_multiply(impulse, constraint->manifold->normal);
+  body_add_impulse(constraint->body1, vec_negate(push));
+  body_add_impulse(constraint->body2, push);
+}
+
+/**
+ * Finds the speed each of a contact's points aims for: bouncing back at
+ * the elasticity times the closing speed, or at least fast enough to push
+ * out a fraction of the overlap. Then applies last tick's impulses.
+ */
+void prepare_constraint(contact_constraint_t *constraint, double dt) {
+  contact_manifold_t *manifold = constraint->manifold;
+  double closing = normal_speed(constraint, dt);
+  double bounce = closing < -RESTITUTION_THRESHOLD
+                      ? -constraint->elasticity * closing
+                      : 0.0;
+  for (size_t i = 0; i < manifold->count; i++) {
+    contact_point_t *point = &manifold->points[i];
+    double bias = BAUMGARTE / dt * fmax(point->depth - CONTACT_SLOP, 0.0);
+    constraint->targets[i] = fmax(bounce, bias);
+  }
+  for (size_t i = 0; i < manifold->count; i++) {
+    apply_normal_impulse(constraint, manifold->points[i].normal_impulse);
+  }
+}
+
+void solve_constraint(contact_constraint_t *constraint, double dt) {
+  double mass = inverse_mass(constraint->body1) +
+                inverse_mass(constraint->body2);
+  contact_manifold_t *manifold = constraint->manifold;
+  for (size_t i = 0; i < manifold->count; i++) {
+    contact_point_t *point = &manifold->points[i];
+    double impulse =
+        (constraint->targets[i] - normal_speed(constraint, dt)) / mass;
+    // The total impulse can push but never pull
+    double total = fmax(point->normal_impulse + impulse, 0.0);
+    apply_normal_impulse(constraint, total - point->normal_impulse);
+    point->normal_impulse = total;
+  }
+}
+
+void contact_solver_solve(contact_solver_t *solver, double dt) {
+  size_t count = 0;
+  for (size_t i = 0; i < solver->count; i++) {
+    contact_constraint_t *constraint = &solver->constraints[i];
+    // Two bodies of infinite mass cannot push each other
+    if (inverse_mass(constraint->body1) + inverse_mass(constraint->body2) >
+        0) {
+      solver->constraints[count++] = *constraint;
+    }
+  }
+  solver->count = count;
+
+  for (size_t i = 0; i < solver->count; i++) {
+    prepare_constraint(&solver->constraints[i], dt);
+  }
+  for (size_t iteration = 0; iteration < CONTACT_ITERATIONS; iteration++) {
+    for (size_t i = 0; i < solver->count; i++) {
+      solve_constraint(&solver->constraints[i], dt);
+    }
+  }
+  solver->count = 0;
+}
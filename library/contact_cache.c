@@ -0,0 +1,139 @@
+#include "contact_cache.h"
+#include "key_table.h"
+#include <assert.h>
+
+const size_t CONTACT_TABLE_SIZE = 64;
+const size_t CONTACT_LIST_SIZE = 16;
+
+struct contact_cache {
+  const allocator_t *allocator;
+  /** Maps each pair's key (see contact_key()) to its index in contacts */
+  key_table_t keys;
+  /**
+   * Each contact is allocated on its own, so its manifold stays put for
+   * the solver while other contacts are added
+   */
+  contact_t **contacts;
+  size_t count;
+  size_t capacity;
+  size_t tick;
+  contact_listener_t listener;
+  void *aux;
+};
+
+/**
+ * The key of a pair of bodies, in either order. Only the low 32 bits of
+ * each id are kept, so pairs only clash after billions of bodies.
+ */
+uint64_t contact_key(body_t *body1, body_t *body2) {
+  uint64_t id1 = body_get_id(body1) & UINT32_MAX;
+  uint64_t id2 = body_get_id(body2) & UINT32_MAX;
+  uint64_t low = id1 < id2 ? id1 : id2;
+  uint64_t high = id1 < id2 ? id2 : id1;
+  return (low << 32) | high;
+}
+
+contact_cache_t *contact_cache_init(const allocator_t *allocator) {
+  contact_cache_t *cache = allocator_alloc(allocator, sizeof(contact_cache_t));
+  cache->allocator = allocator;
+  key_table_init(&cache->keys, CONTACT_TABLE_SIZE);
+  cache->capacity = CONTACT_LIST_SIZE;
+  cache->contacts =
+      allocator_alloc(allocator, cache->capacity * sizeof(contact_t *));
+  cache->count = 0;
+  cache->tick = 1;
+  cache->listener = NULL;
+  cache->aux = NULL;
+  return cache;
+}
+
+void contact_cache_free(contact_cache_t *cache) {
+  key_table_free(&cache->keys);
+  for (size_t i = 0; i < cache->count; i++) {
+    allocator_free(cache->allocator, cache->contacts[i]);
+  }
+  allocator_free(cache->allocator, cache->contacts);
+  allocator_free(cache->allocator, cache);
+}
+
+void contact_cache_set_listener(contact_cache_t *cache,
+                                contact_listener_t listener, void *aux) {
+  cache->listener = listener;
+  cache->aux = aux;
+}
+
+contact_t *contact_cache_touch(contact_cache_t *cache, body_t *body1,
+                               body_t *body2, contact_event_t *event) {
+  uint64_t key = contact_key(body1, body2);
+  size_t index;
+  contact_t *contact;
+  if (key_table_get(&cache->keys, key, &index)) {
+    contact = cache->contacts[index];
+  } else {
+    if (cache->count == cache->capacity) {
+      size_t size = cache->capacity * sizeof(contact_t *);
+      cache->contacts = allocator_realloc(cache->allocator, cache->contacts,
+                                          size, 2 * size);
+      cache->capacity *= 2;
+    }
+    contact = allocator_alloc(cache->allocator, sizeof(contact_t));
+    contact->body1 = body1;
+    contact->body2 = body2;
+    contact->manifold.count = 0;
+    contact->began = cache->tick;
+    // Not touched yet, so the listener hears that it began below
+    contact->touched = 0;
+    key_table_put(&cache->keys, key, cache->count);
+    cache->contacts[cache->count++] = contact;
+  }
+
+  *event = contact->began == cache->tick ? CONTACT_BEGIN : CONTACT_PERSIST;
+  if (contact->touched != cache->tick) {
+    contact->touched = cache->tick;
+    if (cache->listener != NULL) {
+      cache->listener(contact->body1, contact->body2, *event, cache->aux);
+    }
+  }
+  return contact;
+}
+
+contact_t *contact_cache_find(contact_cache_t *cache, body_t *body1,
+                              body_t *body2) {
+  size_t index;
+  if (!key_table_get(&cache->keys, contact_key(body1, body2), &index)) {
+    return NULL;
+  }
+  return cache->contacts[index];
+}
+
+size_t contact_cache_size(contact_cache_t *cache) { return cache->count; }
+
+size_t contact_cache_expire(contact_cache_t *cache) {
+  size_t ended = 0;
+  size_t i = 0;
+  while (i < cache->count) {
+    contact_t *contact = cache->contacts[i];
+    if (contact->touched == cache->tick && !body_is_removed(contact->body1) &&
+        !body_is_removed(contact->body2)) {
+      i++;
+      continue;
+    }
+    if (cache->listener != NULL) {
+      cache->listener(contact->body1, contact->body2, CONTACT_END,
+                      cache->aux);
+    }
+    key_table_remove(&cache->keys,
+                     contact_key(contact->body1, contact->body2));
+    allocator_free(cache->allocator, contact);
+    ended++;
+    // The last contact fills the gap, so this index is looked at again
+    cache->count--;
+    if (i < cache->count) {
+      contact_t *last = cache->contacts[cache->count];
+      cache->contacts[i] = last;
+      key_table_put(&cache->keys, contact_key(last->body1, last->body2), i);
+    }
+  }
+  cache->tick++;
+  return ended;
+}
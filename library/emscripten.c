@@ -1,24 +1,48 @@
+#include "alloc_track.h"
+#include "arena.h"
 #include "math.h"
+#include "profiler.h"
 #include "sdl_wrapper.h"
 #include "state.h"
 #include <stdio.h>
 #include <stdlib.h>
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
+#elif defined(ALLOC_TRACK)
+#include <signal.h>
+#endif
+
+#ifdef PROFILE
+/** The file the profiler's trace is written to at exit, if profiling */
+const char *profile_trace_path = NULL;
 #endif
 
 state_t *state;
 
 void loop() {
+  // Everything allocated from the frame arena last frame is released
+  frame_arena_reset();
+#ifdef ALLOC_TRACK
+  alloc_track_frame();
+#endif
+
   // If needed, generate a pointer to our initial state
   if (!state) {
     state = emscripten_init();
   }
 
+  PROFILE_BEGIN("frame");
   emscripten_main(state);
+  bool done = sdl_is_done(state);
+  PROFILE_END();
 
-  if (sdl_is_done(state)) { // Once our demo exits...
+  if (done) { // Once our demo exits...
     emscripten_free(state); // Free any state variables we've been using
+    frame_arena_free();
+#ifdef ALLOC_TRACK
+    // whatever is still live here was leaked
+    alloc_track_dump(stderr);
+#endif
 #ifdef __EMSCRIPTEN__ // Clean up emscripten environment (if we're using it)
     emscripten_cancel_main_loop();
     emscripten_force_exit(0);
@@ -29,7 +53,44 @@ void loop() {
   }
 }
 
+#if defined(ALLOC_TRACK) && !defined(__EMSCRIPTEN__)
+void request_alloc_dump(int signal) { alloc_track_request_dump(); }
+#endif
+
+#ifdef PROFILE
+/**
+ * Writes the profiler's trace. Registered with atexit() before sdl_init()
+ * registers the render thread's shutdown, so it runs after that thread is
+ * joined.
+ */
+void write_profile_trace(void) {
+  profile_enable(false);
+  FILE *out = fopen(profile_trace_path, "w");
+  if (out == NULL) {
+    perror(profile_trace_path);
+    return;
+  }
+  size_t events = profile_write_trace(out);
+  fclose(out);
+  fprintf(stderr, "wrote %zu profile events to %s\n", events,
+          profile_trace_path);
+}
+#endif
+
 int main() {
+#ifdef PROFILE
+  // 'PROFILE_TRACE=trace.json bin/game' records a trace of every frame
+  profile_trace_path = getenv("PROFILE_TRACE");
+  if (profile_trace_path != NULL) {
+    profile_enable(true);
+    PROFILE_THREAD("main");
+    atexit(write_profile_trace);
+  }
+#endif
+#if defined(ALLOC_TRACK) && !defined(__EMSCRIPTEN__)
+  // 'kill -USR1 <pid>' prints the allocations at the end of the next frame
+  signal(SIGUSR1, request_alloc_dump);
+#endif
 #ifdef __EMSCRIPTEN__
   // Set loop as the function emscripten calls to request a new frame
   emscripten_set_main_loop_arg(loop, NULL, 0, 1);
@@ -1,7 +1,10 @@
 #include "forces.h"
 #include "body.h"
 #include "collision.h"
+#include "contact.h"
+#include "gjk.h"
 #include "map.h"
+#include "profiler.h"
 #include "scene.h"
 #include <assert.h>
 #include <math.h>
@@ -9,18 +12,52 @@
 #include <stdlib.h>
 
 double MINIMUM_DISTANCE = 5.0;
+// With this many vertices between them, two shapes are tested faster by
+// GJK than by the separating-axis test (see the bench's gjk_* cases)
+const size_t GJK_MIN_VERTICES = 24;
 
 typedef struct store_force {
   list_t *bodies;
   double constant;
   collision_handler_t handler;
   void *aux;
-  bool just_collided;
+  /**
+   * For a collision, the axis that last separated the bodies, which is
+   * tested first next time (see find_collision_cached())
+   */
+  size_t separating_axis;
+  /** The record allocator of the scene the storage was made for */
+  const allocator_t *allocator;
+  /** The scene the force creator belongs to, which counts its collisions */
+  scene_t *scene;
 } store_force_t;
 
 void store_force_free(store_force_t *storage) {
   list_free(storage->bodies);
-  free(storage);
+  allocator_free(storage->allocator, storage);
+}
+
+/**
+ * Gets an empty storage for a new force creator, reusing one the scene kept
+ * from a removed force creator if it can
+ */
+store_force_t *store_force_init(scene_t *scene) {
+  store_force_t *storage = scene_reuse_aux(scene);
+  if (storage == NULL) {
+    const allocator_t *allocator = scene_get_record_allocator(scene);
+    storage = allocator_alloc(allocator, sizeof(store_force_t));
+    storage->allocator = allocator;
+    storage->scene = scene;
+    storage->bodies = list_init_with_allocator(2, NULL, allocator);
+  }
+  while (list_size(storage->bodies) > 0) {
+    list_remove(storage->bodies, list_size(storage->bodies) - 1);
+  }
+  storage->constant = 0.0;
+  storage->handler = NULL;
+  storage->aux = NULL;
+  storage->separating_axis = 0;
+  return storage;
 }
 
 vector_t calculate_unit_vector(vector_t body1, vector_t body2) {
@@ -60,17 +97,14 @@ void gravity_forcer(store_force_t *storage) {
 
 void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
                               body_t *body2) {
-  store_force_t *storage = malloc(sizeof(store_force_t));
-  assert(storage != NULL);
-  storage->bodies = list_init(2, NULL);
+  store_force_t *storage = store_force_init(scene);
   list_add(storage->bodies, body1);
   list_add(storage->bodies, body2);
   storage->constant = G;
 
   force_creator_t forcer = (force_creator_t)gravity_forcer;
 
-  scene_add_bodies_force_creator(scene, forcer, storage, storage->bodies,
-                                 (free_func_t)free);
+  scene_add_force(scene, FORCE_GRAVITY, forcer, storage, storage->bodies);
 }
 
 void spring_forcer(store_force_t *storage) {
@@ -95,16 +129,14 @@ void spring_forcer(store_force_t *storage) {
 }
 
 void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
-  store_force_t *storage = malloc(sizeof(store_force_t));
-  storage->bodies = list_init(2, NULL);
+  store_force_t *storage = store_force_init(scene);
   list_add(storage->bodies, body1);
   list_add(storage->bodies, body2);
   storage->constant = k;
 
   force_creator_t forcer = (force_creator_t)spring_forcer;
 
-  scene_add_bodies_force_creator(scene, forcer, storage, storage->bodies,
-                                 (free_func_t)free);
+  scene_add_force(scene, FORCE_SPRING, forcer, storage, storage->bodies);
 }
 
 void drag_forcer(store_force_t *storage) {
@@ -116,15 +148,13 @@ void drag_forcer(store_force_t *storage) {
 }
 
 void create_drag(scene_t *scene, double gamma, body_t *body) {
-  store_force_t *storage = malloc(sizeof(store_force_t));
-  storage->bodies = list_init(1, NULL);
+  store_force_t *storage = store_force_init(scene);
   list_add(storage->bodies, body);
   storage->constant = gamma;
 
   force_creator_t forcer = (force_creator_t)drag_forcer;
 
-  scene_add_bodies_force_creator(scene, forcer, storage, storage->bodies,
-                                 (free_func_t)free);
+  scene_add_force(scene, FORCE_DRAG, forcer, storage, storage->bodies);
 }
 
 void destructive_collision_handler(body_t *body1, body_t *body2, vector_t axis,
@@ -163,35 +193,189 @@ void create_partial_destructive_collision(scene_t *scene, body_t *body1,
                    NULL, (free_func_t)free);
 }
 
-void impulse_handler(body_t *body1, body_t *body2, vector_t axis, void *aux) {
-  double constant = *(double *)aux;
-  double mass1 = body_get_mass(body1);
-  double mass2 = body_get_mass(body2);
+/** What happens when two bodies start touching, besides pushing apart */
+void physics_begin(body_t *body1, body_t *body2) {
+  if (*(size_t *)body_get_info(body1) == TRIANGLE_OBSTACLE_TYPE) {
+    body_set_health(body2, body_get_health(body2) - TRIANGLE_DAMAGE);
+  }
+  if (*(size_t *)body_get_info(body2) == TRIANGLE_OBSTACLE_TYPE) {
+    body_set_health(body1, body_get_health(body1) - TRIANGLE_DAMAGE);
+  }
+}
 
-  double u_a = vec_dot(body_get_velocity(body1), axis);
-  double u_b = vec_dot(body_get_velocity(body2), axis);
+/**
+ * Whether a narrow phase tests shapes with this many vertices between them
+ * with GJK rather than the separating-axis test
+ */
+bool use_gjk(narrow_phase_kind_t kind, size_t vertices) {
+  return kind == NARROW_PHASE_GJK ||
+         (kind == NARROW_PHASE_AUTO && vertices >= GJK_MIN_VERTICES);
+}
 
-  double reduced_mass;
-  if (mass1 == INFINITY && mass2 != INFINITY) {
-    reduced_mass = mass2;
-  } else if (mass2 == INFINITY && mass1 != INFINITY) {
-    reduced_mass = mass1;
-  } else {
-    reduced_mass = ((mass1 * mass2) / (mass1 + mass2));
+/**
+ * Finds which of two polygons' edge normals, numbered as in
+ * find_collision_cached(), lies nearest a direction
+ */
+size_t nearest_normal(const vector_t *normals1, size_t count1,
+                      const vector_t *normals2, size_t count2,
+                      vector_t direction) {
+  size_t nearest = 0;
+  double best = -1.0;
+  for (size_t i = 0; i < count1 + count2; i++) {
+    vector_t normal = i < count1 ? normals1[i] : normals2[i - count1];
+    double along = fabs(vec_dot(normal, direction));
+    if (along > best) {
+      best = along;
+      nearest = i;
+    }
   }
+  return nearest;
+}
 
-  double impulse_magnitude = reduced_mass * (1 + constant) * (u_b - u_a);
-  vector_t impulse = vec_multiply(impulse_magnitude, axis);
+/**
+ * Tests two polygons for find_body_collision(). GJK is only run for pairs
+ * that the axis which last separated them no longer does: a pair that
+ * stays apart is ruled out by that one axis faster than by GJK, so when
+ * GJK finds a pair apart, the edge normal nearest its axis is kept instead.
+ */
+collision_info_t find_polygon_collision(body_t *body1, list_t *shape1,
+                                        body_t *body2, list_t *shape2,
+                                        narrow_phase_kind_t kind,
+                                        size_t *first_axis) {
+  const vector_t *normals1 = body_get_normals(body1);
+  const vector_t *normals2 = body_get_normals(body2);
+  size_t count1 = list_size(shape1);
+  size_t count2 = list_size(shape2);
+  if (!use_gjk(kind, count1 + count2)) {
+    return find_collision_cached(shape1, normals1, shape2, normals2,
+                                 first_axis);
+  }
+  if (first_axis != NULL &&
+      is_separating_axis(shape1, normals1, shape2, normals2, *first_axis)) {
+    return (collision_info_t){false, VEC_ZERO};
+  }
+  penetration_info_t penetration = find_penetration(shape1, shape2);
+  if (!penetration.collided && first_axis != NULL) {
+    *first_axis =
+        nearest_normal(normals1, count1, normals2, count2, penetration.axis);
+  }
+  return (collision_info_t){penetration.collided, penetration.axis};
+}
 
-  body_add_impulse(body1, impulse);
-  body_add_impulse(body2, vec_negate(impulse));
+/** Tests a capsule and a polygon by GJK, for find_body_collision() */
+collision_info_t find_capsule_penetration(body_t *capsule, list_t *polygon) {
+  penetration_info_t penetration =
+      find_penetration_capsule(body_get_capsule(capsule), polygon);
+  return (collision_info_t){penetration.collided, penetration.axis};
+}
 
-  if (*(size_t *)body_get_info(body1) == TRIANGLE_OBSTACLE_TYPE) {
-    body_set_health(body2, body_get_health(body2) - TRIANGLE_DAMAGE);
+collision_info_t find_body_collision(body_t *body1, body_t *body2,
+                                     narrow_phase_kind_t kind,
+                                     size_t *first_axis) {
+  collider_kind_t kind1 = body_get_collider(body1);
+  collider_kind_t kind2 = body_get_collider(body2);
+  bool round1 = kind1 == COLLIDER_CIRCLE || kind1 == COLLIDER_CAPSULE;
+  bool round2 = kind2 == COLLIDER_CIRCLE || kind2 == COLLIDER_CAPSULE;
+  if (round1 && round2) {
+    return find_collision_capsules(body_get_capsule(body1),
+                                   body_get_capsule(body2));
   }
-  if (*(size_t *)body_get_info(body2) == TRIANGLE_OBSTACLE_TYPE) {
-    body_set_health(body1, body_get_health(body1) - TRIANGLE_DAMAGE);
+  if (kind1 == COLLIDER_BOX && kind2 == COLLIDER_BOX) {
+    return find_collision_boxes(body_get_box(body1), body_get_box(body2));
+  }
+  // The shape copies are only needed for this test, so they are given back
+  // to the frame arena straight away
+  arena_t *arena = frame_arena();
+  arena_mark_t mark = arena_mark(arena);
+  list_t *shape1 = round1 ? NULL : body_get_shape_arena(body1, arena);
+  list_t *shape2 = round2 ? NULL : body_get_shape_arena(body2, arena);
+  // A capsule's segment has two ends
+  size_t vertices = (round1 ? 2 : list_size(shape1)) +
+                    (round2 ? 2 : list_size(shape2));
+  collision_info_t collision;
+  bool gjk = use_gjk(kind, vertices);
+  if (round1) {
+    collision = gjk ? find_capsule_penetration(body1, shape2)
+                    : find_collision_capsule_polygon(body_get_capsule(body1),
+                                                     shape2);
+  } else if (round2) {
+    collision = gjk ? find_capsule_penetration(body2, shape1)
+                    : find_collision_capsule_polygon(body_get_capsule(body2),
+                                                     shape1);
+    collision.axis = vec_negate(collision.axis);
+  } else if (kind1 == COLLIDER_BOX && !gjk) {
+    collision = find_collision_box_polygon(body_get_box(body1), shape2,
+                                           body_get_normals(body2));
+  } else if (kind2 == COLLIDER_BOX && !gjk) {
+    collision = find_collision_box_polygon(body_get_box(body2), shape1,
+                                           body_get_normals(body1));
+    collision.axis = vec_negate(collision.axis);
+  } else {
+    collision = find_polygon_collision(body1, shape1, body2, shape2, kind,
+                                       first_axis);
   }
+  arena_rewind(arena, mark);
+  return collision;
+}
+
+contact_manifold_t find_body_manifold(body_t *body1, body_t *body2) {
+  collider_kind_t kind1 = body_get_collider(body1);
+  collider_kind_t kind2 = body_get_collider(body2);
+  bool round1 = kind1 == COLLIDER_CIRCLE || kind1 == COLLIDER_CAPSULE;
+  bool round2 = kind2 == COLLIDER_CIRCLE || kind2 == COLLIDER_CAPSULE;
+  if (round1 && round2) {
+    return contact_manifold_point(find_penetration_capsules(
+        body_get_capsule(body1), body_get_capsule(body2)));
+  }
+  arena_t *arena = frame_arena();
+  arena_mark_t mark = arena_mark(arena);
+  list_t *shape1 = round1 ? NULL : body_get_shape_arena(body1, arena);
+  list_t *shape2 = round2 ? NULL : body_get_shape_arena(body2, arena);
+  contact_manifold_t manifold;
+  if (round1) {
+    manifold = contact_manifold_point(
+        find_penetration_capsule(body_get_capsule(body1), shape2));
+  } else if (round2) {
+    penetration_info_t penetration =
+        find_penetration_capsule(body_get_capsule(body2), shape1);
+    penetration.axis = vec_negate(penetration.axis);
+    manifold = contact_manifold_point(penetration);
+  } else {
+    manifold = find_contact_manifold(shape1, shape2,
+                                     find_penetration(shape1, shape2));
+  }
+  arena_rewind(arena, mark);
+  return manifold;
+}
+
+impact_info_t find_body_time_of_impact(body_t *body1, vector_t displacement1,
+                                       body_t *body2, vector_t displacement2) {
+  collider_kind_t kind1 = body_get_collider(body1);
+  collider_kind_t kind2 = body_get_collider(body2);
+  bool round1 = kind1 == COLLIDER_CIRCLE || kind1 == COLLIDER_CAPSULE;
+  bool round2 = kind2 == COLLIDER_CIRCLE || kind2 == COLLIDER_CAPSULE;
+  if (round1 && round2) {
+    return find_time_of_impact_capsules(body_get_capsule(body1),
+                                        displacement1, body_get_capsule(body2),
+                                        displacement2);
+  }
+  arena_t *arena = frame_arena();
+  arena_mark_t mark = arena_mark(arena);
+  list_t *shape1 = round1 ? NULL : body_get_shape_arena(body1, arena);
+  list_t *shape2 = round2 ? NULL : body_get_shape_arena(body2, arena);
+  impact_info_t impact;
+  if (round1) {
+    impact = find_time_of_impact_capsule(body_get_capsule(body1),
+                                         displacement1, shape2, displacement2);
+  } else if (round2) {
+    impact = find_time_of_impact_capsule(body_get_capsule(body2),
+                                         displacement2, shape1, displacement1);
+    impact.axis = vec_negate(impact.axis);
+  } else {
+    impact = find_time_of_impact(shape1, displacement1, shape2, displacement2);
+  }
+  arena_rewind(arena, mark);
+  return impact;
 }
 
 void custom_forcer(store_force_t *storage) {
@@ -199,24 +383,28 @@ void custom_forcer(store_force_t *storage) {
   body_t *body1 = list_get(bodies, 0);
   body_t *body2 = list_get(bodies, 1);
 
-  // if (storage->just_collided) {
-  //   storage->just_collided = false;
-  //   return;
-  // }
+  if (!scene_may_collide(storage->scene, body1, body2)) {
+    return;
+  }
 
+  PROFILE_BEGIN("collision");
   collision_info_t collision_info =
-      find_collision(body_get_shape(body1), body_get_shape(body2));
+      find_body_collision(body1, body2, scene_get_narrow_phase(storage->scene),
+                          &storage->separating_axis);
+  PROFILE_END();
+  scene_count_collision_test(storage->scene, collision_info.collided);
 
   if (collision_info.collided == false) {
-    storage->just_collided = false;
     return;
   }
   body_set_just_collided(body1, true);
   body_set_just_collided(body2, true);
-  if (storage->just_collided) {
+  // The handler only runs when the bodies start touching
+  contact_event_t event;
+  scene_touch_contact(storage->scene, body1, body2, &event);
+  if (event != CONTACT_BEGIN) {
     return;
   }
-  storage->just_collided = true;
 
   collision_handler_t handler = storage->handler;
   void *aux = storage->aux;
@@ -224,19 +412,53 @@ void custom_forcer(store_force_t *storage) {
   handler(body1, body2, collision_info.axis, aux);
 }
 
-void create_physics_collision(scene_t *scene, double elasticity, body_t *body1,
-                              body_t *body2) {
-  double *constant = malloc(sizeof(double));
-  *constant = elasticity;
-  create_collision(scene, body1, body2, impulse_handler, constant,
-                   (free_func_t)free);
+/**
+ * Finds where two bodies touch, and adds the contact to the scene's solver,
+ * starting from the impulses of the scene's contact for the bodies
+ */
+void physics_forcer(store_force_t *storage) {
+  body_t *body1 = list_get(storage->bodies, 0);
+  body_t *body2 = list_get(storage->bodies, 1);
+  if (!scene_may_collide(storage->scene, body1, body2)) {
+    return;
+  }
+
+  PROFILE_BEGIN("collision");
+  collision_info_t collision =
+      find_body_collision(body1, body2, scene_get_narrow_phase(storage->scene),
+                          &storage->separating_axis);
+  contact_manifold_t manifold = {VEC_ZERO, 0};
+  if (collision.collided) {
+    manifold = find_body_manifold(body1, body2);
+  }
+  PROFILE_END();
+  scene_count_collision_test(storage->scene, collision.collided);
+
+  if (manifold.count == 0) {
+    return;
+  }
+  body_set_just_collided(body1, true);
+  body_set_just_collided(body2, true);
+  contact_event_t event;
+  contact_t *contact =
+      scene_touch_contact(storage->scene, body1, body2, &event);
+  if (event == CONTACT_BEGIN) {
+    physics_begin(body1, body2);
+  }
+  // The contact keeps the first order it saw the bodies in
+  if (contact->body1 != body1) {
+    manifold.normal = vec_negate(manifold.normal);
+  }
+  contact_manifold_warm_start(&manifold, &contact->manifold);
+  contact->manifold = manifold;
+  scene_add_contact(storage->scene, contact->body1, contact->body2,
+                    &contact->manifold, storage->constant);
 }
 
-void create_collision(scene_t *scene, body_t *body1, body_t *body2,
-                      collision_handler_t handler, void *aux,
-                      free_func_t freer) {
-  store_force_t *storage = malloc(sizeof(store_force_t));
-  storage->bodies = list_init(2, NULL);
+/** Adds a collision force creator and returns its storage */
+store_force_t *add_collision(scene_t *scene, body_t *body1, body_t *body2,
+                             collision_handler_t handler, void *aux) {
+  store_force_t *storage = store_force_init(scene);
   list_add(storage->bodies, body1);
   list_add(storage->bodies, body2);
   storage->aux = aux;
@@ -244,6 +466,23 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2,
 
   force_creator_t forcer = (force_creator_t)custom_forcer;
 
-  scene_add_bodies_force_creator(scene, forcer, storage, storage->bodies,
-                                 (free_func_t)free);
+  scene_add_force(scene, FORCE_COLLISION, forcer, storage, storage->bodies);
+  return storage;
+}
+
+void create_physics_collision(scene_t *scene, double elasticity, body_t *body1,
+                              body_t *body2) {
+  store_force_t *storage = store_force_init(scene);
+  list_add(storage->bodies, body1);
+  list_add(storage->bodies, body2);
+  // the elasticity lives in the storage, so it is recycled along with it
+  storage->constant = elasticity;
+  scene_add_force(scene, FORCE_COLLISION, (force_creator_t)physics_forcer,
+                  storage, storage->bodies);
+}
+
+void create_collision(scene_t *scene, body_t *body1, body_t *body2,
+                      collision_handler_t handler, void *aux,
+                      free_func_t freer) {
+  add_collision(scene, body1, body2, handler, aux);
 }
\ No newline at end of file
@@ -0,0 +1,483 @@
+#include "gjk.h"
+#include "arena.h"
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+
+// How many support points GJK may add before settling for its best guess
+const size_t GJK_MAX_ITERATIONS = 64;
+// GJK stops when a new support point brings the simplex less than this
+// fraction of its distance closer to the origin
+const double GJK_TOLERANCE = 1e-9;
+// Simplices closer to the origin than this are taken to touch it
+const double GJK_EPSILON = 1e-12;
+// EPA stops when the nearest edge is within this fraction of the support
+// point beyond it
+const double EPA_TOLERANCE = 1e-9;
+// A swept capsule is taken to touch what it is swept against this close
+const double TOI_TOLERANCE = 1e-6;
+
+/**
+ * A convex shape GJK can find support points on: a polygon, or the segment
+ * (or single point) at the core of a capsule.
+ */
+typedef struct {
+  list_t *polygon;
+  vector_t ends[2];
+  size_t count;
+} hull_t;
+
+/** A point of the Minkowski difference, and the points it came from */
+typedef struct {
+  /** point1 - point2 */
+  vector_t w;
+  vector_t point1;
+  vector_t point2;
+  /** The point's share of the simplex's closest point to the origin */
+  double weight;
+} simplex_vertex_t;
+
+typedef struct {
+  simplex_vertex_t vertices[3];
+  size_t count;
+} simplex_t;
+
+hull_t polygon_hull(list_t *polygon) {
+  return (hull_t){polygon, {VEC_ZERO, VEC_ZERO}, list_size(polygon)};
+}
+
+hull_t capsule_hull(capsule_t capsule) {
+  bool circle =
+      capsule.start.x == capsule.end.x && capsule.start.y == capsule.end.y;
+  return (hull_t){NULL, {capsule.start, capsule.end}, circle ? 1 : 2};
+}
+
+/** Finds the hull's furthest point in a direction */
+vector_t hull_support(hull_t *hull, vector_t direction) {
+  vector_t best = VEC_ZERO;
+  double best_dot = -INFINITY;
+  for (size_t i = 0; i < hull->count; i++) {
+    vector_t point =
+        hull->polygon != NULL ? *(vector_t *)list_get(hull->polygon, i)
+                              : hull->ends[i];
+    double dot = vec_dot(point, direction);
+    if (dot > best_dot) {
+      best_dot = dot;
+      best = point;
+    }
+  }
+  return best;
+}
+
+/** Finds the Minkowski difference's furthest point in a direction */
+simplex_vertex_t support(hull_t *hull1, hull_t *hull2, vector_t direction) {
+  simplex_vertex_t vertex;
+  vertex.point1 = hull_support(hull1, direction);
+  vertex.point2 = hull_support(hull2, vec_negate(direction));
+  vertex.w = vec_subtract(vertex.point1, vertex.point2);
+  vertex.weight = 1.0;
+  return vertex;
+}
+
+/** Reduces a segment simplex to the feature nearest the origin */
+void solve_segment(simplex_t *simplex) {
+  simplex_vertex_t *v = simplex->vertices;
+  vector_t edge = vec_subtract(v[1].w, v[0].w);
+  double weight0 = vec_dot(v[1].w, edge);
+  double weight1 = -vec_dot(v[0].w, edge);
+  if (weight1 <= 0) {
+    v[0].weight = 1.0;
+    simplex->count = 1;
+  } else if (weight0 <= 0) {
+    v[0] = v[1];
+    v[0].weight = 1.0;
+    simplex->count = 1;
+  } else {
+    v[0].weight = weight0 / (weight0 + weight1);
+    v[1].weight = weight1 / (weight0 + weight1);
+  }
+}
+
+/** Sets a simplex to one of its edges, with unnormalized weights */
+void keep_edge(simplex_t *simplex, simplex_vertex_t a, double weight_a,
+               simplex_vertex_t b, double weight_b) {
+  simplex->vertices[0] = a;
+  simplex->vertices[0].weight = weight_a / (weight_a + weight_b);
+  simplex->vertices[1] = b;
+  simplex->vertices[1].weight = weight_b / (weight_a + weight_b);
+  simplex->count = 2;
+}
+
+/** Sets a simplex to one of its vertices */
+void keep_vertex(simplex_t *simplex, simplex_vertex_t a) {
+  simplex->vertices[0] = a;
+  simplex->vertices[0].weight = 1.0;
+  simplex->count = 1;
+}
+
+/**
+ * Reduces a triangle simplex to the feature nearest the origin, by finding
+ * which of its Voronoi regions the origin is in. The weights of each edge
+ * are the origin's barycentric coordinates on it, and the weights of the
+ * triangle are the signed areas of the triangles the origin makes with
+ * each edge (see Ericson, Real-Time Collision Detection, 5.1.5).
+ */
+void solve_triangle(simplex_t *simplex) {
+  simplex_vertex_t a = simplex->vertices[0];
+  simplex_vertex_t b = simplex->vertices[1];
+  simplex_vertex_t c = simplex->vertices[2];
+
+  vector_t ab = vec_subtract(b.w, a.w);
+  double ab_a = vec_dot(b.w, ab);
+  double ab_b = -vec_dot(a.w, ab);
+  vector_t ac = vec_subtract(c.w, a.w);
+  double ac_a = vec_dot(c.w, ac);
+  double ac_c = -vec_dot(a.w, ac);
+  vector_t bc = vec_subtract(c.w, b.w);
+  double bc_b = vec_dot(c.w, bc);
+  double bc_c = -vec_dot(b.w, bc);
+
+  double area = vec_cross(ab, ac);
+  double abc_a = area * vec_cross(b.w, c.w);
+  double abc_b = area * vec_cross(c.w, a.w);
+  double abc_c = area * vec_cross(a.w, b.w);
+
+  if (ab_b <= 0 && ac_c <= 0) {
+    keep_vertex(simplex, a);
+  } else if (ab_a > 0 && ab_b > 0 && abc_c <= 0) {
+    keep_edge(simplex, a, ab_a, b, ab_b);
+  } else if (ac_a > 0 && ac_c > 0 && abc_b <= 0) {
+    keep_edge(simplex, a, ac_a, c, ac_c);
+  } else if (ab_a <= 0 && bc_c <= 0) {
+    keep_vertex(simplex, b);
+  } else if (ac_a <= 0 && bc_b <= 0) {
+    keep_vertex(simplex, c);
+  } else if (bc_b > 0 && bc_c > 0 && abc_a <= 0) {
+    keep_edge(simplex, b, bc_b, c, bc_c);
+  } else {
+    double total = abc_a + abc_b + abc_c;
+    simplex->vertices[0].weight = abc_a / total;
+    simplex->vertices[1].weight = abc_b / total;
+    simplex->vertices[2].weight = abc_c / total;
+  }
+}
+
+/** Finds the simplex's point nearest the origin, and the shapes' points */
+vector_t simplex_closest(simplex_t *simplex, vector_t *point1,
+                         vector_t *point2) {
+  vector_t closest = VEC_ZERO;
+  *point1 = VEC_ZERO;
+  *point2 = VEC_ZERO;
+  for (size_t i = 0; i < simplex->count; i++) {
+    simplex_vertex_t *v = &simplex->vertices[i];
+    closest = vec_add(closest, vec_multiply(v->weight, v->w));
+    *point1 = vec_add(*point1, vec_multiply(v->weight, v->point1));
+    *point2 = vec_add(*point2, vec_multiply(v->weight, v->point2));
+  }
+  return closest;
+}
+
+bool same_point(vector_t point1, vector_t point2) {
+  return point1.x == point2.x && point1.y == point2.y;
+}
+
+bool simplex_has(simplex_vertex_t *vertices, size_t count, vector_t w) {
+  for (size_t i = 0; i < count; i++) {
+    if (same_point(vertices[i].w, w)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Runs GJK on two hulls, leaving the simplex nearest the origin.
+ * Returns whether the simplex reached the origin, i.e. the hulls overlap.
+ */
+bool gjk(hull_t *hull1, hull_t *hull2, simplex_t *simplex) {
+  simplex->vertices[0] = support(hull1, hull2, (vector_t){1, 0});
+  simplex->count = 1;
+  for (size_t i = 0; i < GJK_MAX_ITERATIONS; i++) {
+    simplex_vertex_t previous[3];
+    size_t previous_count = simplex->count;
+    for (size_t j = 0; j < previous_count; j++) {
+      previous[j] = simplex->vertices[j];
+    }
+
+    if (simplex->count == 2) {
+      solve_segment(simplex);
+    } else if (simplex->count == 3) {
+      solve_triangle(simplex);
+    }
+    if (simplex->count == 3) {
+      return true;
+    }
+    vector_t point1, point2;
+    vector_t closest = simplex_closest(simplex, &point1, &point2);
+    double distance_squared = vec_dot(closest, closest);
+    if (distance_squared <= GJK_EPSILON * GJK_EPSILON) {
+      return true;
+    }
+
+    simplex_vertex_t next = support(hull1, hull2, vec_negate(closest));
+    // A point already tried, or one barely closer than the simplex,
+    // means the simplex is as near as it gets
+    if (simplex_has(previous, previous_count, next.w) ||
+        distance_squared - vec_dot(next.w, closest) <=
+            GJK_TOLERANCE * distance_squared) {
+      return false;
+    }
+    simplex->vertices[simplex->count++] = next;
+  }
+  // Out of iterations, the last point added was never solved for, so the
+  // simplex before it is the nearest
+  simplex->count--;
+  return false;
+}
+
+/**
+ * Grows a simplex that touches the origin without surrounding it into a
+ * triangle, by adding support points across it. Returns false if the
+ * Minkowski difference is too thin to make one.
+ */
+bool fill_simplex(hull_t *hull1, hull_t *hull2, simplex_t *simplex) {
+  if (simplex->count == 1) {
+    simplex_vertex_t next = support(hull1, hull2, (vector_t){-1, 0});
+    if (same_point(next.w, simplex->vertices[0].w)) {
+      next = support(hull1, hull2, (vector_t){0, 1});
+    }
+    if (same_point(next.w, simplex->vertices[0].w)) {
+      return false;
+    }
+    simplex->vertices[simplex->count++] = next;
+  }
+  if (simplex->count == 2) {
+    vector_t edge =
+        vec_subtract(simplex->vertices[1].w, simplex->vertices[0].w);
+    vector_t across = {-edge.y, edge.x};
+    simplex_vertex_t next = support(hull1, hull2, across);
+    if (vec_dot(vec_subtract(next.w, simplex->vertices[0].w), across) <=
+        GJK_EPSILON) {
+      next = support(hull1, hull2, vec_negate(across));
+    }
+    if (fabs(vec_cross(edge, vec_subtract(next.w, simplex->vertices[0].w))) <=
+        GJK_EPSILON) {
+      return false;
+    }
+    simplex->vertices[simplex->count++] = next;
+  }
+  return true;
+}
+
+/** The polygon EPA grows inside the Minkowski difference */
+typedef struct {
+  simplex_vertex_t *vertices;
+  size_t count;
+  size_t capacity;
+} polytope_t;
+
+/** Finds the polytope's edge nearest the origin, and its outward normal */
+size_t nearest_edge(polytope_t *polytope, vector_t *normal, double *distance) {
+  size_t nearest = 0;
+  *distance = INFINITY;
+  for (size_t i = 0; i < polytope->count; i++) {
+    vector_t start = polytope->vertices[i].w;
+    vector_t end = polytope->vertices[(i + 1) % polytope->count].w;
+    vector_t edge = vec_subtract(end, start);
+    double length = sqrt(vec_dot(edge, edge));
+    if (length <= GJK_EPSILON) {
+      continue;
+    }
+    vector_t outward = {edge.y / length, -edge.x / length};
+    double edge_distance = vec_dot(outward, start);
+    if (edge_distance < *distance) {
+      *distance = edge_distance;
+      *normal = outward;
+      nearest = i;
+    }
+  }
+  return nearest;
+}
+
+/**
+ * Runs EPA from a triangle around the origin: keeps pushing out the
+ * polytope's edge nearest the origin to the support point beyond it, until
+ * the edge is on the Minkowski difference's boundary.
+ */
+penetration_info_t epa(hull_t *hull1, hull_t *hull2, simplex_t *simplex) {
+  arena_t *arena = frame_arena();
+  arena_mark_t mark = arena_mark(arena);
+  polytope_t polytope;
+  // The difference of two convex polygons has at most as many vertices as
+  // both of them together
+  polytope.capacity = hull1->count + hull2->count + 3;
+  polytope.vertices =
+      arena_alloc(arena, polytope.capacity * sizeof(simplex_vertex_t));
+  polytope.count = 3;
+  simplex_vertex_t *v = polytope.vertices;
+  for (size_t i = 0; i < 3; i++) {
+    v[i] = simplex->vertices[i];
+  }
+  // Edge normals point out of a counterclockwise polytope
+  if (vec_cross(vec_subtract(v[1].w, v[0].w), vec_subtract(v[2].w, v[0].w)) <
+      0) {
+    simplex_vertex_t swap = v[1];
+    v[1] = v[2];
+    v[2] = swap;
+  }
+
+  vector_t normal = {1, 0};
+  double distance = 0.0;
+  size_t edge = nearest_edge(&polytope, &normal, &distance);
+  while (polytope.count < polytope.capacity) {
+    simplex_vertex_t next = support(hull1, hull2, normal);
+    double reach = vec_dot(next.w, normal);
+    if (reach - distance <= EPA_TOLERANCE * fmax(1.0, fabs(reach))) {
+      break;
+    }
+    for (size_t i = polytope.count; i > edge + 1; i--) {
+      v[i] = v[i - 1];
+    }
+    v[edge + 1] = next;
+    polytope.count++;
+    edge = nearest_edge(&polytope, &normal, &distance);
+  }
+
+  // The origin's projection onto the nearest edge says how far along the
+  // edge the contact points are
+  simplex_vertex_t start = v[edge];
+  simplex_vertex_t end = v[(edge + 1) % polytope.count];
+  vector_t side = vec_subtract(end.w, start.w);
+  double side_squared = vec_dot(side, side);
+  double t = side_squared > 0 ? -vec_dot(start.w, side) / side_squared : 0;
+  t = fmin(fmax(t, 0.0), 1.0);
+  penetration_info_t penetration;
+  penetration.collided = true;
+  penetration.axis = normal;
+  penetration.depth = fmax(distance, 0.0);
+  penetration.point1 = vec_add(
+      start.point1, vec_multiply(t, vec_subtract(end.point1, start.point1)));
+  penetration.point2 = vec_add(
+      start.point2, vec_multiply(t, vec_subtract(end.point2, start.point2)));
+  arena_rewind(arena, mark);
+  return penetration;
+}
+
+/**
+ * Finds the penetration of two hulls rounded by radii: GJK finds the hulls'
+ * distance, or EPA their depth if they overlap, and the radii are added to
+ * the depth and push the points out to the rounded surfaces.
+ */
+penetration_info_t find_hull_penetration(hull_t *hull1, double radius1,
+                                         hull_t *hull2, double radius2) {
+  simplex_t simplex;
+  penetration_info_t penetration;
+  if (gjk(hull1, hull2, &simplex)) {
+    if (fill_simplex(hull1, hull2, &simplex)) {
+      penetration = epa(hull1, hull2, &simplex);
+    } else {
+      // Too thin to have an inside, so the shapes only touch
+      penetration.collided = true;
+      penetration.axis = (vector_t){1, 0};
+      penetration.depth = 0.0;
+      simplex_closest(&simplex, &penetration.point1, &penetration.point2);
+    }
+  } else {
+    vector_t closest = simplex_closest(&simplex, &penetration.point1,
+                                       &penetration.point2);
+    double distance = sqrt(vec_dot(closest, closest));
+    penetration.collided = false;
+    penetration.axis = vec_multiply(-1.0 / distance, closest);
+    penetration.depth = -distance;
+  }
+  double radius = radius1 + radius2;
+  if (radius > 0) {
+    penetration.depth += radius;
+    penetration.collided = penetration.depth >= 0;
+    penetration.point1 = vec_add(penetration.point1,
+                                 vec_multiply(radius1, penetration.axis));
+    penetration.point2 = vec_subtract(
+        penetration.point2, vec_multiply(radius2, penetration.axis));
+  }
+  return penetration;
+}
+
+penetration_info_t find_penetration(list_t *shape1, list_t *shape2) {
+  assert(list_size(shape1) > 0 && list_size(shape2) > 0);
+  hull_t hull1 = polygon_hull(shape1);
+  hull_t hull2 = polygon_hull(shape2);
+  return find_hull_penetration(&hull1, 0.0, &hull2, 0.0);
+}
+
+penetration_info_t find_penetration_capsule(capsule_t capsule,
+                                            list_t *polygon) {
+  assert(list_size(polygon) > 0);
+  hull_t hull1 = capsule_hull(capsule);
+  hull_t hull2 = polygon_hull(polygon);
+  return find_hull_penetration(&hull1, capsule.radius, &hull2, 0.0);
+}
+
+penetration_info_t find_penetration_capsules(capsule_t capsule1,
+                                             capsule_t capsule2) {
+  hull_t hull1 = capsule_hull(capsule1);
+  hull_t hull2 = capsule_hull(capsule2);
+  return find_hull_penetration(&hull1, capsule1.radius, &hull2,
+                               capsule2.radius);
+}
+
+/**
+ * Finds when a capsule moving in a straight line first touches a still hull
+ * rounded by a radius, by conservative advancement: the capsule cannot touch
+ * the hull before it has closed the gap between them along the axis GJK
+ * finds, so it is moved that far and the gap found again, until the gap
+ * closes or the capsule is no longer moving towards the hull.
+ */
+impact_info_t sweep_capsule(capsule_t capsule, vector_t displacement,
+                            hull_t *hull, double radius) {
+  impact_info_t impact = {.collided = false, .time = 0.0};
+  for (size_t i = 0; i < GJK_MAX_ITERATIONS; i++) {
+    vector_t moved = vec_multiply(impact.time, displacement);
+    hull_t moving = capsule_hull((capsule_t){vec_add(capsule.start, moved),
+                                             vec_add(capsule.end, moved),
+                                             capsule.radius});
+    penetration_info_t penetration =
+        find_hull_penetration(&moving, capsule.radius, hull, radius);
+    impact.axis = penetration.axis;
+    double gap = -penetration.depth;
+    if (gap <= TOI_TOLERANCE) {
+      // overlapping from the start is left to the discrete test
+      impact.collided = impact.time > 0;
+      return impact;
+    }
+    double closing = vec_dot(displacement, penetration.axis);
+    if (closing <= 0) {
+      return impact;
+    }
+    impact.time += gap / closing;
+    if (impact.time > 1) {
+      return impact;
+    }
+  }
+  // Still closing in after every step, so the shapes all but touch
+  impact.collided = true;
+  return impact;
+}
+
+impact_info_t find_time_of_impact_capsule(capsule_t capsule,
+                                          vector_t displacement1,
+                                          list_t *polygon,
+                                          vector_t displacement2) {
+  assert(list_size(polygon) > 0);
+  hull_t hull = polygon_hull(polygon);
+  return sweep_capsule(capsule, vec_subtract(displacement1, displacement2),
+                       &hull, 0.0);
+}
+
+impact_info_t find_time_of_impact_capsules(capsule_t capsule1,
+                                           vector_t displacement1,
+                                           capsule_t capsule2,
+                                           vector_t displacement2) {
+  hull_t hull = capsule_hull(capsule2);
+  return sweep_capsule(capsule1, vec_subtract(displacement1, displacement2),
+                       &hull, capsule2.radius);
+}
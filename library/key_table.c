@@ -0,0 +1,99 @@
+#include "key_table.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+const uint64_t EMPTY_KEY = 0;
+
+void key_table_init(key_table_t *table, size_t capacity) {
+  table->keys = calloc(capacity, sizeof(uint64_t));
+  table->values = malloc(capacity * sizeof(size_t));
+  assert(table->keys != NULL && table->values != NULL);
+  table->capacity = capacity;
+  table->size = 0;
+}
+
+void key_table_free(key_table_t *table) {
+  free(table->keys);
+  free(table->values);
+}
+
+size_t key_table_slot(key_table_t *table, uint64_t key) {
+  // Fibonacci hashing spreads out keys that differ only in their low bits
+  uint64_t hash = (key * 0x9E3779B97F4A7C15ull) >> 32;
+  return hash & (table->capacity - 1);
+}
+
+/** Returns the slot holding a key, or the empty slot where it would go */
+size_t key_table_find(key_table_t *table, uint64_t key) {
+  size_t slot = key_table_slot(table, key);
+  while (table->keys[slot] != EMPTY_KEY && table->keys[slot] != key) {
+    slot = (slot + 1) & (table->capacity - 1);
+  }
+  return slot;
+}
+
+void key_table_grow(key_table_t *table) {
+  key_table_t old = *table;
+  key_table_init(table, old.capacity * 2);
+  for (size_t i = 0; i < old.capacity; i++) {
+    if (old.keys[i] != EMPTY_KEY) {
+      key_table_put(table, old.keys[i], old.values[i]);
+    }
+  }
+  key_table_free(&old);
+}
+
+void key_table_put(key_table_t *table, uint64_t key, size_t value) {
+  assert(key != EMPTY_KEY);
+  if ((table->size + 1) * 2 > table->capacity) {
+    key_table_grow(table);
+  }
+  size_t slot = key_table_find(table, key);
+  if (table->keys[slot] == EMPTY_KEY) {
+    table->keys[slot] = key;
+    table->size++;
+  }
+  table->values[slot] = value;
+}
+
+bool key_table_get(key_table_t *table, uint64_t key, size_t *value) {
+  size_t slot = key_table_find(table, key);
+  if (table->keys[slot] == EMPTY_KEY) {
+    return false;
+  }
+  if (value != NULL) {
+    *value = table->values[slot];
+  }
+  return true;
+}
+
+void key_table_remove(key_table_t *table, uint64_t key) {
+  size_t mask = table->capacity - 1;
+  size_t hole = key_table_find(table, key);
+  if (table->keys[hole] == EMPTY_KEY) {
+    return;
+  }
+  table->size--;
+  // Shift later keys of the same run back, so no lookup stops at the hole
+  size_t slot = hole;
+  while (true) {
+    table->keys[hole] = EMPTY_KEY;
+    do {
+      slot = (slot + 1) & mask;
+      if (table->keys[slot] == EMPTY_KEY) {
+        return;
+      }
+      // A key can fill the hole unless its home slot lies after the hole
+    } while (((slot - key_table_slot(table, table->keys[slot])) & mask) <
+             ((slot - hole) & mask));
+    table->keys[hole] = table->keys[slot];
+    table->values[hole] = table->values[slot];
+    hole = slot;
+  }
+}
+
+void key_table_clear(key_table_t *table) {
+  memset(table->keys, 0, table->capacity * sizeof(uint64_t));
+  table->size = 0;
+}
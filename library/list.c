@@ -10,26 +10,39 @@ typedef struct list {
   size_t size;
   int capacity;
   free_func_t freer;
+  /** Where the list and its array were allocated from */
+  allocator_t allocator;
 } list_t;
 
 list_t *list_init(size_t initial_size, free_func_t freer) {
-  list_t *lst = malloc(sizeof(list_t));
-  assert(lst != NULL);
+  return list_init_with_allocator(initial_size, freer, NULL);
+}
+
+list_t *list_init_with_allocator(size_t initial_size, free_func_t freer,
+                                 const allocator_t *allocator) {
+  allocator_t list_allocator =
+      allocator != NULL ? *allocator : heap_allocator();
+  list_t *lst = allocator_alloc(&list_allocator, sizeof(list_t));
 
   lst->size = 0;
-  lst->capacity = initial_size;
-  lst->items = malloc(initial_size * sizeof(void *));
-  assert(lst->items != NULL);
+  lst->capacity = initial_size > 0 ? initial_size : 1;
+  lst->items = allocator_alloc(&list_allocator, lst->capacity * sizeof(void *));
 
   if (freer != NULL) {
     lst->freer = freer;
   } else {
     lst->freer = NULL;
   }
+  lst->allocator = list_allocator;
 
   return lst;
 }
 
+list_t *list_init_arena(arena_t *arena, size_t initial_size) {
+  allocator_t allocator = arena_allocator(arena);
+  return list_init_with_allocator(initial_size, NULL, &allocator);
+}
+
 void list_free(list_t *list) {
   assert(list != NULL);
 
@@ -39,8 +52,10 @@ void list_free(list_t *list) {
     }
   }
 
-  free(list->items);
-  free(list);
+  // the allocator may not free anything, e.g. for an arena list
+  allocator_t allocator = list->allocator;
+  allocator_free(&allocator, list->items);
+  allocator_free(&allocator, list);
 }
 
 size_t list_size(list_t *list) { return list->size; }
@@ -70,7 +85,10 @@ void list_add(list_t *list, void *value) {
 
   if (list->size >= list->capacity) {
     list->capacity = list->capacity * GROW_FACTOR;
-    list->items = realloc(list->items, sizeof(void *) * list->capacity);
+    list->items =
+        allocator_realloc(&list->allocator, list->items,
+                          sizeof(void *) * list->size,
+                          sizeof(void *) * list->capacity);
   }
 
   list->items[list->size] = value;
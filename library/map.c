@@ -49,6 +49,20 @@ list_t *make_rectangle(vector_t corner, double width, double height) {
   return rectangle;
 }
 
+list_t *make_rectangle_arena(arena_t *arena, vector_t corner, double width,
+                             double height) {
+  list_t *rectangle = list_init_arena(arena, 4);
+  vector_t *points = arena_alloc(arena, 4 * sizeof(vector_t));
+  points[0] = corner;
+  points[1] = (vector_t){corner.x, corner.y - height};
+  points[2] = (vector_t){corner.x + width, corner.y - height};
+  points[3] = (vector_t){corner.x + width, corner.y};
+  for (size_t i = 0; i < 4; i++) {
+    list_add(rectangle, &points[i]);
+  }
+  return rectangle;
+}
+
 list_t *make_vert_triangle(vector_t bisector_point, double perp_bisector) {
   list_t *triangle = list_init(3, (free_func_t)free);
   vector_t *point1 = malloc(sizeof(vector_t));
@@ -92,7 +106,7 @@ list_t *make_horz_triangle(vector_t bisector_point, double perp_bisector) {
 void spawn_rectangle(scene_t *scene, vector_t corner, double width,
                      double height, rgb_color_t color) {
   list_t *points = make_rectangle(corner, width, height);
-  int *type = malloc(sizeof(int));
+  size_t *type = malloc(sizeof(size_t));
   *type = RECTANGLE_OBSTACLE_TYPE;
   body_t *rectangle = body_init_with_info(points, OBSTACLE_MASS, color, type,
                                           (free_func_t)free);
@@ -102,7 +116,7 @@ void spawn_rectangle(scene_t *scene, vector_t corner, double width,
 void spawn_vert_triangle(scene_t *scene, vector_t bisector_point,
                          double perp_bisector, rgb_color_t color) {
   list_t *points = make_vert_triangle(bisector_point, perp_bisector);
-  int *type = malloc(sizeof(int));
+  size_t *type = malloc(sizeof(size_t));
   *type = TRIANGLE_OBSTACLE_TYPE;
   body_t *triangle = body_init_with_info(points, OBSTACLE_MASS, color, type,
                                          (free_func_t)free);
@@ -112,7 +126,7 @@ void spawn_vert_triangle(scene_t *scene, vector_t bisector_point,
 void spawn_horz_triangle(scene_t *scene, vector_t bisector_point,
                          double perp_bisector, rgb_color_t color) {
   list_t *points = make_horz_triangle(bisector_point, perp_bisector);
-  int *type = malloc(sizeof(int));
+  size_t *type = malloc(sizeof(size_t));
   *type = TRIANGLE_OBSTACLE_TYPE;
   body_t *triangle = body_init_with_info(points, OBSTACLE_MASS, color, type,
                                          (free_func_t)free);
@@ -0,0 +1,162 @@
+#include "perf_overlay.h"
+#include "alloc_track.h"
+#include "arena.h"
+#include "sdl_wrapper.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** How many frames of frame times the percentiles are taken over */
+#define PERF_OVERLAY_HISTORY 256
+/** The longest line of text */
+#define PERF_OVERLAY_LINE_LENGTH 48
+/** How often the text is updated, in nanoseconds of frames */
+const uint64_t PERF_OVERLAY_REFRESH_NS = 250000000;
+const double NS_PER_MS = 1e6;
+const double NS_PER_S = 1e9;
+const SDL_Color OVERLAY_TEXT_COLOR = {120, 255, 120, 255};
+const rgb_color_t OVERLAY_BACKGROUND = {0.1, 0.1, 0.1};
+
+typedef struct perf_overlay {
+  text_t *text;
+  vector_t corner;
+  vector_t size;
+  bool visible;
+  /** The most recent frame times, oldest overwritten first */
+  uint64_t frame_ns[PERF_OVERLAY_HISTORY];
+  size_t frame_count;
+  /** Sums over the frames since the text was last updated */
+  size_t window_frames;
+  uint64_t window_ns;
+  uint64_t window_simulate_ns;
+  uint64_t window_render_ns;
+  size_t window_collision_tests;
+  size_t window_allocations;
+  char lines[PERF_OVERLAY_LINES][PERF_OVERLAY_LINE_LENGTH];
+} perf_overlay_t;
+
+perf_overlay_t *perf_overlay_init(text_t *text, vector_t corner,
+                                  vector_t size) {
+  perf_overlay_t *overlay = calloc(1, sizeof(perf_overlay_t));
+  assert(overlay != NULL);
+  overlay->text = text;
+  overlay->corner = corner;
+  overlay->size = size;
+  strcpy(overlay->lines[0], "FPS --");
+  return overlay;
+}
+
+void perf_overlay_free(perf_overlay_t *overlay) { free(overlay); }
+
+void perf_overlay_toggle(perf_overlay_t *overlay) {
+  overlay->visible = !overlay->visible;
+}
+
+bool perf_overlay_visible(perf_overlay_t *overlay) { return overlay->visible; }
+
+void perf_sample_scene(perf_sample_t *sample, scene_t *scene) {
+  scene_stats_t stats = scene_stats(scene);
+  sample->bodies = scene_bodies(scene);
+  sample->forces = 0;
+  for (force_kind_t kind = 0; kind < FORCE_KIND_COUNT; kind++) {
+    sample->forces += stats.last_tick[kind].count;
+  }
+  sample->collision_tests = stats.last_tick_collisions.tests;
+  sample->allocations = 0;
+#ifdef ALLOC_TRACK
+  for (alloc_tag_t tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+    sample->allocations += alloc_track_stats(tag).last_frame_count;
+  }
+#endif
+}
+
+int compare_ns(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+/** Rewrites the text from the frames since it was last written */
+void update_lines(perf_overlay_t *overlay, perf_sample_t latest) {
+  size_t history = overlay->frame_count < PERF_OVERLAY_HISTORY
+                       ? overlay->frame_count
+                       : PERF_OVERLAY_HISTORY;
+  uint64_t sorted[PERF_OVERLAY_HISTORY];
+  memcpy(sorted, overlay->frame_ns, history * sizeof(uint64_t));
+  qsort(sorted, history, sizeof(uint64_t), compare_ns);
+  double p50 = sorted[(history - 1) * 50 / 100] / NS_PER_MS;
+  double p99 = sorted[(history - 1) * 99 / 100] / NS_PER_MS;
+
+  double frames = overlay->window_frames;
+  snprintf(overlay->lines[0], PERF_OVERLAY_LINE_LENGTH, "FPS %.1f",
+           frames * NS_PER_S / overlay->window_ns);
+  snprintf(overlay->lines[1], PERF_OVERLAY_LINE_LENGTH,
+           "frame p50 %.2f ms  p99 %.2f ms", p50, p99);
+  snprintf(overlay->lines[2], PERF_OVERLAY_LINE_LENGTH,
+           "simulate %.2f ms  render %.2f ms",
+           overlay->window_simulate_ns / frames / NS_PER_MS,
+           overlay->window_render_ns / frames / NS_PER_MS);
+  snprintf(overlay->lines[3], PERF_OVERLAY_LINE_LENGTH,
+           "bodies %zu  forces %zu", latest.bodies, latest.forces);
+  snprintf(overlay->lines[4], PERF_OVERLAY_LINE_LENGTH,
+           "collision tests %.0f / frame",
+           overlay->window_collision_tests / frames);
+#ifdef ALLOC_TRACK
+  snprintf(overlay->lines[5], PERF_OVERLAY_LINE_LENGTH,
+           "allocations %.1f / frame", overlay->window_allocations / frames);
+#else
+  snprintf(overlay->lines[5], PERF_OVERLAY_LINE_LENGTH,
+           "allocations: build with ALLOC_TRACK");
+#endif
+}
+
+void perf_overlay_add_sample(perf_overlay_t *overlay, perf_sample_t sample) {
+  overlay->frame_ns[overlay->frame_count % PERF_OVERLAY_HISTORY] =
+      sample.frame_ns;
+  overlay->frame_count++;
+  overlay->window_frames++;
+  overlay->window_ns += sample.frame_ns;
+  overlay->window_simulate_ns += sample.simulate_ns;
+  overlay->window_render_ns += sample.render_ns;
+  overlay->window_collision_tests += sample.collision_tests;
+  overlay->window_allocations += sample.allocations;
+  if (overlay->window_ns < PERF_OVERLAY_REFRESH_NS) {
+    return;
+  }
+
+  update_lines(overlay, sample);
+  overlay->window_frames = 0;
+  overlay->window_ns = 0;
+  overlay->window_simulate_ns = 0;
+  overlay->window_render_ns = 0;
+  overlay->window_collision_tests = 0;
+  overlay->window_allocations = 0;
+}
+
+const char *perf_overlay_line(perf_overlay_t *overlay, size_t index) {
+  assert(index < PERF_OVERLAY_LINES);
+  return overlay->lines[index];
+}
+
+void perf_overlay_draw(perf_overlay_t *overlay) {
+  if (!overlay->visible) {
+    return;
+  }
+  // The background only has to last until it is drawn
+  arena_t *arena = frame_arena();
+  list_t *background = list_init_arena(arena, 4);
+  vector_t corners[] = {{0, 0}, {1, 0}, {1, -1}, {0, -1}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *point = arena_alloc(arena, sizeof(vector_t));
+    point->x = overlay->corner.x + corners[i].x * overlay->size.x;
+    point->y = overlay->corner.y + corners[i].y * overlay->size.y;
+    list_add(background, point);
+  }
+  sdl_draw_polygon(background, OVERLAY_BACKGROUND);
+
+  double line_height = overlay->size.y / PERF_OVERLAY_LINES;
+  for (size_t i = 0; i < PERF_OVERLAY_LINES; i++) {
+    vector_t loc = {overlay->corner.x, overlay->corner.y - i * line_height};
+    sdl_draw_glyphs(overlay->text, overlay->lines[i], OVERLAY_TEXT_COLOR, loc);
+  }
+}
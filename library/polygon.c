@@ -5,6 +5,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+// How far from a right angle a rectangle's corners may be,
+// as the cosine of the angle
+const double RIGHT_ANGLE_TOLERANCE = 1e-9;
+
 double polygon_area(list_t *polygon) {
   // shoelace method
   double sum = 0.0;
@@ -71,3 +75,170 @@ void polygon_rotate(list_t *polygon, double angle, vector_t point) {
     vector->y = final.y;
   }
 }
+
+aabb_t polygon_bounds(list_t *polygon) {
+  vector_t *first = list_get(polygon, 0);
+  aabb_t bounds = {*first, *first};
+  for (size_t i = 1; i < list_size(polygon); i++) {
+    vector_t *point = list_get(polygon, i);
+    bounds.min.x = fmin(bounds.min.x, point->x);
+    bounds.min.y = fmin(bounds.min.y, point->y);
+    bounds.max.x = fmax(bounds.max.x, point->x);
+    bounds.max.y = fmax(bounds.max.y, point->y);
+  }
+  return bounds;
+}
+
+bool polygon_is_rectangle(list_t *polygon) {
+  if (list_size(polygon) != 4) {
+    return false;
+  }
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *a = list_get(polygon, i);
+    vector_t *b = list_get(polygon, (i + 1) % 4);
+    vector_t *c = list_get(polygon, (i + 2) % 4);
+    vector_t edge1 = vec_subtract(*b, *a);
+    vector_t edge2 = vec_subtract(*c, *b);
+    // dot * dot / lengths is the squared cosine of the corner's angle
+    double lengths = vec_dot(edge1, edge1) * vec_dot(edge2, edge2);
+    double dot = vec_dot(edge1, edge2);
+    if (lengths == 0 || dot * dot > RIGHT_ANGLE_TOLERANCE *
+                                        RIGHT_ANGLE_TOLERANCE * lengths) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool polygon_contains(list_t *polygon, vector_t point) {
+  // Counts the edges a ray to the right of the point crosses
+  bool inside = false;
+  size_t n = list_size(polygon);
+  for (size_t i = 0, j = n - 1; i < n; j = i++) {
+    vector_t *a = list_get(polygon, i);
+    vector_t *b = list_get(polygon, j);
+    if ((a->y > point.y) != (b->y > point.y) &&
+        point.x < a->x + (point.y - a->y) * (b->x - a->x) / (b->y - a->y)) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+bool polygon_overlaps_aabb(list_t *polygon, aabb_t box) {
+  if (!aabb_overlap(polygon_bounds(polygon), box)) {
+    return false;
+  }
+  // The box's own axes are covered by the bounds, so only the polygon's
+  // edge normals can still separate them
+  vector_t corners[] = {box.min, {box.max.x, box.min.y}, box.max,
+                        {box.min.x, box.max.y}};
+  size_t n = list_size(polygon);
+  for (size_t i = 0; i < n; i++) {
+    vector_t *a = list_get(polygon, i);
+    vector_t *b = list_get(polygon, (i + 1) % n);
+    vector_t axis = {b->y - a->y, a->x - b->x};
+    double polygon_min = INFINITY, polygon_max = -INFINITY;
+    for (size_t j = 0; j < n; j++) {
+      double projection = vec_dot(axis, *(vector_t *)list_get(polygon, j));
+      polygon_min = fmin(polygon_min, projection);
+      polygon_max = fmax(polygon_max, projection);
+    }
+    double box_min = INFINITY, box_max = -INFINITY;
+    for (size_t j = 0; j < 4; j++) {
+      double projection = vec_dot(axis, corners[j]);
+      box_min = fmin(box_min, projection);
+      box_max = fmax(box_max, projection);
+    }
+    if (polygon_max < box_min || box_max < polygon_min) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool polygon_raycast(list_t *polygon, vector_t origin, vector_t end,
+                     double *fraction, vector_t *normal) {
+  vector_t direction = vec_subtract(end, origin);
+  double nearest = INFINITY;
+  size_t n = list_size(polygon);
+  for (size_t i = 0; i < n; i++) {
+    vector_t a = *(vector_t *)list_get(polygon, i);
+    vector_t b = *(vector_t *)list_get(polygon, (i + 1) % n);
+    vector_t edge = vec_subtract(b, a);
+    double denominator = vec_cross(direction, edge);
+    if (denominator == 0) {
+      // parallel to the edge
+      continue;
+    }
+    vector_t to_edge = vec_subtract(a, origin);
+    double t = vec_cross(to_edge, edge) / denominator;
+    double u = vec_cross(to_edge, direction) / denominator;
+    if (t < 0 || t > 1 || u < 0 || u > 1 || t >= nearest) {
+      continue;
+    }
+    nearest = t;
+    vector_t edge_normal = vec_multiply(1 / sqrt(vec_dot(edge, edge)),
+                                        (vector_t){edge.y, -edge.x});
+    *normal = vec_dot(edge_normal, direction) > 0 ? vec_negate(edge_normal)
+                                                  : edge_normal;
+  }
+  if (nearest == INFINITY) {
+    return false;
+  }
+  *fraction = nearest;
+  return true;
+}
+
+bool aabb_overlap(aabb_t box1, aabb_t box2) {
+  return box1.min.x <= box2.max.x && box2.min.x <= box1.max.x &&
+         box1.min.y <= box2.max.y && box2.min.y <= box1.max.y;
+}
+
+aabb_t aabb_union(aabb_t box1, aabb_t box2) {
+  vector_t min = {fmin(box1.min.x, box2.min.x), fmin(box1.min.y, box2.min.y)};
+  vector_t max = {fmax(box1.max.x, box2.max.x), fmax(box1.max.y, box2.max.y)};
+  return (aabb_t){min, max};
+}
+
+aabb_t aabb_sweep(aabb_t box, vector_t displacement) {
+  aabb_t moved = {vec_add(box.min, displacement),
+                  vec_add(box.max, displacement)};
+  return aabb_union(box, moved);
+}
+
+bool aabb_contains(aabb_t outer, aabb_t inner) {
+  return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+         inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+}
+
+bool aabb_contains_point(aabb_t box, vector_t point) {
+  return box.min.x <= point.x && point.x <= box.max.x &&
+         box.min.y <= point.y && point.y <= box.max.y;
+}
+
+/**
+ * Narrows the range of fractions [*t_min, *t_max] at which a segment is
+ * between a box's sides on one axis.
+ *
+ * @return whether any of the range is left
+ */
+bool clip_to_slab(double origin, double delta, double min, double max,
+                  double *t_min, double *t_max) {
+  if (delta == 0) {
+    return min <= origin && origin <= max;
+  }
+  double t1 = (min - origin) / delta, t2 = (max - origin) / delta;
+  *t_min = fmax(*t_min, fmin(t1, t2));
+  *t_max = fmin(*t_max, fmax(t1, t2));
+  return *t_min <= *t_max;
+}
+
+bool aabb_segment_overlap(aabb_t box, vector_t origin, vector_t end,
+                          double max_fraction) {
+  double t_min = 0, t_max = max_fraction;
+  return clip_to_slab(origin.x, end.x - origin.x, box.min.x, box.max.x, &t_min,
+                      &t_max) &&
+         clip_to_slab(origin.y, end.y - origin.y, box.min.y, box.max.y, &t_min,
+                      &t_max);
+}
@@ -0,0 +1,200 @@
+#include "profiler.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+const size_t PROFILE_EVENTS = 1 << 16;
+/** Scopes nested deeper than this are not recorded */
+#define MAX_PROFILE_DEPTH 32
+
+/** An open scope */
+typedef struct {
+  const char *name;
+  uint64_t start_ns;
+} open_scope_t;
+
+typedef struct profile_thread {
+  /** A ring of PROFILE_EVENTS events */
+  profile_event_t *events;
+  /** Every event ever recorded; the newest is at (written - 1) % size */
+  atomic_size_t written;
+  open_scope_t open[MAX_PROFILE_DEPTH];
+  size_t depth;
+  size_t id;
+  const char *name;
+  struct profile_thread *next;
+} profile_thread_t;
+
+atomic_bool profiling = false;
+/** Timestamps are relative to when the profiler was first enabled */
+uint64_t profile_epoch = 0;
+
+/** Every thread that has recorded, guarded by threads_lock */
+profile_thread_t *profile_threads = NULL;
+size_t profile_thread_count = 0;
+atomic_flag threads_lock = ATOMIC_FLAG_INIT;
+
+_Thread_local profile_thread_t *current_thread = NULL;
+
+uint64_t profile_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+void profile_enable(bool enabled) {
+  if (enabled && profile_epoch == 0) {
+    profile_epoch = profile_now_ns();
+  }
+  atomic_store_explicit(&profiling, enabled, memory_order_relaxed);
+}
+
+bool profile_enabled(void) {
+  return atomic_load_explicit(&profiling, memory_order_relaxed);
+}
+
+/** Gets the calling thread's buffers, creating them the first time */
+profile_thread_t *get_profile_thread(void) {
+  if (current_thread != NULL) {
+    return current_thread;
+  }
+  profile_thread_t *thread = malloc(sizeof(profile_thread_t));
+  assert(thread != NULL);
+  thread->events = malloc(PROFILE_EVENTS * sizeof(profile_event_t));
+  assert(thread->events != NULL);
+  atomic_init(&thread->written, 0);
+  thread->depth = 0;
+  thread->name = NULL;
+
+  while (atomic_flag_test_and_set_explicit(&threads_lock,
+                                           memory_order_acquire)) {
+  }
+  thread->id = ++profile_thread_count;
+  thread->next = profile_threads;
+  profile_threads = thread;
+  atomic_flag_clear_explicit(&threads_lock, memory_order_release);
+
+  current_thread = thread;
+  return thread;
+}
+
+bool profile_begin(const char *name) {
+  if (!atomic_load_explicit(&profiling, memory_order_relaxed)) {
+    return false;
+  }
+  profile_thread_t *thread = get_profile_thread();
+  if (thread->depth < MAX_PROFILE_DEPTH) {
+    thread->open[thread->depth] = (open_scope_t){name, profile_now_ns()};
+  }
+  thread->depth++;
+  return true;
+}
+
+void profile_end(void) {
+  profile_thread_t *thread = current_thread;
+  if (thread == NULL || thread->depth == 0) {
+    return;
+  }
+  thread->depth--;
+  if (thread->depth >= MAX_PROFILE_DEPTH) {
+    return;
+  }
+  open_scope_t *scope = &thread->open[thread->depth];
+  uint64_t now = profile_now_ns();
+  size_t written = atomic_load_explicit(&thread->written, memory_order_relaxed);
+  thread->events[written % PROFILE_EVENTS] = (profile_event_t){
+      scope->name, scope->start_ns - profile_epoch, now - scope->start_ns,
+      (uint32_t)thread->depth};
+  // publishes the event to profile_write_trace()
+  atomic_store_explicit(&thread->written, written + 1, memory_order_release);
+}
+
+void profile_scope_end(bool *recording) {
+  if (*recording) {
+    profile_end();
+  }
+}
+
+void profile_thread_name(const char *name) {
+  if (profile_enabled()) {
+    get_profile_thread()->name = name;
+  }
+}
+
+/** Gets the oldest of a thread's events that is still in its ring */
+size_t first_event(size_t written) {
+  return written > PROFILE_EVENTS ? written - PROFILE_EVENTS : 0;
+}
+
+size_t profile_thread_events(profile_event_t *events, size_t max) {
+  profile_thread_t *thread = get_profile_thread();
+  size_t written = atomic_load_explicit(&thread->written, memory_order_acquire);
+  size_t count = 0;
+  for (size_t i = first_event(written); i < written && count < max;
+       i++) {
+    events[count++] = thread->events[i % PROFILE_EVENTS];
+  }
+  return count;
+}
+
+/** Writes a string as a JSON string literal */
+void write_json_string(FILE *out, const char *string) {
+  fputc('"', out);
+  for (const char *c = string; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', out);
+    }
+    fputc(*c, out);
+  }
+  fputc('"', out);
+}
+
+size_t profile_write_trace(FILE *out) {
+  size_t count = 0;
+  fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  while (atomic_flag_test_and_set_explicit(&threads_lock,
+                                           memory_order_acquire)) {
+  }
+  bool first = true;
+  for (profile_thread_t *thread = profile_threads; thread != NULL;
+       thread = thread->next) {
+    if (thread->name != NULL) {
+      fprintf(out,
+              "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+              "\"tid\":%zu,\"args\":{\"name\":",
+              first ? "" : ",", thread->id);
+      write_json_string(out, thread->name);
+      fprintf(out, "}}");
+      first = false;
+    }
+    size_t written =
+        atomic_load_explicit(&thread->written, memory_order_acquire);
+    for (size_t i = first_event(written); i < written; i++) {
+      profile_event_t *event = &thread->events[i % PROFILE_EVENTS];
+      // trace timestamps are in microseconds
+      fprintf(out, "%s\n{\"name\":", first ? "" : ",");
+      write_json_string(out, event->name);
+      fprintf(out,
+              ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%zu}",
+              event->start_ns / 1000.0, event->duration_ns / 1000.0,
+              thread->id);
+      first = false;
+      count++;
+    }
+  }
+  atomic_flag_clear_explicit(&threads_lock, memory_order_release);
+  fprintf(out, "\n]}\n");
+  return count;
+}
+
+void profile_reset(void) {
+  while (atomic_flag_test_and_set_explicit(&threads_lock,
+                                           memory_order_acquire)) {
+  }
+  for (profile_thread_t *thread = profile_threads; thread != NULL;
+       thread = thread->next) {
+    atomic_store(&thread->written, 0);
+  }
+  atomic_flag_clear_explicit(&threads_lock, memory_order_release);
+}
@@ -0,0 +1,255 @@
+#include "render_snapshot.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t INITIAL_ITEMS = 64;
+const size_t INITIAL_VERTICES = 256;
+const size_t INITIAL_TEXT = 256;
+const size_t SNAPSHOT_GROW_FACTOR = 2;
+
+/** The value of render_buffer->reading when the reader holds no snapshot */
+const int NOT_READING = -1;
+
+typedef struct render_snapshot {
+  render_item_t *items;
+  size_t item_count;
+  size_t item_capacity;
+  vector_t *vertices;
+  size_t vertex_count;
+  size_t vertex_capacity;
+  char *text;
+  size_t text_size;
+  size_t text_capacity;
+  /** Which publish this snapshot came from; 0 if never published */
+  size_t sequence;
+  /** The size of the window the frame is drawn for, in pixels */
+  vector_t window_size;
+} render_snapshot_t;
+
+typedef struct render_buffer {
+  render_snapshot_t *snapshots[2];
+  /** The index of the newest published snapshot */
+  atomic_int front;
+  /** The index of the snapshot the reader is drawing, or NOT_READING */
+  atomic_int reading;
+  /** The index the writer is filling, or NOT_READING between frames */
+  int writing;
+  /** The sequence of the last snapshot the reader acquired */
+  size_t last_acquired;
+  atomic_size_t published;
+  atomic_size_t dropped;
+  atomic_size_t rendered;
+} render_buffer_t;
+
+render_snapshot_t *render_snapshot_init(void) {
+  render_snapshot_t *snapshot = malloc(sizeof(render_snapshot_t));
+  assert(snapshot != NULL);
+  snapshot->items = malloc(INITIAL_ITEMS * sizeof(render_item_t));
+  snapshot->vertices = malloc(INITIAL_VERTICES * sizeof(vector_t));
+  snapshot->text = malloc(INITIAL_TEXT);
+  assert(snapshot->items != NULL);
+  assert(snapshot->vertices != NULL);
+  assert(snapshot->text != NULL);
+  snapshot->item_capacity = INITIAL_ITEMS;
+  snapshot->vertex_capacity = INITIAL_VERTICES;
+  snapshot->text_capacity = INITIAL_TEXT;
+  snapshot->sequence = 0;
+  snapshot->window_size = VEC_ZERO;
+  render_snapshot_clear(snapshot);
+  return snapshot;
+}
+
+void render_snapshot_free(render_snapshot_t *snapshot) {
+  free(snapshot->items);
+  free(snapshot->vertices);
+  free(snapshot->text);
+  free(snapshot);
+}
+
+void render_snapshot_clear(render_snapshot_t *snapshot) {
+  snapshot->item_count = 0;
+  snapshot->vertex_count = 0;
+  snapshot->text_size = 0;
+}
+
+/** Appends an item, growing the item array if it is full */
+render_item_t *add_item(render_snapshot_t *snapshot, render_item_kind_t kind) {
+  if (snapshot->item_count == snapshot->item_capacity) {
+    snapshot->item_capacity *= SNAPSHOT_GROW_FACTOR;
+    snapshot->items = realloc(snapshot->items,
+                              snapshot->item_capacity * sizeof(render_item_t));
+    assert(snapshot->items != NULL);
+  }
+  render_item_t *item = &snapshot->items[snapshot->item_count++];
+  memset(item, 0, sizeof(*item));
+  item->kind = kind;
+  return item;
+}
+
+void render_snapshot_add_polygon(render_snapshot_t *snapshot, list_t *points,
+                                 rgb_color_t color) {
+  size_t n = list_size(points);
+  while (snapshot->vertex_count + n > snapshot->vertex_capacity) {
+    snapshot->vertex_capacity *= SNAPSHOT_GROW_FACTOR;
+    snapshot->vertices = realloc(snapshot->vertices,
+                                 snapshot->vertex_capacity * sizeof(vector_t));
+    assert(snapshot->vertices != NULL);
+  }
+  render_item_t *item = add_item(snapshot, RENDER_POLYGON);
+  item->color = color;
+  item->first_vertex = snapshot->vertex_count;
+  item->vertex_count = n;
+  for (size_t i = 0; i < n; i++) {
+    snapshot->vertices[snapshot->vertex_count++] =
+        *(vector_t *)list_get(points, i);
+  }
+}
+
+void render_snapshot_add_texture(render_snapshot_t *snapshot, size_t texture_id,
+                                 const char *image_path, vector_t centroid,
+                                 double rotation) {
+  render_item_t *item = add_item(snapshot, RENDER_TEXTURE);
+  item->texture_id = texture_id;
+  item->image_path = image_path;
+  item->centroid = centroid;
+  item->rotation = rotation;
+}
+
+/** Appends a RENDER_TEXT or RENDER_GLYPHS item, copying its words */
+void add_label(render_snapshot_t *snapshot, render_item_kind_t kind,
+               text_t *font, const char *words, SDL_Color color,
+               vector_t loc) {
+  size_t length = strlen(words) + 1;
+  while (snapshot->text_size + length > snapshot->text_capacity) {
+    snapshot->text_capacity *= SNAPSHOT_GROW_FACTOR;
+    snapshot->text = realloc(snapshot->text, snapshot->text_capacity);
+    assert(snapshot->text != NULL);
+  }
+  render_item_t *item = add_item(snapshot, kind);
+  item->font = font;
+  item->text_color = color;
+  item->loc = loc;
+  item->text_offset = snapshot->text_size;
+  memcpy(snapshot->text + snapshot->text_size, words, length);
+  snapshot->text_size += length;
+}
+
+void render_snapshot_add_text(render_snapshot_t *snapshot, text_t *font,
+                              const char *words, SDL_Color color,
+                              vector_t loc) {
+  add_label(snapshot, RENDER_TEXT, font, words, color, loc);
+}
+
+void render_snapshot_add_glyphs(render_snapshot_t *snapshot, text_t *font,
+                                const char *words, SDL_Color color,
+                                vector_t loc) {
+  add_label(snapshot, RENDER_GLYPHS, font, words, color, loc);
+}
+
+void render_snapshot_set_window_size(render_snapshot_t *snapshot,
+                                     vector_t window_size) {
+  snapshot->window_size = window_size;
+}
+
+vector_t render_snapshot_window_size(render_snapshot_t *snapshot) {
+  return snapshot->window_size;
+}
+
+size_t render_snapshot_size(render_snapshot_t *snapshot) {
+  return snapshot->item_count;
+}
+
+const render_item_t *render_snapshot_get(render_snapshot_t *snapshot,
+                                         size_t index) {
+  assert(index < snapshot->item_count);
+  return &snapshot->items[index];
+}
+
+const vector_t *render_snapshot_vertices(render_snapshot_t *snapshot,
+                                         const render_item_t *item) {
+  assert(item->kind == RENDER_POLYGON);
+  return &snapshot->vertices[item->first_vertex];
+}
+
+const char *render_snapshot_text(render_snapshot_t *snapshot,
+                                 const render_item_t *item) {
+  assert(item->kind == RENDER_TEXT || item->kind == RENDER_GLYPHS);
+  return &snapshot->text[item->text_offset];
+}
+
+render_buffer_t *render_buffer_init(void) {
+  render_buffer_t *buffer = malloc(sizeof(render_buffer_t));
+  assert(buffer != NULL);
+  buffer->snapshots[0] = render_snapshot_init();
+  buffer->snapshots[1] = render_snapshot_init();
+  atomic_init(&buffer->front, 0);
+  atomic_init(&buffer->reading, NOT_READING);
+  buffer->writing = NOT_READING;
+  buffer->last_acquired = 0;
+  atomic_init(&buffer->published, 0);
+  atomic_init(&buffer->dropped, 0);
+  atomic_init(&buffer->rendered, 0);
+  return buffer;
+}
+
+void render_buffer_free(render_buffer_t *buffer) {
+  render_snapshot_free(buffer->snapshots[0]);
+  render_snapshot_free(buffer->snapshots[1]);
+  free(buffer);
+}
+
+render_snapshot_t *render_buffer_begin_write(render_buffer_t *buffer) {
+  int back = 1 - atomic_load(&buffer->front);
+  // The reader only ever pins a snapshot it saw as the front one, and the
+  // front only changes in render_buffer_publish(), so once the back snapshot
+  // is seen unpinned here it stays unpinned until it is published.
+  if (atomic_load(&buffer->reading) == back) {
+    buffer->writing = NOT_READING;
+    atomic_fetch_add(&buffer->dropped, 1);
+    return NULL;
+  }
+  buffer->writing = back;
+  render_snapshot_clear(buffer->snapshots[back]);
+  return buffer->snapshots[back];
+}
+
+void render_buffer_publish(render_buffer_t *buffer) {
+  if (buffer->writing == NOT_READING) {
+    return;
+  }
+  buffer->snapshots[buffer->writing]->sequence =
+      atomic_fetch_add(&buffer->published, 1) + 1;
+  atomic_store(&buffer->front, buffer->writing);
+  buffer->writing = NOT_READING;
+}
+
+render_snapshot_t *render_buffer_acquire(render_buffer_t *buffer) {
+  int front;
+  do {
+    // Pin the front snapshot, then check it is still the front one;
+    // if the writer published in between, pin the new front instead
+    front = atomic_load(&buffer->front);
+    atomic_store(&buffer->reading, front);
+  } while (atomic_load(&buffer->front) != front);
+
+  render_snapshot_t *snapshot = buffer->snapshots[front];
+  if (snapshot->sequence == buffer->last_acquired) {
+    atomic_store(&buffer->reading, NOT_READING);
+    return NULL;
+  }
+  buffer->last_acquired = snapshot->sequence;
+  atomic_fetch_add(&buffer->rendered, 1);
+  return snapshot;
+}
+
+void render_buffer_release(render_buffer_t *buffer) {
+  atomic_store(&buffer->reading, NOT_READING);
+}
+
+render_stats_t render_buffer_stats(render_buffer_t *buffer) {
+  return (render_stats_t){.published = atomic_load(&buffer->published),
+                          .dropped = atomic_load(&buffer->dropped),
+                          .rendered = atomic_load(&buffer->rendered)};
+}
@@ -1,42 +1,155 @@
 #include "scene.h"
+#include "arena.h"
 #include "body.h"
+#include "broad_phase.h"
+#include "collision.h"
+#include "contact.h"
+#include "contact_cache.h"
 #include "forces.h"
 #include "list.h"
+#include "profiler.h"
+#include "slab.h"
 #include <assert.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 
 size_t LIST_SIZE = 10000;
+size_t SPARE_FORCES_SIZE = 64;
+size_t IMPACTS_SIZE = 16;
+/**
+ * How far past its time of impact a bullet is moved, so that it overlaps
+ * the body it hit and the collision is found
+ */
+const double IMPACT_DEPTH = 0.5;
 
 typedef struct scene {
   list_t *bodies;
   list_t *force_infos;
+  /** Force infos removed with their bodies, kept to be reused */
+  list_t *spare_infos;
+  /** The auxes of those force infos, kept for scene_reuse_aux() */
+  list_t *spare_auxes;
+  /** Where the scene and everything it creates are allocated from */
+  allocator_t allocator;
+  /** Holds the scene's force infos and force storage */
+  slab_t *slab;
+  /** Allocates from slab */
+  allocator_t records;
+  scene_stats_t stats;
+  /** Finds the bodies that may be colliding, or NULL to test every pair */
+  broad_phase_t *broad_phase;
+  /** Finds the bodies for queries when there is no broad_phase */
+  broad_phase_t *query_tree;
+  /** Whether bodies may have moved since the broad phase last saw them */
+  bool queries_stale;
+  /** How collision force creators test polygons */
+  narrow_phase_kind_t narrow_phase;
+  /** The contacts physics collisions found this tick, solved together */
+  contact_solver_t *contacts;
+  /** The pairs of bodies touching, kept from tick to tick */
+  contact_cache_t *contact_cache;
+  /** The bullets hitting a body this tick, as impact_t records in the slab */
+  list_t *impacts;
 } scene_t;
 
+/** Where a bullet should stop at the end of a tick, having hit a body */
+typedef struct {
+  body_t *bullet;
+  /** When during the tick the bullet hits, from 0 to 1 */
+  double time;
+  vector_t stop;
+} impact_t;
+
 typedef struct force_info {
   force_creator_t forcer;
   list_t *bodies;
   void *aux;
+  force_kind_t kind;
+  /** The scene's record allocator, which the force info came from */
+  const allocator_t *allocator;
 } force_info_t;
 
 void force_free(force_info_t *force_storage) {
   store_force_free(force_storage->aux);
-  free(force_storage);
+  allocator_free(force_storage->allocator, force_storage);
 }
 
-scene_t *scene_init(void) {
-  scene_t *scene = malloc(sizeof(scene_t));
-  assert(scene != NULL);
-  scene->bodies = list_init(LIST_SIZE, (free_func_t)body_free);
-  scene->force_infos = list_init(LIST_SIZE, (free_func_t)force_free);
+scene_t *scene_init(void) { return scene_init_with_allocator(NULL); }
+
+scene_t *scene_init_with_allocator(const allocator_t *allocator) {
+  allocator_t scene_allocator =
+      allocator != NULL ? *allocator : heap_allocator();
+  scene_t *scene = allocator_alloc(&scene_allocator, sizeof(scene_t));
+  scene->allocator = scene_allocator;
+  scene->slab = slab_init();
+  scene->records = slab_allocator(scene->slab);
+  allocator = &scene->allocator;
+  scene->bodies =
+      list_init_with_allocator(LIST_SIZE, (free_func_t)body_free, allocator);
+  // the force infos and their auxes all live in the slab, which frees them
+  scene->force_infos = list_init_with_allocator(LIST_SIZE, NULL, allocator);
+  scene->spare_infos =
+      list_init_with_allocator(SPARE_FORCES_SIZE, NULL, allocator);
+  scene->spare_auxes =
+      list_init_with_allocator(SPARE_FORCES_SIZE, NULL, allocator);
+  scene->impacts = list_init_with_allocator(IMPACTS_SIZE, NULL, allocator);
+  scene_stats_reset(scene);
+  scene->broad_phase = NULL;
+  scene->query_tree = NULL;
+  scene->queries_stale = true;
+  scene->narrow_phase = NARROW_PHASE_AUTO;
+  scene->contacts = contact_solver_init(allocator);
+  scene->contact_cache = contact_cache_init(allocator);
 
   return scene;
 }
 
 void scene_free(scene_t *scene) {
+  slab_free(scene->slab);
+  if (scene->broad_phase != NULL) {
+    broad_phase_free(scene->broad_phase);
+  }
+  if (scene->query_tree != NULL) {
+    broad_phase_free(scene->query_tree);
+  }
+  // its hash table is on the heap whatever the scene's allocator
+  contact_cache_free(scene->contact_cache);
+  if (scene->allocator.free == NULL) {
+    // everything else belongs to the allocator, which releases it at once
+    return;
+  }
   list_free(scene->bodies);
   list_free(scene->force_infos);
-  free(scene);
+  list_free(scene->spare_infos);
+  list_free(scene->spare_auxes);
+  list_free(scene->impacts);
+  contact_solver_free(scene->contacts);
+  allocator_t allocator = scene->allocator;
+  allocator_free(&allocator, scene);
+}
+
+const allocator_t *scene_get_allocator(scene_t *scene) {
+  return &scene->allocator;
+}
+
+const allocator_t *scene_get_record_allocator(scene_t *scene) {
+  return &scene->records;
+}
+
+slab_stats_t scene_record_stats(scene_t *scene) {
+  return slab_stats(scene->slab);
+}
+
+/** Keeps a removed force info and its aux to be reused by later forces */
+void scene_recycle_force(scene_t *scene, force_info_t *force_storage) {
+  list_add(scene->spare_auxes, force_storage->aux);
+  list_add(scene->spare_infos, force_storage);
+}
+
+void *scene_reuse_aux(scene_t *scene) {
+  size_t spares = list_size(scene->spare_auxes);
+  return spares > 0 ? list_remove(scene->spare_auxes, spares - 1) : NULL;
 }
 
 size_t scene_bodies(scene_t *scene) { return list_size(scene->bodies); }
@@ -49,6 +162,7 @@ body_t *scene_get_body(scene_t *scene, size_t index) {
 
 void scene_add_body(scene_t *scene, body_t *body) {
   list_add(scene->bodies, body);
+  scene->queries_stale = true;
 }
 
 void scene_remove_body(scene_t *scene, size_t index) {
@@ -65,23 +179,266 @@ void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux,
 void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies,
                                     free_func_t freer) {
-  force_info_t *force_storage = malloc(sizeof(force_info_t));
+  scene_add_force(scene, FORCE_OTHER, forcer, aux, bodies);
+}
+
+void scene_add_force(scene_t *scene, force_kind_t kind, force_creator_t forcer,
+                     void *aux, list_t *bodies) {
+  assert(kind < FORCE_KIND_COUNT);
+  force_info_t *force_storage;
+  size_t spares = list_size(scene->spare_infos);
+  if (spares > 0) {
+    force_storage = list_remove(scene->spare_infos, spares - 1);
+  } else {
+    force_storage = allocator_alloc(&scene->records, sizeof(force_info_t));
+    force_storage->allocator = &scene->records;
+  }
   force_storage->forcer = forcer;
   force_storage->aux = aux;
   force_storage->bodies = bodies;
+  force_storage->kind = kind;
 
   list_add(scene->force_infos, force_storage);
 }
 
+void scene_set_broad_phase(scene_t *scene, broad_phase_kind_t kind) {
+  assert(kind < BROAD_PHASE_KIND_COUNT);
+  if (scene->broad_phase != NULL) {
+    broad_phase_free(scene->broad_phase);
+  }
+  scene->broad_phase =
+      kind == BROAD_PHASE_NONE ? NULL : broad_phase_init(kind);
+  if (scene->query_tree != NULL) {
+    broad_phase_free(scene->query_tree);
+    scene->query_tree = NULL;
+  }
+  scene->queries_stale = true;
+}
+
+void scene_set_narrow_phase(scene_t *scene, narrow_phase_kind_t kind) {
+  assert(kind < NARROW_PHASE_KIND_COUNT);
+  scene->narrow_phase = kind;
+}
+
+narrow_phase_kind_t scene_get_narrow_phase(scene_t *scene) {
+  return scene->narrow_phase;
+}
+
+bool scene_may_collide(scene_t *scene, body_t *body1, body_t *body2) {
+  if (scene->broad_phase == NULL ||
+      broad_phase_may_collide(scene->broad_phase, body1, body2)) {
+    return true;
+  }
+  scene->stats.last_tick_collisions.culled++;
+  return false;
+}
+
+void scene_add_contact(scene_t *scene, body_t *body1, body_t *body2,
+                       contact_manifold_t *manifold, double elasticity) {
+  contact_solver_add(scene->contacts, body1, body2, manifold, elasticity);
+}
+
+contact_t *scene_touch_contact(scene_t *scene, body_t *body1, body_t *body2,
+                               contact_event_t *event) {
+  return contact_cache_touch(scene->contact_cache, body1, body2, event);
+}
+
+contact_t *scene_find_contact(scene_t *scene, body_t *body1, body_t *body2) {
+  return contact_cache_find(scene->contact_cache, body1, body2);
+}
+
+size_t scene_contacts(scene_t *scene) {
+  return contact_cache_size(scene->contact_cache);
+}
+
+void scene_set_contact_listener(scene_t *scene, contact_listener_t listener,
+                                void *aux) {
+  contact_cache_set_listener(scene->contact_cache, listener, aux);
+}
+
+void scene_count_collision_test(scene_t *scene, bool hit) {
+  scene->stats.last_tick_collisions.tests++;
+  if (hit) {
+    scene->stats.last_tick_collisions.hits++;
+  }
+}
+
+scene_stats_t scene_stats(scene_t *scene) { return scene->stats; }
+
+void scene_stats_reset(scene_t *scene) {
+  scene->stats = (scene_stats_t){0};
+}
+
+const char *force_kind_name(force_kind_t kind) {
+  static const char *names[FORCE_KIND_COUNT] = {"gravity", "spring", "drag",
+                                                "collision", "other"};
+  assert(kind < FORCE_KIND_COUNT);
+  return names[kind];
+}
+
+void scene_print_stats(scene_t *scene, FILE *out) {
+  scene_stats_t stats = scene->stats;
+  if (stats.ticks == 0) {
+    return;
+  }
+  fprintf(out, "force creators, per tick over %zu ticks:\n", stats.ticks);
+  for (force_kind_t kind = 0; kind < FORCE_KIND_COUNT; kind++) {
+    force_cost_t total = stats.total[kind];
+    if (total.count == 0) {
+      continue;
+    }
+    fprintf(out, "  %-9s %8.1f run %9.1f us\n", force_kind_name(kind),
+            (double)total.count / stats.ticks,
+            total.ns / 1000.0 / stats.ticks);
+  }
+  collision_counts_t collisions = stats.total_collisions;
+  if (collisions.tests > 0) {
+    fprintf(out, "  %zu collision tests, %.1f%% hits\n", collisions.tests,
+            100.0 * collisions.hits / collisions.tests);
+  }
+  if (collisions.culled > 0) {
+    fprintf(out, "  %zu pairs culled by the broad phase\n", collisions.culled);
+  }
+  if (collisions.impacts > 0) {
+    fprintf(out, "  %zu bullets stopped at their time of impact\n",
+            collisions.impacts);
+  }
+}
+
+/**
+ * Sweeps a bullet against a body it has a collision with over the coming
+ * tick, and records where it should stop if it would move into the body.
+ * Only the earliest impact of each bullet is kept.
+ */
+void sweep_bullet(scene_t *scene, body_t *bullet, body_t *body, double dt) {
+  vector_t displacement = body_get_translation(bullet, dt);
+  vector_t body_displacement = body_get_translation(body, dt);
+  if (!aabb_overlap(aabb_sweep(body_get_bounds(bullet), displacement),
+                   aabb_sweep(body_get_bounds(body), body_displacement))) {
+    return;
+  }
+
+  impact_info_t impact =
+      find_body_time_of_impact(bullet, displacement, body, body_displacement);
+  if (!impact.collided) {
+    return;
+  }
+
+  impact_t *record = NULL;
+  for (size_t i = 0; i < list_size(scene->impacts); i++) {
+    impact_t *other = list_get(scene->impacts, i);
+    if (other->bullet == bullet) {
+      if (other->time <= impact.time) {
+        return;
+      }
+      record = other;
+    }
+  }
+  if (record == NULL) {
+    record = allocator_alloc(&scene->records, sizeof(impact_t));
+    list_add(scene->impacts, record);
+  }
+
+  // Carry on a little past the impact, so the bodies overlap, and keep up
+  // with the body for the rest of the tick so they still do at the end
+  vector_t relative = vec_subtract(displacement, body_displacement);
+  double distance = sqrt(vec_dot(relative, relative));
+  double time = fmin(1, impact.time + IMPACT_DEPTH / distance);
+  vector_t moved = vec_add(vec_multiply(time, relative), body_displacement);
+  *record = (impact_t){bullet, impact.time,
+                       vec_add(body_get_centroid(bullet), moved)};
+}
+
+/**
+ * Sweeps each bullet against the bodies it has collisions with, before the
+ * bodies are ticked. Bullets are not swept against each other.
+ */
+void find_impacts(scene_t *scene, double dt) {
+  for (size_t i = 0; i < list_size(scene->force_infos); i++) {
+    force_info_t *force_storage = list_get(scene->force_infos, i);
+    if (force_storage->kind != FORCE_COLLISION) {
+      continue;
+    }
+    body_t *body1 = list_get(force_storage->bodies, 0);
+    body_t *body2 = list_get(force_storage->bodies, 1);
+    if (body_is_bullet(body1) && !body_is_bullet(body2)) {
+      sweep_bullet(scene, body1, body2, dt);
+    } else if (body_is_bullet(body2) && !body_is_bullet(body1)) {
+      sweep_bullet(scene, body2, body1, dt);
+    }
+  }
+}
+
+/** Moves the bullets that hit a body this tick back to where they hit */
+void stop_bullets(scene_t *scene) {
+  size_t count = list_size(scene->impacts);
+  for (size_t i = 0; i < count; i++) {
+    impact_t *impact = list_remove(scene->impacts, count - 1 - i);
+    body_set_centroid(impact->bullet, impact->stop);
+    allocator_free(&scene->records, impact);
+  }
+  scene->stats.last_tick_collisions.impacts = count;
+  scene->stats.total_collisions.impacts += count;
+}
+
 void scene_tick(scene_t *scene, double dt) {
+  PROFILE_SCOPE("scene_tick");
+  if (scene->broad_phase != NULL) {
+    PROFILE_BEGIN("broad phase");
+    broad_phase_update(scene->broad_phase, scene->bodies);
+    scene->queries_stale = false;
+    PROFILE_END();
+  }
+
+  PROFILE_BEGIN("forces");
+  scene_stats_t *stats = &scene->stats;
+  for (force_kind_t kind = 0; kind < FORCE_KIND_COUNT; kind++) {
+    stats->last_tick[kind] = (force_cost_t){0, 0};
+  }
+  stats->last_tick_collisions = (collision_counts_t){0, 0, 0, 0};
+
+  // Forces of a kind are usually added together, so the clock is only read
+  // where the kind changes rather than around every force creator
+  force_kind_t kind = FORCE_KIND_COUNT;
+  uint64_t start = 0;
   for (size_t i = 0; i < list_size(scene->force_infos); i++) {
     force_info_t *force_storage = list_get(scene->force_infos, i);
     force_creator_t forcer = force_storage->forcer;
     store_force_t *storage = (store_force_t *)force_storage->aux;
 
+    if (force_storage->kind != kind) {
+      uint64_t now = profile_now_ns();
+      if (kind != FORCE_KIND_COUNT) {
+        stats->last_tick[kind].ns += now - start;
+      }
+      kind = force_storage->kind;
+      start = now;
+    }
+    stats->last_tick[kind].count++;
     forcer(storage);
   }
+  if (kind != FORCE_KIND_COUNT) {
+    stats->last_tick[kind].ns += profile_now_ns() - start;
+  }
+
+  stats->ticks++;
+  for (kind = 0; kind < FORCE_KIND_COUNT; kind++) {
+    stats->total[kind].count += stats->last_tick[kind].count;
+    stats->total[kind].ns += stats->last_tick[kind].ns;
+  }
+  stats->total_collisions.tests += stats->last_tick_collisions.tests;
+  stats->total_collisions.hits += stats->last_tick_collisions.hits;
+  stats->total_collisions.culled += stats->last_tick_collisions.culled;
+  PROFILE_END();
 
+  // Before the contacts holding the manifolds end, and before the bodies of
+  // the ones that end with a removed body are freed
+  PROFILE_BEGIN("contacts");
+  contact_solver_solve(scene->contacts, dt);
+  contact_cache_expire(scene->contact_cache);
+  PROFILE_END();
+
+  PROFILE_BEGIN("remove forces");
   for (size_t i = 0; i < list_size(scene->force_infos); i++) {
     force_info_t *force_storage = list_get(scene->force_infos, i);
 
@@ -93,13 +450,19 @@ void scene_tick(scene_t *scene, double dt) {
       // if body is removed, remove the corresponding force
       if (body_is_removed(body)) {
         force_info_t *f = list_remove(scene->force_infos, i);
-        force_free(f);
+        scene_recycle_force(scene, f);
         i--;
         break;
       }
     }
   }
+  PROFILE_END();
+
+  PROFILE_BEGIN("sweep bullets");
+  find_impacts(scene, dt);
+  PROFILE_END();
 
+  PROFILE_BEGIN("integrate");
   size_t size = list_size(scene->bodies);
   for (size_t i = 0; i < size; i++) {
     if (body_is_removed(list_get(scene->bodies, i))) {
@@ -111,4 +474,159 @@ void scene_tick(scene_t *scene, double dt) {
       body_tick(list_get(scene->bodies, i), dt);
     }
   }
-}
\ No newline at end of file
+  stop_bullets(scene);
+  scene->queries_stale = true;
+  PROFILE_END();
+}
+
+/**
+ * Gets the broad phase that answers a scene's queries, creating a tree for
+ * them if the scene has no broad phase, and brings it up to date if bodies
+ * have moved since it last saw them.
+ */
+broad_phase_t *scene_query_phase(scene_t *scene) {
+  broad_phase_t *broad_phase = scene->broad_phase;
+  if (broad_phase == NULL) {
+    if (scene->query_tree == NULL) {
+      scene->query_tree = broad_phase_init(BROAD_PHASE_AABB_TREE);
+    }
+    broad_phase = scene->query_tree;
+  }
+  if (scene->queries_stale) {
+    PROFILE_SCOPE("refresh queries");
+    broad_phase_refresh(broad_phase, scene->bodies);
+    scene->queries_stale = false;
+  }
+  return broad_phase;
+}
+
+/** An AABB or point query in progress */
+typedef struct {
+  aabb_t box;
+  vector_t point;
+  query_mode_t mode;
+  query_filter_t filter;
+  void *aux;
+  list_t *hits;
+  size_t count;
+} body_query_t;
+
+/** Whether a query should consider a body it found */
+bool query_accepts(query_filter_t filter, void *aux, body_t *body) {
+  return !body_is_removed(body) && (filter == NULL || filter(body, aux));
+}
+
+/** Records a body a query found, and returns whether to keep searching */
+bool query_hit(body_query_t *query, body_t *body) {
+  query->count++;
+  if (query->hits != NULL) {
+    list_add(query->hits, body);
+  }
+  return query->mode == QUERY_ALL_HITS;
+}
+
+bool visit_aabb_query(body_t *body, void *aux) {
+  body_query_t *query = aux;
+  if (!query_accepts(query->filter, query->aux, body) ||
+      !aabb_overlap(body_get_bounds(body), query->box)) {
+    return true;
+  }
+  arena_t *arena = frame_arena();
+  arena_mark_t mark = arena_mark(arena);
+  bool overlaps =
+      polygon_overlaps_aabb(body_get_shape_arena(body, arena), query->box);
+  arena_rewind(arena, mark);
+  return overlaps ? query_hit(query, body) : true;
+}
+
+bool visit_point_query(body_t *body, void *aux) {
+  body_query_t *query = aux;
+  if (!query_accepts(query->filter, query->aux, body) ||
+      !aabb_contains_point(body_get_bounds(body), query->point)) {
+    return true;
+  }
+  arena_t *arena = frame_arena();
+  arena_mark_t mark = arena_mark(arena);
+  bool contains =
+      polygon_contains(body_get_shape_arena(body, arena), query->point);
+  arena_rewind(arena, mark);
+  return contains ? query_hit(query, body) : true;
+}
+
+size_t scene_query_aabb(scene_t *scene, aabb_t box, query_mode_t mode,
+                        query_filter_t filter, void *aux, list_t *hits) {
+  body_query_t query = {.box = box, .mode = mode, .filter = filter,
+                        .aux = aux, .hits = hits, .count = 0};
+  broad_phase_query(scene_query_phase(scene), box, visit_aabb_query, &query);
+  return query.count;
+}
+
+size_t scene_query_point(scene_t *scene, vector_t point, query_mode_t mode,
+                         query_filter_t filter, void *aux, list_t *hits) {
+  body_query_t query = {.box = {point, point}, .point = point, .mode = mode,
+                        .filter = filter, .aux = aux, .hits = hits,
+                        .count = 0};
+  broad_phase_query(scene_query_phase(scene), query.box, visit_point_query,
+                    &query);
+  return query.count;
+}
+
+/** A raycast in progress */
+typedef struct {
+  vector_t origin;
+  vector_t end;
+  query_filter_t filter;
+  void *aux;
+  /** The nearest hits so far, nearest first */
+  raycast_hit_t *hits;
+  size_t max_hits;
+  size_t count;
+} scene_raycast_t;
+
+double visit_raycast(body_t *body, double max_fraction, void *aux) {
+  scene_raycast_t *ray = aux;
+  if (!query_accepts(ray->filter, ray->aux, body)) {
+    return max_fraction;
+  }
+  arena_t *arena = frame_arena();
+  arena_mark_t mark = arena_mark(arena);
+  list_t *shape = body_get_shape_arena(body, arena);
+  raycast_hit_t hit = {.body = body};
+  bool crossed = !polygon_contains(shape, ray->origin) &&
+                 polygon_raycast(shape, ray->origin, ray->end, &hit.fraction,
+                                 &hit.normal);
+  arena_rewind(arena, mark);
+  if (!crossed || hit.fraction > max_fraction) {
+    return max_fraction;
+  }
+  vector_t delta = vec_subtract(ray->end, ray->origin);
+  hit.point = vec_add(ray->origin, vec_multiply(hit.fraction, delta));
+
+  // Insert the hit in order, dropping the farthest one if there is no room
+  if (ray->count == ray->max_hits) {
+    if (ray->hits[ray->count - 1].fraction <= hit.fraction) {
+      return max_fraction;
+    }
+    ray->count--;
+  }
+  size_t i = ray->count++;
+  for (; i > 0 && ray->hits[i - 1].fraction > hit.fraction; i--) {
+    ray->hits[i] = ray->hits[i - 1];
+  }
+  ray->hits[i] = hit;
+  // Once there is no room left, only nearer hits matter
+  return ray->count == ray->max_hits ? ray->hits[ray->count - 1].fraction
+                                     : max_fraction;
+}
+
+size_t scene_raycast(scene_t *scene, vector_t origin, vector_t end,
+                     query_mode_t mode, query_filter_t filter, void *aux,
+                     raycast_hit_t *hits, size_t max_hits) {
+  assert(max_hits > 0);
+  scene_raycast_t ray = {.origin = origin, .end = end, .filter = filter,
+                         .aux = aux, .hits = hits, .count = 0,
+                         .max_hits = mode == QUERY_FIRST_HIT ? 1 : max_hits};
+  broad_phase_raycast(scene_query_phase(scene), origin, end, visit_raycast,
+                      &ray);
+  return ray.count;
+}
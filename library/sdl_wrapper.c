@@ -1,5 +1,9 @@
 #include "sdl_wrapper.h"
+#include "arena.h"
+#include "asset_pack.h"
 #include "body.h"
+#include "profiler.h"
+#include "render_snapshot.h"
 #include "state.h"
 #include "text.h"
 #include <SDL2/SDL2_gfxPrimitives.h>
@@ -7,14 +11,27 @@
 #include <SDL2/SDL_ttf.h>
 #include <assert.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 const char WINDOW_TITLE[] = "CS 3";
 const int WINDOW_WIDTH = 1000;
 const int WINDOW_HEIGHT = 500;
 const double MS_PER_S = 1e3;
+/** The most distinct body images the render thread caches textures for */
+#define MAX_TEXTURES 32
+/** The most fonts sdl_draw_glyphs() keeps glyphs for */
+#define MAX_GLYPH_FONTS 4
+/** sdl_draw_glyphs() caches the printable ASCII characters */
+#define FIRST_GLYPH ' '
+#define GLYPH_COUNT ('~' - FIRST_GLYPH + 1)
+/** How long the render thread sleeps when no new frame has been published */
+const uint32_t RENDER_IDLE_MS = 1;
+/** The render thread's scratch arena only holds one polygon at a time */
+const size_t RENDER_ARENA_SIZE = 4096;
 
 /**
  * The coordinate at the center of the screen.
@@ -47,18 +64,79 @@ uint32_t key_start_timestamp;
  */
 clock_t last_clock = 0;
 
-SDL_Texture *img = NULL;
+/**
+ * The in-memory surface frames are drawn into when rendering offscreen,
+ * or NULL when rendering to a window.
+ */
+SDL_Surface *frame_surface = NULL;
+/**
+ * The snapshots shared with the render thread, or NULL when drawing directly.
+ * While this is set, the drawing functions record into a snapshot on the
+ * calling thread and only the render thread touches the renderer.
+ */
+render_buffer_t *render_buffer = NULL;
+/**
+ * The snapshot being recorded since the last sdl_clear(),
+ * or NULL if the render thread is still drawing it and this frame is skipped.
+ */
+render_snapshot_t *recording = NULL;
+/**
+ * The render thread, and whether it should keep running.
+ */
+SDL_Thread *render_thread = NULL;
+SDL_atomic_t render_running;
+/**
+ * The render thread's scratch memory, since the frame arena belongs to
+ * the simulation thread.
+ */
+arena_t *render_arena = NULL;
+/**
+ * The image paths seen so far; a path's index is its texture id.
+ * Only the simulation thread reads or writes these.
+ */
+const char *texture_paths[MAX_TEXTURES];
+size_t texture_count = 0;
+/**
+ * The renderer's textures, indexed by texture id,
+ * or NULL for ones it has not loaded yet.
+ */
+SDL_Texture *texture_cache[MAX_TEXTURES];
+/**
+ * Images decoded by an asset loader, indexed by texture id,
+ * or NULL for images the renderer should load itself.
+ */
+asset_t *texture_assets[MAX_TEXTURES];
+
+/**
+ * One font's glyphs, rendered in white so any color can be applied
+ * with a color mod. Only the thread that owns the renderer uses these.
+ */
+typedef struct {
+  TTF_Font *font;
+  /** NULL for glyphs with nothing to draw, e.g. ' ' */
+  SDL_Texture *glyphs[GLYPH_COUNT];
+  int advances[GLYPH_COUNT];
+} glyph_cache_t;
+glyph_cache_t glyph_caches[MAX_GLYPH_FONTS];
+size_t glyph_cache_count = 0;
+
+/**
+ * Gets the size of the window (or offscreen frame) in pixels.
+ * Only the thread that owns the window may call this; the render thread
+ * reads the size recorded in each snapshot instead.
+ */
+vector_t get_window_size(void) {
+  if (frame_surface != NULL) {
+    return (vector_t){.x = frame_surface->w, .y = frame_surface->h};
+  }
+  int width, height;
+  SDL_GetWindowSize(window, &width, &height);
+  return (vector_t){.x = width, .y = height};
+}
 
 /** Computes the center of the window in pixel coordinates */
 vector_t get_window_center(void) {
-  int *width = malloc(sizeof(*width)), *height = malloc(sizeof(*height));
-  assert(width != NULL);
-  assert(height != NULL);
-  SDL_GetWindowSize(window, width, height);
-  vector_t dimensions = {.x = *width, .y = *height};
-  free(width);
-  free(height);
-  return vec_multiply(0.5, dimensions);
+  return vec_multiply(0.5, get_window_size());
 }
 
 /**
@@ -128,6 +206,303 @@ char get_keycode(SDL_Keycode key) {
   }
 }
 
+/**
+ * Draws a filled polygon from an array of scene-coordinate vertices, in a
+ * window with the given center. The pixel coordinates are scratch space in
+ * the given arena, which belongs to the calling thread.
+ */
+void draw_vertices(arena_t *arena, const vector_t *vertices, size_t n,
+                   rgb_color_t color, vector_t window_center) {
+  arena_mark_t mark = arena_mark(arena);
+  int16_t *x_points = arena_alloc(arena, sizeof(*x_points) * n),
+          *y_points = arena_alloc(arena, sizeof(*y_points) * n);
+  for (size_t i = 0; i < n; i++) {
+    vector_t pixel = get_window_position(vertices[i], window_center);
+    x_points[i] = pixel.x;
+    y_points[i] = pixel.y;
+  }
+  filledPolygonRGBA(renderer, x_points, y_points, n, color.r * 255,
+                    color.g * 255, color.b * 255, 255);
+  arena_rewind(arena, mark);
+}
+
+/**
+ * Draws a body's image at its position and rotation.
+ */
+void draw_texture(SDL_Texture *texture, vector_t centroid, double rotation,
+                  vector_t window_center) {
+  double angle = rotation * -(180 / M_PI); // set the angle.
+  SDL_RendererFlip flip = SDL_FLIP_NONE;   // the flip of the texture.
+  SDL_Rect texr;
+  vector_t coord = {centroid.x - 40, centroid.y + 50};
+  SDL_Point center = {16, 20};
+  vector_t pixel = get_window_position(coord, window_center);
+  texr.x = pixel.x;
+  texr.y = pixel.y;
+  texr.w = 40;
+  texr.h = 40;
+  SDL_RenderCopyEx(renderer, texture, NULL, &texr, angle, &center, flip);
+}
+
+/**
+ * Draws a line of text with its top left corner at loc.
+ * Returns the texture it created, which the caller must destroy.
+ */
+SDL_Texture *draw_text(TTF_Font *font, const char *words, SDL_Color color,
+                       vector_t loc, vector_t window_center) {
+  SDL_Surface *surfaceMessage = TTF_RenderText_Solid(font, words, color);
+  SDL_Texture *Message = SDL_CreateTextureFromSurface(renderer, surfaceMessage);
+
+  // scale from vector_t to pixel
+  vector_t coords = get_window_position(loc, window_center);
+
+  SDL_Rect Message_rect;              // create a rect
+  Message_rect.x = coords.x;          // controls the rect's x coordinate
+  Message_rect.y = coords.y;          // controls the rect's y coordinte
+  Message_rect.w = surfaceMessage->w; // controls the width of the rect
+  Message_rect.h = surfaceMessage->h; // controls the height of the rect
+
+  SDL_RenderCopy(renderer, Message, NULL, &Message_rect);
+
+  SDL_FreeSurface(surfaceMessage);
+
+  return Message;
+}
+
+/**
+ * Gets the glyphs for a font, rendering them all the first time.
+ * Must be called on the thread that owns the renderer.
+ */
+glyph_cache_t *get_glyph_cache(TTF_Font *font) {
+  for (size_t i = 0; i < glyph_cache_count; i++) {
+    if (glyph_caches[i].font == font) {
+      return &glyph_caches[i];
+    }
+  }
+  assert(glyph_cache_count < MAX_GLYPH_FONTS);
+  glyph_cache_t *cache = &glyph_caches[glyph_cache_count++];
+  cache->font = font;
+  SDL_Color white = {255, 255, 255, 255};
+  for (size_t i = 0; i < GLYPH_COUNT; i++) {
+    uint16_t glyph = FIRST_GLYPH + i;
+    TTF_GlyphMetrics(font, glyph, NULL, NULL, NULL, NULL, &cache->advances[i]);
+    SDL_Surface *surface = TTF_RenderGlyph_Blended(font, glyph, white);
+    cache->glyphs[i] = NULL;
+    if (surface != NULL) {
+      cache->glyphs[i] = SDL_CreateTextureFromSurface(renderer, surface);
+      SDL_FreeSurface(surface);
+    }
+  }
+  return cache;
+}
+
+/** Destroys every cached glyph, before the renderer is destroyed */
+void free_glyph_caches(void) {
+  for (size_t i = 0; i < glyph_cache_count; i++) {
+    for (size_t j = 0; j < GLYPH_COUNT; j++) {
+      if (glyph_caches[i].glyphs[j] != NULL) {
+        SDL_DestroyTexture(glyph_caches[i].glyphs[j]);
+      }
+    }
+  }
+  glyph_cache_count = 0;
+}
+
+/**
+ * Draws a line of text with its top left corner at loc, one cached glyph
+ * at a time, so no surface or texture is created once the font's glyphs are.
+ * Characters outside printable ASCII are drawn as '?'.
+ */
+void draw_glyphs(TTF_Font *font, const char *words, SDL_Color color,
+                 vector_t loc, vector_t window_center) {
+  glyph_cache_t *cache = get_glyph_cache(font);
+  vector_t pixel = get_window_position(loc, window_center);
+  SDL_Rect rect = {.x = pixel.x, .y = pixel.y};
+  for (const char *c = words; *c != '\0'; c++) {
+    size_t index = *c >= FIRST_GLYPH && *c <= '~' ? *c - FIRST_GLYPH
+                                                  : '?' - FIRST_GLYPH;
+    SDL_Texture *glyph = cache->glyphs[index];
+    if (glyph != NULL) {
+      SDL_QueryTexture(glyph, NULL, NULL, &rect.w, &rect.h);
+      SDL_SetTextureColorMod(glyph, color.r, color.g, color.b);
+      SDL_SetTextureAlphaMod(glyph, color.a);
+      SDL_RenderCopy(renderer, glyph, NULL, &rect);
+    }
+    rect.x += cache->advances[index];
+  }
+}
+
+/** Draws the boundary lines of the scene */
+void draw_boundary(vector_t window_center) {
+  vector_t max = vec_add(center, max_diff),
+           min = vec_subtract(center, max_diff);
+  vector_t max_pixel = get_window_position(max, window_center),
+           min_pixel = get_window_position(min, window_center);
+  SDL_Rect boundary = {.x = min_pixel.x,
+                       .y = max_pixel.y,
+                       .w = max_pixel.x - min_pixel.x,
+                       .h = min_pixel.y - max_pixel.y};
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+  SDL_RenderDrawRect(renderer, &boundary);
+}
+
+/**
+ * Gets the texture for an image, creating it the first time.
+ * Images registered with sdl_register_image() are only uploaded here;
+ * others are read and decoded too.
+ * Must be called on the thread that owns the renderer.
+ *
+ * @param wait whether to wait for a registered image that is still being
+ *   decoded, or return NULL
+ */
+SDL_Texture *get_texture(size_t texture_id, const char *image_path,
+                         bool wait) {
+  if (texture_cache[texture_id] != NULL) {
+    return texture_cache[texture_id];
+  }
+  asset_t *image = texture_assets[texture_id];
+  if (image == NULL) {
+    texture_cache[texture_id] =
+        IMG_LoadTexture_RW(renderer, asset_open(image_path), 1);
+  } else if (wait || asset_ready(image)) {
+    SDL_Surface *surface = asset_surface(image);
+    if (surface != NULL) {
+      texture_cache[texture_id] =
+          SDL_CreateTextureFromSurface(renderer, surface);
+    }
+  }
+  return texture_cache[texture_id];
+}
+
+/**
+ * Draws every item of a snapshot, in the order they were recorded, for the
+ * window size recorded with it
+ */
+void draw_snapshot(render_snapshot_t *snapshot, arena_t *arena) {
+  PROFILE_SCOPE("draw snapshot");
+  vector_t window_center =
+      vec_multiply(0.5, render_snapshot_window_size(snapshot));
+  SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+  SDL_RenderClear(renderer);
+  size_t item_count = render_snapshot_size(snapshot);
+  for (size_t i = 0; i < item_count; i++) {
+    const render_item_t *item = render_snapshot_get(snapshot, i);
+    switch (item->kind) {
+    case RENDER_POLYGON:
+      draw_vertices(arena, render_snapshot_vertices(snapshot, item),
+                    item->vertex_count, item->color, window_center);
+      break;
+    case RENDER_TEXTURE: {
+      // Don't hold up the frame for an image that is still being decoded
+      SDL_Texture *texture =
+          get_texture(item->texture_id, item->image_path, false);
+      if (texture != NULL) {
+        draw_texture(texture, item->centroid, item->rotation, window_center);
+      }
+      break;
+    }
+    case RENDER_TEXT:
+      PROFILE_BEGIN("text");
+      SDL_DestroyTexture(draw_text(
+          text_get_font(item->font), render_snapshot_text(snapshot, item),
+          item->text_color, item->loc, window_center));
+      PROFILE_END();
+      break;
+    case RENDER_GLYPHS:
+      draw_glyphs(text_get_font(item->font),
+                  render_snapshot_text(snapshot, item), item->text_color,
+                  item->loc, window_center);
+      break;
+    }
+  }
+  draw_boundary(window_center);
+}
+
+/**
+ * The render thread's loop: draws and presents each newly published snapshot
+ * until render_running is cleared.
+ * The renderer is created here, since it may only be used on one thread.
+ */
+int render_thread_main(void *data) {
+  PROFILE_THREAD("render");
+  renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+  assert(renderer != NULL);
+  render_arena = arena_init(RENDER_ARENA_SIZE);
+  while (SDL_AtomicGet(&render_running)) {
+    render_snapshot_t *snapshot = render_buffer_acquire(render_buffer);
+    if (snapshot == NULL) {
+      SDL_Delay(RENDER_IDLE_MS);
+      continue;
+    }
+    draw_snapshot(snapshot, render_arena);
+    // The draw calls are queued in the renderer now, so the simulation can
+    // start overwriting the snapshot while we wait for vsync
+    render_buffer_release(render_buffer);
+    PROFILE_BEGIN("present");
+    SDL_RenderPresent(renderer);
+    PROFILE_END();
+  }
+  for (size_t i = 0; i < MAX_TEXTURES; i++) {
+    if (texture_cache[i] != NULL) {
+      SDL_DestroyTexture(texture_cache[i]);
+      texture_cache[i] = NULL;
+    }
+  }
+  free_glyph_caches();
+  SDL_DestroyRenderer(renderer);
+  renderer = NULL;
+  arena_free(render_arena);
+  render_arena = NULL;
+  return 0;
+}
+
+/**
+ * Stops and joins the render thread. Registered with atexit(),
+ * since the demos exit from inside their main loop.
+ * Set the RENDER_STATS environment variable to print the frame counts.
+ */
+void render_thread_stop(void) {
+  SDL_AtomicSet(&render_running, 0);
+  SDL_WaitThread(render_thread, NULL);
+  render_thread = NULL;
+  if (getenv("RENDER_STATS") != NULL) {
+    render_stats_t stats = render_buffer_stats(render_buffer);
+    fprintf(stderr, "frames published %zu, rendered %zu, dropped %zu\n",
+            stats.published, stats.rendered, stats.dropped);
+  }
+  render_buffer_free(render_buffer);
+  render_buffer = NULL;
+  recording = NULL;
+}
+
+/** Starts the render thread and switches the drawing functions to record */
+void render_thread_start(void) {
+  render_buffer = render_buffer_init();
+  SDL_AtomicSet(&render_running, 1);
+  render_thread = SDL_CreateThread(render_thread_main, "render", NULL);
+  assert(render_thread != NULL);
+  atexit(render_thread_stop);
+}
+
+/**
+ * Gets the texture id for an image path, assigning the next unused id
+ * the first time a path is seen.
+ */
+size_t get_texture_id(const char *image_path) {
+  for (size_t i = 0; i < texture_count; i++) {
+    if (strcmp(texture_paths[i], image_path) == 0) {
+      return i;
+    }
+  }
+  assert(texture_count < MAX_TEXTURES);
+  texture_paths[texture_count] = image_path;
+  return texture_count++;
+}
+
+void sdl_register_image(const char *image_path, asset_t *image) {
+  texture_assets[get_texture_id(image_path)] = image;
+}
+
 void sdl_init(vector_t min, vector_t max) {
   // Check parameters
   assert(min.x < max.x);
@@ -139,17 +514,141 @@ void sdl_init(vector_t min, vector_t max) {
   window = SDL_CreateWindow(WINDOW_TITLE, SDL_WINDOWPOS_CENTERED,
                             SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT,
                             SDL_WINDOW_RESIZABLE);
+  TTF_Init();
+#if !defined(__EMSCRIPTEN__) && !defined(NO_RENDER_THREAD)
+  render_thread_start();
+#else
   renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+#endif
+}
+
+void sdl_init_offscreen(vector_t min, vector_t max, int width, int height) {
+  // Check parameters
+  assert(min.x < max.x);
+  assert(min.y < max.y);
+  assert(width > 0 && height > 0);
+
+  center = vec_multiply(0.5, vec_add(min, max));
+  max_diff = vec_subtract(max, center);
+  // No subsystems are needed; the software renderer draws straight to memory
+  SDL_Init(0);
+  window = NULL;
+  frame_surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32,
+                                                 SDL_PIXELFORMAT_RGBA32);
+  assert(frame_surface != NULL);
+  renderer = SDL_CreateSoftwareRenderer(frame_surface);
+  assert(renderer != NULL);
   TTF_Init();
 }
 
+bool sdl_is_offscreen(void) { return frame_surface != NULL; }
+
+/** Returns whether a path ends with the given extension, e.g. ".png" */
+bool has_extension(const char *path, const char *extension) {
+  size_t path_length = strlen(path), extension_length = strlen(extension);
+  return path_length >= extension_length &&
+         strcmp(path + path_length - extension_length, extension) == 0;
+}
+
+bool sdl_dump_frame(const char *path) {
+  assert(frame_surface != NULL);
+  if (has_extension(path, ".png")) {
+    return IMG_SavePNG(frame_surface, path) == 0;
+  }
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  // Binary PPM: a short text header followed by packed RGB triples
+  fprintf(file, "P6\n%d %d\n255\n", frame_surface->w, frame_surface->h);
+  for (int y = 0; y < frame_surface->h; y++) {
+    uint8_t *row = (uint8_t *)frame_surface->pixels + y * frame_surface->pitch;
+    for (int x = 0; x < frame_surface->w; x++) {
+      // RGBA32 stores the bytes of each pixel in R, G, B, A order
+      fwrite(row + 4 * x, 1, 3, file);
+    }
+  }
+  bool written = !ferror(file);
+  fclose(file);
+  return written;
+}
+
+/**
+ * Reads the next unsigned integer from a PPM header,
+ * skipping whitespace and '#' comments before it.
+ * Returns -1 if the header is malformed.
+ */
+int read_ppm_header_value(FILE *file) {
+  int c = fgetc(file);
+  while (c == '#' || (c != EOF && strchr(" \t\r\n", c) != NULL)) {
+    if (c == '#') {
+      while (c != '\n' && c != EOF) {
+        c = fgetc(file);
+      }
+    }
+    c = fgetc(file);
+  }
+  int value = 0;
+  if (c < '0' || c > '9') {
+    return -1;
+  }
+  while (c >= '0' && c <= '9') {
+    value = value * 10 + (c - '0');
+    c = fgetc(file);
+  }
+  // The single whitespace character after the value has now been consumed
+  return value;
+}
+
+size_t sdl_frame_diff(const char *golden_path, int tolerance) {
+  assert(frame_surface != NULL);
+  FILE *file = fopen(golden_path, "rb");
+  if (file == NULL) {
+    return SIZE_MAX;
+  }
+  char magic[2];
+  if (fread(magic, 1, 2, file) != 2 || magic[0] != 'P' || magic[1] != '6') {
+    fclose(file);
+    return SIZE_MAX;
+  }
+  int width = read_ppm_header_value(file);
+  int height = read_ppm_header_value(file);
+  int max_value = read_ppm_header_value(file);
+  if (width != frame_surface->w || height != frame_surface->h ||
+      max_value != 255) {
+    fclose(file);
+    return SIZE_MAX;
+  }
+
+  size_t differing = 0;
+  uint8_t golden[3];
+  for (int y = 0; y < height; y++) {
+    uint8_t *row = (uint8_t *)frame_surface->pixels + y * frame_surface->pitch;
+    for (int x = 0; x < width; x++) {
+      if (fread(golden, 1, 3, file) != 3) {
+        fclose(file);
+        return SIZE_MAX;
+      }
+      for (size_t channel = 0; channel < 3; channel++) {
+        if (abs(row[4 * x + channel] - golden[channel]) > tolerance) {
+          differing++;
+          break;
+        }
+      }
+    }
+  }
+  fclose(file);
+  return differing;
+}
+
 bool sdl_is_done(state_t *state) {
-  SDL_Event *event = malloc(sizeof(*event));
-  assert(event != NULL);
+  PROFILE_SCOPE("events");
+  SDL_Event event_storage;
+  SDL_Event *event = &event_storage;
   while (SDL_PollEvent(event)) {
     switch (event->type) {
     case SDL_QUIT:
-      free(event);
       return true;
     case SDL_KEYDOWN:
     case SDL_KEYUP:
@@ -202,35 +701,38 @@ bool sdl_is_done(state_t *state) {
       break;
     }
   }
-  free(event);
   return false;
 }
 
 SDL_Texture *sdl_load_text(state_t *state, char *words, text_t *text,
                            SDL_Color color, vector_t loc) {
-  TTF_Font *font = text_get_font(text);
-
-  SDL_Surface *surfaceMessage = TTF_RenderText_Solid(font, words, color);
-  SDL_Texture *Message = SDL_CreateTextureFromSurface(renderer, surfaceMessage);
-
-  // scale from vector_t to pixel
-  vector_t window_center = get_window_center();
-  vector_t coords = get_window_position(loc, window_center);
-
-  SDL_Rect Message_rect;              // create a rect
-  Message_rect.x = coords.x;          // controls the rect's x coordinate
-  Message_rect.y = coords.y;          // controls the rect's y coordinte
-  Message_rect.w = surfaceMessage->w; // controls the width of the rect
-  Message_rect.h = surfaceMessage->h; // controls the height of the rect
-
-  SDL_RenderCopy(renderer, Message, NULL, &Message_rect);
-
-  SDL_FreeSurface(surfaceMessage);
+  PROFILE_SCOPE("text");
+  if (render_buffer != NULL) {
+    if (recording != NULL) {
+      render_snapshot_add_text(recording, text, words, color, loc);
+    }
+    return NULL;
+  }
+  return draw_text(text_get_font(text), words, color, loc,
+                   get_window_center());
+}
 
-  return Message;
+void sdl_draw_glyphs(text_t *text, const char *words, SDL_Color color,
+                     vector_t loc) {
+  if (render_buffer != NULL) {
+    if (recording != NULL) {
+      render_snapshot_add_glyphs(recording, text, words, color, loc);
+    }
+    return;
+  }
+  draw_glyphs(text_get_font(text), words, color, loc, get_window_center());
 }
 
 void sdl_clear(void) {
+  if (render_buffer != NULL) {
+    recording = render_buffer_begin_write(render_buffer);
+    return;
+  }
   SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
   SDL_RenderClear(renderer);
 }
@@ -243,78 +745,78 @@ void sdl_draw_polygon(list_t *points, rgb_color_t color) {
   assert(0 <= color.g && color.g <= 1);
   assert(0 <= color.b && color.b <= 1);
 
-  vector_t window_center = get_window_center();
+  if (render_buffer != NULL) {
+    if (recording != NULL) {
+      render_snapshot_add_polygon(recording, points, color);
+    }
+    return;
+  }
 
-  // Convert each vertex to a point on screen
-  int16_t *x_points = malloc(sizeof(*x_points) * n),
-          *y_points = malloc(sizeof(*y_points) * n);
-  assert(x_points != NULL);
-  assert(y_points != NULL);
+  // Gather the vertices into an array, then draw them like the render thread
+  arena_t *arena = frame_arena();
+  arena_mark_t mark = arena_mark(arena);
+  vector_t *vertices = arena_alloc(arena, sizeof(*vertices) * n);
   for (size_t i = 0; i < n; i++) {
-    vector_t *vertex = list_get(points, i);
-    vector_t pixel = get_window_position(*vertex, window_center);
-    x_points[i] = pixel.x;
-    y_points[i] = pixel.y;
+    vertices[i] = *(vector_t *)list_get(points, i);
   }
-
-  // Draw polygon with the given color
-  filledPolygonRGBA(renderer, x_points, y_points, n, color.r * 255,
-                    color.g * 255, color.b * 255, 255);
-  free(x_points);
-  free(y_points);
+  draw_vertices(arena, vertices, n, color, get_window_center());
+  arena_rewind(arena, mark);
 }
 
 void sdl_show(void) {
-  // Draw boundary lines
-  vector_t window_center = get_window_center();
-  vector_t max = vec_add(center, max_diff),
-           min = vec_subtract(center, max_diff);
-  vector_t max_pixel = get_window_position(max, window_center),
-           min_pixel = get_window_position(min, window_center);
-  SDL_Rect *boundary = malloc(sizeof(*boundary));
-  boundary->x = min_pixel.x;
-  boundary->y = max_pixel.y;
-  boundary->w = max_pixel.x - min_pixel.x;
-  boundary->h = min_pixel.y - max_pixel.y;
-  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-  SDL_RenderDrawRect(renderer, boundary);
-  free(boundary);
-
+  PROFILE_SCOPE("present");
+  if (render_buffer != NULL) {
+    // The render thread draws the boundary and presents the frame, at the
+    // size the window is now, since it may not ask the window itself
+    if (recording != NULL) {
+      render_snapshot_set_window_size(recording, get_window_size());
+    }
+    render_buffer_publish(render_buffer);
+    recording = NULL;
+    return;
+  }
+  draw_boundary(get_window_center());
   SDL_RenderPresent(renderer);
 }
 
-void sdl_render_scene(scene_t *scene) {
-  sdl_clear();
+void sdl_draw_scene(scene_t *scene) {
+  PROFILE_SCOPE("draw scene");
   size_t body_count = scene_bodies(scene);
-  int *w = malloc(sizeof(int));
-  int *h = malloc(sizeof(int));
   for (size_t i = 0; i < body_count; i++) {
     body_t *body = scene_get_body(scene, i);
-    list_t *shape = body_get_shape(body);
-    if (body_get_image_path(body) == NULL) {
+    char *image_path = body_get_image_path(body);
+    if (image_path == NULL) {
+      list_t *shape = body_get_shape_arena(body, frame_arena());
       sdl_draw_polygon(shape, body_get_color(body));
+    } else if (render_buffer != NULL) {
+      if (recording != NULL) {
+        render_snapshot_add_texture(recording, get_texture_id(image_path),
+                                    image_path, body_get_centroid(body),
+                                    body_get_rotation(body));
+      }
     } else {
-      img = IMG_LoadTexture(renderer, body_get_image_path(body));
-      double angle = body_get_rotation(body) * -(180 / M_PI); // set the angle.
-      SDL_RendererFlip flip = SDL_FLIP_NONE; // the flip of the texture.
-      SDL_QueryTexture(img, NULL, NULL, w, h);
-      SDL_Rect texr;
-      vector_t window_center = get_window_center();
-      vector_t coord = {body_get_centroid(body).x - 40,
-                        body_get_centroid(body).y + 50};
-      SDL_Point center = {16, 20};
-      vector_t pixel = get_window_position(coord, window_center);
-      texr.x = pixel.x;
-      texr.y = pixel.y;
-      texr.w = 40;
-      texr.h = 40;
-      SDL_RenderCopyEx(renderer, img, NULL, &texr, angle, &center, flip);
+      SDL_Texture *texture =
+          get_texture(get_texture_id(image_path), image_path, true);
+      draw_texture(texture, body_get_centroid(body), body_get_rotation(body),
+                   get_window_center());
     }
-    list_free(shape);
   }
+}
+
+void sdl_render_scene(scene_t *scene) {
+  PROFILE_SCOPE("sdl_render_scene");
+  sdl_clear();
+  sdl_draw_scene(scene);
   sdl_show();
 }
 
+render_stats_t sdl_render_stats(void) {
+  if (render_buffer == NULL) {
+    return (render_stats_t){0};
+  }
+  return render_buffer_stats(render_buffer);
+}
+
 void sdl_on_key(key_handler_t handler) { key_handler = handler; }
 
 double time_since_last_tick(void) {
@@ -0,0 +1,136 @@
+#include "slab.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * The size of every page. Pages are aligned to their size,
+ * so a record's page is found by rounding its address down.
+ */
+const size_t SLAB_PAGE_SIZE = 16 * 1024;
+const size_t SLAB_ALIGNMENT = 16;
+const size_t SLAB_MAX_RECORD = 128;
+
+/** The record sizes a slab rounds allocations up to */
+static const size_t SIZE_CLASSES[] = {16, 32, 48, 64, 96, 128};
+#define CLASS_COUNT (sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0]))
+
+/** A released record, which holds the next one on its class's free list */
+typedef struct free_record {
+  struct free_record *next;
+} free_record_t;
+
+/** The start of every page; its records follow */
+typedef struct slab_page {
+  struct slab_page *next;
+  size_t size_class;
+} slab_page_t;
+
+typedef struct slab {
+  /** Every page, newest first */
+  slab_page_t *pages;
+  /** Released records of each class, ready to be reused */
+  free_record_t *free_records[CLASS_COUNT];
+  /** The next never-used record in each class's newest page, or NULL */
+  unsigned char *next_record[CLASS_COUNT];
+  /** The end of each class's newest page */
+  unsigned char *page_end[CLASS_COUNT];
+  slab_stats_t stats;
+} slab_t;
+
+size_t slab_size_class(size_t size) {
+  assert(size <= SLAB_MAX_RECORD);
+  size_t i = 0;
+  while (SIZE_CLASSES[i] < size) {
+    i++;
+  }
+  return i;
+}
+
+/** The offset of a page's first record, which keeps records aligned */
+size_t page_header_size(void) {
+  return (sizeof(slab_page_t) + SLAB_ALIGNMENT - 1) / SLAB_ALIGNMENT *
+         SLAB_ALIGNMENT;
+}
+
+void slab_add_page(slab_t *slab, size_t size_class) {
+  slab_page_t *page = aligned_alloc(SLAB_PAGE_SIZE, SLAB_PAGE_SIZE);
+  assert(page != NULL);
+  page->next = slab->pages;
+  page->size_class = size_class;
+  slab->pages = page;
+  slab->next_record[size_class] = (unsigned char *)page + page_header_size();
+  slab->page_end[size_class] = (unsigned char *)page + SLAB_PAGE_SIZE;
+  slab->stats.pages++;
+}
+
+slab_t *slab_init(void) {
+  slab_t *slab = malloc(sizeof(slab_t));
+  assert(slab != NULL);
+  slab->pages = NULL;
+  for (size_t i = 0; i < CLASS_COUNT; i++) {
+    slab->free_records[i] = NULL;
+    slab->next_record[i] = NULL;
+    slab->page_end[i] = NULL;
+  }
+  slab->stats = (slab_stats_t){0, 0, 0};
+  return slab;
+}
+
+void slab_free(slab_t *slab) {
+  slab_page_t *page = slab->pages;
+  while (page != NULL) {
+    slab_page_t *next = page->next;
+    free(page);
+    page = next;
+  }
+  free(slab);
+}
+
+void *slab_alloc(slab_t *slab, size_t size) {
+  size_t class = slab_size_class(size > 0 ? size : 1);
+  void *record;
+  if (slab->free_records[class] != NULL) {
+    free_record_t *reused = slab->free_records[class];
+    slab->free_records[class] = reused->next;
+    record = reused;
+  } else {
+    if (slab->next_record[class] == NULL ||
+        slab->page_end[class] - slab->next_record[class] <
+            (ptrdiff_t)SIZE_CLASSES[class]) {
+      slab_add_page(slab, class);
+    }
+    record = slab->next_record[class];
+    slab->next_record[class] += SIZE_CLASSES[class];
+  }
+
+  slab->stats.live++;
+  if (slab->stats.live > slab->stats.high_water) {
+    slab->stats.high_water = slab->stats.live;
+  }
+  return record;
+}
+
+void slab_release(slab_t *slab, void *record) {
+  assert(slab->stats.live > 0);
+  slab_page_t *page =
+      (slab_page_t *)((uintptr_t)record & ~(uintptr_t)(SLAB_PAGE_SIZE - 1));
+  free_record_t *released = record;
+  released->next = slab->free_records[page->size_class];
+  slab->free_records[page->size_class] = released;
+  slab->stats.live--;
+}
+
+void *slab_allocator_alloc(void *context, size_t size) {
+  return slab_alloc(context, size);
+}
+
+void slab_allocator_free(void *context, void *memory) {
+  slab_release(context, memory);
+}
+
+allocator_t slab_allocator(slab_t *slab) {
+  return (allocator_t){slab_allocator_alloc, slab_allocator_free, slab};
+}
+
+slab_stats_t slab_stats(slab_t *slab) { return slab->stats; }
@@ -0,0 +1,27 @@
+#include "body.h"
+#include "forces.h"
+#include "scene.h"
+#include <stddef.h>
+
+// The game constants the library expects from the program, for the tests
+// that link the whole library without a game
+
+// types of different bodies
+const size_t WALL_TYPE = 0;
+const size_t BULLET_TYPE = 1;
+const size_t SNIPER_BULLET_TYPE = 10;
+const size_t GRAVITY_BULLET_TYPE = 13;
+const size_t GATLING_BULLET_TYPE = 11;
+const size_t DEFAULT_TANK_TYPE = 2;
+const size_t GRAVITY_TANK_TYPE = 3;
+const size_t SNIPER_TANK_TYPE = 4;
+const size_t HEALTH_BAR_TYPE = 6;
+const size_t GATLING_TANK_TYPE = 7;
+
+const double BULLET_DAMAGE = 10.0;
+const double GRAVITY_BULLET_DAMAGE = 15.0;
+const double SNIPER_BULLET_DAMAGE = 25.0;
+const double GATLING_BULLET_DAMAGE = 5.0;
+
+const double MAX_WIDTH_GAME = 100.0;
+const double MAX_HEIGHT_GAME = 50.0;
@@ -0,0 +1,282 @@
+#include "aabb_tree.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+const rgb_color_t RED = {1, 0, 0};
+#define RANDOM_BOXES 200
+const double RANDOM_AREA = 100.0;
+
+body_t *make_box(vector_t corner, vector_t size) {
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {{0, 0}, {size.x, 0}, {size.x, size.y}, {0, size.y}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = vec_add(corner, corners[i]);
+    list_add(shape, v);
+  }
+  size_t *type = malloc(sizeof(size_t));
+  *type = BULLET_TYPE;
+  return body_init_with_info(shape, 1, RED, type, free);
+}
+
+list_t *make_random_boxes(size_t count) {
+  list_t *bodies = list_init(count, (free_func_t)body_free);
+  for (size_t i = 0; i < count; i++) {
+    vector_t corner = {rand() * RANDOM_AREA / RAND_MAX,
+                       rand() * RANDOM_AREA / RAND_MAX};
+    vector_t size = {1 + rand() * 5.0 / RAND_MAX, 1 + rand() * 5.0 / RAND_MAX};
+    list_add(bodies, make_box(corner, size));
+  }
+  return bodies;
+}
+
+bool count_body(body_t *body, void *aux) {
+  (*(size_t *)aux)++;
+  return true;
+}
+
+bool stop_at_first(body_t *body, void *aux) {
+  (*(size_t *)aux)++;
+  return false;
+}
+
+double count_ray_body(body_t *body, double max_fraction, void *aux) {
+  (*(size_t *)aux)++;
+  return max_fraction;
+}
+
+/** Shortens the ray to where it reaches each body's box, nearest first */
+double clip_ray_to_body(body_t *body, double max_fraction, void *aux) {
+  double *nearest = aux;
+  aabb_t box = body_get_bounds(body);
+  // the ray runs along y = 50 from x = 0 to x = 100
+  double fraction = fmax(box.min.x / 100, 0);
+  if (fraction < max_fraction) {
+    *nearest = fraction;
+    return fraction;
+  }
+  return max_fraction;
+}
+
+void count_pair(body_t *body1, body_t *body2, void *aux) {
+  assert(body1 != body2);
+  (*(size_t *)aux)++;
+}
+
+/** Checks that a pair from aabb_tree_pairs() has its bodies in order */
+void check_pair_order(body_t *body1, body_t *body2, void *aux) {
+  list_t *first = aux;
+  bool found = false;
+  for (size_t i = 0; i < list_size(first); i++) {
+    found |= list_get(first, i) == body1;
+  }
+  assert(found);
+}
+
+size_t count_overlaps(list_t *bodies, aabb_t box) {
+  size_t count = 0;
+  for (size_t i = 0; i < list_size(bodies); i++) {
+    count += aabb_overlap(body_get_bounds(list_get(bodies, i)), box);
+  }
+  return count;
+}
+
+size_t count_overlapping_pairs(list_t *bodies1, list_t *bodies2) {
+  size_t count = 0;
+  for (size_t i = 0; i < list_size(bodies1); i++) {
+    aabb_t box = body_get_bounds(list_get(bodies1, i));
+    if (bodies2 == NULL) {
+      for (size_t j = i + 1; j < list_size(bodies1); j++) {
+        count += aabb_overlap(box, body_get_bounds(list_get(bodies1, j)));
+      }
+    } else {
+      count += count_overlaps(bodies2, box);
+    }
+  }
+  return count;
+}
+
+void test_static_tree() {
+  srand(42);
+  list_t *bodies = make_random_boxes(RANDOM_BOXES);
+  aabb_tree_t *tree = aabb_tree_build(bodies);
+  assert(aabb_tree_size(tree) == RANDOM_BOXES);
+  // splitting in half at every level makes the shallowest tree possible
+  assert(aabb_tree_height(tree) == 9);
+
+  // a static tree's leaves fit its bodies exactly, so it finds exactly the
+  // overlapping boxes
+  for (size_t i = 0; i < 50; i++) {
+    aabb_t box = body_get_bounds(list_get(bodies, i));
+    box.max = vec_add(box.max, (vector_t){10, 10});
+    size_t found = 0;
+    aabb_tree_query(tree, box, count_body, &found);
+    assert(found == count_overlaps(bodies, box));
+  }
+  size_t pairs = 0;
+  aabb_tree_self_pairs(tree, count_pair, &pairs);
+  assert(pairs == count_overlapping_pairs(bodies, NULL));
+  aabb_tree_free(tree);
+  list_free(bodies);
+
+  list_t *none = list_init(1, NULL);
+  tree = aabb_tree_build(none);
+  assert(aabb_tree_size(tree) == 0 && aabb_tree_height(tree) == 0);
+  aabb_tree_query(tree, (aabb_t){{0, 0}, {1, 1}}, count_body, &pairs);
+  aabb_tree_free(tree);
+  list_free(none);
+}
+
+void test_tree_pairs() {
+  srand(43);
+  list_t *moving = make_random_boxes(RANDOM_BOXES);
+  list_t *walls = make_random_boxes(RANDOM_BOXES / 4);
+  aabb_tree_t *dynamic_tree = aabb_tree_init(0.0);
+  for (size_t i = 0; i < list_size(moving); i++) {
+    body_t *body = list_get(moving, i);
+    aabb_tree_insert(dynamic_tree, body, body_get_bounds(body));
+  }
+  aabb_tree_t *static_tree = aabb_tree_build(walls);
+
+  size_t pairs = 0;
+  aabb_tree_pairs(dynamic_tree, static_tree, count_pair, &pairs);
+  assert(pairs == count_overlapping_pairs(moving, walls));
+  aabb_tree_pairs(dynamic_tree, static_tree, check_pair_order, moving);
+  aabb_tree_pairs(static_tree, dynamic_tree, check_pair_order, walls);
+  pairs = 0;
+  aabb_tree_self_pairs(dynamic_tree, count_pair, &pairs);
+  assert(pairs == count_overlapping_pairs(moving, NULL));
+
+  aabb_tree_free(dynamic_tree);
+  aabb_tree_free(static_tree);
+  list_free(moving);
+  list_free(walls);
+}
+
+void test_stays_balanced() {
+  // boxes inserted in order along a line would make a list of a tree
+  // without rebalancing
+  aabb_tree_t *tree = aabb_tree_init(0.1);
+  list_t *bodies = list_init(1024, (free_func_t)body_free);
+  for (size_t i = 0; i < 1024; i++) {
+    body_t *body = make_box((vector_t){i * 2.0, 0}, (vector_t){1, 1});
+    list_add(bodies, body);
+    aabb_tree_insert(tree, body, body_get_bounds(body));
+  }
+  assert(aabb_tree_size(tree) == 1024);
+  assert(aabb_tree_height(tree) <= 20);
+  aabb_tree_free(tree);
+  list_free(bodies);
+}
+
+void test_move_and_remove() {
+  srand(44);
+  list_t *bodies = make_random_boxes(RANDOM_BOXES);
+  aabb_tree_t *tree = aabb_tree_init(0.1);
+  size_t leaves[RANDOM_BOXES];
+  for (size_t i = 0; i < RANDOM_BOXES; i++) {
+    body_t *body = list_get(bodies, i);
+    leaves[i] = aabb_tree_insert(tree, body, body_get_bounds(body));
+    assert(aabb_tree_body(tree, leaves[i]) == body);
+    assert(aabb_contains(aabb_tree_leaf_bounds(tree, leaves[i]),
+                         body_get_bounds(body)));
+  }
+
+  // a body that moves a little stays in its fattened leaf
+  body_t *body = list_get(bodies, 0);
+  aabb_t box = body_get_bounds(body);
+  vector_t nudge = {(box.max.x - box.min.x) * 0.05, 0};
+  body_set_centroid(body, vec_add(body_get_centroid(body), nudge));
+  assert(!aabb_tree_move(tree, leaves[0], body_get_bounds(body), nudge));
+
+  // bodies that move further are reinserted, stretched the way they went
+  for (size_t step = 0; step < 20; step++) {
+    for (size_t i = 0; i < RANDOM_BOXES; i++) {
+      body = list_get(bodies, i);
+      vector_t move = {i % 3 - 1.0, i % 5 - 2.0};
+      body_set_centroid(body, vec_add(body_get_centroid(body), move));
+      aabb_tree_move(tree, leaves[i], body_get_bounds(body), move);
+      assert(aabb_contains(aabb_tree_leaf_bounds(tree, leaves[i]),
+                           body_get_bounds(body)));
+    }
+  }
+  size_t pairs = 0;
+  aabb_tree_self_pairs(tree, count_pair, &pairs);
+  assert(pairs >= count_overlapping_pairs(bodies, NULL));
+
+  for (size_t i = 0; i < RANDOM_BOXES; i += 2) {
+    aabb_tree_remove(tree, leaves[i]);
+  }
+  assert(aabb_tree_size(tree) == RANDOM_BOXES / 2);
+  aabb_t everything = {{-INFINITY, -INFINITY}, {INFINITY, INFINITY}};
+  size_t found = 0;
+  aabb_tree_query(tree, everything, count_body, &found);
+  assert(found == RANDOM_BOXES / 2);
+  for (size_t i = 1; i < RANDOM_BOXES; i += 2) {
+    aabb_tree_remove(tree, leaves[i]);
+  }
+  assert(aabb_tree_size(tree) == 0 && aabb_tree_height(tree) == 0);
+  aabb_tree_free(tree);
+  list_free(bodies);
+}
+
+void test_raycast() {
+  srand(7);
+  list_t *bodies = make_random_boxes(RANDOM_BOXES);
+  aabb_tree_t *tree = aabb_tree_build(bodies);
+  vector_t origin = {0, 50}, end = {100, 50};
+  size_t expected = 0;
+  double nearest = INFINITY;
+  for (size_t i = 0; i < RANDOM_BOXES; i++) {
+    aabb_t box = body_get_bounds(list_get(bodies, i));
+    if (aabb_segment_overlap(box, origin, end, 1)) {
+      expected++;
+      nearest = fmin(nearest, box.min.x / 100);
+    }
+  }
+  assert(expected > 0);
+  size_t found = 0;
+  assert(aabb_tree_raycast(tree, origin, end, 1, count_ray_body, &found) == 1);
+  assert(found == expected);
+
+  double clipped = INFINITY;
+  assert(isclose(
+      aabb_tree_raycast(tree, origin, end, 1, clip_ray_to_body, &clipped),
+      nearest));
+  assert(isclose(clipped, nearest));
+
+  // a ray that stops short of every box visits none
+  found = 0;
+  assert(aabb_tree_raycast(tree, (vector_t){-20, -20}, (vector_t){-10, -10}, 1,
+                           count_ray_body, &found) == 1);
+  assert(found == 0);
+
+  // the visitor can stop a query after the first body
+  found = 0;
+  aabb_t everything = {{-INFINITY, -INFINITY}, {INFINITY, INFINITY}};
+  assert(!aabb_tree_query(tree, everything, stop_at_first, &found));
+  assert(found == 1);
+  aabb_tree_free(tree);
+  list_free(bodies);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_static_tree)
+  DO_TEST(test_tree_pairs)
+  DO_TEST(test_stays_balanced)
+  DO_TEST(test_move_and_remove)
+  DO_TEST(test_raycast)
+
+  puts("aabb_tree_test PASS");
+}
@@ -0,0 +1,133 @@
+#include "alloc_track.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+void test_tags() {
+  assert(alloc_tag_of_file("library/list.c") == ALLOC_LIST);
+  assert(alloc_tag_of_file("library/body_pool.c") == ALLOC_BODY);
+  assert(alloc_tag_of_file("library/slab.c") == ALLOC_FORCE);
+  assert(alloc_tag_of_file("library/collision.c") == ALLOC_COLLISION);
+  assert(alloc_tag_of_file("library/render_snapshot.c") == ALLOC_RENDER);
+  assert(alloc_tag_of_file("demo/game.c") == ALLOC_GAME);
+  assert(alloc_tag_of_file("library/map.c") == ALLOC_GAME);
+  assert(alloc_tag_of_file("library/arena.c") == ALLOC_OTHER);
+  assert(strcmp(alloc_tag_name(ALLOC_COLLISION), "collision") == 0);
+}
+
+void test_live_bytes() {
+  alloc_stats_t before = alloc_track_stats(ALLOC_BODY);
+  void *small = alloc_track_malloc(24, "library/body.c", 10);
+  void *large = alloc_track_calloc(10, 100, "library/body.c", 20);
+  alloc_stats_t during = alloc_track_stats(ALLOC_BODY);
+  assert(during.live_bytes == before.live_bytes + 24 + 1000);
+  assert(during.live_count == before.live_count + 2);
+  assert(during.total_count == before.total_count + 2);
+  assert(during.peak_bytes >= during.live_bytes);
+
+  alloc_track_free(small);
+  alloc_track_free(large);
+  alloc_stats_t after = alloc_track_stats(ALLOC_BODY);
+  assert(after.live_bytes == before.live_bytes);
+  assert(after.live_count == before.live_count);
+  assert(after.peak_bytes == during.peak_bytes);
+}
+
+void test_realloc_moves_charge() {
+  alloc_stats_t before = alloc_track_stats(ALLOC_LIST);
+  char *memory = alloc_track_realloc(NULL, 8, "library/list.c", 30);
+  for (size_t size = 16; size <= 4096; size *= 2) {
+    memory = alloc_track_realloc(memory, size, "library/list.c", 31);
+    memory[size - 1] = 'x';
+  }
+  alloc_stats_t during = alloc_track_stats(ALLOC_LIST);
+  assert(during.live_bytes == before.live_bytes + 4096);
+  assert(during.live_count == before.live_count + 1);
+  alloc_track_free(memory);
+  assert(alloc_track_stats(ALLOC_LIST).live_bytes == before.live_bytes);
+}
+
+void test_untracked_memory() {
+  alloc_stats_t before = alloc_track_stats(ALLOC_OTHER);
+  // memory from elsewhere is just freed
+  alloc_track_free(malloc(100));
+  alloc_track_free(NULL);
+  assert(alloc_track_stats(ALLOC_OTHER).live_bytes == before.live_bytes);
+}
+
+void test_many_allocations() {
+  size_t count = 5000;
+  void **allocations = malloc(count * sizeof(void *));
+  alloc_stats_t before = alloc_track_stats(ALLOC_FORCE);
+  for (size_t i = 0; i < count; i++) {
+    allocations[i] = alloc_track_malloc(i % 64 + 1, "library/forces.c", 40);
+  }
+  // free every other one, then the rest, so the table sees tombstones
+  for (size_t i = 0; i < count; i += 2) {
+    alloc_track_free(allocations[i]);
+  }
+  assert(alloc_track_stats(ALLOC_FORCE).live_count ==
+         before.live_count + count / 2);
+  for (size_t i = 1; i < count; i += 2) {
+    alloc_track_free(allocations[i]);
+  }
+  assert(alloc_track_stats(ALLOC_FORCE).live_count == before.live_count);
+  assert(alloc_track_stats(ALLOC_FORCE).live_bytes == before.live_bytes);
+  free(allocations);
+}
+
+void test_frames() {
+  // the first frame boundary ends startup, which does not count
+  alloc_track_frame();
+  for (size_t i = 0; i < 3; i++) {
+    alloc_track_free(alloc_track_malloc(8, "demo/game.c", 50));
+  }
+  alloc_track_frame();
+  alloc_stats_t stats = alloc_track_stats(ALLOC_GAME);
+  assert(stats.last_frame_count == 3);
+  assert(stats.max_frame_count == 3);
+
+  alloc_track_free(alloc_track_malloc(8, "demo/game.c", 50));
+  alloc_track_frame();
+  stats = alloc_track_stats(ALLOC_GAME);
+  assert(stats.last_frame_count == 1);
+  assert(stats.max_frame_count == 3);
+}
+
+void test_dump() {
+  void *leak = alloc_track_malloc(12345, "library/collision.c", 60);
+  FILE *out = tmpfile();
+  assert(out != NULL);
+  alloc_track_dump(out);
+  rewind(out);
+  char report[4096];
+  size_t length = fread(report, 1, sizeof(report) - 1, out);
+  report[length] = '\0';
+  fclose(out);
+  assert(strstr(report, "collision") != NULL);
+  // the line is listed with its live bytes
+  assert(strstr(report, "library/collision.c:60 (collision): 12345 bytes") !=
+         NULL);
+  alloc_track_free(leak);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_tags)
+  DO_TEST(test_live_bytes)
+  DO_TEST(test_realloc_moves_charge)
+  DO_TEST(test_untracked_memory)
+  DO_TEST(test_many_allocations)
+  DO_TEST(test_frames)
+  DO_TEST(test_dump)
+
+  puts("alloc_track_test PASS");
+}
@@ -0,0 +1,151 @@
+#include "allocator.h"
+#include "forces.h"
+#include "scene.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const rgb_color_t RED = {1, 0, 0};
+
+/** Counts the heap allocations made through it */
+typedef struct {
+  size_t allocs;
+  size_t frees;
+} counts_t;
+
+void *counting_alloc(void *context, size_t size) {
+  ((counts_t *)context)->allocs++;
+  return malloc(size);
+}
+
+void counting_free(void *context, void *memory) {
+  ((counts_t *)context)->frees++;
+  free(memory);
+}
+
+/**
+ * Makes a square body from an allocator. For an allocator that frees
+ * individually, its shape's vertices and info come from the heap, since
+ * free_func_t cannot reach the allocator; otherwise everything comes from it.
+ */
+body_t *make_square(const allocator_t *allocator, vector_t center,
+                    size_t type) {
+  const allocator_t *memory = allocator->free != NULL ? NULL : allocator;
+  list_t *shape = list_init_with_allocator(4, memory ? NULL : free, allocator);
+  vector_t corners[] = {{-1, -1}, {+1, -1}, {+1, +1}, {-1, +1}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = allocator_alloc(memory, sizeof(*v));
+    *v = vec_add(center, corners[i]);
+    list_add(shape, v);
+  }
+  size_t *info = allocator_alloc(memory, sizeof(size_t));
+  *info = type;
+  return body_init_with_allocator(shape, 1, RED, info, memory ? NULL : free,
+                                  allocator);
+}
+
+void test_list_grows() {
+  counts_t counts = {0, 0};
+  allocator_t allocator = {counting_alloc, counting_free, &counts};
+  list_t *list = list_init_with_allocator(1, free, &allocator);
+  for (size_t i = 0; i < 100; i++) {
+    list_add(list, malloc(sizeof(size_t)));
+  }
+  assert(list_size(list) == 100);
+  list_free(list);
+  // The list and its array, which was reallocated as it grew
+  assert(counts.allocs > 2);
+  assert(counts.allocs == counts.frees);
+}
+
+void test_scene_inherits_allocator() {
+  counts_t counts = {0, 0};
+  allocator_t allocator = {counting_alloc, counting_free, &counts};
+  scene_t *scene = scene_init_with_allocator(&allocator);
+  const allocator_t *scene_allocator = scene_get_allocator(scene);
+  assert(scene_allocator->context == &counts);
+  size_t scene_allocs = counts.allocs;
+  assert(scene_allocs > 0);
+
+  body_t *wall = make_square(scene_allocator, (vector_t){10, 0}, WALL_TYPE);
+  scene_add_body(scene, wall);
+  for (size_t i = 0; i < 5; i++) {
+    body_t *bullet = make_square(scene_allocator, VEC_ZERO, BULLET_TYPE);
+    body_set_velocity(bullet, (vector_t){100, 0});
+    scene_add_body(scene, bullet);
+    create_drag(scene, 1, bullet);
+    create_physics_collision(scene, 1, bullet, wall);
+  }
+  size_t allocs = counts.allocs;
+  // Only the bodies, their shape lists and their edge normals came from the
+  // scene's allocator; the force infos and storage came from its slab
+  assert(allocs == scene_allocs + 6 * 4);
+  // Each force is four records: its info, its storage, and the storage's
+  // bodies list and array. Contact manifolds are not records; they live in
+  // the scene's contact cache, outside the slab.
+  slab_stats_t records = scene_record_stats(scene);
+  assert(records.live == 5 * 2 * 4);
+  assert(records.pages > 0);
+
+  // So a tick with a bullet touching the wall adds no records
+  body_set_centroid(scene_get_body(scene, 1), (vector_t){10, 0});
+  scene_tick(scene, 0.01);
+  assert(scene_contacts(scene) > 0);
+  assert(scene_record_stats(scene).live == records.live);
+  allocs = counts.allocs;
+
+  // Removing a body frees it through the allocator,
+  // and keeps its forces to be reused
+  body_remove(scene_get_body(scene, 1));
+  scene_tick(scene, 0.01);
+  assert(counts.frees > 0);
+  create_drag(scene, 1, scene_get_body(scene, 1));
+  assert(counts.allocs == allocs);
+
+  scene_free(scene);
+  assert(counts.allocs == counts.frees);
+}
+
+void test_arena_scene() {
+  arena_t *arena = arena_init(4096);
+  allocator_t allocator = arena_allocator(arena);
+  for (size_t match = 0; match < 3; match++) {
+    scene_t *scene = scene_init_with_allocator(&allocator);
+    const allocator_t *scene_allocator = scene_get_allocator(scene);
+    body_t *wall = make_square(scene_allocator, (vector_t){5, 0}, WALL_TYPE);
+    scene_add_body(scene, wall);
+    for (size_t i = 0; i < 10; i++) {
+      body_t *bullet = make_square(scene_allocator, VEC_ZERO, BULLET_TYPE);
+      scene_add_body(scene, bullet);
+      create_physics_collision(scene, 1, bullet, wall);
+    }
+    body_remove(scene_get_body(scene, 1));
+    scene_tick(scene, 0.01);
+    assert(scene_bodies(scene) == 10);
+
+    // Tearing the match down is a reset, not a walk over the scene
+    scene_free(scene);
+    arena_reset(arena);
+  }
+  // Every match fit in the memory reserved for the first
+  arena_stats_t stats = arena_stats(arena);
+  assert(stats.capacity < 2 * stats.high_water);
+  arena_free(arena);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_list_grows)
+  DO_TEST(test_scene_inherits_allocator)
+  DO_TEST(test_arena_scene)
+
+  puts("allocator_test PASS");
+}
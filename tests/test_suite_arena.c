@@ -0,0 +1,113 @@
+#include "arena.h"
+#include "list.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+const size_t BLOCK_SIZE = 256;
+
+void test_alignment() {
+  arena_t *arena = arena_init(BLOCK_SIZE);
+  for (size_t size = 1; size < 40; size++) {
+    void *memory = arena_alloc(arena, size);
+    assert((uintptr_t)memory % 16 == 0);
+    memset(memory, 1, size);
+  }
+  arena_free(arena);
+}
+
+void test_grows_and_reuses_blocks() {
+  arena_t *arena = arena_init(BLOCK_SIZE);
+  char *small = arena_alloc(arena, 16);
+  // Bigger than a whole block, so it gets a block of its own
+  char *big = arena_alloc(arena, 4 * BLOCK_SIZE);
+  big[4 * BLOCK_SIZE - 1] = 'x';
+  small[0] = 'y';
+  arena_stats_t stats = arena_stats(arena);
+  assert(stats.used == 16 + 4 * BLOCK_SIZE);
+  assert(stats.capacity == 5 * BLOCK_SIZE);
+
+  // The same frame again fits in the memory already reserved
+  arena_reset(arena);
+  assert(arena_stats(arena).used == 0);
+  assert(arena_alloc(arena, 16) == small);
+  assert(arena_alloc(arena, 4 * BLOCK_SIZE) == big);
+  assert(arena_stats(arena).capacity == 5 * BLOCK_SIZE);
+  arena_free(arena);
+}
+
+void test_high_water() {
+  arena_t *arena = arena_init(BLOCK_SIZE);
+  arena_alloc(arena, 100);
+  arena_alloc(arena, 100);
+  arena_reset(arena);
+  arena_alloc(arena, 50);
+  arena_stats_t stats = arena_stats(arena);
+  assert(stats.used == 64);
+  assert(stats.high_water == 224);
+  arena_free(arena);
+}
+
+void test_rewind() {
+  arena_t *arena = arena_init(BLOCK_SIZE);
+  int *kept = arena_alloc(arena, sizeof(int));
+  *kept = 42;
+  arena_mark_t mark = arena_mark(arena);
+  // Scratch work that spills into more blocks
+  for (size_t i = 0; i < 10; i++) {
+    arena_alloc(arena, BLOCK_SIZE / 2);
+  }
+  arena_rewind(arena, mark);
+  assert(*kept == 42);
+  assert(arena_stats(arena).used == 16);
+  int *next = arena_alloc(arena, sizeof(int));
+  assert(next == kept + 4);
+  arena_free(arena);
+}
+
+void test_arena_list() {
+  arena_t *arena = arena_init(BLOCK_SIZE);
+  list_t *list = list_init_arena(arena, 1);
+  int values[100];
+  for (int i = 0; i < 100; i++) {
+    values[i] = i;
+    list_add(list, &values[i]);
+  }
+  assert(list_size(list) == 100);
+  for (int i = 0; i < 100; i++) {
+    assert(*(int *)list_get(list, i) == i);
+  }
+  // Freeing an arena list does nothing; the arena owns it
+  list_free(list);
+  arena_reset(arena);
+  arena_free(arena);
+}
+
+void test_frame_arena() {
+  arena_t *frame = frame_arena();
+  assert(frame == frame_arena());
+  arena_alloc(frame, 100);
+  frame_arena_reset();
+  assert(arena_stats(frame).used == 0);
+  frame_arena_free();
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_alignment)
+  DO_TEST(test_grows_and_reuses_blocks)
+  DO_TEST(test_high_water)
+  DO_TEST(test_rewind)
+  DO_TEST(test_arena_list)
+  DO_TEST(test_frame_arena)
+
+  puts("arena_test PASS");
+}
@@ -0,0 +1,99 @@
+#include "asset_loader.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+const char IMAGE_PATH[] = "assets/tank.png";
+const char SOUND_PATH[] = "assets/death.wav";
+const char FONT_PATH[] = "assets/font.ttf";
+const char MISSING_PATH[] = "assets/does_not_exist.png";
+const size_t WORKERS = 4;
+const size_t MANY_IMAGES = 40;
+
+void check_loads(size_t workers) {
+  asset_loader_t *loader = asset_loader_init(workers);
+  assert(asset_loader_progress(loader) == 1.0);
+  asset_t *image = asset_loader_image(loader, IMAGE_PATH);
+  asset_t *sound = asset_loader_sound(loader, SOUND_PATH);
+  asset_t *font = asset_loader_font(loader, FONT_PATH, 20);
+
+  SDL_Surface *surface = asset_surface(image);
+  assert(asset_ready(image));
+  assert(surface != NULL && surface->w > 0 && surface->h > 0);
+  Mix_Chunk *chunk = asset_chunk(sound);
+  assert(chunk != NULL);
+  TTF_Font *ttf = asset_font(font);
+  assert(ttf != NULL);
+
+  asset_loader_wait_all(loader);
+  assert(asset_loader_progress(loader) == 1.0);
+  Mix_FreeChunk(chunk);
+  TTF_CloseFont(ttf);
+  asset_loader_free(loader);
+}
+
+void test_load_sequential() { check_loads(0); }
+
+void test_load_workers() { check_loads(WORKERS); }
+
+void test_missing_asset() {
+  asset_loader_t *loader = asset_loader_init(WORKERS);
+  asset_t *missing = asset_loader_image(loader, MISSING_PATH);
+  // A failed asset is still ready, so nobody waits on it forever
+  assert(asset_surface(missing) == NULL);
+  assert(asset_ready(missing));
+  asset_loader_free(loader);
+}
+
+void test_progress() {
+  asset_loader_t *loader = asset_loader_init(WORKERS);
+  asset_t *images[MANY_IMAGES];
+  for (size_t i = 0; i < MANY_IMAGES; i++) {
+    images[i] = asset_loader_image(loader, IMAGE_PATH);
+  }
+  double last_progress = 0.0;
+  while (last_progress < 1.0) {
+    double progress = asset_loader_progress(loader);
+    assert(progress >= last_progress && progress <= 1.0);
+    last_progress = progress;
+  }
+  for (size_t i = 0; i < MANY_IMAGES; i++) {
+    assert(asset_ready(images[i]));
+    assert(asset_surface(images[i]) != NULL);
+  }
+  asset_loader_free(loader);
+}
+
+void test_free_while_loading() {
+  // Freeing the loader must not wait for (or leak) unstarted assets
+  asset_loader_t *loader = asset_loader_init(1);
+  for (size_t i = 0; i < MANY_IMAGES; i++) {
+    asset_loader_image(loader, IMAGE_PATH);
+  }
+  asset_loader_free(loader);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  // Sounds are decoded into the mixer's format, so open a dummy mixer
+  setenv("SDL_AUDIODRIVER", "dummy", 1);
+  SDL_Init(SDL_INIT_AUDIO);
+  TTF_Init();
+  assert(Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) == 0);
+
+  DO_TEST(test_load_sequential)
+  DO_TEST(test_load_workers)
+  DO_TEST(test_missing_asset)
+  DO_TEST(test_progress)
+  DO_TEST(test_free_while_loading)
+
+  Mix_CloseAudio();
+  puts("asset_loader_test PASS");
+}
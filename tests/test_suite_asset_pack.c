@@ -0,0 +1,127 @@
+#include "asset_pack.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+const char PACK_PATH[] = "out/test_assets.pack";
+const char FIRST_PATH[] = "out/test_asset_first.txt";
+const char SECOND_PATH[] = "out/test_asset_second.bin";
+const char FIRST_CONTENTS[] = "first asset";
+const size_t SECOND_SIZE = 1000;
+
+void write_file(const char *path, const void *data, size_t size) {
+  FILE *file = fopen(path, "wb");
+  assert(file != NULL);
+  assert(fwrite(data, 1, size, file) == size);
+  fclose(file);
+}
+
+/** Writes the two loose test assets and packs them */
+void make_pack() {
+  write_file(FIRST_PATH, FIRST_CONTENTS, strlen(FIRST_CONTENTS));
+  unsigned char second[SECOND_SIZE];
+  for (size_t i = 0; i < SECOND_SIZE; i++) {
+    second[i] = i * 7;
+  }
+  write_file(SECOND_PATH, second, SECOND_SIZE);
+  // Packed out of order, to check the index is sorted
+  const char *paths[] = {SECOND_PATH, FIRST_PATH};
+  assert(asset_pack_write(PACK_PATH, paths, 2));
+}
+
+void remove_pack() {
+  remove(PACK_PATH);
+  remove(FIRST_PATH);
+  remove(SECOND_PATH);
+}
+
+void test_find() {
+  make_pack();
+  asset_pack_t *pack = asset_pack_open(PACK_PATH);
+  assert(pack != NULL);
+  assert(asset_pack_size(pack) == 2);
+
+  size_t size;
+  const char *first = asset_pack_find(pack, FIRST_PATH, &size);
+  assert(first != NULL);
+  assert(size == strlen(FIRST_CONTENTS));
+  assert(memcmp(first, FIRST_CONTENTS, size) == 0);
+
+  const unsigned char *second = asset_pack_find(pack, SECOND_PATH, &size);
+  assert(second != NULL);
+  assert(size == SECOND_SIZE);
+  for (size_t i = 0; i < SECOND_SIZE; i++) {
+    assert(second[i] == (unsigned char)(i * 7));
+  }
+  // Data is aligned so it can be read in place
+  assert((size_t)second % 16 == 0);
+
+  assert(asset_pack_find(pack, "out/not_packed.txt", &size) == NULL);
+  asset_pack_close(pack);
+  remove_pack();
+}
+
+void test_missing_file() {
+  const char *paths[] = {"out/does_not_exist.txt"};
+  assert(!asset_pack_write(PACK_PATH, paths, 1));
+  assert(asset_pack_open("out/does_not_exist.pack") == NULL);
+}
+
+void test_rejects_bad_pack() {
+  write_file(PACK_PATH, "not a pack at all", 17);
+  assert(asset_pack_open(PACK_PATH) == NULL);
+
+  // A valid pack cut short must not be trusted either
+  make_pack();
+  FILE *file = fopen(PACK_PATH, "rb");
+  unsigned char header[200];
+  size_t read = fread(header, 1, sizeof(header), file);
+  fclose(file);
+  write_file(PACK_PATH, header, read);
+  assert(asset_pack_open(PACK_PATH) == NULL);
+  remove_pack();
+}
+
+void test_asset_open() {
+  make_pack();
+  assert(asset_pack_mount(PACK_PATH));
+  // Once mounted, assets are served from the pack even if the files go away
+  remove(FIRST_PATH);
+  SDL_RWops *rw = asset_open(FIRST_PATH);
+  assert(rw != NULL);
+  char contents[sizeof(FIRST_CONTENTS)] = {0};
+  assert(SDL_RWread(rw, contents, 1, sizeof(contents)) ==
+         strlen(FIRST_CONTENTS));
+  assert(strcmp(contents, FIRST_CONTENTS) == 0);
+  SDL_RWclose(rw);
+
+  // Paths not in the pack fall back to loose files
+  const char loose_path[] = "out/test_asset_loose.txt";
+  write_file(loose_path, "loose", 5);
+  rw = asset_open(loose_path);
+  assert(rw != NULL);
+  SDL_RWclose(rw);
+  remove(loose_path);
+  assert(asset_open(loose_path) == NULL);
+
+  asset_pack_unmount();
+  assert(asset_open(FIRST_PATH) == NULL);
+  remove_pack();
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_find)
+  DO_TEST(test_missing_file)
+  DO_TEST(test_rejects_bad_pack)
+  DO_TEST(test_asset_open)
+
+  puts("asset_pack_test PASS");
+}
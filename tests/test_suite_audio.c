@@ -0,0 +1,77 @@
+#include "audio.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+const char SHOT_PATH[] = "assets/default_tank_sound.wav";
+const char DEATH_PATH[] = "assets/death.wav";
+const size_t SHOT_VOICES = 3;
+
+void test_play_uses_pool() {
+  assert(audio_init(NULL));
+  size_t shot = audio_load(SHOT_PATH, SHOT_VOICES);
+  size_t death = audio_load(DEATH_PATH, 1);
+  assert(shot != death);
+  // Each sound gets its own channels
+  assert(Mix_AllocateChannels(-1) == (int)SHOT_VOICES + 1);
+  assert(Mix_GroupCount(shot) == (int)SHOT_VOICES);
+  assert(Mix_GroupCount(death) == 1);
+
+  audio_stats_t before = audio_stats();
+  audio_play(shot);
+  audio_stats_t after = audio_stats();
+  assert(after.played + after.stolen == before.played + before.stolen + 1);
+  assert(after.failed == before.failed);
+  audio_free();
+}
+
+void test_voice_limit() {
+  assert(audio_init(NULL));
+  size_t shot = audio_load(SHOT_PATH, SHOT_VOICES);
+  size_t death = audio_load(DEATH_PATH, 1);
+  audio_play(death);
+  Mix_Chunk *death_chunk = Mix_GetChunk(SHOT_VOICES);
+  for (size_t i = 0; i < 4 * SHOT_VOICES; i++) {
+    audio_play(shot);
+    // Rapid fire never spills over onto the other sound's channel
+    assert(Mix_GetChunk(SHOT_VOICES) == death_chunk);
+    int playing = 0;
+    for (size_t channel = 0; channel < SHOT_VOICES; channel++) {
+      playing += Mix_Playing(channel);
+    }
+    assert(playing <= (int)SHOT_VOICES);
+  }
+  audio_stats_t stats = audio_stats();
+  assert(stats.failed == 0);
+  // Past the voice limit, new shots replace old ones
+  assert(stats.stolen > 0);
+  audio_free();
+}
+
+void test_missing_file() {
+  assert(audio_init(NULL));
+  size_t missing = audio_load("assets/does_not_exist.wav", 2);
+  audio_stats_t before = audio_stats();
+  audio_play(missing);
+  assert(audio_stats().failed == before.failed + 1);
+  audio_free();
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  // Mix into memory instead of a sound card
+  setenv("SDL_AUDIODRIVER", "dummy", 1);
+
+  DO_TEST(test_play_uses_pool)
+  DO_TEST(test_voice_limit)
+  DO_TEST(test_missing_file)
+
+  puts("audio_test PASS");
+}
@@ -0,0 +1,143 @@
+#include "bench_stats.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char RESULTS_PATH[] = "out/test_bench_results.json";
+
+void test_summarize() {
+  double samples[] = {2, 4, 4, 4, 5, 5, 7, 9};
+  bench_summary_t summary = bench_summarize(samples, 8);
+  assert(summary.count == 8);
+  assert(isclose(summary.mean, 5));
+  assert(isclose(summary.stddev, sqrt(32.0 / 7)));
+
+  bench_summary_t single = bench_summarize(samples, 1);
+  assert(isclose(single.mean, 2));
+  assert(single.stddev == 0);
+}
+
+void test_t_critical() {
+  assert(isclose(bench_t_critical(1), 12.706));
+  assert(isclose(bench_t_critical(10), 2.228));
+  // Fractional degrees of freedom round down
+  assert(isclose(bench_t_critical(9.7), 2.262));
+  assert(within(0.005, bench_t_critical(60), 2.000));
+  assert(within(0.005, bench_t_critical(1000), 1.962));
+  // The critical value only shrinks as the degrees of freedom grow
+  for (double df = 1; df < 200; df += 0.5) {
+    assert(bench_t_critical(df + 0.5) <= bench_t_critical(df));
+  }
+}
+
+void test_significant_slowdown() {
+  double before[] = {100, 101, 99, 100, 102, 98, 100, 100};
+  double after[] = {110, 111, 109, 110, 112, 108, 110, 110};
+  bench_comparison_t comparison =
+      bench_compare(bench_summarize(before, 8), bench_summarize(after, 8));
+  assert(isclose(comparison.change, 0.1));
+  assert(comparison.significant);
+  assert(comparison.change_low > 0 && comparison.change_low < 0.1);
+  assert(comparison.change_high > 0.1);
+  assert(comparison.t > 0);
+  assert(bench_is_regression(comparison, 0.05));
+  // A real slowdown smaller than the threshold does not count
+  assert(!bench_is_regression(comparison, 0.15));
+}
+
+void test_noise_is_not_significant() {
+  double before[] = {100, 140, 60, 120, 80};
+  double after[] = {110, 150, 70, 130, 90};
+  bench_comparison_t comparison =
+      bench_compare(bench_summarize(before, 5), bench_summarize(after, 5));
+  assert(isclose(comparison.change, 0.1));
+  assert(!comparison.significant);
+  assert(comparison.change_low < 0 && comparison.change_high > 0);
+  assert(!bench_is_regression(comparison, 0.05));
+}
+
+void test_speedup_is_not_regression() {
+  double before[] = {100, 101, 99, 100};
+  double after[] = {80, 81, 79, 80};
+  bench_comparison_t comparison =
+      bench_compare(bench_summarize(before, 4), bench_summarize(after, 4));
+  assert(isclose(comparison.change, -0.2));
+  assert(comparison.significant);
+  assert(comparison.change_high < 0);
+  assert(!bench_is_regression(comparison, 0.05));
+}
+
+void test_zero_variance() {
+  double before[] = {100, 100, 100};
+  double after[] = {120, 120, 120};
+  bench_comparison_t comparison =
+      bench_compare(bench_summarize(before, 3), bench_summarize(after, 3));
+  assert(comparison.significant);
+  assert(isclose(comparison.change_low, 0.2));
+  assert(bench_is_regression(comparison, 0.05));
+
+  comparison =
+      bench_compare(bench_summarize(before, 3), bench_summarize(before, 3));
+  assert(!comparison.significant);
+  assert(comparison.change == 0);
+}
+
+void test_read_results() {
+  FILE *file = fopen(RESULTS_PATH, "w");
+  assert(file != NULL);
+  fputs("{\n  \"commit\": \"abc123\",\n"
+        "  \"fingerprint\": \"0123456789abcdef\",\n"
+        "  \"seed\": 39,\n  \"samples\": 3,\n  \"benchmarks\": [\n"
+        "    {\"name\": \"first\", \"unit\": \"tick\", \"size\": 10,\n"
+        "     \"ns_per_op\": 2.000, \"allocs_per_op\": null,\n"
+        "     \"samples\": [1.000, 2.000, 3.000]},\n"
+        "    {\"name\": \"second\", \"unit\": \"call\", \"size\": 1,\n"
+        "     \"ns_per_op\": 5.500, \"allocs_per_op\": 0.000,\n"
+        "     \"samples\": [5.000, 6.000]}\n"
+        "  ]\n}\n",
+        file);
+  fclose(file);
+
+  bench_record_t *records = malloc(sizeof(bench_record_t) * 4);
+  char fingerprint[BENCH_NAME_LENGTH];
+  assert(bench_read_results(RESULTS_PATH, records, 4, fingerprint) == 2);
+  assert(strcmp(fingerprint, "0123456789abcdef") == 0);
+  assert(strcmp(records[0].name, "first") == 0);
+  assert(records[0].count == 3);
+  assert(isclose(records[0].samples[2], 3));
+  assert(strcmp(records[1].name, "second") == 0);
+  assert(records[1].count == 2);
+  assert(isclose(records[1].samples[0], 5));
+
+  // Only as many records as there is room for are read
+  assert(bench_read_results(RESULTS_PATH, records, 1, NULL) == 1);
+  assert(strcmp(records[0].name, "first") == 0);
+
+  assert(bench_read_results("out/no_such_results.json", records, 4, NULL) ==
+         -1);
+  free(records);
+  remove(RESULTS_PATH);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_summarize)
+  DO_TEST(test_t_critical)
+  DO_TEST(test_significant_slowdown)
+  DO_TEST(test_noise_is_not_significant)
+  DO_TEST(test_speedup_is_not_regression)
+  DO_TEST(test_zero_variance)
+  DO_TEST(test_read_results)
+
+  puts("bench_stats_test PASS");
+}
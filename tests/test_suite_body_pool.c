@@ -0,0 +1,155 @@
+#include "body_pool.h"
+#include "forces.h"
+#include "scene.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const size_t POOL_SIZE = 4;
+const rgb_color_t RED = {1, 0, 0};
+
+list_t *make_shape() {
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {{-1, -1}, {+1, -1}, {+1, +1}, {-1, +1}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+void test_counters() {
+  body_pool_t *pool = body_pool_init(make_shape(), POOL_SIZE);
+  body_t *bodies[POOL_SIZE + 2];
+  for (size_t i = 0; i < POOL_SIZE + 2; i++) {
+    bodies[i] = body_pool_get(pool, 1, RED, BULLET_TYPE);
+  }
+  body_pool_stats_t stats = body_pool_stats(pool);
+  assert(stats.hits == POOL_SIZE);
+  assert(stats.misses == 2);
+  assert(stats.in_use == POOL_SIZE + 2);
+  assert(stats.high_water == POOL_SIZE + 2);
+
+  // The extra bodies become spares too, so nothing else is allocated
+  for (size_t i = 0; i < POOL_SIZE + 2; i++) {
+    body_free(bodies[i]);
+  }
+  for (size_t i = 0; i < POOL_SIZE + 2; i++) {
+    bodies[i] = body_pool_get(pool, 1, RED, BULLET_TYPE);
+  }
+  stats = body_pool_stats(pool);
+  assert(stats.hits == 2 * POOL_SIZE + 2);
+  assert(stats.misses == 2);
+  assert(stats.high_water == POOL_SIZE + 2);
+
+  for (size_t i = 0; i < POOL_SIZE + 2; i++) {
+    body_free(bodies[i]);
+  }
+  assert(body_pool_stats(pool).in_use == 0);
+  body_pool_free(pool);
+}
+
+void test_reused_body_is_reset() {
+  body_pool_t *pool = body_pool_init(make_shape(), 1);
+  body_t *body = body_pool_get(pool, 1, RED, BULLET_TYPE);
+  body_set_centroid(body, (vector_t){10, 20});
+  body_set_rotation(body, M_PI / 3);
+  body_set_velocity(body, (vector_t){5, 5});
+  body_add_force(body, (vector_t){1, 1});
+  body_remove(body);
+  body_free(body);
+
+  body_t *reused = body_pool_get(pool, 2, (rgb_color_t){0, 1, 0}, WALL_TYPE);
+  assert(reused == body);
+  assert(*(size_t *)body_get_info(reused) == WALL_TYPE);
+  assert(body_get_mass(reused) == 2);
+  assert(body_get_color(reused).g == 1);
+  assert(!body_is_removed(reused));
+  assert(body_get_rotation(reused) == 0);
+  assert(vec_isclose(body_get_velocity(reused), VEC_ZERO));
+  assert(vec_isclose(body_get_centroid(reused), VEC_ZERO));
+  list_t *shape = body_get_shape(reused);
+  assert(vec_isclose(*(vector_t *)list_get(shape, 0), (vector_t){-1, -1}));
+  assert(vec_isclose(*(vector_t *)list_get(shape, 2), (vector_t){+1, +1}));
+  list_free(shape);
+
+  // No force was added since the reset, so the body keeps still
+  body_tick(reused, 1);
+  assert(vec_isclose(body_get_centroid(reused), VEC_ZERO));
+  body_free(reused);
+  body_pool_free(pool);
+}
+
+void test_scene_returns_bodies() {
+  body_pool_t *pool = body_pool_init(make_shape(), POOL_SIZE);
+  scene_t *scene = scene_init();
+  body_t *wall = body_init_with_info(make_shape(), INFINITY, RED,
+                                     malloc(sizeof(size_t)), free);
+  *(size_t *)body_get_info(wall) = WALL_TYPE;
+  body_set_centroid(wall, (vector_t){50, 0});
+  scene_add_body(scene, wall);
+
+  // Fire and expire many more bullets than the pool holds, a few at a time
+  for (size_t round = 0; round < 10 * POOL_SIZE; round++) {
+    for (size_t i = 0; i < POOL_SIZE; i++) {
+      body_t *bullet = body_pool_get(pool, 1, RED, BULLET_TYPE);
+      scene_add_body(scene, bullet);
+      create_drag(scene, 1, bullet);
+      create_physics_collision(scene, 1, bullet, wall);
+    }
+    scene_tick(scene, 0.01);
+    for (size_t i = 1; i < scene_bodies(scene); i++) {
+      body_remove(scene_get_body(scene, i));
+    }
+    scene_tick(scene, 0.01);
+    assert(scene_bodies(scene) == 1);
+  }
+  body_pool_stats_t stats = body_pool_stats(pool);
+  assert(stats.misses == 0);
+  assert(stats.in_use == 0);
+  assert(stats.high_water == POOL_SIZE);
+
+  // Bodies still in the scene go back to the pool when it is freed
+  scene_add_body(scene, body_pool_get(pool, 1, RED, BULLET_TYPE));
+  scene_free(scene);
+  assert(body_pool_stats(pool).in_use == 0);
+  body_pool_free(pool);
+}
+
+void test_reused_force_storage() {
+  scene_t *scene = scene_init();
+  body_t *body = body_init_with_info(make_shape(), 1, RED,
+                                     malloc(sizeof(size_t)), free);
+  *(size_t *)body_get_info(body) = BULLET_TYPE;
+  scene_add_body(scene, body);
+  assert(scene_reuse_aux(scene) == NULL);
+  create_drag(scene, 1, body);
+  body_remove(body);
+  scene_tick(scene, 0.01);
+
+  // The drag's storage was kept when its body was removed
+  void *aux = scene_reuse_aux(scene);
+  assert(aux != NULL);
+  assert(scene_reuse_aux(scene) == NULL);
+  store_force_free(aux);
+  scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_counters)
+  DO_TEST(test_reused_body_is_reset)
+  DO_TEST(test_scene_returns_bodies)
+  DO_TEST(test_reused_force_storage)
+
+  puts("body_pool_test PASS");
+}
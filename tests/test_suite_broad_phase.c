@@ -0,0 +1,278 @@
+#include "broad_phase.h"
+#include "forces.h"
+#include "scene.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+const rgb_color_t RED = {1, 0, 0};
+const size_t RANDOM_BODIES = 60;
+const size_t RANDOM_WALLS = 4;
+const size_t RANDOM_STEPS = 200;
+const double RANDOM_AREA = 100.0;
+
+body_t *make_box_with_mass(vector_t centroid, vector_t size, double mass) {
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {{0, 0}, {size.x, 0}, {size.x, size.y}, {0, size.y}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  size_t *type = malloc(sizeof(size_t));
+  *type = BULLET_TYPE;
+  body_t *body = body_init_with_info(shape, mass, RED, type, free);
+  body_set_centroid(body, centroid);
+  return body;
+}
+
+body_t *make_box(vector_t centroid, vector_t size) {
+  return make_box_with_mass(centroid, size, 1);
+}
+
+body_t *make_random_box() {
+  vector_t centroid = {rand() * RANDOM_AREA / RAND_MAX,
+                       rand() * RANDOM_AREA / RAND_MAX};
+  vector_t size = {1 + rand() * 10.0 / RAND_MAX, 1 + rand() * 10.0 / RAND_MAX};
+  body_t *body = make_box(centroid, size);
+  body_set_velocity(body, (vector_t){rand() * 2.0 / RAND_MAX - 1,
+                                     rand() * 2.0 / RAND_MAX - 1});
+  return body;
+}
+
+/**
+ * Checks a broad phase's pairs against testing every pair of boxes.
+ * The AABB tree broad phase never pairs two bodies of infinite mass.
+ */
+void check_pairs(broad_phase_t *broad_phase, list_t *bodies) {
+  bool tree = broad_phase_kind(broad_phase) == BROAD_PHASE_AABB_TREE;
+  size_t overlapping = 0;
+  for (size_t i = 0; i < list_size(bodies); i++) {
+    body_t *body1 = list_get(bodies, i);
+    for (size_t j = i + 1; j < list_size(bodies); j++) {
+      body_t *body2 = list_get(bodies, j);
+      bool overlap =
+          aabb_overlap(body_get_bounds(body1), body_get_bounds(body2)) &&
+          !(tree && body_get_mass(body1) == INFINITY &&
+            body_get_mass(body2) == INFINITY);
+      assert(broad_phase_may_collide(broad_phase, body1, body2) == overlap);
+      assert(broad_phase_may_collide(broad_phase, body2, body1) == overlap);
+      overlapping += overlap;
+    }
+  }
+  assert(broad_phase_pair_count(broad_phase) == overlapping);
+}
+
+void check_random_boxes(broad_phase_kind_t kind) {
+  srand(41);
+  broad_phase_t *broad_phase = broad_phase_init(kind);
+  list_t *bodies = list_init(RANDOM_BODIES, (free_func_t)body_free);
+  // some walls that never move
+  for (size_t i = 0; i < RANDOM_WALLS; i++) {
+    vector_t corner = {i * RANDOM_AREA / RANDOM_WALLS, RANDOM_AREA / 2};
+    list_add(bodies,
+             make_box_with_mass(corner, (vector_t){5, 30}, INFINITY));
+  }
+  for (size_t i = 0; i < RANDOM_BODIES; i++) {
+    list_add(bodies, make_random_box());
+  }
+  for (size_t step = 0; step < RANDOM_STEPS; step++) {
+    for (size_t i = RANDOM_WALLS; i < list_size(bodies); i++) {
+      body_t *body = list_get(bodies, i);
+      body_set_centroid(body, vec_add(body_get_centroid(body),
+                                      body_get_velocity(body)));
+    }
+    // bodies come and go, and freed bodies' memory is reused by new ones
+    if (step % 7 == 0) {
+      for (size_t i = 0; i < 3; i++) {
+        size_t moving = list_size(bodies) - RANDOM_WALLS;
+        size_t index = RANDOM_WALLS + rand() % moving;
+        body_free(list_remove(bodies, index));
+      }
+      for (size_t i = 0; i < 3; i++) {
+        list_add(bodies, make_random_box());
+      }
+    }
+    // and now and then a wall is moved
+    if (step % 50 == 0) {
+      body_t *wall = list_get(bodies, step / 50 % RANDOM_WALLS);
+      body_set_centroid(wall,
+                        vec_add(body_get_centroid(wall), (vector_t){3, 0}));
+    }
+    broad_phase_update(broad_phase, bodies);
+    check_pairs(broad_phase, bodies);
+  }
+  list_free(bodies);
+  broad_phase_free(broad_phase);
+}
+
+void test_matches_brute_force() {
+  check_random_boxes(BROAD_PHASE_SWEEP_AND_PRUNE);
+  check_random_boxes(BROAD_PHASE_AABB_TREE);
+}
+
+void check_removed_bodies(broad_phase_kind_t kind) {
+  broad_phase_t *broad_phase = broad_phase_init(kind);
+  list_t *bodies = list_init(3, (free_func_t)body_free);
+  body_t *a = make_box((vector_t){0, 0}, (vector_t){2, 2});
+  body_t *b = make_box((vector_t){1, 1}, (vector_t){2, 2});
+  body_t *c = make_box((vector_t){1, 0}, (vector_t){2, 2});
+  list_add(bodies, a);
+  list_add(bodies, b);
+  list_add(bodies, c);
+  broad_phase_update(broad_phase, bodies);
+  assert(broad_phase_pair_count(broad_phase) == 3);
+
+  // bodies marked for removal leave the broad phase along with their pairs,
+  // even pairs of two bodies removed together
+  body_remove(b);
+  body_remove(c);
+  broad_phase_update(broad_phase, bodies);
+  assert(broad_phase_pair_count(broad_phase) == 0);
+
+  body_t *d = make_box((vector_t){0, 1}, (vector_t){2, 2});
+  list_add(bodies, d);
+  // a body the broad phase has not seen yet may collide with anything
+  assert(broad_phase_may_collide(broad_phase, a, d));
+  broad_phase_update(broad_phase, bodies);
+  assert(broad_phase_pair_count(broad_phase) == 1);
+  assert(broad_phase_may_collide(broad_phase, a, d));
+  list_free(bodies);
+  broad_phase_free(broad_phase);
+}
+
+void test_removed_bodies() {
+  check_removed_bodies(BROAD_PHASE_SWEEP_AND_PRUNE);
+  check_removed_bodies(BROAD_PHASE_AABB_TREE);
+}
+
+void count_pair(body_t *body1, body_t *body2, void *aux) {
+  assert(body1 != body2);
+  (*(size_t *)aux)++;
+}
+
+void test_visit_pairs() {
+  for (broad_phase_kind_t kind = BROAD_PHASE_SWEEP_AND_PRUNE;
+       kind < BROAD_PHASE_KIND_COUNT; kind++) {
+    broad_phase_t *broad_phase = broad_phase_init(kind);
+    list_t *bodies = list_init(4, (free_func_t)body_free);
+    // two overlapping pairs, far from each other
+    vector_t corners[] = {{0, 0}, {1, 1}, {50, 0}, {51, 0}};
+    for (size_t i = 0; i < 4; i++) {
+      list_add(bodies, make_box(corners[i], (vector_t){2, 2}));
+    }
+    broad_phase_update(broad_phase, bodies);
+    size_t pairs = 0;
+    broad_phase_visit_pairs(broad_phase, count_pair, &pairs);
+    assert(pairs == 2);
+    list_free(bodies);
+    broad_phase_free(broad_phase);
+  }
+  assert(strcmp(broad_phase_name(BROAD_PHASE_SWEEP_AND_PRUNE),
+                "sweep and prune") == 0);
+  assert(strcmp(broad_phase_name(BROAD_PHASE_AABB_TREE), "aabb tree") == 0);
+}
+
+void check_not_removed(body_t *body1, body_t *body2, void *aux) {
+  assert(!body_is_removed(body1) && !body_is_removed(body2));
+}
+
+bool add_found(body_t *body, void *aux) {
+  list_add(aux, body);
+  return true;
+}
+
+void test_refresh() {
+  for (broad_phase_kind_t kind = BROAD_PHASE_SWEEP_AND_PRUNE;
+       kind < BROAD_PHASE_KIND_COUNT; kind++) {
+    broad_phase_t *broad_phase = broad_phase_init(kind);
+    list_t *bodies = list_init(3, (free_func_t)body_free);
+    body_t *a = make_box((vector_t){0, 0}, (vector_t){2, 2});
+    body_t *b = make_box((vector_t){1, 0}, (vector_t){2, 2});
+    body_t *c = make_box((vector_t){50, 0}, (vector_t){2, 2});
+    list_add(bodies, a);
+    list_add(bodies, b);
+    list_add(bodies, c);
+    broad_phase_update(broad_phase, bodies);
+    assert(broad_phase_pair_count(broad_phase) == 1);
+
+    body_remove(b);
+    body_set_centroid(c, (vector_t){0, 1});
+    broad_phase_refresh(broad_phase, bodies);
+    // queries see the bodies where they are now
+    list_t *found = list_init(3, NULL);
+    aabb_t box = {{-1, -1}, {1, 1}};
+    broad_phase_query(broad_phase, box, add_found, found);
+    assert(list_size(found) == 2);
+    for (size_t i = 0; i < list_size(found); i++) {
+      assert(list_get(found, i) == a || list_get(found, i) == c);
+    }
+    list_free(found);
+    // the pairs of removed bodies are gone, even if no new pairs were found
+    broad_phase_visit_pairs(broad_phase, check_not_removed, NULL);
+    if (kind == BROAD_PHASE_AABB_TREE) {
+      assert(broad_phase_pair_count(broad_phase) == 0);
+    }
+    broad_phase_update(broad_phase, bodies);
+    assert(broad_phase_pair_count(broad_phase) == 1);
+    assert(broad_phase_may_collide(broad_phase, a, c));
+    list_free(bodies);
+    broad_phase_free(broad_phase);
+  }
+}
+
+void count_hits(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+  (*(size_t *)aux)++;
+}
+
+void test_scene_culls_pairs() {
+  for (broad_phase_kind_t kind = 0; kind < BROAD_PHASE_KIND_COUNT; kind++) {
+    scene_t *scene = scene_init();
+    scene_set_broad_phase(scene, kind);
+    body_t *a = make_box((vector_t){0, 0}, (vector_t){2, 2});
+    body_t *b = make_box((vector_t){10, 0}, (vector_t){2, 2});
+    body_t *c = make_box((vector_t){1, 0}, (vector_t){2, 2});
+    scene_add_body(scene, a);
+    scene_add_body(scene, b);
+    scene_add_body(scene, c);
+    size_t hits = 0;
+    create_collision(scene, a, b, count_hits, &hits, NULL);
+    create_collision(scene, a, c, count_hits, &hits, NULL);
+
+    scene_tick(scene, 0.001);
+    scene_stats_t stats = scene_stats(scene);
+    assert(hits == 1);
+    assert(stats.last_tick_collisions.hits == 1);
+    if (kind == BROAD_PHASE_NONE) {
+      assert(stats.last_tick_collisions.tests == 2);
+      assert(stats.last_tick_collisions.culled == 0);
+    } else {
+      // a and b are too far apart to need a test
+      assert(stats.last_tick_collisions.tests == 1);
+      assert(stats.last_tick_collisions.culled == 1);
+    }
+    assert(stats.total_collisions.culled ==
+           stats.last_tick_collisions.culled);
+    scene_free(scene);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_matches_brute_force)
+  DO_TEST(test_removed_bodies)
+  DO_TEST(test_visit_pairs)
+  DO_TEST(test_refresh)
+  DO_TEST(test_scene_culls_pairs)
+
+  puts("broad_phase_test PASS");
+}
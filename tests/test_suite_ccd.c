@@ -0,0 +1,295 @@
+#include "collision.h"
+#include "forces.h"
+#include "gjk.h"
+#include "scene.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const rgb_color_t RED = {1, 0, 0};
+// A bullet this fast crosses the whole wall in one tick of DT
+const double BULLET_SPEED = 1000.0;
+const double DT = 0.1;
+const double WALL_X = 50.0;
+const double WALL_THICKNESS = 5.0;
+// The game's bullet speed, and a tick long enough to cross its map's bars
+const double CAPSULE_BULLET_SPEED = 500.0;
+const double CAPSULE_DT = 0.15;
+
+list_t *make_box_shape(vector_t corner, vector_t size) {
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {corner,
+                        {corner.x + size.x, corner.y},
+                        vec_add(corner, size),
+                        {corner.x, corner.y + size.y}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+body_t *make_body(vector_t corner, vector_t size, double mass, size_t type) {
+  size_t *info = malloc(sizeof(size_t));
+  *info = type;
+  return body_init_with_info(make_box_shape(corner, size), mass, RED, info,
+                             free);
+}
+
+void test_time_of_impact() {
+  list_t *square = make_box_shape((vector_t){0, 0}, (vector_t){2, 2});
+  list_t *wall = make_box_shape((vector_t){10, -10}, (vector_t){1, 20});
+
+  // Moving 20 to the right, the square touches the wall after 8
+  impact_info_t impact =
+      find_time_of_impact(square, (vector_t){20, 0}, wall, VEC_ZERO);
+  assert(impact.collided);
+  assert(isclose(impact.time, 0.4));
+  assert(vec_isclose(impact.axis, (vector_t){1, 0}));
+
+  // The same impact, seen from the wall moving the other way
+  impact = find_time_of_impact(wall, (vector_t){-20, 0}, square, VEC_ZERO);
+  assert(impact.collided);
+  assert(isclose(impact.time, 0.4));
+  assert(vec_isclose(impact.axis, (vector_t){-1, 0}));
+
+  // Both moving towards each other close the gap twice as fast
+  impact = find_time_of_impact(square, (vector_t){10, 0}, wall,
+                               (vector_t){-10, 0});
+  assert(impact.collided);
+  assert(isclose(impact.time, 0.4));
+
+  // Stopping short of the wall, moving away, and passing above it all miss
+  assert(!find_time_of_impact(square, (vector_t){7, 0}, wall, VEC_ZERO)
+              .collided);
+  assert(!find_time_of_impact(square, (vector_t){-20, 0}, wall, VEC_ZERO)
+              .collided);
+  assert(!find_time_of_impact(square, (vector_t){20, 0}, wall,
+                              (vector_t){0, -30})
+              .collided);
+
+  // Shapes that already overlap are left to find_collision()
+  assert(!find_time_of_impact(square, (vector_t){20, 0}, square, VEC_ZERO)
+              .collided);
+
+  list_free(square);
+  list_free(wall);
+}
+
+void test_time_of_impact_diagonal() {
+  list_t *square = make_box_shape((vector_t){0, 0}, (vector_t){2, 2});
+  list_t *wall = make_box_shape((vector_t){10, 5}, (vector_t){1, 20});
+
+  // Moving diagonally, the square reaches the wall's side at x = 8
+  // when it has risen 8, well past the wall's bottom at 5
+  impact_info_t impact =
+      find_time_of_impact(square, (vector_t){20, 20}, wall, VEC_ZERO);
+  assert(impact.collided);
+  assert(isclose(impact.time, 0.4));
+  assert(vec_isclose(impact.axis, (vector_t){1, 0}));
+
+  // Moving along x = y the other way round, it reaches the bottom first
+  list_t *floor = make_box_shape((vector_t){5, 10}, (vector_t){20, 1});
+  impact = find_time_of_impact(square, (vector_t){20, 20}, floor, VEC_ZERO);
+  assert(impact.collided);
+  assert(isclose(impact.time, 0.4));
+  assert(vec_isclose(impact.axis, (vector_t){0, 1}));
+
+  list_free(square);
+  list_free(wall);
+  list_free(floor);
+}
+
+void test_time_of_impact_capsule() {
+  capsule_t capsule = {{0, 0}, {2, 0}, 1};
+  list_t *wall = make_box_shape((vector_t){10, -10}, (vector_t){1, 20});
+
+  // The capsule's round end reaches the wall when its segment ends at x = 9
+  impact_info_t impact =
+      find_time_of_impact_capsule(capsule, (vector_t){20, 0}, wall, VEC_ZERO);
+  assert(impact.collided);
+  assert(isclose(impact.time, 0.35));
+  assert(vec_isclose(impact.axis, (vector_t){1, 0}));
+  assert(!find_time_of_impact_capsule(capsule, (vector_t){-20, 0}, wall,
+                                      VEC_ZERO)
+              .collided);
+
+  // Heading straight for a corner, a circle touches it later than the
+  // square around it would, once it is its radius away
+  capsule_t circle = {{0, 0}, {0, 0}, 1};
+  list_t *square = make_box_shape((vector_t){10, 10}, (vector_t){5, 5});
+  impact = find_time_of_impact_capsule(circle, (vector_t){20, 20}, square,
+                                       VEC_ZERO);
+  assert(impact.collided);
+  assert(isclose(impact.time, (10 - sqrt(0.5)) / 20));
+  assert(vec_isclose(impact.axis, (vector_t){sqrt(0.5), sqrt(0.5)}));
+  list_t *around = make_box_shape((vector_t){-1, -1}, (vector_t){2, 2});
+  assert(isclose(
+      find_time_of_impact(around, (vector_t){20, 20}, square, VEC_ZERO).time,
+      0.45));
+
+  // Two capsules close the gap between their round ends
+  capsule_t other = {{10, 0}, {12, 0}, 1};
+  impact = find_time_of_impact_capsules(capsule, (vector_t){10, 0}, other,
+                                        (vector_t){-10, 0});
+  assert(impact.collided);
+  assert(isclose(impact.time, 0.3));
+
+  // Shapes that already overlap are left to the discrete test
+  assert(!find_time_of_impact_capsule(capsule, (vector_t){20, 0}, around,
+                                      VEC_ZERO)
+              .collided);
+
+  list_free(wall);
+  list_free(square);
+  list_free(around);
+}
+
+void count_hit(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+  (*(size_t *)aux)++;
+}
+
+/**
+ * Fires a bullet at a thin wall, in ticks long enough to skip over it.
+ * Returns the number of ticks in which the bullet's collision handler ran.
+ */
+size_t fire_at_wall(bool bullet_flag) {
+  scene_t *scene = scene_init();
+  body_t *wall = make_body((vector_t){WALL_X, -50},
+                           (vector_t){WALL_THICKNESS, 100}, INFINITY,
+                           WALL_TYPE);
+  body_t *bullet =
+      make_body((vector_t){0, -1}, (vector_t){2, 2}, 1, BULLET_TYPE);
+  body_set_velocity(bullet, (vector_t){BULLET_SPEED, 0});
+  body_set_bullet(bullet, bullet_flag);
+  scene_add_body(scene, wall);
+  scene_add_body(scene, bullet);
+  size_t hits = 0;
+  create_collision(scene, bullet, wall, count_hit, &hits, NULL);
+
+  scene_tick(scene, DT);
+  if (bullet_flag) {
+    // Stopped just inside the wall, and counted
+    assert(body_get_centroid(bullet).x + 1 > WALL_X);
+    assert(body_get_centroid(bullet).x + 1 < WALL_X + WALL_THICKNESS);
+    assert(scene_stats(scene).last_tick_collisions.impacts == 1);
+  } else {
+    assert(body_get_centroid(bullet).x - 1 > WALL_X + WALL_THICKNESS);
+    assert(scene_stats(scene).last_tick_collisions.impacts == 0);
+  }
+  for (size_t i = 0; i < 3; i++) {
+    scene_tick(scene, DT);
+  }
+  scene_free(scene);
+  return hits;
+}
+
+void test_bullets_stop_at_walls() {
+  // Without sweeping, the bullet is never seen touching the wall
+  assert(fire_at_wall(false) == 0);
+  // Swept, it stops inside the wall, and the next tick's test finds it there
+  assert(fire_at_wall(true) > 0);
+}
+
+/**
+ * Fires a bullet like the game's, a 25 by 10 rectangle that collides as a
+ * capsule, at an angle into a bar, in ticks long enough to skip over it.
+ * Returns the number of ticks in which the bullet's collision handler ran.
+ */
+size_t fire_capsule_at_bar(double angle) {
+  scene_t *scene = scene_init();
+  body_t *bar = make_body((vector_t){-165, 100}, (vector_t){330, 35}, INFINITY,
+                          WALL_TYPE);
+  body_t *bullet =
+      make_body((vector_t){-92.5, -5}, (vector_t){25, 10}, 1, BULLET_TYPE);
+  body_set_capsule(bullet, 15, 5);
+  body_set_rotation(bullet, angle);
+  body_set_velocity(bullet, vec_multiply(CAPSULE_BULLET_SPEED,
+                                         (vector_t){cos(angle), sin(angle)}));
+  body_set_bullet(bullet, true);
+  scene_add_body(scene, bar);
+  scene_add_body(scene, bullet);
+  size_t hits = 0;
+  create_collision(scene, bullet, bar, count_hit, &hits, NULL);
+
+  for (size_t i = 0; i < 4; i++) {
+    scene_tick(scene, CAPSULE_DT);
+  }
+  scene_free(scene);
+  return hits;
+}
+
+void test_angled_capsule_bullets() {
+  // The capsule's round ends are inside its rectangle's corners, so at an
+  // angle it is stopped where the capsule touches the bar, not the rectangle
+  double angles[] = {M_PI / 6, M_PI / 4, M_PI / 3, 5 * M_PI / 12};
+  for (size_t i = 0; i < sizeof(angles) / sizeof(angles[0]); i++) {
+    assert(fire_capsule_at_bar(angles[i]) > 0);
+  }
+}
+
+void test_bullets_hit_the_nearest_body() {
+  scene_t *scene = scene_init();
+  body_t *far = make_body((vector_t){WALL_X + 20, -50},
+                          (vector_t){WALL_THICKNESS, 100}, INFINITY,
+                          WALL_TYPE);
+  body_t *near = make_body((vector_t){WALL_X, -50},
+                           (vector_t){WALL_THICKNESS, 100}, INFINITY,
+                           WALL_TYPE);
+  body_t *bullet =
+      make_body((vector_t){0, -1}, (vector_t){2, 2}, 1, BULLET_TYPE);
+  body_set_velocity(bullet, (vector_t){BULLET_SPEED, 0});
+  body_set_bullet(bullet, true);
+  scene_add_body(scene, far);
+  scene_add_body(scene, near);
+  scene_add_body(scene, bullet);
+  create_collision(scene, bullet, far, count_hit, &(size_t){0}, NULL);
+  create_collision(scene, bullet, near, count_hit, &(size_t){0}, NULL);
+
+  scene_tick(scene, DT);
+  assert(body_get_centroid(bullet).x + 1 < WALL_X + WALL_THICKNESS);
+  assert(scene_stats(scene).last_tick_collisions.impacts == 1);
+  scene_free(scene);
+}
+
+void test_slow_bullets_move_freely() {
+  scene_t *scene = scene_init();
+  body_t *wall = make_body((vector_t){WALL_X, -50},
+                           (vector_t){WALL_THICKNESS, 100}, INFINITY,
+                           WALL_TYPE);
+  body_t *bullet =
+      make_body((vector_t){0, -1}, (vector_t){2, 2}, 1, BULLET_TYPE);
+  body_set_velocity(bullet, (vector_t){100, 0});
+  body_set_bullet(bullet, true);
+  scene_add_body(scene, wall);
+  scene_add_body(scene, bullet);
+  create_collision(scene, bullet, wall, count_hit, &(size_t){0}, NULL);
+
+  // Short of the wall, the bullet moves as if it were not swept
+  scene_tick(scene, DT);
+  assert(vec_isclose(body_get_centroid(bullet), (vector_t){11, 0}));
+  assert(scene_stats(scene).last_tick_collisions.impacts == 0);
+  scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_time_of_impact)
+  DO_TEST(test_time_of_impact_diagonal)
+  DO_TEST(test_time_of_impact_capsule)
+  DO_TEST(test_bullets_stop_at_walls)
+  DO_TEST(test_angled_capsule_bullets)
+  DO_TEST(test_bullets_hit_the_nearest_body)
+  DO_TEST(test_slow_bullets_move_freely)
+
+  puts("ccd_test PASS");
+}
@@ -0,0 +1,549 @@
+#include "collision.h"
+#include "forces.h"
+#include "polygon.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const rgb_color_t RED = {1, 0, 0};
+const size_t RANDOM_CASES = 2000;
+const size_t SAMPLES = 200;
+// Random cases this close to touching are too close to call by sampling
+const double MARGIN = 0.05;
+
+list_t *make_shape(vector_t *points, size_t count) {
+  list_t *shape = list_init(count, free);
+  for (size_t i = 0; i < count; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = points[i];
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+/** The square from (0, 0) to (2, 2) */
+list_t *make_square() {
+  vector_t corners[] = {{0, 0}, {2, 0}, {2, 2}, {0, 2}};
+  return make_shape(corners, 4);
+}
+
+capsule_t circle(vector_t center, double radius) {
+  return (capsule_t){center, center, radius};
+}
+
+body_t *make_body(list_t *shape) {
+  size_t *info = malloc(sizeof(size_t));
+  *info = WALL_TYPE;
+  return body_init_with_info(shape, 1, RED, info, free);
+}
+
+void test_circles() {
+  collision_info_t collision = find_collision_capsules(
+      circle(VEC_ZERO, 1), circle((vector_t){1.5, 0}, 1));
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){1, 0}));
+
+  collision = find_collision_capsules(circle((vector_t){3, 4}, 2),
+                                      circle(VEC_ZERO, 4));
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){-0.6, -0.8}));
+
+  assert(!find_collision_capsules(circle(VEC_ZERO, 1),
+                                  circle((vector_t){2.1, 0}, 1))
+              .collided);
+
+  // Circles with the same center still get an axis
+  collision = find_collision_capsules(circle(VEC_ZERO, 1), circle(VEC_ZERO, 2));
+  assert(collision.collided);
+  assert(isclose(vec_dot(collision.axis, collision.axis), 1));
+}
+
+void test_capsules() {
+  capsule_t horizontal = {{-2, 0}, {2, 0}, 0.5};
+
+  // Side by side, the axis is the capsules' normal
+  capsule_t above = {{-1, 0.8}, {3, 0.8}, 0.5};
+  collision_info_t collision = find_collision_capsules(horizontal, above);
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){0, 1}));
+  above.start.y = above.end.y = 1.1;
+  assert(!find_collision_capsules(horizontal, above).collided);
+
+  // Past the end of one, only its round end can touch the other
+  capsule_t vertical = {{2.6, -3}, {2.6, 3}, 0.5};
+  collision = find_collision_capsules(horizontal, vertical);
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){1, 0}));
+  collision = find_collision_capsules(vertical, horizontal);
+  assert(vec_isclose(collision.axis, (vector_t){-1, 0}));
+  vertical.start.x = vertical.end.x = 3.1;
+  assert(!find_collision_capsules(horizontal, vertical).collided);
+
+  // A circle is a capsule too
+  assert(find_collision_capsules(horizontal, circle((vector_t){0, 1.4}, 1))
+             .collided);
+  assert(!find_collision_capsules(horizontal, circle((vector_t){0, 1.6}, 1))
+              .collided);
+
+  // Crossing segments have no closest points apart, but still collide
+  capsule_t crossing = {{0, -2}, {0.5, 2}, 0.5};
+  collision = find_collision_capsules(horizontal, crossing);
+  assert(collision.collided);
+  assert(isclose(vec_dot(collision.axis, collision.axis), 1));
+}
+
+void test_circle_polygon() {
+  list_t *square = make_square();
+
+  // Against a side
+  collision_info_t collision =
+      find_collision_capsule_polygon(circle((vector_t){2.5, 1}, 1), square);
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){-1, 0}));
+  assert(!find_collision_capsule_polygon(circle((vector_t){3.1, 1}, 1), square)
+              .collided);
+
+  // Off a corner, the sides' normals all overlap, but the circle is
+  // further than its radius from the corner
+  assert(!find_collision_capsule_polygon(circle((vector_t){2.8, 2.8}, 1),
+                                         square)
+              .collided);
+  collision =
+      find_collision_capsule_polygon(circle((vector_t){2.6, 2.6}, 1), square);
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){-M_SQRT1_2, -M_SQRT1_2}));
+
+  // Inside
+  assert(
+      find_collision_capsule_polygon(circle((vector_t){1, 1}, 0.1), square)
+          .collided);
+
+  list_free(square);
+}
+
+void test_capsule_polygon() {
+  list_t *square = make_square();
+
+  // Lying along the top, only the middle of the capsule reaches the square
+  capsule_t capsule = {{-3, 2.4}, {5, 2.4}, 0.5};
+  collision_info_t collision = find_collision_capsule_polygon(capsule, square);
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){0, -1}));
+  capsule.start.y = capsule.end.y = 2.6;
+  assert(!find_collision_capsule_polygon(capsule, square).collided);
+
+  // Passing diagonally by a corner, the capsule's side is what separates it
+  capsule_t diagonal = {{3.6, 1.2}, {1.2, 3.6}, 0.5};
+  assert(!find_collision_capsule_polygon(diagonal, square).collided);
+  diagonal = (capsule_t){{2.8, 1}, {1, 2.8}, 0.5};
+  collision = find_collision_capsule_polygon(diagonal, square);
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){-M_SQRT1_2, -M_SQRT1_2}));
+
+  // Pointing at a corner, the capsule's end is what separates it
+  capsule_t pointing = {{2.8, 2.8}, {5, 5}, 0.5};
+  assert(!find_collision_capsule_polygon(pointing, square).collided);
+  pointing.start = (vector_t){2.3, 2.3};
+  assert(find_collision_capsule_polygon(pointing, square).collided);
+
+  // Through the middle
+  capsule_t through = {{-5, 1}, {5, 1.5}, 0.1};
+  assert(find_collision_capsule_polygon(through, square).collided);
+
+  list_free(square);
+}
+
+/** How far a point is from a segment */
+double segment_distance(vector_t point, vector_t start, vector_t end) {
+  vector_t along = vec_subtract(end, start);
+  double t = vec_dot(vec_subtract(point, start), along) / vec_dot(along, along);
+  t = fmin(fmax(t, 0), 1);
+  vector_t delta =
+      vec_subtract(point, vec_add(start, vec_multiply(t, along)));
+  return sqrt(vec_dot(delta, delta));
+}
+
+/** How far a capsule's segment is from a polygon, sampled along it */
+double sampled_distance(capsule_t capsule, list_t *polygon) {
+  double least = INFINITY;
+  size_t size = list_size(polygon);
+  vector_t along = vec_subtract(capsule.end, capsule.start);
+  for (size_t i = 0; i <= SAMPLES; i++) {
+    vector_t point =
+        vec_add(capsule.start, vec_multiply((double)i / SAMPLES, along));
+    if (polygon_contains(polygon, point)) {
+      return 0;
+    }
+    for (size_t j = 0; j < size; j++) {
+      vector_t *start = list_get(polygon, j);
+      vector_t *end = list_get(polygon, (j + 1) % size);
+      least = fmin(least, segment_distance(point, *start, *end));
+    }
+  }
+  return least;
+}
+
+void test_capsule_polygon_matches_distance() {
+  srand(7);
+  size_t called = 0;
+  for (size_t i = 0; i < RANDOM_CASES; i++) {
+    // a random convex quadrilateral around the origin
+    vector_t corners[4];
+    for (size_t j = 0; j < 4; j++) {
+      double angle = M_PI / 2 * (j + (double)rand() / RAND_MAX * 0.8);
+      double radius = 1 + (double)rand() / RAND_MAX * 2;
+      corners[j] = (vector_t){radius * cos(angle), radius * sin(angle)};
+    }
+    list_t *polygon = make_shape(corners, 4);
+    vector_t start = {(double)rand() / RAND_MAX * 10 - 5,
+                      (double)rand() / RAND_MAX * 10 - 5};
+    vector_t along = {(double)rand() / RAND_MAX * 4 - 2,
+                      (double)rand() / RAND_MAX * 4 - 2};
+    // every fourth case is a circle
+    if (i % 4 == 0) {
+      along = VEC_ZERO;
+    }
+    capsule_t capsule = {start, vec_add(start, along),
+                         0.2 + (double)rand() / RAND_MAX};
+    double distance = sampled_distance(capsule, polygon);
+    if (fabs(distance - capsule.radius) > MARGIN) {
+      bool touching = distance < capsule.radius;
+      collision_info_t collision =
+          find_collision_capsule_polygon(capsule, polygon);
+      assert(collision.collided == touching);
+      called++;
+    }
+    list_free(polygon);
+  }
+  assert(called > RANDOM_CASES / 2);
+}
+
+void test_body_colliders() {
+  // A diamond drawn inside a circle of radius 1
+  vector_t diamond[] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+  body_t *body1 = make_body(make_shape(diamond, 4));
+  body_t *body2 = make_body(make_shape(diamond, 4));
+  body_set_centroid(body2, (vector_t){1.3, 1.3});
+  // a square, turned
+  assert(body_get_collider(body1) == COLLIDER_BOX);
+
+  // The diamonds are apart, and so is either one from the other's circle,
+  // but the circles are not
+  assert(
+      !find_body_collision(body1, body2, NARROW_PHASE_SAT, NULL).collided);
+  body_set_circle(body1, 1);
+  assert(
+      !find_body_collision(body1, body2, NARROW_PHASE_SAT, NULL).collided);
+  body_set_circle(body2, 1);
+  collision_info_t collision =
+      find_body_collision(body1, body2, NARROW_PHASE_SAT, NULL);
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){M_SQRT1_2, M_SQRT1_2}));
+  aabb_t bounds = body_get_bounds(body2);
+  assert(vec_isclose(bounds.min, (vector_t){0.3, 0.3}));
+  assert(vec_isclose(bounds.max, (vector_t){2.3, 2.3}));
+
+  // Resetting a body makes it collide as its shape again
+  list_t *shape = make_shape(diamond, 4);
+  body_reset(body2, shape, 1, RED);
+  list_free(shape);
+  assert(body_get_collider(body2) == COLLIDER_BOX);
+
+  // A circle against a polygon, both ways round
+  body_set_centroid(body2, (vector_t){1.2, 0});
+  collision = find_body_collision(body1, body2, NARROW_PHASE_SAT, NULL);
+  assert(collision.collided);
+  assert(vec_dot(collision.axis, (vector_t){1, 0}) > 0);
+  collision = find_body_collision(body2, body1, NARROW_PHASE_SAT, NULL);
+  assert(collision.collided);
+  assert(vec_dot(collision.axis, (vector_t){1, 0}) < 0);
+
+  body_free(body1);
+  body_free(body2);
+}
+
+void test_capsule_turns_with_body() {
+  vector_t rectangle[] = {{-2, -0.5}, {2, -0.5}, {2, 0.5}, {-2, 0.5}};
+  body_t *body = make_body(make_shape(rectangle, 4));
+  body_set_capsule(body, 3, 0.5);
+  assert(body_get_collider(body) == COLLIDER_CAPSULE);
+  capsule_t capsule = body_get_capsule(body);
+  assert(vec_isclose(capsule.start, (vector_t){-1.5, 0}));
+  assert(vec_isclose(capsule.end, (vector_t){1.5, 0}));
+  assert(isclose(capsule.radius, 0.5));
+
+  body_set_rotation(body, M_PI / 2);
+  body_set_centroid(body, (vector_t){10, 0});
+  capsule = body_get_capsule(body);
+  assert(vec_isclose(capsule.start, (vector_t){10, -1.5}));
+  assert(vec_isclose(capsule.end, (vector_t){10, 1.5}));
+  aabb_t bounds = body_get_bounds(body);
+  assert(vec_isclose(bounds.min, (vector_t){9.5, -2}));
+  assert(vec_isclose(bounds.max, (vector_t){10.5, 2}));
+
+  body_free(body);
+}
+
+/** Makes a rectangle's vertices, counterclockwise from its first side */
+list_t *make_rectangle_shape(obb_t box) {
+  vector_t side = {-box.axis.y, box.axis.x};
+  vector_t x = vec_multiply(box.half_size.x, box.axis);
+  vector_t y = vec_multiply(box.half_size.y, side);
+  vector_t corners[] = {
+      vec_subtract(vec_subtract(box.center, x), y),
+      vec_subtract(vec_add(box.center, x), y),
+      vec_add(vec_add(box.center, x), y),
+      vec_add(vec_subtract(box.center, x), y)};
+  return make_shape(corners, 4);
+}
+
+obb_t turned_box(vector_t center, vector_t half_size, double angle) {
+  return (obb_t){center, {cos(angle), sin(angle)}, half_size};
+}
+
+void test_rectangles_are_boxes() {
+  obb_t turned = turned_box((vector_t){3, 4}, (vector_t){2, 0.5}, 0.3);
+  list_t *rectangle = make_rectangle_shape(turned);
+  assert(polygon_is_rectangle(rectangle));
+  vector_t triangle[] = {{0, 0}, {1, 0}, {0, 1}};
+  vector_t slanted[] = {{0, 0}, {2, 0}, {3, 1}, {1, 1}};
+  vector_t pentagon[] = {{0, 0}, {2, 0}, {2, 1}, {1, 2}, {0, 1}};
+  list_t *shapes[] = {make_shape(triangle, 3), make_shape(slanted, 4),
+                      make_shape(pentagon, 5)};
+  for (size_t i = 0; i < 3; i++) {
+    assert(!polygon_is_rectangle(shapes[i]));
+    body_t *body = make_body(shapes[i]);
+    assert(body_get_collider(body) == COLLIDER_POLYGON);
+    body_free(body);
+  }
+
+  body_t *body = make_body(rectangle);
+  assert(body_get_collider(body) == COLLIDER_BOX);
+  obb_t box = body_get_box(body);
+  assert(vec_isclose(box.center, turned.center));
+  assert(vec_isclose(box.axis, turned.axis));
+  assert(vec_isclose(box.half_size, turned.half_size));
+
+  // The box turns and moves with the body
+  body_set_rotation(body, 1.0);
+  body_set_centroid(body, VEC_ZERO);
+  box = body_get_box(body);
+  assert(vec_isclose(box.center, VEC_ZERO));
+  assert(vec_isclose(box.axis, (vector_t){cos(1.3), sin(1.3)}));
+  assert(vec_isclose(box.half_size, turned.half_size));
+
+  // Round colliders win over boxes until the body is reset
+  body_set_circle(body, 1);
+  assert(body_get_collider(body) == COLLIDER_CIRCLE);
+  list_t *shape = make_shape(slanted, 4);
+  body_reset(body, shape, 1, RED);
+  assert(body_get_collider(body) == COLLIDER_POLYGON);
+  list_free(shape);
+  body_free(body);
+}
+
+void test_aligned_boxes() {
+  obb_t box1 = {VEC_ZERO, {1, 0}, {2, 1}};
+  // Turned a right angle, so its first side runs along y
+  obb_t box2 = {{3.5, 1.5}, {0, 1}, {1, 2}};
+  collision_info_t collision = find_collision_boxes(box1, box2);
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){0, 1}));
+  collision = find_collision_boxes(box2, box1);
+  assert(vec_isclose(collision.axis, (vector_t){0, -1}));
+
+  box2.center = (vector_t){3.9, 0};
+  collision = find_collision_boxes(box1, box2);
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){1, 0}));
+  box2.center = (vector_t){4.1, 0};
+  assert(!find_collision_boxes(box1, box2).collided);
+}
+
+void test_turned_boxes() {
+  obb_t box1 = {VEC_ZERO, {1, 0}, {1, 1}};
+  // A square turned to a diamond, whose corner points at box1's corner
+  obb_t box2 = turned_box((vector_t){2.2, 2.2}, (vector_t){1, 1}, M_PI / 4);
+  // Box1's axes all overlap, but the diamond's own axis separates them
+  assert(!find_collision_boxes(box1, box2).collided);
+  box2.center = (vector_t){1.5, 1.5};
+  collision_info_t collision = find_collision_boxes(box1, box2);
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){M_SQRT1_2, M_SQRT1_2}));
+
+  // Turned by a right angle from each other, boxes share their axes
+  vector_t direction = {cos(0.3), sin(0.3)};
+  obb_t box3 = turned_box(VEC_ZERO, (vector_t){1, 1}, 0.3);
+  obb_t box4 = turned_box(vec_multiply(1.2, direction), (vector_t){2, 0.5},
+                          0.3 + M_PI / 2);
+  collision = find_collision_boxes(box3, box4);
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, direction));
+  box4.center = vec_multiply(1.6, direction);
+  assert(!find_collision_boxes(box3, box4).collided);
+}
+
+void test_box_polygon() {
+  obb_t box = {VEC_ZERO, {1, 0}, {1, 1}};
+  // A triangle whose long side faces the box's corner
+  vector_t corners[] = {{3, 1}, {3, 3}, {1, 3}};
+  list_t *triangle = make_shape(corners, 3);
+  assert(!find_collision_box_polygon(box, triangle, NULL).collided);
+  polygon_translate(triangle, (vector_t){-1.2, -1.2});
+  collision_info_t collision = find_collision_box_polygon(box, triangle, NULL);
+  assert(collision.collided);
+  assert(vec_isclose(collision.axis, (vector_t){M_SQRT1_2, M_SQRT1_2}));
+  list_free(triangle);
+}
+
+void test_boxes_match_sat() {
+  srand(11);
+  arena_t *arena = arena_init(4096);
+  for (size_t i = 0; i < RANDOM_CASES; i++) {
+    vector_t center1 = {(double)rand() / RAND_MAX * 6 - 3,
+                        (double)rand() / RAND_MAX * 6 - 3};
+    vector_t half1 = {0.2 + (double)rand() / RAND_MAX * 2,
+                      0.2 + (double)rand() / RAND_MAX * 2};
+    vector_t half2 = {0.2 + (double)rand() / RAND_MAX * 2,
+                      0.2 + (double)rand() / RAND_MAX * 2};
+    // some boxes line up with the axes, or with each other
+    double angle1 = i % 3 == 0 ? 0 : (double)rand() / RAND_MAX * 2 * M_PI;
+    double angle2 =
+        i % 5 == 0 ? angle1 + M_PI / 2 : (double)rand() / RAND_MAX * 2 * M_PI;
+    obb_t box1 = turned_box(center1, half1, angle1);
+    obb_t box2 = turned_box(VEC_ZERO, half2, angle2);
+    list_t *shape1 = make_rectangle_shape(box1);
+    list_t *shape2 = make_rectangle_shape(box2);
+    bool expected = find_collision_arena(arena, shape1, shape2).collided;
+    assert(find_collision_boxes(box1, box2).collided == expected);
+    assert(find_collision_box_polygon(box1, shape2, NULL).collided == expected);
+    list_free(shape1);
+    list_free(shape2);
+  }
+  arena_free(arena);
+}
+
+/** Checks a body's cached normals against its shape's edges */
+void assert_normals_match(body_t *body) {
+  list_t *shape = body_get_shape(body);
+  size_t n = list_size(shape);
+  vector_t *expected = malloc(n * sizeof(vector_t));
+  find_perp_axis(shape, expected);
+  const vector_t *normals = body_get_normals(body);
+  for (size_t i = 0; i < n; i++) {
+    assert(vec_isclose(normals[i], expected[i]));
+  }
+  free(expected);
+  list_free(shape);
+}
+
+void test_normals_follow_rotation() {
+  vector_t corners[] = {{0, 0}, {3, 0}, {1, 2}};
+  list_t *triangle = make_shape(corners, 3);
+  body_t *body = make_body(triangle);
+  assert_normals_match(body);
+  body_set_rotation(body, 0.7);
+  assert_normals_match(body);
+  body_set_centroid(body, (vector_t){5, -5});
+  assert_normals_match(body);
+  body_set_rotation_speed(body, 2.0);
+  for (size_t i = 0; i < 10; i++) {
+    body_tick(body, 0.1);
+    assert_normals_match(body);
+  }
+
+  // A shape made already turned, and told its rotation afterwards
+  list_t *turned = make_shape(corners, 3);
+  polygon_rotate(turned, 1.0, VEC_ZERO);
+  body_t *turned_body = make_body(turned);
+  body_set_rotation_empty(turned_body, 1.0);
+  assert_normals_match(turned_body);
+  body_set_rotation(turned_body, 1.5);
+  assert_normals_match(turned_body);
+
+  // New vertices, including a different number of them
+  vector_t pentagon[] = {{0, 0}, {2, 0}, {3, 1}, {1, 3}, {-1, 1}};
+  body_set_shape(body, make_shape(pentagon, 5));
+  assert_normals_match(body);
+
+  list_free(triangle);
+  body_free(body);
+  body_free(turned_body);
+}
+
+void test_separating_axis_is_kept() {
+  srand(13);
+  for (size_t i = 0; i < RANDOM_CASES; i++) {
+    vector_t corners1[3], corners2[3];
+    for (size_t j = 0; j < 3; j++) {
+      double angle = 2 * M_PI * (j + (double)rand() / RAND_MAX * 0.5) / 3;
+      corners1[j] = (vector_t){2 * cos(angle), 2 * sin(angle)};
+      corners2[j] = (vector_t){3 * cos(angle + 1) + 4.0 * rand() / RAND_MAX,
+                               3 * sin(angle + 1) + 2.0 * rand() / RAND_MAX};
+    }
+    list_t *shape1 = make_shape(corners1, 3);
+    list_t *shape2 = make_shape(corners2, 3);
+    vector_t normals1[3], normals2[3];
+    find_perp_axis(shape1, normals1);
+    find_perp_axis(shape2, normals2);
+    // Any first axis gives the same answer as the full test
+    size_t first_axis = rand() % 6;
+    collision_info_t expected = find_collision_cached(
+        shape1, normals1, shape2, normals2, NULL);
+    collision_info_t collision = find_collision_cached(
+        shape1, normals1, shape2, normals2, &first_axis);
+    assert(collision.collided == expected.collided);
+    assert(first_axis < 6);
+    if (!collision.collided) {
+      // The kept axis separates the shapes on its own
+      vector_t axis = first_axis < 3 ? normals1[first_axis]
+                                     : normals2[first_axis - 3];
+      list_t *one1 = make_shape(corners1, 3);
+      list_t *one2 = make_shape(corners2, 3);
+      vector_t one_normal[] = {axis, axis, axis};
+      size_t kept = first_axis;
+      first_axis = 0;
+      assert(!find_collision_cached(one1, one_normal, one2, one_normal,
+                                    &first_axis)
+                  .collided);
+      // and is tried first, and kept, next time
+      first_axis = kept;
+      assert(!find_collision_cached(shape1, normals1, shape2, normals2,
+                                    &first_axis)
+                  .collided);
+      assert(first_axis == kept);
+      list_free(one1);
+      list_free(one2);
+    }
+    list_free(shape1);
+    list_free(shape2);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_circles)
+  DO_TEST(test_capsules)
+  DO_TEST(test_circle_polygon)
+  DO_TEST(test_capsule_polygon)
+  DO_TEST(test_capsule_polygon_matches_distance)
+  DO_TEST(test_body_colliders)
+  DO_TEST(test_capsule_turns_with_body)
+  DO_TEST(test_rectangles_are_boxes)
+  DO_TEST(test_aligned_boxes)
+  DO_TEST(test_turned_boxes)
+  DO_TEST(test_box_polygon)
+  DO_TEST(test_boxes_match_sat)
+  DO_TEST(test_normals_follow_rotation)
+  DO_TEST(test_separating_axis_is_kept)
+
+  puts("colliders_test PASS");
+}
@@ -0,0 +1,245 @@
+#include "contact.h"
+#include "forces.h"
+#include "gjk.h"
+#include "scene.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const rgb_color_t RED = {1, 0, 0};
+const double DT = 1.0 / 60.0;
+const double GRAVITY = 10.0;
+// Two seconds of ticks
+const size_t SETTLE_TICKS = 120;
+// How still a settled body is, and how far it may sink into what it rests
+// on (the solver's slop, and a little)
+const double STILL_SPEED = 1e-3;
+const double MAX_SINK = 0.02;
+
+list_t *make_box(vector_t corner, vector_t size) {
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {corner,
+                        {corner.x + size.x, corner.y},
+                        vec_add(corner, size),
+                        {corner.x, corner.y + size.y}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+body_t *make_body(list_t *shape, double mass) {
+  size_t *info = malloc(sizeof(size_t));
+  *info = WALL_TYPE;
+  return body_init_with_info(shape, mass, RED, info, free);
+}
+
+/** Finds the contact of two shapes, freeing them */
+contact_manifold_t find_manifold(list_t *shape1, list_t *shape2) {
+  contact_manifold_t manifold = find_contact_manifold(
+      shape1, shape2, find_penetration(shape1, shape2));
+  list_free(shape1);
+  list_free(shape2);
+  return manifold;
+}
+
+/** The floor, from y = -1 to y = 0 */
+list_t *make_floor() {
+  return make_box((vector_t){-5, -1}, (vector_t){10, 1});
+}
+
+void test_face_contact() {
+  // A box sunk 0.1 into the floor touches it along its whole bottom
+  contact_manifold_t manifold = find_manifold(
+      make_floor(), make_box((vector_t){0, -0.1}, (vector_t){2, 2}));
+  assert(manifold.count == 2);
+  assert(vec_isclose(manifold.normal, (vector_t){0, 1}));
+  for (size_t i = 0; i < 2; i++) {
+    assert(isclose(manifold.points[i].depth, 0.1));
+    assert(isclose(manifold.points[i].point.y, -0.05));
+  }
+  double width = manifold.points[0].point.x - manifold.points[1].point.x;
+  assert(isclose(fabs(width), 2));
+
+  // The other way round, the normal turns around but the points do not
+  contact_manifold_t flipped = find_manifold(
+      make_box((vector_t){0, -0.1}, (vector_t){2, 2}), make_floor());
+  assert(flipped.count == 2);
+  assert(vec_isclose(flipped.normal, (vector_t){0, -1}));
+  for (size_t i = 0; i < 2; i++) {
+    assert(isclose(flipped.points[i].depth, 0.1));
+    assert(isclose(flipped.points[i].point.y, -0.05));
+  }
+}
+
+void test_clipped_contact() {
+  // Hanging off the floor's end, the box only touches as far as x = 5
+  contact_manifold_t manifold = find_manifold(
+      make_floor(), make_box((vector_t){4, -0.1}, (vector_t){2, 2}));
+  assert(manifold.count == 2);
+  double left = fmin(manifold.points[0].point.x, manifold.points[1].point.x);
+  double right = fmax(manifold.points[0].point.x, manifold.points[1].point.x);
+  assert(isclose(left, 4));
+  assert(isclose(right, 5));
+}
+
+void test_corner_contact() {
+  // A diamond pokes one corner into the floor
+  vector_t corners[] = {{0, -0.2}, {1, 0.8}, {0, 1.8}, {-1, 0.8}};
+  list_t *diamond = list_init(4, free);
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = corners[i];
+    list_add(diamond, v);
+  }
+  contact_manifold_t manifold = find_manifold(make_floor(), diamond);
+  assert(manifold.count == 1);
+  assert(vec_isclose(manifold.normal, (vector_t){0, 1}));
+  assert(isclose(manifold.points[0].depth, 0.2));
+  assert(vec_isclose(manifold.points[0].point, (vector_t){0, -0.1}));
+
+  // Apart, there is no contact at all
+  manifold =
+      find_manifold(make_floor(), make_box((vector_t){0, 1}, (vector_t){2, 2}));
+  assert(manifold.count == 0);
+}
+
+void test_round_contact() {
+  capsule_t circle = {{0, 0.5}, {0, 0.5}, 1};
+  list_t *floor = make_floor();
+  contact_manifold_t manifold =
+      contact_manifold_point(find_penetration_capsule(circle, floor));
+  assert(manifold.count == 1);
+  assert(vec_isclose(manifold.normal, (vector_t){0, -1}));
+  assert(isclose(manifold.points[0].depth, 0.5));
+  assert(vec_isclose(manifold.points[0].point, (vector_t){0, -0.25}));
+  list_free(floor);
+}
+
+void test_warm_start() {
+  contact_manifold_t old = find_manifold(
+      make_floor(), make_box((vector_t){0, -0.1}, (vector_t){2, 2}));
+  old.points[0].normal_impulse = 1;
+  old.points[1].normal_impulse = 2;
+
+  // Moved a little, the same corners touch the same edge
+  contact_manifold_t manifold = find_manifold(
+      make_floor(), make_box((vector_t){0.1, -0.05}, (vector_t){2, 2}));
+  contact_manifold_warm_start(&manifold, &old);
+  double impulse0 = manifold.points[0].normal_impulse;
+  double impulse1 = manifold.points[1].normal_impulse;
+  assert(impulse0 + impulse1 == 3 && impulse0 != impulse1);
+
+  // A different corner touching starts from nothing
+  contact_manifold_t other = find_manifold(
+      make_floor(), make_box((vector_t){0, -0.1}, (vector_t){2, 2}));
+  other.points[0].feature = other.points[1].feature = (size_t)-1;
+  contact_manifold_warm_start(&other, &old);
+  assert(other.points[0].normal_impulse == 0);
+  assert(other.points[1].normal_impulse == 0);
+}
+
+/** Ticks a scene with gravity on some of its bodies */
+void tick_with_gravity(scene_t *scene, body_t **bodies, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    body_add_force(bodies[i],
+                   (vector_t){0, -GRAVITY * body_get_mass(bodies[i])});
+  }
+  scene_tick(scene, DT);
+}
+
+void test_box_settles() {
+  scene_t *scene = scene_init();
+  body_t *floor = make_body(make_floor(), INFINITY);
+  body_t *box = make_body(make_box((vector_t){0, 0.5}, (vector_t){2, 2}), 1);
+  scene_add_body(scene, floor);
+  scene_add_body(scene, box);
+  create_physics_collision(scene, 0.5, floor, box);
+
+  for (size_t i = 0; i < SETTLE_TICKS; i++) {
+    tick_with_gravity(scene, &box, 1);
+  }
+  // Resting on the floor, still touching it every tick, but not bouncing
+  assert(fabs(body_get_velocity(box).y) < STILL_SPEED);
+  double bottom = body_get_centroid(box).y - 1;
+  assert(bottom < 0 && bottom > -MAX_SINK);
+  assert(scene_stats(scene).last_tick_collisions.hits == 1);
+  scene_free(scene);
+}
+
+void test_stack_settles() {
+  scene_t *scene = scene_init();
+  body_t *floor = make_body(make_floor(), INFINITY);
+  scene_add_body(scene, floor);
+  body_t *boxes[3];
+  for (size_t i = 0; i < 3; i++) {
+    boxes[i] =
+        make_body(make_box((vector_t){0, 2.05 * i}, (vector_t){2, 2}), 1);
+    scene_add_body(scene, boxes[i]);
+    create_physics_collision(scene, 0, i == 0 ? floor : boxes[i - 1],
+                             boxes[i]);
+  }
+
+  for (size_t i = 0; i < SETTLE_TICKS; i++) {
+    tick_with_gravity(scene, boxes, 3);
+  }
+  // Each box rests on the one below, without sinking through it
+  double below = 0;
+  for (size_t i = 0; i < 3; i++) {
+    assert(fabs(body_get_velocity(boxes[i]).y) < STILL_SPEED);
+    double bottom = body_get_centroid(boxes[i]).y - 1;
+    assert(bottom < below && bottom > below - MAX_SINK);
+    below = bottom + 2;
+  }
+  scene_free(scene);
+}
+
+/** Drops a box onto the floor, and returns how fast it leaves it */
+double bounce(double elasticity) {
+  scene_t *scene = scene_init();
+  body_t *floor = make_body(make_floor(), INFINITY);
+  body_t *box = make_body(make_box((vector_t){0, 0.1}, (vector_t){2, 2}), 1);
+  body_set_velocity(box, (vector_t){0, -10});
+  scene_add_body(scene, floor);
+  scene_add_body(scene, box);
+  create_physics_collision(scene, elasticity, floor, box);
+
+  // The box reaches the floor in the first tick and is sent back up
+  for (size_t i = 0; i < 3; i++) {
+    scene_tick(scene, DT);
+  }
+  double speed = body_get_velocity(box).y;
+  scene_free(scene);
+  return speed;
+}
+
+void test_bounce() {
+  assert(isclose(bounce(1), 10));
+  assert(isclose(bounce(0.5), 5));
+  // Without bouncing, it only leaves as fast as its overlap is pushed out
+  assert(fabs(bounce(0)) < 2);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_face_contact)
+  DO_TEST(test_clipped_contact)
+  DO_TEST(test_corner_contact)
+  DO_TEST(test_round_contact)
+  DO_TEST(test_warm_start)
+  DO_TEST(test_box_settles)
+  DO_TEST(test_stack_settles)
+  DO_TEST(test_bounce)
+
+  puts("contact_test PASS");
+}
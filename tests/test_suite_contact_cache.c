@@ -0,0 +1,206 @@
+#include "contact_cache.h"
+#include "forces.h"
+#include "scene.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const rgb_color_t RED = {1, 0, 0};
+const double DT = 1.0 / 60.0;
+const size_t MANY_BODIES = 100;
+
+list_t *make_square(vector_t corner) {
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {corner,
+                        {corner.x + 1, corner.y},
+                        {corner.x + 1, corner.y + 1},
+                        {corner.x, corner.y + 1}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+body_t *make_body(vector_t corner) {
+  size_t *info = malloc(sizeof(size_t));
+  *info = WALL_TYPE;
+  return body_init_with_info(make_square(corner), 1, RED, info, free);
+}
+
+/** The events a listener heard, by kind */
+typedef struct {
+  size_t counts[3];
+} event_counts_t;
+
+void count_event(body_t *body1, body_t *body2, contact_event_t event,
+                 void *aux) {
+  ((event_counts_t *)aux)->counts[event]++;
+}
+
+void test_events() {
+  contact_cache_t *cache = contact_cache_init(NULL);
+  event_counts_t events = {{0, 0, 0}};
+  contact_cache_set_listener(cache, count_event, &events);
+  body_t *body1 = make_body(VEC_ZERO);
+  body_t *body2 = make_body(VEC_ZERO);
+
+  contact_event_t event;
+  contact_t *contact = contact_cache_touch(cache, body1, body2, &event);
+  assert(event == CONTACT_BEGIN);
+  assert(contact->body1 == body1 && contact->body2 == body2);
+  assert(contact->manifold.count == 0);
+  // Found in either order, and touching again this tick still begins it
+  assert(contact_cache_find(cache, body2, body1) == contact);
+  assert(contact_cache_touch(cache, body2, body1, &event) == contact);
+  assert(event == CONTACT_BEGIN);
+  assert(contact_cache_expire(cache) == 0);
+
+  assert(contact_cache_touch(cache, body1, body2, &event) == contact);
+  assert(event == CONTACT_PERSIST);
+  assert(contact_cache_expire(cache) == 0);
+  assert(contact_cache_size(cache) == 1);
+
+  // Not touched this tick, so it ends
+  assert(contact_cache_expire(cache) == 1);
+  assert(contact_cache_size(cache) == 0);
+  assert(contact_cache_find(cache, body1, body2) == NULL);
+  contact_cache_touch(cache, body1, body2, &event);
+  assert(event == CONTACT_BEGIN);
+
+  // The listener hears each event once per tick
+  assert(events.counts[CONTACT_BEGIN] == 2);
+  assert(events.counts[CONTACT_PERSIST] == 1);
+  assert(events.counts[CONTACT_END] == 1);
+
+  body_free(body1);
+  body_free(body2);
+  contact_cache_free(cache);
+}
+
+void test_removed_body() {
+  contact_cache_t *cache = contact_cache_init(NULL);
+  body_t *body1 = make_body(VEC_ZERO);
+  body_t *body2 = make_body(VEC_ZERO);
+  contact_event_t event;
+  contact_cache_touch(cache, body1, body2, &event);
+  body_remove(body2);
+  // Touched this tick, but its body is going away
+  assert(contact_cache_expire(cache) == 1);
+  assert(contact_cache_size(cache) == 0);
+  body_free(body1);
+  body_free(body2);
+  contact_cache_free(cache);
+}
+
+void test_ids() {
+  body_t *body = make_body(VEC_ZERO);
+  body_t *other = make_body(VEC_ZERO);
+  size_t id = body_get_id(body);
+  assert(id != 0 && id != body_get_id(other));
+  // A reset body, e.g. one reused by a pool, is a new body to a contact
+  list_t *shape = make_square(VEC_ZERO);
+  body_reset(body, shape, 1, RED);
+  assert(body_get_id(body) != id);
+
+  contact_cache_t *cache = contact_cache_init(NULL);
+  contact_event_t event;
+  contact_cache_touch(cache, body, other, &event);
+  assert(contact_cache_find(cache, body, other) != NULL);
+  body_reset(body, shape, 1, RED);
+  assert(contact_cache_find(cache, body, other) == NULL);
+  list_free(shape);
+  body_free(body);
+  body_free(other);
+  contact_cache_free(cache);
+}
+
+void test_many_contacts() {
+  contact_cache_t *cache = contact_cache_init(NULL);
+  body_t *hub = make_body(VEC_ZERO);
+  body_t *bodies[MANY_BODIES];
+  contact_event_t event;
+  for (size_t i = 0; i < MANY_BODIES; i++) {
+    bodies[i] = make_body(VEC_ZERO);
+    contact_cache_touch(cache, hub, bodies[i], &event);
+  }
+  assert(contact_cache_expire(cache) == 0);
+
+  // Only every third pair keeps touching
+  for (size_t i = 0; i < MANY_BODIES; i += 3) {
+    contact_cache_touch(cache, bodies[i], hub, &event);
+    assert(event == CONTACT_PERSIST);
+  }
+  assert(contact_cache_expire(cache) == MANY_BODIES - (MANY_BODIES + 2) / 3);
+  assert(contact_cache_size(cache) == (MANY_BODIES + 2) / 3);
+  for (size_t i = 0; i < MANY_BODIES; i++) {
+    contact_t *contact = contact_cache_find(cache, hub, bodies[i]);
+    assert((contact != NULL) == (i % 3 == 0));
+    assert(contact == NULL || contact->body2 == bodies[i]);
+  }
+
+  body_free(hub);
+  for (size_t i = 0; i < MANY_BODIES; i++) {
+    body_free(bodies[i]);
+  }
+  contact_cache_free(cache);
+}
+
+void count_hit(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+  (*(size_t *)aux)++;
+}
+
+void test_scene_contacts() {
+  scene_t *scene = scene_init();
+  scene_set_broad_phase(scene, BROAD_PHASE_AABB_TREE);
+  event_counts_t events = {{0, 0, 0}};
+  scene_set_contact_listener(scene, count_event, &events);
+  body_t *body1 = make_body(VEC_ZERO);
+  body_t *body2 = make_body((vector_t){0.5, 0});
+  scene_add_body(scene, body1);
+  scene_add_body(scene, body2);
+  size_t hits = 0;
+  create_collision(scene, body1, body2, count_hit, &hits, NULL);
+
+  // The handler runs once while the bodies stay touching
+  for (size_t i = 0; i < 3; i++) {
+    scene_tick(scene, DT);
+  }
+  assert(hits == 1);
+  assert(scene_contacts(scene) == 1);
+  assert(scene_find_contact(scene, body2, body1) != NULL);
+  assert(events.counts[CONTACT_BEGIN] == 1);
+  assert(events.counts[CONTACT_PERSIST] == 2);
+
+  // Once the broad phase rules the pair out, the contact ends
+  body_set_centroid(body2, (vector_t){10, 0});
+  scene_tick(scene, DT);
+  assert(scene_contacts(scene) == 0);
+  assert(events.counts[CONTACT_END] == 1);
+
+  // And touching again runs the handler again
+  body_set_centroid(body2, (vector_t){1, 0.5});
+  scene_tick(scene, DT);
+  assert(hits == 2);
+  scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_events)
+  DO_TEST(test_removed_body)
+  DO_TEST(test_ids)
+  DO_TEST(test_many_contacts)
+  DO_TEST(test_scene_contacts)
+
+  puts("contact_cache_test PASS");
+}
@@ -0,0 +1,303 @@
+#include "collision.h"
+#include "forces.h"
+#include "gjk.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const rgb_color_t RED = {1, 0, 0};
+const size_t RANDOM_CASES = 2000;
+// How far past the depth the shapes are moved to check it
+const double NUDGE = 1e-6;
+
+list_t *make_shape(vector_t *points, size_t count) {
+  list_t *shape = list_init(count, free);
+  for (size_t i = 0; i < count; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = points[i];
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+/** The rectangle from corner to corner + size */
+list_t *make_box(vector_t corner, vector_t size) {
+  vector_t corners[] = {corner,
+                        {corner.x + size.x, corner.y},
+                        vec_add(corner, size),
+                        {corner.x, corner.y + size.y}};
+  return make_shape(corners, 4);
+}
+
+/** A regular polygon, turned so its first vertex is at angle */
+list_t *make_regular(vector_t center, double radius, size_t sides,
+                     double angle) {
+  list_t *shape = list_init(sides, free);
+  for (size_t i = 0; i < sides; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    double theta = angle + 2 * M_PI * i / sides;
+    *v = vec_add(center, (vector_t){radius * cos(theta), radius * sin(theta)});
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+double random_between(double min, double max) {
+  return min + (max - min) * rand() / RAND_MAX;
+}
+
+void assert_penetration(penetration_info_t penetration, double depth,
+                        vector_t axis, vector_t point1, vector_t point2) {
+  assert(penetration.collided == (depth >= 0));
+  assert(isclose(penetration.depth, depth));
+  assert(vec_isclose(penetration.axis, axis));
+  assert(vec_isclose(penetration.point1, point1));
+  assert(vec_isclose(penetration.point2, point2));
+}
+
+void test_overlapping_boxes() {
+  list_t *box1 = make_box((vector_t){0, 0}, (vector_t){2, 2});
+  list_t *box2 = make_box((vector_t){1.5, 0.5}, (vector_t){2, 2});
+
+  // Least deep along x, where box1's right side is inside box2
+  penetration_info_t penetration = find_penetration(box1, box2);
+  assert(penetration.collided);
+  assert(isclose(penetration.depth, 0.5));
+  assert(vec_isclose(penetration.axis, (vector_t){1, 0}));
+  assert(isclose(penetration.point1.x, 2));
+  assert(isclose(penetration.point2.x, 1.5));
+  assert(isclose(penetration.point1.y, penetration.point2.y));
+
+  // The other way round, the axis turns around
+  penetration = find_penetration(box2, box1);
+  assert(isclose(penetration.depth, 0.5));
+  assert(vec_isclose(penetration.axis, (vector_t){-1, 0}));
+
+  list_free(box1);
+  list_free(box2);
+}
+
+void test_separated_boxes() {
+  list_t *box1 = make_box((vector_t){0, 0}, (vector_t){2, 2});
+  list_t *beside = make_box((vector_t){5, 1}, (vector_t){2, 2});
+  list_t *diagonal = make_box((vector_t){3, 3}, (vector_t){2, 2});
+
+  penetration_info_t penetration = find_penetration(box1, beside);
+  assert(!penetration.collided);
+  assert(isclose(penetration.depth, -3));
+  assert(vec_isclose(penetration.axis, (vector_t){1, 0}));
+  assert(isclose(penetration.point1.x, 2));
+  assert(isclose(penetration.point2.x, 5));
+
+  // Corner to corner
+  assert_penetration(find_penetration(box1, diagonal), -M_SQRT2,
+                     (vector_t){M_SQRT1_2, M_SQRT1_2}, (vector_t){2, 2},
+                     (vector_t){3, 3});
+
+  list_free(box1);
+  list_free(beside);
+  list_free(diagonal);
+}
+
+void test_vertex_order() {
+  // Clockwise, with a repeated vertex like the hearts' notch
+  vector_t corners[] = {{0, 0}, {0, 2}, {2, 2}, {2, 2}, {2, 0}};
+  list_t *box1 = make_shape(corners, 5);
+  list_t *box2 = make_box((vector_t){1.5, 0.5}, (vector_t){2, 2});
+
+  penetration_info_t penetration = find_penetration(box1, box2);
+  assert(penetration.collided);
+  assert(isclose(penetration.depth, 0.5));
+  assert(vec_isclose(penetration.axis, (vector_t){1, 0}));
+
+  list_free(box1);
+  list_free(box2);
+}
+
+void test_capsules() {
+  list_t *box = make_box((vector_t){1.2, -2}, (vector_t){2, 4});
+
+  // The capsule's end reaches 0.3 into the box
+  capsule_t capsule = {{-1, 0}, {1, 0}, 0.5};
+  assert_penetration(find_penetration_capsule(capsule, box), 0.3,
+                     (vector_t){1, 0}, (vector_t){1.5, 0},
+                     (vector_t){1.2, 0});
+
+  // With its segment inside the box too, the radius adds to the depth
+  capsule = (capsule_t){{0, 0}, {2.2, 0}, 0.5};
+  penetration_info_t penetration = find_penetration_capsule(capsule, box);
+  assert(penetration.collided);
+  assert(isclose(penetration.depth, 1.5));
+  assert(vec_isclose(penetration.axis, (vector_t){1, 0}));
+
+  // A circle near a corner is only as deep as its rounded side reaches
+  vector_t center = {0.5, 2.5};
+  vector_t corner = {1.2, 2};
+  vector_t apart = vec_subtract(corner, center);
+  double distance = sqrt(vec_dot(apart, apart));
+  vector_t axis = vec_multiply(1 / distance, apart);
+  capsule = (capsule_t){center, center, 1};
+  assert_penetration(find_penetration_capsule(capsule, box), 1 - distance,
+                     axis, vec_add(center, axis), corner);
+  capsule.radius = 0.5;
+  assert_penetration(find_penetration_capsule(capsule, box), 0.5 - distance,
+                     axis, vec_add(center, vec_multiply(0.5, axis)), corner);
+
+  list_free(box);
+}
+
+/** Finds the least overlap of the shapes' projections on their normals */
+double sat_depth(list_t *shape1, list_t *shape2) {
+  list_t *shapes[] = {shape1, shape2};
+  double depth = INFINITY;
+  for (size_t s = 0; s < 2; s++) {
+    size_t n = list_size(shapes[s]);
+    for (size_t i = 0; i < n; i++) {
+      vector_t *start = list_get(shapes[s], i);
+      vector_t *end = list_get(shapes[s], (i + 1) % n);
+      vector_t edge = vec_subtract(*end, *start);
+      double length = sqrt(vec_dot(edge, edge));
+      vector_t normal = {-edge.y / length, edge.x / length};
+      double min1 = INFINITY, max1 = -INFINITY;
+      double min2 = INFINITY, max2 = -INFINITY;
+      for (size_t j = 0; j < list_size(shape1); j++) {
+        double dot = vec_dot(normal, *(vector_t *)list_get(shape1, j));
+        min1 = fmin(min1, dot);
+        max1 = fmax(max1, dot);
+      }
+      for (size_t j = 0; j < list_size(shape2); j++) {
+        double dot = vec_dot(normal, *(vector_t *)list_get(shape2, j));
+        min2 = fmin(min2, dot);
+        max2 = fmax(max2, dot);
+      }
+      depth = fmin(depth, fmin(max1 - min2, max2 - min1));
+    }
+  }
+  return depth;
+}
+
+void test_matches_sat() {
+  srand(48);
+  size_t collided = 0;
+  for (size_t i = 0; i < RANDOM_CASES; i++) {
+    list_t *shape1 =
+        make_regular(VEC_ZERO, random_between(0.5, 2),
+                     3 + rand() % 30, random_between(0, 2 * M_PI));
+    vector_t center = {random_between(-4, 4), random_between(-4, 4)};
+    list_t *shape2 =
+        make_regular(center, random_between(0.5, 2), 3 + rand() % 30,
+                     random_between(0, 2 * M_PI));
+
+    penetration_info_t penetration = find_penetration(shape1, shape2);
+    double depth = sat_depth(shape1, shape2);
+    if (depth > 0) {
+      // Convex polygons overlap least along one of their edge normals
+      assert(penetration.collided);
+      assert(fabs(penetration.depth - depth) < 1e-6);
+      collided++;
+    } else {
+      assert(!penetration.collided);
+      assert(penetration.depth <= depth + 1e-6);
+    }
+    // point1 - point2 is always the axis times the depth
+    assert(vec_isclose(
+        vec_subtract(penetration.point1, penetration.point2),
+        vec_multiply(penetration.depth, penetration.axis)));
+
+    // Moving shape2 along the axis just past the depth separates them,
+    // and just short of it does not
+    polygon_translate(shape2,
+                      vec_multiply(penetration.depth + NUDGE,
+                                   penetration.axis));
+    assert(!find_penetration(shape1, shape2).collided);
+    polygon_translate(shape2, vec_multiply(-2 * NUDGE, penetration.axis));
+    assert(find_penetration(shape1, shape2).collided);
+
+    list_free(shape1);
+    list_free(shape2);
+  }
+  // Both kinds of case came up
+  assert(collided > RANDOM_CASES / 10);
+  assert(collided < RANDOM_CASES * 9 / 10);
+}
+
+body_t *make_body(list_t *shape) {
+  size_t *info = malloc(sizeof(size_t));
+  *info = WALL_TYPE;
+  return body_init_with_info(shape, 1, RED, info, free);
+}
+
+void test_narrow_phases_agree() {
+  srand(49);
+  for (size_t i = 0; i < RANDOM_CASES; i++) {
+    body_t *body1 = make_body(make_regular(VEC_ZERO, random_between(0.5, 2),
+                                           3 + rand() % 30, 0));
+    body_t *body2 = make_body(make_regular(VEC_ZERO, random_between(0.5, 2),
+                                           3 + rand() % 30, 0));
+    body_set_rotation(body1, random_between(0, 2 * M_PI));
+    body_set_rotation(body2, random_between(0, 2 * M_PI));
+    body_set_centroid(body2,
+                      (vector_t){random_between(-4, 4), random_between(-4, 4)});
+    if (rand() % 4 == 0) {
+      body_set_capsule(body1, random_between(0, 2), random_between(0.1, 1));
+    }
+
+    collision_info_t sat =
+        find_body_collision(body1, body2, NARROW_PHASE_SAT, NULL);
+    collision_info_t gjk =
+        find_body_collision(body1, body2, NARROW_PHASE_GJK, NULL);
+    collision_info_t automatic =
+        find_body_collision(body1, body2, NARROW_PHASE_AUTO, NULL);
+    // Pairs that only just touch may go either way
+    list_t *shape2 = body_get_shape(body2);
+    penetration_info_t penetration;
+    if (body_get_collider(body1) == COLLIDER_CAPSULE) {
+      penetration = find_penetration_capsule(body_get_capsule(body1), shape2);
+    } else {
+      list_t *shape1 = body_get_shape(body1);
+      penetration = find_penetration(shape1, shape2);
+      list_free(shape1);
+    }
+    list_free(shape2);
+    if (fabs(penetration.depth) > NUDGE) {
+      assert(gjk.collided == penetration.collided);
+      assert(sat.collided == gjk.collided);
+      assert(automatic.collided == gjk.collided);
+    }
+    body_free(body1);
+    body_free(body2);
+  }
+}
+
+void test_scene_narrow_phase() {
+  scene_t *scene = scene_init();
+  assert(scene_get_narrow_phase(scene) == NARROW_PHASE_AUTO);
+  for (narrow_phase_kind_t kind = 0; kind < NARROW_PHASE_KIND_COUNT;
+       kind++) {
+    scene_set_narrow_phase(scene, kind);
+    assert(scene_get_narrow_phase(scene) == kind);
+    assert(narrow_phase_name(kind) != NULL);
+  }
+  scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_overlapping_boxes)
+  DO_TEST(test_separated_boxes)
+  DO_TEST(test_vertex_order)
+  DO_TEST(test_capsules)
+  DO_TEST(test_matches_sat)
+  DO_TEST(test_narrow_phases_agree)
+  DO_TEST(test_scene_narrow_phase)
+
+  puts("gjk_test PASS");
+}
@@ -0,0 +1,150 @@
+#include "perf_overlay.h"
+#include "scene.h"
+#include "sdl_wrapper.h"
+#include "test_util.h"
+#include <SDL2/SDL_ttf.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+const int FRAME_WIDTH = 200;
+const int FRAME_HEIGHT = 100;
+const char FONT_PATH[] = "assets/font.ttf";
+const char BLANK_FRAME[] = "out/perf_overlay_blank.ppm";
+const uint64_t MS = 1000000;
+
+perf_sample_t frame(uint64_t frame_ms) {
+  return (perf_sample_t){.frame_ns = frame_ms * MS,
+                         .simulate_ns = 2 * MS,
+                         .render_ns = 3 * MS,
+                         .bodies = 7,
+                         .forces = 12,
+                         .collision_tests = 10};
+}
+
+void test_updates_a_few_times_per_second() {
+  perf_overlay_t *overlay =
+      perf_overlay_init(NULL, (vector_t){0, 50}, (vector_t){50, 30});
+  assert(!perf_overlay_visible(overlay));
+  // 24 frames of 10 ms is not yet a quarter second
+  for (size_t i = 0; i < 24; i++) {
+    perf_overlay_add_sample(overlay, frame(10));
+  }
+  assert(strcmp(perf_overlay_line(overlay, 0), "FPS --") == 0);
+  perf_overlay_add_sample(overlay, frame(10));
+  assert(strcmp(perf_overlay_line(overlay, 0), "FPS 100.0") == 0);
+  assert(strcmp(perf_overlay_line(overlay, 2),
+                "simulate 2.00 ms  render 3.00 ms") == 0);
+  assert(strcmp(perf_overlay_line(overlay, 3), "bodies 7  forces 12") == 0);
+  assert(strcmp(perf_overlay_line(overlay, 4), "collision tests 10 / frame") ==
+         0);
+
+  // The text stays as it was until the next quarter second
+  for (size_t i = 0; i < 4; i++) {
+    perf_overlay_add_sample(overlay, frame(50));
+  }
+  assert(strcmp(perf_overlay_line(overlay, 0), "FPS 100.0") == 0);
+  perf_overlay_add_sample(overlay, frame(50));
+  assert(strcmp(perf_overlay_line(overlay, 0), "FPS 20.0") == 0);
+
+  perf_overlay_toggle(overlay);
+  assert(perf_overlay_visible(overlay));
+  perf_overlay_toggle(overlay);
+  assert(!perf_overlay_visible(overlay));
+  perf_overlay_free(overlay);
+}
+
+void test_percentiles() {
+  perf_overlay_t *overlay =
+      perf_overlay_init(NULL, (vector_t){0, 50}, (vector_t){50, 30});
+  // 99 quick frames and one slow one
+  for (size_t i = 0; i < 99; i++) {
+    perf_overlay_add_sample(overlay, frame(2));
+  }
+  perf_overlay_add_sample(overlay, frame(100));
+  assert(strcmp(perf_overlay_line(overlay, 1),
+                "frame p50 2.00 ms  p99 2.00 ms") == 0);
+  // A few more slow frames push it into the 99th percentile
+  for (size_t i = 0; i < 3; i++) {
+    perf_overlay_add_sample(overlay, frame(100));
+  }
+  assert(strcmp(perf_overlay_line(overlay, 1),
+                "frame p50 2.00 ms  p99 100.00 ms") == 0);
+  perf_overlay_free(overlay);
+}
+
+void test_scene_sample() {
+  scene_t *scene = scene_init();
+  list_t *shape = list_init(3, free);
+  vector_t corners[] = {{0, 0}, {1, 0}, {0, 1}};
+  for (size_t i = 0; i < 3; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  size_t *type = malloc(sizeof(size_t));
+  *type = WALL_TYPE;
+  scene_add_body(scene, body_init_with_info(shape, 1, (rgb_color_t){0, 0, 0},
+                                            type, free));
+  scene_tick(scene, 0.01);
+  perf_sample_t sample = {0};
+  perf_sample_scene(&sample, scene);
+  assert(sample.bodies == 1);
+  assert(sample.forces == 0);
+  assert(sample.collision_tests == 0);
+  scene_free(scene);
+}
+
+void test_draws_only_when_visible() {
+  TTF_Font *font = TTF_OpenFont(FONT_PATH, 12);
+  assert(font != NULL);
+  text_t *text = text_init(font, (free_func_t)TTF_CloseFont);
+  perf_overlay_t *overlay =
+      perf_overlay_init(text, (vector_t){0, 50}, (vector_t){50, 30});
+  for (size_t i = 0; i < 30; i++) {
+    perf_overlay_add_sample(overlay, frame(10));
+  }
+
+  sdl_clear();
+  sdl_show();
+  assert(sdl_dump_frame(BLANK_FRAME));
+  sdl_clear();
+  perf_overlay_draw(overlay);
+  sdl_show();
+  assert(sdl_frame_diff(BLANK_FRAME, 0) == 0);
+
+  perf_overlay_toggle(overlay);
+  sdl_clear();
+  perf_overlay_draw(overlay);
+  sdl_show();
+  assert(sdl_frame_diff(BLANK_FRAME, 0) > 0);
+  // The glyphs are cached, so drawing again looks the same
+  sdl_clear();
+  perf_overlay_draw(overlay);
+  sdl_show();
+  assert(sdl_frame_diff(BLANK_FRAME, 0) > 0);
+
+  remove(BLANK_FRAME);
+  perf_overlay_free(overlay);
+  text_free(text);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  sdl_init_offscreen(VEC_ZERO, (vector_t){MAX_WIDTH_GAME, MAX_HEIGHT_GAME},
+                     FRAME_WIDTH, FRAME_HEIGHT);
+
+  DO_TEST(test_updates_a_few_times_per_second)
+  DO_TEST(test_percentiles)
+  DO_TEST(test_scene_sample)
+  DO_TEST(test_draws_only_when_visible)
+
+  puts("perf_overlay_test PASS");
+}
@@ -0,0 +1,137 @@
+#include "profiler.h"
+#include "test_util.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t MAX_EVENTS = 64;
+
+/** Spins for at least the given number of nanoseconds */
+void busy_wait(uint64_t ns) {
+  uint64_t start = profile_now_ns();
+  while (profile_now_ns() - start < ns) {
+  }
+}
+
+void scoped(void) {
+  PROFILE_SCOPE("scoped");
+  busy_wait(1000);
+}
+
+void test_disabled_records_nothing() {
+  profile_enable(false);
+  profile_reset();
+  PROFILE_BEGIN("ignored");
+  PROFILE_END();
+  scoped();
+  profile_event_t events[MAX_EVENTS];
+  assert(profile_thread_events(events, MAX_EVENTS) == 0);
+}
+
+void test_nested_scopes() {
+  profile_enable(true);
+  profile_reset();
+  PROFILE_BEGIN("outer");
+  busy_wait(1000);
+  scoped();
+  busy_wait(1000);
+  PROFILE_END();
+  profile_enable(false);
+
+  profile_event_t events[MAX_EVENTS];
+  assert(profile_thread_events(events, MAX_EVENTS) == 2);
+  // scopes are recorded when they close, so the inner one comes first
+  assert(strcmp(events[0].name, "scoped") == 0);
+  assert(events[0].depth == 1);
+  assert(events[0].duration_ns >= 1000);
+  assert(strcmp(events[1].name, "outer") == 0);
+  assert(events[1].depth == 0);
+  assert(events[1].start_ns <= events[0].start_ns);
+  assert(events[1].start_ns + events[1].duration_ns >=
+         events[0].start_ns + events[0].duration_ns);
+  assert(events[1].duration_ns >= events[0].duration_ns + 2000);
+}
+
+void test_ring_keeps_newest() {
+  profile_enable(true);
+  profile_reset();
+  for (size_t i = 0; i < PROFILE_EVENTS + 10; i++) {
+    PROFILE_BEGIN(i < PROFILE_EVENTS ? "old" : "new");
+    PROFILE_END();
+  }
+  profile_enable(false);
+  profile_event_t *events = malloc(PROFILE_EVENTS * sizeof(profile_event_t));
+  assert(profile_thread_events(events, PROFILE_EVENTS) == PROFILE_EVENTS);
+  assert(strcmp(events[0].name, "old") == 0);
+  assert(strcmp(events[PROFILE_EVENTS - 1].name, "new") == 0);
+  assert(strcmp(events[PROFILE_EVENTS - 10].name, "new") == 0);
+  assert(strcmp(events[PROFILE_EVENTS - 11].name, "old") == 0);
+  free(events);
+}
+
+void *worker(void *data) {
+  PROFILE_THREAD("worker");
+  for (size_t i = 0; i < 100; i++) {
+    PROFILE_SCOPE("work");
+  }
+  profile_event_t events[MAX_EVENTS];
+  size_t *count = data;
+  *count = profile_thread_events(events, MAX_EVENTS);
+  return NULL;
+}
+
+void test_threads_and_trace() {
+  profile_enable(true);
+  profile_reset();
+  PROFILE_THREAD("test");
+  PROFILE_BEGIN("main \"quoted\"");
+  pthread_t threads[2];
+  size_t counts[2];
+  for (size_t i = 0; i < 2; i++) {
+    pthread_create(&threads[i], NULL, worker, &counts[i]);
+  }
+  for (size_t i = 0; i < 2; i++) {
+    pthread_join(threads[i], NULL);
+    // each thread only sees its own events
+    assert(counts[i] == MAX_EVENTS);
+  }
+  PROFILE_END();
+  profile_enable(false);
+
+  FILE *out = tmpfile();
+  assert(out != NULL);
+  size_t written = profile_write_trace(out);
+  assert(written == 2 * 100 + 1);
+  size_t size = ftell(out);
+  rewind(out);
+  char *trace = malloc(size + 1);
+  assert(fread(trace, 1, size, out) == size);
+  trace[size] = '\0';
+  fclose(out);
+  assert(strncmp(trace, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 39) ==
+         0);
+  assert(strstr(trace, "\"name\":\"worker\"") != NULL);
+  assert(strstr(trace, "\"name\":\"test\"") != NULL);
+  assert(strstr(trace, "\"name\":\"main \\\"quoted\\\"\",\"ph\":\"X\"") !=
+         NULL);
+  assert(strstr(trace, "\n]}\n") != NULL);
+  free(trace);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_disabled_records_nothing)
+  DO_TEST(test_nested_scopes)
+  DO_TEST(test_ring_keeps_newest)
+  DO_TEST(test_threads_and_trace)
+
+  puts("profiler_test PASS");
+}
@@ -0,0 +1,108 @@
+#include "body.h"
+#include "scene.h"
+#include "sdl_wrapper.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+const int FRAME_WIDTH = 200;
+const int FRAME_HEIGHT = 100;
+const char GOLDEN_DIR[] = "tests/golden";
+const char GOLDEN_SCENE[] = "tests/golden/render_scene.ppm";
+
+list_t *make_square(vector_t center, double side) {
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {{+1, +1}, {-1, +1}, {-1, -1}, {+1, -1}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = vec_add(center, vec_multiply(side / 2, corners[i]));
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+body_t *make_body(vector_t center, double side, rgb_color_t color) {
+  size_t *type = malloc(sizeof(*type));
+  *type = WALL_TYPE;
+  return body_init_with_info(make_square(center, side), INFINITY, color, type,
+                             free);
+}
+
+/** Renders a fixed scene of untextured polygons, so the output is stable */
+void render_fixed_scene() {
+  scene_t *scene = scene_init();
+  scene_add_body(scene,
+                 make_body((vector_t){25, 25}, 20, (rgb_color_t){1, 0, 0}));
+  scene_add_body(scene,
+                 make_body((vector_t){50, 25}, 10, (rgb_color_t){0, 1, 0}));
+  body_t *rotated = make_body((vector_t){75, 25}, 20, (rgb_color_t){0, 0, 1});
+  body_set_rotation(rotated, M_PI / 4);
+  scene_add_body(scene, rotated);
+  sdl_render_scene(scene);
+  scene_free(scene);
+}
+
+void test_offscreen_size() {
+  assert(sdl_is_offscreen());
+  vector_t window_center = get_window_center();
+  assert(vec_equal(window_center,
+                   (vector_t){FRAME_WIDTH / 2, FRAME_HEIGHT / 2}));
+  // The scene fits the frame exactly, so its corners map to the frame corners
+  assert(vec_equal(get_window_position(VEC_ZERO, window_center),
+                   (vector_t){0, FRAME_HEIGHT}));
+  assert(vec_equal(
+      get_window_position((vector_t){MAX_WIDTH_GAME, MAX_HEIGHT_GAME},
+                          window_center),
+      (vector_t){FRAME_WIDTH, 0}));
+}
+
+void test_dump_round_trip() {
+  render_fixed_scene();
+  char *path = "out/test_render_round_trip.ppm";
+  assert(sdl_dump_frame(path));
+  assert(sdl_frame_diff(path, 0) == 0);
+
+  // A different frame should not match the dump
+  sdl_clear();
+  assert(sdl_frame_diff(path, 0) > 0);
+  remove(path);
+}
+
+void test_missing_golden() {
+  assert(sdl_frame_diff("out/does_not_exist.ppm", 0) == SIZE_MAX);
+}
+
+void test_golden_scene() {
+  render_fixed_scene();
+  if (getenv("UPDATE_GOLDEN") != NULL) {
+    // Re-record the golden image after an intended rendering change
+    mkdir(GOLDEN_DIR, 0755);
+    assert(sdl_dump_frame(GOLDEN_SCENE));
+    printf("wrote %s\n", GOLDEN_SCENE);
+    return;
+  }
+  // A missing golden image is a failure too (the diff is SIZE_MAX)
+  assert(sdl_frame_diff(GOLDEN_SCENE, 2) == 0);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  sdl_init_offscreen(VEC_ZERO, (vector_t){MAX_WIDTH_GAME, MAX_HEIGHT_GAME},
+                     FRAME_WIDTH, FRAME_HEIGHT);
+
+  DO_TEST(test_offscreen_size)
+  DO_TEST(test_dump_round_trip)
+  DO_TEST(test_missing_golden)
+  DO_TEST(test_golden_scene)
+
+  puts("render_test PASS");
+}
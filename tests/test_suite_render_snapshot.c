@@ -0,0 +1,195 @@
+#include "render_snapshot.h"
+#include "test_util.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+const size_t RACE_FRAMES = 20000;
+const size_t RACE_POLYGONS = 20;
+
+/** Makes a list of n vertices that are all at the given point */
+list_t *make_points(size_t n, vector_t point) {
+  list_t *points = list_init(n, free);
+  for (size_t i = 0; i < n; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = point;
+    list_add(points, v);
+  }
+  return points;
+}
+
+void test_snapshot_records_items() {
+  render_buffer_t *buffer = render_buffer_init();
+  render_snapshot_t *snapshot = render_buffer_begin_write(buffer);
+  assert(snapshot != NULL);
+  assert(render_snapshot_size(snapshot) == 0);
+
+  list_t *points = make_points(3, (vector_t){1, 2});
+  render_snapshot_add_polygon(snapshot, points, (rgb_color_t){1, 0, 0});
+  // The vertices are copied, so the list can go away
+  list_free(points);
+  render_snapshot_add_texture(snapshot, 4, "assets/tank.png", (vector_t){5, 6},
+                              0.5);
+  char words[] = "1   -   0";
+  render_snapshot_add_text(snapshot, NULL, words, (SDL_Color){0, 0, 0, 255},
+                           (vector_t){7, 8});
+  render_snapshot_add_glyphs(snapshot, NULL, "FPS 60",
+                             (SDL_Color){0, 0, 0, 255}, (vector_t){9, 10});
+  words[0] = '2';
+
+  assert(render_snapshot_size(snapshot) == 4);
+  const render_item_t *polygon = render_snapshot_get(snapshot, 0);
+  assert(polygon->kind == RENDER_POLYGON);
+  assert(polygon->vertex_count == 3);
+  const vector_t *vertices = render_snapshot_vertices(snapshot, polygon);
+  for (size_t i = 0; i < 3; i++) {
+    assert(vec_equal(vertices[i], (vector_t){1, 2}));
+  }
+  const render_item_t *texture = render_snapshot_get(snapshot, 1);
+  assert(texture->kind == RENDER_TEXTURE);
+  assert(texture->texture_id == 4);
+  assert(vec_equal(texture->centroid, (vector_t){5, 6}));
+  assert(texture->rotation == 0.5);
+  const render_item_t *text = render_snapshot_get(snapshot, 2);
+  assert(text->kind == RENDER_TEXT);
+  assert(strcmp(render_snapshot_text(snapshot, text), "1   -   0") == 0);
+  assert(vec_equal(text->loc, (vector_t){7, 8}));
+  const render_item_t *glyphs = render_snapshot_get(snapshot, 3);
+  assert(glyphs->kind == RENDER_GLYPHS);
+  assert(strcmp(render_snapshot_text(snapshot, glyphs), "FPS 60") == 0);
+
+  // The window size is recorded with the frame, and kept until it is set
+  assert(vec_equal(render_snapshot_window_size(snapshot), VEC_ZERO));
+  render_snapshot_set_window_size(snapshot, (vector_t){1000, 500});
+  render_snapshot_clear(snapshot);
+  assert(render_snapshot_size(snapshot) == 0);
+  assert(
+      vec_equal(render_snapshot_window_size(snapshot), (vector_t){1000, 500}));
+  render_buffer_free(buffer);
+}
+
+void test_snapshot_grows() {
+  render_buffer_t *buffer = render_buffer_init();
+  render_snapshot_t *snapshot = render_buffer_begin_write(buffer);
+  char words[] = "a";
+  for (size_t i = 0; i < 1000; i++) {
+    list_t *points = make_points(4, (vector_t){i, i});
+    render_snapshot_add_polygon(snapshot, points, (rgb_color_t){0, 0, 0});
+    list_free(points);
+    words[0] = 'a' + i % 26;
+    render_snapshot_add_text(snapshot, NULL, words, (SDL_Color){0, 0, 0, 0},
+                             VEC_ZERO);
+  }
+  assert(render_snapshot_size(snapshot) == 2000);
+  for (size_t i = 0; i < 1000; i++) {
+    const render_item_t *polygon = render_snapshot_get(snapshot, 2 * i);
+    assert(render_snapshot_vertices(snapshot, polygon)[3].x == i);
+    const render_item_t *text = render_snapshot_get(snapshot, 2 * i + 1);
+    assert(render_snapshot_text(snapshot, text)[0] == 'a' + i % 26);
+  }
+  render_buffer_free(buffer);
+}
+
+void test_buffer_protocol() {
+  render_buffer_t *buffer = render_buffer_init();
+  // Nothing has been published yet
+  assert(render_buffer_acquire(buffer) == NULL);
+
+  render_snapshot_t *first = render_buffer_begin_write(buffer);
+  render_buffer_publish(buffer);
+  assert(render_buffer_acquire(buffer) == first);
+
+  // While the reader holds the first snapshot, the writer gets the other one
+  render_snapshot_t *second = render_buffer_begin_write(buffer);
+  assert(second != NULL && second != first);
+  render_buffer_publish(buffer);
+  // ... and the one after that would overwrite the held snapshot, so it drops
+  assert(render_buffer_begin_write(buffer) == NULL);
+  render_buffer_publish(buffer);
+  render_buffer_release(buffer);
+
+  // The reader skips straight to the newest snapshot, and only once
+  assert(render_buffer_acquire(buffer) == second);
+  render_buffer_release(buffer);
+  assert(render_buffer_acquire(buffer) == NULL);
+
+  render_stats_t stats = render_buffer_stats(buffer);
+  assert(stats.published == 2);
+  assert(stats.dropped == 1);
+  assert(stats.rendered == 2);
+  render_buffer_free(buffer);
+}
+
+/** Publishes frames whose vertices all hold the frame's number */
+void *write_frames(void *aux) {
+  render_buffer_t *buffer = aux;
+  for (size_t frame = 1; frame <= RACE_FRAMES; frame++) {
+    render_snapshot_t *snapshot = render_buffer_begin_write(buffer);
+    if (snapshot == NULL) {
+      continue;
+    }
+    for (size_t i = 0; i < RACE_POLYGONS; i++) {
+      list_t *points = make_points(3, (vector_t){frame, frame});
+      render_snapshot_add_polygon(snapshot, points, (rgb_color_t){0, 0, 0});
+      list_free(points);
+    }
+    render_buffer_publish(buffer);
+  }
+  return NULL;
+}
+
+void test_buffer_race() {
+  render_buffer_t *buffer = render_buffer_init();
+  pthread_t writer;
+  assert(pthread_create(&writer, NULL, write_frames, buffer) == 0);
+
+  // Every acquired snapshot must be one whole frame, newer than the last one
+  double last_frame = 0;
+  while (last_frame < RACE_FRAMES) {
+    render_snapshot_t *snapshot = render_buffer_acquire(buffer);
+    if (snapshot == NULL) {
+      render_stats_t stats = render_buffer_stats(buffer);
+      if (stats.published + stats.dropped == RACE_FRAMES) {
+        // The writer is done; the last frame may have been dropped
+        break;
+      }
+      continue;
+    }
+    assert(render_snapshot_size(snapshot) == RACE_POLYGONS);
+    double frame = render_snapshot_vertices(
+        snapshot, render_snapshot_get(snapshot, 0))[0].x;
+    assert(frame > last_frame);
+    for (size_t i = 0; i < RACE_POLYGONS; i++) {
+      const vector_t *vertices =
+          render_snapshot_vertices(snapshot, render_snapshot_get(snapshot, i));
+      for (size_t j = 0; j < 3; j++) {
+        assert(vertices[j].x == frame && vertices[j].y == frame);
+      }
+    }
+    last_frame = frame;
+    render_buffer_release(buffer);
+  }
+  assert(pthread_join(writer, NULL) == 0);
+
+  render_stats_t stats = render_buffer_stats(buffer);
+  assert(stats.published + stats.dropped == RACE_FRAMES);
+  assert(stats.rendered <= stats.published);
+  render_buffer_free(buffer);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_snapshot_records_items)
+  DO_TEST(test_snapshot_grows)
+  DO_TEST(test_buffer_protocol)
+  DO_TEST(test_buffer_race)
+
+  puts("render_snapshot_test PASS");
+}
@@ -0,0 +1,264 @@
+#include "polygon.h"
+#include "scene.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const rgb_color_t RED = {1, 0, 0};
+#define MAX_HITS 8
+const size_t RANDOM_BODIES = 100;
+const size_t RANDOM_RAYS = 200;
+const double RANDOM_AREA = 100.0;
+
+body_t *make_polygon(vector_t *points, size_t count, double mass,
+                     size_t type) {
+  list_t *shape = list_init(count, free);
+  for (size_t i = 0; i < count; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = points[i];
+    list_add(shape, v);
+  }
+  size_t *info = malloc(sizeof(size_t));
+  *info = type;
+  return body_init_with_info(shape, mass, RED, info, free);
+}
+
+/** Makes a box; walls have infinite mass, like the map's obstacles */
+body_t *make_box(vector_t corner, vector_t size, size_t type) {
+  vector_t corners[] = {corner,
+                        {corner.x + size.x, corner.y},
+                        vec_add(corner, size),
+                        {corner.x, corner.y + size.y}};
+  return make_polygon(corners, 4, type == WALL_TYPE ? INFINITY : 1, type);
+}
+
+/** A right triangle filling the lower right half of the box from 0 to 10 */
+body_t *make_triangle() {
+  vector_t corners[] = {{0, 0}, {10, 0}, {10, 10}};
+  return make_polygon(corners, 3, 1, BULLET_TYPE);
+}
+
+bool is_wall(body_t *body, void *aux) {
+  return *(size_t *)body_get_info(body) == WALL_TYPE;
+}
+
+bool is_not(body_t *body, void *aux) { return body != aux; }
+
+bool list_has(list_t *list, body_t *body) {
+  for (size_t i = 0; i < list_size(list); i++) {
+    if (list_get(list, i) == body) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void test_query_aabb() {
+  for (broad_phase_kind_t kind = 0; kind < BROAD_PHASE_KIND_COUNT; kind++) {
+    scene_t *scene = scene_init();
+    scene_set_broad_phase(scene, kind);
+    body_t *triangle = make_triangle();
+    body_t *wall = make_box((vector_t){20, 0}, (vector_t){5, 5}, WALL_TYPE);
+    body_t *far = make_box((vector_t){80, 80}, (vector_t){5, 5}, WALL_TYPE);
+    scene_add_body(scene, triangle);
+    scene_add_body(scene, wall);
+    scene_add_body(scene, far);
+
+    list_t *hits = list_init(3, NULL);
+    aabb_t box = {{5, 1}, {22, 3}};
+    assert(scene_query_aabb(scene, box, QUERY_ALL_HITS, NULL, NULL, hits) ==
+           2);
+    assert(list_has(hits, triangle) && list_has(hits, wall));
+    // the box is inside the triangle's bounds but above its slanted edge
+    aabb_t above = {{1, 7}, {3, 9}};
+    assert(scene_query_aabb(scene, above, QUERY_ALL_HITS, NULL, NULL, NULL) ==
+           0);
+    assert(scene_query_aabb(scene, box, QUERY_FIRST_HIT, NULL, NULL, NULL) ==
+           1);
+    assert(scene_query_aabb(scene, box, QUERY_ALL_HITS, is_wall, NULL, NULL) ==
+           1);
+
+    // bodies marked for removal are not found
+    body_remove(wall);
+    assert(scene_query_aabb(scene, box, QUERY_ALL_HITS, NULL, NULL, NULL) ==
+           1);
+    list_free(hits);
+    scene_free(scene);
+  }
+}
+
+void test_query_point() {
+  for (broad_phase_kind_t kind = 0; kind < BROAD_PHASE_KIND_COUNT; kind++) {
+    scene_t *scene = scene_init();
+    scene_set_broad_phase(scene, kind);
+    body_t *triangle = make_triangle();
+    body_t *box = make_box((vector_t){5, 0}, (vector_t){10, 2}, WALL_TYPE);
+    scene_add_body(scene, triangle);
+    scene_add_body(scene, box);
+
+    list_t *hits = list_init(2, NULL);
+    assert(scene_query_point(scene, (vector_t){8, 1}, QUERY_ALL_HITS, NULL,
+                             NULL, hits) == 2);
+    assert(list_has(hits, triangle) && list_has(hits, box));
+    assert(scene_query_point(scene, (vector_t){8, 1}, QUERY_ALL_HITS, is_not,
+                             box, NULL) == 1);
+    assert(scene_query_point(scene, (vector_t){8, 5}, QUERY_ALL_HITS, NULL,
+                             NULL, NULL) == 1);
+    // inside the triangle's bounds, but not the triangle
+    assert(scene_query_point(scene, (vector_t){2, 8}, QUERY_ALL_HITS, NULL,
+                             NULL, NULL) == 0);
+    assert(scene_query_point(scene, (vector_t){50, 50}, QUERY_FIRST_HIT, NULL,
+                             NULL, NULL) == 0);
+    list_free(hits);
+    scene_free(scene);
+  }
+}
+
+void test_raycast() {
+  for (broad_phase_kind_t kind = 0; kind < BROAD_PHASE_KIND_COUNT; kind++) {
+    scene_t *scene = scene_init();
+    scene_set_broad_phase(scene, kind);
+    // three walls across the ray, and the shooter at its origin
+    body_t *shooter = make_box((vector_t){-1, -1}, (vector_t){2, 2}, 2);
+    scene_add_body(scene, shooter);
+    body_t *walls[3];
+    for (size_t i = 0; i < 3; i++) {
+      walls[i] =
+          make_box((vector_t){20 * (3 - i), -5}, (vector_t){2, 10}, WALL_TYPE);
+      scene_add_body(scene, walls[i]);
+    }
+
+    raycast_hit_t hits[MAX_HITS];
+    vector_t origin = {0, 0}, end = {100, 0};
+    // the ray starts inside the shooter, so it passes out of it
+    assert(scene_raycast(scene, origin, end, QUERY_FIRST_HIT, NULL, NULL, hits,
+                         MAX_HITS) == 1);
+    assert(hits[0].body == walls[2]);
+    assert(isclose(hits[0].fraction, 0.2));
+    assert(vec_isclose(hits[0].point, (vector_t){20, 0}));
+    assert(vec_isclose(hits[0].normal, (vector_t){-1, 0}));
+
+    assert(scene_raycast(scene, origin, end, QUERY_ALL_HITS, NULL, NULL, hits,
+                         MAX_HITS) == 3);
+    for (size_t i = 0; i < 3; i++) {
+      assert(hits[i].body == walls[2 - i]);
+      assert(isclose(hits[i].fraction, 0.2 * (i + 1)));
+    }
+    // with room for two hits, the nearest two are kept
+    assert(scene_raycast(scene, origin, end, QUERY_ALL_HITS, NULL, NULL, hits,
+                         2) == 2);
+    assert(hits[0].body == walls[2] && hits[1].body == walls[1]);
+
+    assert(scene_raycast(scene, origin, end, QUERY_FIRST_HIT, is_not, walls[2],
+                         hits, 1) == 1);
+    assert(hits[0].body == walls[1]);
+    // a ray that stops short hits nothing
+    assert(scene_raycast(scene, origin, (vector_t){19, 0}, QUERY_ALL_HITS,
+                         NULL, NULL, hits, MAX_HITS) == 0);
+    // from the other side, the first wall is hit on its right edge
+    assert(scene_raycast(scene, (vector_t){100, 3}, (vector_t){0, 3},
+                         QUERY_FIRST_HIT, is_wall, NULL, hits, 1) == 1);
+    assert(hits[0].body == walls[0]);
+    assert(vec_isclose(hits[0].point, (vector_t){62, 3}));
+    assert(vec_isclose(hits[0].normal, (vector_t){1, 0}));
+    scene_free(scene);
+  }
+}
+
+void test_queries_follow_ticks() {
+  for (broad_phase_kind_t kind = 0; kind < BROAD_PHASE_KIND_COUNT; kind++) {
+    scene_t *scene = scene_init();
+    scene_set_broad_phase(scene, kind);
+    body_t *body = make_box((vector_t){0, 0}, (vector_t){2, 2}, BULLET_TYPE);
+    body_set_velocity(body, (vector_t){10, 0});
+    scene_add_body(scene, body);
+    assert(scene_query_point(scene, (vector_t){1, 1}, QUERY_FIRST_HIT, NULL,
+                             NULL, NULL) == 1);
+    for (size_t i = 0; i < 10; i++) {
+      scene_tick(scene, 0.5);
+    }
+    // it has moved 50 to the right, far from where it was last queried
+    assert(scene_query_point(scene, (vector_t){1, 1}, QUERY_FIRST_HIT, NULL,
+                             NULL, NULL) == 0);
+    assert(scene_query_point(scene, (vector_t){51, 1}, QUERY_FIRST_HIT, NULL,
+                             NULL, NULL) == 1);
+
+    // bodies added between ticks are found straight away
+    body_t *added = make_box((vector_t){0, 0}, (vector_t){2, 2}, BULLET_TYPE);
+    scene_add_body(scene, added);
+    assert(scene_query_point(scene, (vector_t){1, 1}, QUERY_FIRST_HIT, NULL,
+                             NULL, NULL) == 1);
+    scene_free(scene);
+  }
+}
+
+/** Checks raycasts against casting the ray at every body */
+void test_raycast_matches_brute_force() {
+  srand(43);
+  for (broad_phase_kind_t kind = 0; kind < BROAD_PHASE_KIND_COUNT; kind++) {
+    scene_t *scene = scene_init();
+    scene_set_broad_phase(scene, kind);
+    for (size_t i = 0; i < RANDOM_BODIES; i++) {
+      vector_t corner = {rand() * RANDOM_AREA / RAND_MAX,
+                         rand() * RANDOM_AREA / RAND_MAX};
+      vector_t size = {1 + rand() * 5.0 / RAND_MAX,
+                       1 + rand() * 5.0 / RAND_MAX};
+      // half the bodies are walls
+      scene_add_body(scene,
+                     make_box(corner, size, i % 2 ? BULLET_TYPE : WALL_TYPE));
+    }
+
+    raycast_hit_t hits[MAX_HITS];
+    for (size_t i = 0; i < RANDOM_RAYS; i++) {
+      vector_t origin = {rand() * RANDOM_AREA / RAND_MAX,
+                         rand() * RANDOM_AREA / RAND_MAX};
+      vector_t end = {rand() * RANDOM_AREA / RAND_MAX,
+                      rand() * RANDOM_AREA / RAND_MAX};
+      size_t expected = 0;
+      double nearest = INFINITY;
+      for (size_t j = 0; j < scene_bodies(scene); j++) {
+        list_t *shape = body_get_shape(scene_get_body(scene, j));
+        double fraction;
+        vector_t normal;
+        if (!polygon_contains(shape, origin) &&
+            polygon_raycast(shape, origin, end, &fraction, &normal)) {
+          expected++;
+          nearest = fmin(nearest, fraction);
+        }
+        list_free(shape);
+      }
+      size_t count = scene_raycast(scene, origin, end, QUERY_ALL_HITS, NULL,
+                                   NULL, hits, MAX_HITS);
+      assert(count == fmin(expected, MAX_HITS));
+      for (size_t j = 1; j < count; j++) {
+        assert(hits[j - 1].fraction <= hits[j].fraction);
+      }
+      if (expected > 0) {
+        assert(isclose(hits[0].fraction, nearest));
+        assert(scene_raycast(scene, origin, end, QUERY_FIRST_HIT, NULL, NULL,
+                             hits, 1) == 1);
+        assert(isclose(hits[0].fraction, nearest));
+      }
+    }
+    scene_free(scene);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_query_aabb)
+  DO_TEST(test_query_point)
+  DO_TEST(test_raycast)
+  DO_TEST(test_queries_follow_ticks)
+  DO_TEST(test_raycast_matches_brute_force)
+
+  puts("scene_query_test PASS");
+}
@@ -0,0 +1,125 @@
+#include "forces.h"
+#include "scene.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+const rgb_color_t RED = {1, 0, 0};
+
+body_t *make_square(scene_t *scene, vector_t centroid, double mass) {
+  list_t *shape = list_init(4, free);
+  vector_t corners[] = {{-1, -1}, {+1, -1}, {+1, +1}, {-1, +1}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = corners[i];
+    list_add(shape, v);
+  }
+  size_t *type = malloc(sizeof(size_t));
+  *type = BULLET_TYPE;
+  body_t *body = body_init_with_info(shape, mass, RED, type, free);
+  body_set_centroid(body, centroid);
+  scene_add_body(scene, body);
+  return body;
+}
+
+void count_hits(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+  (*(size_t *)aux)++;
+}
+
+void test_counts_by_kind() {
+  scene_t *scene = scene_init();
+  body_t *a = make_square(scene, (vector_t){0, 0}, 1);
+  body_t *b = make_square(scene, (vector_t){10, 0}, 1);
+  body_t *c = make_square(scene, (vector_t){1, 0}, 1);
+  create_newtonian_gravity(scene, 1, a, b);
+  create_spring(scene, 1, a, b);
+  create_drag(scene, 1, a);
+  create_drag(scene, 1, b);
+  create_drag(scene, 1, c);
+  size_t hits = 0;
+  // a overlaps c but not b
+  create_collision(scene, a, b, count_hits, &hits, NULL);
+  create_collision(scene, a, c, count_hits, &hits, NULL);
+
+  scene_tick(scene, 0.001);
+  scene_stats_t stats = scene_stats(scene);
+  assert(stats.ticks == 1);
+  assert(stats.last_tick[FORCE_GRAVITY].count == 1);
+  assert(stats.last_tick[FORCE_SPRING].count == 1);
+  assert(stats.last_tick[FORCE_DRAG].count == 3);
+  assert(stats.last_tick[FORCE_COLLISION].count == 2);
+  assert(stats.last_tick[FORCE_OTHER].count == 0);
+  assert(stats.last_tick_collisions.tests == 2);
+  assert(stats.last_tick_collisions.hits == 1);
+  assert(hits == 1);
+
+  scene_tick(scene, 0.001);
+  stats = scene_stats(scene);
+  assert(stats.ticks == 2);
+  assert(stats.last_tick[FORCE_DRAG].count == 3);
+  assert(stats.total[FORCE_DRAG].count == 6);
+  assert(stats.total_collisions.tests == 4);
+  uint64_t ns = 0;
+  for (force_kind_t kind = 0; kind < FORCE_KIND_COUNT; kind++) {
+    assert(stats.total[kind].ns >= stats.last_tick[kind].ns);
+    ns += stats.total[kind].ns;
+  }
+  assert(ns > 0);
+  scene_free(scene);
+}
+
+void test_removed_forces_stop_counting() {
+  scene_t *scene = scene_init();
+  body_t *a = make_square(scene, (vector_t){0, 0}, 1);
+  body_t *b = make_square(scene, (vector_t){10, 0}, 1);
+  create_drag(scene, 1, a);
+  create_drag(scene, 1, b);
+  body_remove(b);
+  scene_tick(scene, 0.001);
+  assert(scene_stats(scene).last_tick[FORCE_DRAG].count == 2);
+  scene_tick(scene, 0.001);
+  assert(scene_stats(scene).last_tick[FORCE_DRAG].count == 1);
+  assert(scene_stats(scene).total[FORCE_DRAG].count == 3);
+  scene_free(scene);
+}
+
+void test_reset() {
+  scene_t *scene = scene_init();
+  body_t *a = make_square(scene, (vector_t){0, 0}, 1);
+  create_drag(scene, 1, a);
+  scene_tick(scene, 0.001);
+  scene_stats_reset(scene);
+  scene_stats_t stats = scene_stats(scene);
+  assert(stats.ticks == 0);
+  assert(stats.total[FORCE_DRAG].count == 0);
+  assert(stats.total[FORCE_DRAG].ns == 0);
+  scene_tick(scene, 0.001);
+  assert(scene_stats(scene).total[FORCE_DRAG].count == 1);
+  scene_free(scene);
+}
+
+void test_kind_names() {
+  assert(strcmp(force_kind_name(FORCE_GRAVITY), "gravity") == 0);
+  assert(strcmp(force_kind_name(FORCE_COLLISION), "collision") == 0);
+  assert(strcmp(force_kind_name(FORCE_OTHER), "other") == 0);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_counts_by_kind)
+  DO_TEST(test_removed_forces_stop_counting)
+  DO_TEST(test_reset)
+  DO_TEST(test_kind_names)
+
+  puts("scene_stats_test PASS");
+}
@@ -0,0 +1,102 @@
+#include "list.h"
+#include "slab.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct {
+  double a;
+  double b;
+  double c;
+} record_t;
+
+void test_records_are_contiguous() {
+  slab_t *slab = slab_init();
+  record_t *records[100];
+  for (size_t i = 0; i < 100; i++) {
+    records[i] = slab_alloc(slab, sizeof(record_t));
+    assert((uintptr_t)records[i] % 16 == 0);
+    *records[i] = (record_t){i, i, i};
+  }
+  // 24-byte records are rounded up to the 32-byte class, and packed
+  for (size_t i = 1; i < 100; i++) {
+    assert((char *)records[i] - (char *)records[i - 1] == 32);
+  }
+  for (size_t i = 0; i < 100; i++) {
+    assert(records[i]->a == i);
+  }
+  assert(slab_stats(slab).pages == 1);
+  slab_free(slab);
+}
+
+void test_classes_do_not_share_pages() {
+  slab_t *slab = slab_init();
+  void *small = slab_alloc(slab, 16);
+  void *large = slab_alloc(slab, SLAB_MAX_RECORD);
+  void *next_small = slab_alloc(slab, 8);
+  assert((char *)next_small - (char *)small == 16);
+  assert(large != NULL);
+  assert(slab_stats(slab).pages == 2);
+  slab_free(slab);
+}
+
+void test_released_records_are_reused() {
+  slab_t *slab = slab_init();
+  void *first = slab_alloc(slab, 40);
+  void *second = slab_alloc(slab, 40);
+  slab_release(slab, first);
+  slab_release(slab, second);
+  // The most recently released record comes back first
+  assert(slab_alloc(slab, 48) == second);
+  assert(slab_alloc(slab, 33) == first);
+  slab_stats_t stats = slab_stats(slab);
+  assert(stats.live == 2);
+  assert(stats.high_water == 2);
+  slab_free(slab);
+}
+
+void test_many_pages() {
+  slab_t *slab = slab_init();
+  size_t count = 10000;
+  for (size_t i = 0; i < count; i++) {
+    size_t *record = slab_alloc(slab, 64);
+    *record = i;
+  }
+  slab_stats_t stats = slab_stats(slab);
+  assert(stats.live == count);
+  assert(stats.pages > 1);
+  // Freeing the slab releases every page without touching the records
+  slab_free(slab);
+}
+
+void test_slab_allocator() {
+  slab_t *slab = slab_init();
+  allocator_t allocator = slab_allocator(slab);
+  list_t *list = list_init_with_allocator(2, NULL, &allocator);
+  int values[2] = {1, 2};
+  list_add(list, &values[0]);
+  list_add(list, &values[1]);
+  assert(slab_stats(slab).live == 2);
+  list_free(list);
+  assert(slab_stats(slab).live == 0);
+  slab_free(slab);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_records_are_contiguous)
+  DO_TEST(test_classes_do_not_share_pages)
+  DO_TEST(test_released_records_are_reused)
+  DO_TEST(test_many_pages)
+  DO_TEST(test_slab_allocator)
+
+  puts("slab_test PASS");
+}
@@ -0,0 +1,23 @@
+#include "asset_pack.h"
+#include <stdio.h>
+
+/**
+ * Packs asset files into one archive for asset_pack_mount().
+ *
+ * Usage: bin/pack_assets <archive> <file>...
+ * e.g. bin/pack_assets bin/assets.pack assets/tank.png assets/font.ttf
+ */
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <archive> <file>...\n", argv[0]);
+    return 1;
+  }
+  const char *const *paths = (const char *const *)&argv[2];
+  size_t count = argc - 2;
+  if (!asset_pack_write(argv[1], paths, count)) {
+    fprintf(stderr, "%s: could not pack %s\n", argv[0], argv[1]);
+    return 1;
+  }
+  printf("packed %zu files into %s\n", count, argv[1]);
+  return 0;
+}